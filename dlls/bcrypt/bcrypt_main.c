@@ -19,13 +19,126 @@
 
 #include "config.h"
 #include "wine/port.h"
-#include "wine/debug.h"
 
+#include <stdarg.h>
+#ifdef SONAME_LIBGNUTLS
+#include <gnutls/gnutls.h>
+#include <gnutls/crypto.h>
+#endif
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
 #include "winbase.h"
+#include "wincrypt.h"
+#include "ntsecapi.h"
 #include "bcrypt.h"
 
+#include "wine/debug.h"
+#include "wine/library.h"
+#include "wine/unicode.h"
+
 WINE_DEFAULT_DEBUG_CHANNEL(bcrypt);
 
+#ifdef SONAME_LIBGNUTLS
+WINE_DECLARE_DEBUG_CHANNEL(winediag);
+
+static void *libgnutls_handle;
+#define MAKE_FUNCPTR(f) static typeof(f) * p##f
+#if GNUTLS_VERSION_MAJOR >= 3
+MAKE_FUNCPTR(gnutls_cipher_add_auth);
+MAKE_FUNCPTR(gnutls_cipher_tag);
+#endif
+MAKE_FUNCPTR(gnutls_cipher_decrypt2);
+MAKE_FUNCPTR(gnutls_cipher_deinit);
+MAKE_FUNCPTR(gnutls_cipher_encrypt2);
+MAKE_FUNCPTR(gnutls_cipher_init);
+MAKE_FUNCPTR(gnutls_cipher_set_iv);
+MAKE_FUNCPTR(gnutls_global_deinit);
+MAKE_FUNCPTR(gnutls_global_init);
+MAKE_FUNCPTR(gnutls_hash);
+MAKE_FUNCPTR(gnutls_hash_deinit);
+MAKE_FUNCPTR(gnutls_hash_init);
+MAKE_FUNCPTR(gnutls_hash_output);
+#undef MAKE_FUNCPTR
+/* only available in recent versions */
+static gnutls_hash_hd_t (*pgnutls_hash_copy)(gnutls_hash_hd_t);
+
+static BOOL gnutls_initialize(void)
+{
+    int ret;
+
+    if (!(libgnutls_handle = wine_dlopen( SONAME_LIBGNUTLS, RTLD_NOW, NULL, 0 )))
+    {
+        ERR_(winediag)( "failed to load libgnutls, using the builtin crypto provider\n" );
+        return FALSE;
+    }
+
+#define LOAD_FUNCPTR(f) \
+    if (!(p##f = wine_dlsym( libgnutls_handle, #f, NULL, 0 ))) \
+    { \
+        ERR( "failed to load %s\n", #f ); \
+        goto fail; \
+    }
+
+#if GNUTLS_VERSION_MAJOR >= 3
+    LOAD_FUNCPTR(gnutls_cipher_add_auth)
+    LOAD_FUNCPTR(gnutls_cipher_tag)
+#endif
+    LOAD_FUNCPTR(gnutls_cipher_decrypt2)
+    LOAD_FUNCPTR(gnutls_cipher_deinit)
+    LOAD_FUNCPTR(gnutls_cipher_encrypt2)
+    LOAD_FUNCPTR(gnutls_cipher_init)
+    LOAD_FUNCPTR(gnutls_cipher_set_iv)
+    LOAD_FUNCPTR(gnutls_global_deinit)
+    LOAD_FUNCPTR(gnutls_global_init)
+    LOAD_FUNCPTR(gnutls_hash)
+    LOAD_FUNCPTR(gnutls_hash_deinit)
+    LOAD_FUNCPTR(gnutls_hash_init)
+    LOAD_FUNCPTR(gnutls_hash_output)
+#undef LOAD_FUNCPTR
+    pgnutls_hash_copy = wine_dlsym( libgnutls_handle, "gnutls_hash_copy", NULL, 0 );
+
+    if ((ret = pgnutls_global_init()) != GNUTLS_E_SUCCESS)
+    {
+        ERR( "gnutls_global_init failed %d\n", ret );
+        goto fail;
+    }
+    return TRUE;
+
+fail:
+    wine_dlclose( libgnutls_handle, NULL, 0 );
+    libgnutls_handle = NULL;
+    return FALSE;
+}
+
+static void gnutls_uninitialize(void)
+{
+    pgnutls_global_deinit();
+    wine_dlclose( libgnutls_handle, NULL, 0 );
+    libgnutls_handle = NULL;
+}
+#endif /* SONAME_LIBGNUTLS */
+
+/* builtin provider, used when GnuTLS is not available */
+static HCRYPTPROV builtin_prov;
+
+static HCRYPTPROV get_builtin_prov(void)
+{
+    HCRYPTPROV prov;
+
+    if (builtin_prov) return builtin_prov;
+
+    if (!CryptAcquireContextW( &prov, NULL, MS_ENH_RSA_AES_PROV_W, PROV_RSA_AES, CRYPT_VERIFYCONTEXT ))
+    {
+        ERR( "failed to acquire the builtin provider %08x\n", GetLastError() );
+        return 0;
+    }
+    if (InterlockedCompareExchangePointer( (void **)&builtin_prov, (void *)prov, NULL ))
+        CryptReleaseContext( prov, 0 );
+    return builtin_prov;
+}
+
 BOOL WINAPI DllMain(HINSTANCE hInstDLL, DWORD fdwReason, LPVOID lpv)
 {
     TRACE("fdwReason %u\n", fdwReason);
@@ -34,6 +147,17 @@ BOOL WINAPI DllMain(HINSTANCE hInstDLL, DWORD fdwReason, LPVOID lpv)
     {
         case DLL_PROCESS_ATTACH:
             DisableThreadLibraryCalls(hInstDLL);
+#ifdef SONAME_LIBGNUTLS
+            gnutls_initialize();
+#endif
+            break;
+
+        case DLL_PROCESS_DETACH:
+            if (lpv) break;
+#ifdef SONAME_LIBGNUTLS
+            if (libgnutls_handle) gnutls_uninitialize();
+#endif
+            if (builtin_prov) CryptReleaseContext( builtin_prov, 0 );
             break;
     }
 
@@ -50,3 +174,884 @@ NTSTATUS WINAPI BCryptEnumAlgorithms(ULONG dwAlgOperations, ULONG *pAlgCount,
 
     return ERROR_CALL_NOT_IMPLEMENTED;
 }
+
+#define MAGIC_ALG  (('A' << 24) | ('L' << 16) | ('G' << 8) | '0')
+#define MAGIC_HASH (('H' << 24) | ('A' << 16) | ('S' << 8) | 'H')
+#define MAGIC_KEY  (('K' << 24) | ('E' << 16) | ('Y' << 8) | '0')
+
+struct object
+{
+    ULONG magic;
+};
+
+enum alg_id
+{
+    ALG_ID_MD5,
+    ALG_ID_SHA1,
+    ALG_ID_SHA256,
+    ALG_ID_SHA384,
+    ALG_ID_SHA512,
+    ALG_ID_AES,
+    ALG_ID_RNG
+};
+
+enum mode_id
+{
+    MODE_ID_NA,
+    MODE_ID_CBC,
+    MODE_ID_ECB,
+    MODE_ID_GCM
+};
+
+#define AES_BLOCK_SIZE 16
+
+static const struct
+{
+    const WCHAR *name;
+    ULONG        object_length;
+    ULONG        hash_length;
+    ULONG        block_length;
+    ALG_ID       calg;
+#ifdef SONAME_LIBGNUTLS
+    gnutls_digest_algorithm_t digest;
+#endif
+} alg_props[] =
+{
+#ifdef SONAME_LIBGNUTLS
+#define DIGEST(x) , x
+#else
+#define DIGEST(x)
+#endif
+    /* ALG_ID_MD5    */ { BCRYPT_MD5_ALGORITHM,    274, 16,  64, CALG_MD5     DIGEST(GNUTLS_DIG_MD5) },
+    /* ALG_ID_SHA1   */ { BCRYPT_SHA1_ALGORITHM,   278, 20,  64, CALG_SHA1    DIGEST(GNUTLS_DIG_SHA1) },
+    /* ALG_ID_SHA256 */ { BCRYPT_SHA256_ALGORITHM, 286, 32,  64, CALG_SHA_256 DIGEST(GNUTLS_DIG_SHA256) },
+    /* ALG_ID_SHA384 */ { BCRYPT_SHA384_ALGORITHM, 382, 48, 128, CALG_SHA_384 DIGEST(GNUTLS_DIG_SHA384) },
+    /* ALG_ID_SHA512 */ { BCRYPT_SHA512_ALGORITHM, 382, 64, 128, CALG_SHA_512 DIGEST(GNUTLS_DIG_SHA512) },
+    /* ALG_ID_AES    */ { BCRYPT_AES_ALGORITHM,    654,  0, AES_BLOCK_SIZE, 0 DIGEST(GNUTLS_DIG_UNKNOWN) },
+    /* ALG_ID_RNG    */ { BCRYPT_RNG_ALGORITHM,      0,  0,  0, 0     DIGEST(GNUTLS_DIG_UNKNOWN) },
+#undef DIGEST
+};
+
+static const WCHAR *mode_names[] =
+{
+    BCRYPT_CHAIN_MODE_NA,
+    BCRYPT_CHAIN_MODE_CBC,
+    BCRYPT_CHAIN_MODE_ECB,
+    BCRYPT_CHAIN_MODE_GCM
+};
+
+static inline BOOL is_hash_alg( enum alg_id id )
+{
+    return id <= ALG_ID_SHA512;
+}
+
+struct algorithm
+{
+    struct object hdr;
+    enum alg_id   id;
+    enum mode_id  mode;
+};
+
+struct hash
+{
+    struct object hdr;
+    enum alg_id   alg_id;
+    ULONG         flags;
+#ifdef SONAME_LIBGNUTLS
+    gnutls_hash_hd_t handle;
+#endif
+    HCRYPTHASH    builtin;
+};
+
+struct key
+{
+    struct object hdr;
+    enum alg_id   alg_id;
+    enum mode_id  mode;
+    UCHAR         secret[32];
+    ULONG         secret_len;
+#ifdef SONAME_LIBGNUTLS
+    gnutls_cipher_hd_t handle;
+#endif
+    HCRYPTKEY     builtin;
+    enum mode_id  builtin_mode;
+};
+
+NTSTATUS WINAPI BCryptOpenAlgorithmProvider( BCRYPT_ALG_HANDLE *handle, LPCWSTR id, LPCWSTR implementation, ULONG flags )
+{
+    struct algorithm *alg;
+    enum alg_id alg_id;
+
+    TRACE( "%p, %s, %s, %08x\n", handle, debugstr_w(id), debugstr_w(implementation), flags );
+
+    if (!handle || !id) return STATUS_INVALID_PARAMETER;
+    if (flags & BCRYPT_ALG_HANDLE_HMAC_FLAG)
+    {
+        FIXME( "HMAC not supported\n" );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    if (flags & ~BCRYPT_HASH_REUSABLE_FLAG)
+    {
+        FIXME( "unsupported flags %08x\n", flags );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    for (alg_id = 0; alg_id < sizeof(alg_props) / sizeof(alg_props[0]); alg_id++)
+        if (!strcmpW( id, alg_props[alg_id].name )) break;
+    if (alg_id == sizeof(alg_props) / sizeof(alg_props[0]))
+    {
+        FIXME( "algorithm %s not supported\n", debugstr_w(id) );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    if (implementation && strcmpW( implementation, MS_PRIMITIVE_PROVIDER ))
+    {
+        FIXME( "implementation %s not supported\n", debugstr_w(implementation) );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    if (!(alg = HeapAlloc( GetProcessHeap(), 0, sizeof(*alg) ))) return STATUS_NO_MEMORY;
+    alg->hdr.magic = MAGIC_ALG;
+    alg->id        = alg_id;
+    alg->mode      = alg_id == ALG_ID_AES ? MODE_ID_CBC : MODE_ID_NA;
+
+    *handle = alg;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptCloseAlgorithmProvider( BCRYPT_ALG_HANDLE handle, ULONG flags )
+{
+    struct algorithm *alg = handle;
+
+    TRACE( "%p, %08x\n", handle, flags );
+
+    if (!alg || alg->hdr.magic != MAGIC_ALG) return STATUS_INVALID_HANDLE;
+    alg->hdr.magic = 0;
+    HeapFree( GetProcessHeap(), 0, alg );
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptGenRandom( BCRYPT_ALG_HANDLE handle, UCHAR *buffer, ULONG count, ULONG flags )
+{
+    struct algorithm *alg = handle;
+
+    TRACE( "%p, %p, %u, %08x\n", handle, buffer, count, flags );
+
+    if (!alg)
+    {
+        if (!(flags & BCRYPT_USE_SYSTEM_PREFERRED_RNG)) return STATUS_INVALID_HANDLE;
+    }
+    else if (alg->hdr.magic != MAGIC_ALG || alg->id != ALG_ID_RNG)
+        return STATUS_INVALID_HANDLE;
+
+    if (!buffer) return STATUS_INVALID_PARAMETER;
+    if (flags & BCRYPT_RNG_USE_ENTROPY_IN_BUFFER)
+        FIXME( "ignoring selected algorithm\n" );
+
+    if (!count) return STATUS_SUCCESS;
+    return RtlGenRandom( buffer, count ) ? STATUS_SUCCESS : STATUS_UNSUCCESSFUL;
+}
+
+static NTSTATUS hash_init( struct hash *hash )
+{
+#ifdef SONAME_LIBGNUTLS
+    if (libgnutls_handle)
+    {
+        if (pgnutls_hash_init( &hash->handle, alg_props[hash->alg_id].digest )) return STATUS_INTERNAL_ERROR;
+        return STATUS_SUCCESS;
+    }
+#endif
+    if (!get_builtin_prov()) return STATUS_INTERNAL_ERROR;
+    if (!CryptCreateHash( builtin_prov, alg_props[hash->alg_id].calg, 0, 0, &hash->builtin ))
+        return STATUS_INTERNAL_ERROR;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS hash_update( struct hash *hash, UCHAR *input, ULONG size )
+{
+#ifdef SONAME_LIBGNUTLS
+    if (libgnutls_handle)
+    {
+        if (pgnutls_hash( hash->handle, input, size )) return STATUS_INTERNAL_ERROR;
+        return STATUS_SUCCESS;
+    }
+#endif
+    if (!CryptHashData( hash->builtin, input, size, 0 )) return STATUS_INTERNAL_ERROR;
+    return STATUS_SUCCESS;
+}
+
+/* Retrieves the hash value. Reusable hashes are reset to their initial state. */
+static NTSTATUS hash_finish( struct hash *hash, UCHAR *output )
+{
+    DWORD size = alg_props[hash->alg_id].hash_length;
+
+#ifdef SONAME_LIBGNUTLS
+    if (libgnutls_handle)
+    {
+        /* gnutls_hash_output resets the hash state */
+        pgnutls_hash_output( hash->handle, output );
+        return STATUS_SUCCESS;
+    }
+#endif
+    if (!CryptGetHashParam( hash->builtin, HP_HASHVAL, output, &size, 0 )) return STATUS_INTERNAL_ERROR;
+    if (!(hash->flags & BCRYPT_HASH_REUSABLE_FLAG)) return STATUS_SUCCESS;
+
+    CryptDestroyHash( hash->builtin );
+    hash->builtin = 0;
+    return hash_init( hash );
+}
+
+static NTSTATUS hash_duplicate( struct hash *hash, struct hash *hash_copy )
+{
+#ifdef SONAME_LIBGNUTLS
+    if (libgnutls_handle)
+    {
+        if (!pgnutls_hash_copy)
+        {
+            FIXME( "hash duplication requires a newer GnuTLS\n" );
+            return STATUS_NOT_IMPLEMENTED;
+        }
+        if (!(hash_copy->handle = pgnutls_hash_copy( hash->handle ))) return STATUS_INTERNAL_ERROR;
+        return STATUS_SUCCESS;
+    }
+#endif
+    if (!CryptDuplicateHash( hash->builtin, NULL, 0, &hash_copy->builtin )) return STATUS_INTERNAL_ERROR;
+    return STATUS_SUCCESS;
+}
+
+static void hash_destroy( struct hash *hash )
+{
+#ifdef SONAME_LIBGNUTLS
+    if (libgnutls_handle)
+    {
+        if (hash->handle) pgnutls_hash_deinit( hash->handle, NULL );
+        return;
+    }
+#endif
+    if (hash->builtin) CryptDestroyHash( hash->builtin );
+}
+
+NTSTATUS WINAPI BCryptCreateHash( BCRYPT_ALG_HANDLE algorithm, BCRYPT_HASH_HANDLE *handle, UCHAR *object, ULONG objectlen,
+                                  UCHAR *secret, ULONG secretlen, ULONG flags )
+{
+    struct algorithm *alg = algorithm;
+    struct hash *hash;
+    NTSTATUS status;
+
+    TRACE( "%p, %p, %p, %u, %p, %u, %08x\n", algorithm, handle, object, objectlen, secret, secretlen, flags );
+
+    if (!alg || alg->hdr.magic != MAGIC_ALG || !is_hash_alg( alg->id )) return STATUS_INVALID_HANDLE;
+    if (!handle) return STATUS_INVALID_PARAMETER;
+    if (object) FIXME( "ignoring object buffer\n" );
+    if (secret)
+    {
+        FIXME( "HMAC not supported\n" );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    if (flags & ~BCRYPT_HASH_REUSABLE_FLAG)
+    {
+        FIXME( "unsupported flags %08x\n", flags );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    if (!(hash = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*hash) ))) return STATUS_NO_MEMORY;
+    hash->hdr.magic = MAGIC_HASH;
+    hash->alg_id    = alg->id;
+    hash->flags     = flags;
+
+    if ((status = hash_init( hash )))
+    {
+        HeapFree( GetProcessHeap(), 0, hash );
+        return status;
+    }
+
+    *handle = hash;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptDuplicateHash( BCRYPT_HASH_HANDLE handle, BCRYPT_HASH_HANDLE *handle_copy,
+                                     UCHAR *object, ULONG objectlen, ULONG flags )
+{
+    struct hash *hash_orig = handle;
+    struct hash *hash_copy;
+    NTSTATUS status;
+
+    TRACE( "%p, %p, %p, %u, %u\n", handle, handle_copy, object, objectlen, flags );
+
+    if (!hash_orig || hash_orig->hdr.magic != MAGIC_HASH) return STATUS_INVALID_HANDLE;
+    if (!handle_copy) return STATUS_INVALID_PARAMETER;
+    if (object) FIXME( "ignoring object buffer\n" );
+
+    if (!(hash_copy = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*hash_copy) ))) return STATUS_NO_MEMORY;
+    hash_copy->hdr.magic = MAGIC_HASH;
+    hash_copy->alg_id    = hash_orig->alg_id;
+    hash_copy->flags     = hash_orig->flags;
+
+    if ((status = hash_duplicate( hash_orig, hash_copy )))
+    {
+        HeapFree( GetProcessHeap(), 0, hash_copy );
+        return status;
+    }
+
+    *handle_copy = hash_copy;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptDestroyHash( BCRYPT_HASH_HANDLE handle )
+{
+    struct hash *hash = handle;
+
+    TRACE( "%p\n", handle );
+
+    if (!hash || hash->hdr.magic != MAGIC_HASH) return STATUS_INVALID_HANDLE;
+    hash_destroy( hash );
+    hash->hdr.magic = 0;
+    HeapFree( GetProcessHeap(), 0, hash );
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptHashData( BCRYPT_HASH_HANDLE handle, UCHAR *input, ULONG size, ULONG flags )
+{
+    struct hash *hash = handle;
+
+    TRACE( "%p, %p, %u, %08x\n", handle, input, size, flags );
+
+    if (!hash || hash->hdr.magic != MAGIC_HASH) return STATUS_INVALID_HANDLE;
+    if (!input && size) return STATUS_INVALID_PARAMETER;
+    if (!size) return STATUS_SUCCESS;
+
+    return hash_update( hash, input, size );
+}
+
+NTSTATUS WINAPI BCryptFinishHash( BCRYPT_HASH_HANDLE handle, UCHAR *output, ULONG size, ULONG flags )
+{
+    struct hash *hash = handle;
+
+    TRACE( "%p, %p, %u, %08x\n", handle, output, size, flags );
+
+    if (!hash || hash->hdr.magic != MAGIC_HASH) return STATUS_INVALID_HANDLE;
+    if (!output) return STATUS_INVALID_PARAMETER;
+    if (size != alg_props[hash->alg_id].hash_length) return STATUS_INVALID_PARAMETER;
+
+    return hash_finish( hash, output );
+}
+
+static NTSTATUS key_init( struct key *key )
+{
+#ifdef SONAME_LIBGNUTLS
+    if (libgnutls_handle)
+    {
+        static const UCHAR zero_iv[AES_BLOCK_SIZE];
+        gnutls_cipher_algorithm_t cipher;
+        gnutls_datum_t secret, iv;
+
+        if (key->handle) return STATUS_SUCCESS;
+
+        switch (key->mode)
+        {
+        case MODE_ID_GCM:
+#if GNUTLS_VERSION_MAJOR >= 3
+            if (key->secret_len == 16) cipher = GNUTLS_CIPHER_AES_128_GCM;
+            else if (key->secret_len == 32) cipher = GNUTLS_CIPHER_AES_256_GCM;
+            else
+            {
+                FIXME( "GCM with %u byte keys not supported\n", key->secret_len );
+                return STATUS_NOT_SUPPORTED;
+            }
+            break;
+#else
+            FIXME( "GCM requires GnuTLS 3\n" );
+            return STATUS_NOT_SUPPORTED;
+#endif
+        default:
+            /* ECB is done one block at a time with a zero IV */
+            if (key->secret_len == 16) cipher = GNUTLS_CIPHER_AES_128_CBC;
+            else if (key->secret_len == 24) cipher = GNUTLS_CIPHER_AES_192_CBC;
+            else cipher = GNUTLS_CIPHER_AES_256_CBC;
+            break;
+        }
+
+        secret.data = key->secret;
+        secret.size = key->secret_len;
+        iv.data     = (UCHAR *)zero_iv;
+        iv.size     = key->mode == MODE_ID_GCM ? 12 : AES_BLOCK_SIZE;
+        if (pgnutls_cipher_init( &key->handle, cipher, &secret, &iv )) return STATUS_INTERNAL_ERROR;
+        return STATUS_SUCCESS;
+    }
+#endif
+    if (key->mode == MODE_ID_GCM)
+    {
+        FIXME( "GCM requires GnuTLS\n" );
+        return STATUS_NOT_SUPPORTED;
+    }
+    if (!key->builtin)
+    {
+        struct
+        {
+            BLOBHEADER hdr;
+            DWORD      len;
+            BYTE       key[32];
+        } blob;
+
+        if (!get_builtin_prov()) return STATUS_INTERNAL_ERROR;
+
+        blob.hdr.bType    = PLAINTEXTKEYBLOB;
+        blob.hdr.bVersion = CUR_BLOB_VERSION;
+        blob.hdr.reserved = 0;
+        blob.hdr.aiKeyAlg = key->secret_len == 16 ? CALG_AES_128 : key->secret_len == 24 ? CALG_AES_192 : CALG_AES_256;
+        blob.len          = key->secret_len;
+        memcpy( blob.key, key->secret, key->secret_len );
+        if (!CryptImportKey( builtin_prov, (BYTE *)&blob, sizeof(blob.hdr) + sizeof(blob.len) + key->secret_len,
+                             0, 0, &key->builtin ))
+            return STATUS_INTERNAL_ERROR;
+        key->builtin_mode = MODE_ID_NA;
+    }
+    if (key->builtin_mode != key->mode)
+    {
+        DWORD mode = key->mode == MODE_ID_ECB ? CRYPT_MODE_ECB : CRYPT_MODE_CBC;
+        if (!CryptSetKeyParam( key->builtin, KP_MODE, (BYTE *)&mode, 0 )) return STATUS_INTERNAL_ERROR;
+        key->builtin_mode = key->mode;
+    }
+    return STATUS_SUCCESS;
+}
+
+static void key_destroy( struct key *key )
+{
+#ifdef SONAME_LIBGNUTLS
+    if (key->handle)
+    {
+        pgnutls_cipher_deinit( key->handle );
+        key->handle = NULL;
+    }
+#endif
+    if (key->builtin)
+    {
+        CryptDestroyKey( key->builtin );
+        key->builtin = 0;
+    }
+}
+
+/* Encrypts or decrypts whole blocks in place in CBC or ECB mode. */
+static NTSTATUS key_crypt_blocks( struct key *key, UCHAR *iv, UCHAR *buf, ULONG len, BOOL encrypt )
+{
+    static const UCHAR zero_iv[AES_BLOCK_SIZE];
+    ULONG i;
+
+#ifdef SONAME_LIBGNUTLS
+    if (libgnutls_handle)
+    {
+        int ret = 0;
+
+        if (key->mode == MODE_ID_ECB)
+        {
+            for (i = 0; i < len && !ret; i += AES_BLOCK_SIZE)
+            {
+                pgnutls_cipher_set_iv( key->handle, (void *)zero_iv, AES_BLOCK_SIZE );
+                if (encrypt) ret = pgnutls_cipher_encrypt2( key->handle, buf + i, AES_BLOCK_SIZE, buf + i, AES_BLOCK_SIZE );
+                else ret = pgnutls_cipher_decrypt2( key->handle, buf + i, AES_BLOCK_SIZE, buf + i, AES_BLOCK_SIZE );
+            }
+        }
+        else
+        {
+            pgnutls_cipher_set_iv( key->handle, iv ? iv : (UCHAR *)zero_iv, AES_BLOCK_SIZE );
+            if (encrypt) ret = pgnutls_cipher_encrypt2( key->handle, buf, len, buf, len );
+            else ret = pgnutls_cipher_decrypt2( key->handle, buf, len, buf, len );
+        }
+        return ret ? STATUS_INTERNAL_ERROR : STATUS_SUCCESS;
+    }
+#endif
+    if (key->mode == MODE_ID_CBC &&
+        !CryptSetKeyParam( key->builtin, KP_IV, iv ? iv : (BYTE *)zero_iv, 0 ))
+        return STATUS_INTERNAL_ERROR;
+
+    /* no padding is added or removed as long as Final is FALSE */
+    for (i = 0; i < len; i += 0x10000)
+    {
+        DWORD size = min( len - i, 0x10000 );
+        if (encrypt ? !CryptEncrypt( key->builtin, 0, FALSE, 0, buf + i, &size, size )
+                    : !CryptDecrypt( key->builtin, 0, FALSE, 0, buf + i, &size ))
+            return STATUS_INTERNAL_ERROR;
+    }
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptGenerateSymmetricKey( BCRYPT_ALG_HANDLE algorithm, BCRYPT_KEY_HANDLE *handle,
+                                            UCHAR *object, ULONG object_len, UCHAR *secret, ULONG secret_len,
+                                            ULONG flags )
+{
+    struct algorithm *alg = algorithm;
+    struct key *key;
+
+    TRACE( "%p, %p, %p, %u, %p, %u, %08x\n", algorithm, handle, object, object_len, secret, secret_len, flags );
+
+    if (!alg || alg->hdr.magic != MAGIC_ALG || alg->id != ALG_ID_AES) return STATUS_INVALID_HANDLE;
+    if (!handle || !secret) return STATUS_INVALID_PARAMETER;
+    if (secret_len != 16 && secret_len != 24 && secret_len != 32) return STATUS_INVALID_PARAMETER;
+    if (object) FIXME( "ignoring object buffer\n" );
+
+    if (!(key = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*key) ))) return STATUS_NO_MEMORY;
+    key->hdr.magic  = MAGIC_KEY;
+    key->alg_id     = alg->id;
+    key->mode       = alg->mode;
+    key->secret_len = secret_len;
+    memcpy( key->secret, secret, secret_len );
+
+    *handle = key;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptDestroyKey( BCRYPT_KEY_HANDLE handle )
+{
+    struct key *key = handle;
+
+    TRACE( "%p\n", handle );
+
+    if (!key || key->hdr.magic != MAGIC_KEY) return STATUS_INVALID_HANDLE;
+    key_destroy( key );
+    key->hdr.magic = 0;
+    memset( key->secret, 0, sizeof(key->secret) );
+    HeapFree( GetProcessHeap(), 0, key );
+    return STATUS_SUCCESS;
+}
+
+#if defined(SONAME_LIBGNUTLS) && GNUTLS_VERSION_MAJOR >= 3
+/* runs in constant time, so that a mismatch doesn't tell how many bytes were right */
+static BOOL tag_equal( const UCHAR *tag1, const UCHAR *tag2, ULONG len )
+{
+    UCHAR diff = 0;
+    ULONG i;
+
+    for (i = 0; i < len; i++) diff |= tag1[i] ^ tag2[i];
+    return !diff;
+}
+#endif
+
+static NTSTATUS key_crypt_gcm( struct key *key, UCHAR *input, ULONG input_len,
+                               BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO *auth_info, UCHAR *output, BOOL encrypt )
+{
+#if defined(SONAME_LIBGNUTLS) && GNUTLS_VERSION_MAJOR >= 3
+    UCHAR tag[AES_BLOCK_SIZE];
+    int ret;
+
+    if (!auth_info || auth_info->cbSize < sizeof(*auth_info)) return STATUS_INVALID_PARAMETER;
+    if (auth_info->dwFlags & BCRYPT_AUTH_MODE_CHAIN_CALLS_FLAG)
+    {
+        FIXME( "chained calls not supported\n" );
+        return STATUS_NOT_SUPPORTED;
+    }
+    if (!auth_info->pbNonce || auth_info->cbNonce != 12) return STATUS_INVALID_PARAMETER;
+    if (!auth_info->pbTag || auth_info->cbTag < 12 || auth_info->cbTag > AES_BLOCK_SIZE)
+        return STATUS_INVALID_PARAMETER;
+
+    pgnutls_cipher_set_iv( key->handle, auth_info->pbNonce, auth_info->cbNonce );
+    if (auth_info->pbAuthData && auth_info->cbAuthData &&
+        pgnutls_cipher_add_auth( key->handle, auth_info->pbAuthData, auth_info->cbAuthData ))
+        return STATUS_INTERNAL_ERROR;
+
+    if (encrypt) ret = pgnutls_cipher_encrypt2( key->handle, input, input_len, output, input_len );
+    else ret = pgnutls_cipher_decrypt2( key->handle, input, input_len, output, input_len );
+    if (ret || pgnutls_cipher_tag( key->handle, tag, sizeof(tag) )) return STATUS_INTERNAL_ERROR;
+
+    if (encrypt)
+        memcpy( auth_info->pbTag, tag, auth_info->cbTag );
+    else if (!tag_equal( auth_info->pbTag, tag, auth_info->cbTag ))
+    {
+        memset( output, 0, input_len );
+        return STATUS_AUTH_TAG_MISMATCH;
+    }
+    return STATUS_SUCCESS;
+#else
+    return STATUS_NOT_SUPPORTED;
+#endif
+}
+
+NTSTATUS WINAPI BCryptEncrypt( BCRYPT_KEY_HANDLE handle, UCHAR *input, ULONG input_len, void *padding,
+                               UCHAR *iv, ULONG iv_len, UCHAR *output, ULONG output_len, ULONG *ret_len,
+                               ULONG flags )
+{
+    struct key *key = handle;
+    ULONG bytes_left = input_len % AES_BLOCK_SIZE, size;
+    NTSTATUS status;
+
+    TRACE( "%p, %p, %u, %p, %p, %u, %p, %u, %p, %08x\n", handle, input, input_len, padding, iv, iv_len,
+           output, output_len, ret_len, flags );
+
+    if (!key || key->hdr.magic != MAGIC_KEY) return STATUS_INVALID_HANDLE;
+    if (!ret_len) return STATUS_INVALID_PARAMETER;
+    if (flags & ~BCRYPT_BLOCK_PADDING)
+    {
+        FIXME( "flags %08x not implemented\n", flags );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    if (key->mode != MODE_ID_GCM && iv && iv_len != AES_BLOCK_SIZE) return STATUS_INVALID_PARAMETER;
+
+    if (key->mode == MODE_ID_GCM)
+    {
+        if (flags & BCRYPT_BLOCK_PADDING) return STATUS_INVALID_PARAMETER;
+        size = input_len;
+    }
+    else if (flags & BCRYPT_BLOCK_PADDING)
+        size = input_len - bytes_left + AES_BLOCK_SIZE;
+    else if (bytes_left)
+        return STATUS_INVALID_BUFFER_SIZE;
+    else
+        size = input_len;
+
+    *ret_len = size;
+    if (!output) return STATUS_SUCCESS;
+    if (output_len < size) return STATUS_BUFFER_TOO_SMALL;
+
+    if ((status = key_init( key ))) return status;
+    if (key->mode == MODE_ID_GCM) return key_crypt_gcm( key, input, input_len, padding, output, TRUE );
+
+    memmove( output, input, input_len );
+    if (flags & BCRYPT_BLOCK_PADDING)
+        memset( output + input_len, AES_BLOCK_SIZE - bytes_left, AES_BLOCK_SIZE - bytes_left );
+
+    if ((status = key_crypt_blocks( key, key->mode == MODE_ID_CBC ? iv : NULL, output, size, TRUE )))
+        return status;
+
+    /* the IV is updated to allow chaining calls */
+    if (iv && key->mode == MODE_ID_CBC) memcpy( iv, output + size - AES_BLOCK_SIZE, AES_BLOCK_SIZE );
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptDecrypt( BCRYPT_KEY_HANDLE handle, UCHAR *input, ULONG input_len, void *padding,
+                               UCHAR *iv, ULONG iv_len, UCHAR *output, ULONG output_len, ULONG *ret_len,
+                               ULONG flags )
+{
+    struct key *key = handle;
+    UCHAR next_iv[AES_BLOCK_SIZE], last_iv[AES_BLOCK_SIZE], last[AES_BLOCK_SIZE];
+    ULONG size, pad, i;
+    NTSTATUS status;
+
+    TRACE( "%p, %p, %u, %p, %p, %u, %p, %u, %p, %08x\n", handle, input, input_len, padding, iv, iv_len,
+           output, output_len, ret_len, flags );
+
+    if (!key || key->hdr.magic != MAGIC_KEY) return STATUS_INVALID_HANDLE;
+    if (!ret_len) return STATUS_INVALID_PARAMETER;
+    if (flags & ~BCRYPT_BLOCK_PADDING)
+    {
+        FIXME( "flags %08x not supported\n", flags );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    if (key->mode != MODE_ID_GCM && iv && iv_len != AES_BLOCK_SIZE) return STATUS_INVALID_PARAMETER;
+
+    if (key->mode == MODE_ID_GCM)
+    {
+        if (flags & BCRYPT_BLOCK_PADDING) return STATUS_INVALID_PARAMETER;
+        *ret_len = input_len;
+        if (!output) return STATUS_SUCCESS;
+        if (output_len < input_len) return STATUS_BUFFER_TOO_SMALL;
+        if ((status = key_init( key ))) return status;
+        return key_crypt_gcm( key, input, input_len, padding, output, FALSE );
+    }
+
+    if (input_len % AES_BLOCK_SIZE) return STATUS_INVALID_BUFFER_SIZE;
+    if ((flags & BCRYPT_BLOCK_PADDING) && !input_len) return STATUS_INVALID_BUFFER_SIZE;
+
+    /* the padding size is only known once the last block is decrypted */
+    size = (flags & BCRYPT_BLOCK_PADDING) ? input_len - AES_BLOCK_SIZE : input_len;
+    if (!output)
+    {
+        *ret_len = input_len;
+        return STATUS_SUCCESS;
+    }
+    if (output_len < size)
+    {
+        *ret_len = input_len;
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    if ((status = key_init( key ))) return status;
+    if (input_len) memcpy( next_iv, input + input_len - AES_BLOCK_SIZE, AES_BLOCK_SIZE );
+    /* the last block chains on the ciphertext before it, which is overwritten when decrypting in place */
+    if (size && size < input_len) memcpy( last_iv, input + size - AES_BLOCK_SIZE, AES_BLOCK_SIZE );
+
+    if (size)
+    {
+        memmove( output, input, size );
+        if ((status = key_crypt_blocks( key, key->mode == MODE_ID_CBC ? iv : NULL, output, size, FALSE )))
+            return status;
+    }
+
+    if (flags & BCRYPT_BLOCK_PADDING)
+    {
+        UCHAR *chain_iv = (key->mode == MODE_ID_CBC) ? (size ? last_iv : iv) : NULL;
+
+        memcpy( last, input + size, AES_BLOCK_SIZE );
+        if ((status = key_crypt_blocks( key, chain_iv, last, AES_BLOCK_SIZE, FALSE )))
+            return status;
+
+        pad = last[AES_BLOCK_SIZE - 1];
+        if (!pad || pad > AES_BLOCK_SIZE) return STATUS_UNSUCCESSFUL;
+        for (i = AES_BLOCK_SIZE - pad; i < AES_BLOCK_SIZE; i++)
+            if (last[i] != pad) return STATUS_UNSUCCESSFUL;
+
+        if (output_len < size + AES_BLOCK_SIZE - pad)
+        {
+            *ret_len = size + AES_BLOCK_SIZE - pad;
+            return STATUS_BUFFER_TOO_SMALL;
+        }
+        memcpy( output + size, last, AES_BLOCK_SIZE - pad );
+        size += AES_BLOCK_SIZE - pad;
+    }
+
+    if (iv && key->mode == MODE_ID_CBC && input_len) memcpy( iv, next_iv, AES_BLOCK_SIZE );
+    *ret_len = size;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS set_ulong( UCHAR *buf, ULONG size, ULONG *ret_size, ULONG value )
+{
+    *ret_size = sizeof(ULONG);
+    if (!buf) return STATUS_SUCCESS;
+    if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+    memcpy( buf, &value, sizeof(value) );
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS set_string( UCHAR *buf, ULONG size, ULONG *ret_size, const WCHAR *value )
+{
+    *ret_size = (strlenW( value ) + 1) * sizeof(WCHAR);
+    if (!buf) return STATUS_SUCCESS;
+    if (size < *ret_size) return STATUS_BUFFER_TOO_SMALL;
+    memcpy( buf, value, *ret_size );
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS get_alg_property( enum alg_id id, enum mode_id mode, const WCHAR *prop,
+                                  UCHAR *buf, ULONG size, ULONG *ret_size )
+{
+    if (!strcmpW( prop, BCRYPT_OBJECT_LENGTH ))
+    {
+        if (!alg_props[id].object_length) return STATUS_NOT_SUPPORTED;
+        return set_ulong( buf, size, ret_size, alg_props[id].object_length );
+    }
+    if (!strcmpW( prop, BCRYPT_HASH_LENGTH ))
+    {
+        if (!alg_props[id].hash_length) return STATUS_NOT_SUPPORTED;
+        return set_ulong( buf, size, ret_size, alg_props[id].hash_length );
+    }
+    if (!strcmpW( prop, BCRYPT_BLOCK_LENGTH ))
+    {
+        if (!alg_props[id].block_length) return STATUS_NOT_SUPPORTED;
+        return set_ulong( buf, size, ret_size, alg_props[id].block_length );
+    }
+    if (!strcmpW( prop, BCRYPT_ALGORITHM_NAME ))
+        return set_string( buf, size, ret_size, alg_props[id].name );
+    if (!strcmpW( prop, BCRYPT_CHAINING_MODE ))
+    {
+        if (id != ALG_ID_AES) return STATUS_NOT_SUPPORTED;
+        return set_string( buf, size, ret_size, mode_names[mode] );
+    }
+    if (!strcmpW( prop, BCRYPT_AUTH_TAG_LENGTH ))
+    {
+        BCRYPT_AUTH_TAG_LENGTHS_STRUCT tag_length = {12, 16, 1};
+
+        if (id != ALG_ID_AES || mode != MODE_ID_GCM) return STATUS_NOT_SUPPORTED;
+        *ret_size = sizeof(tag_length);
+        if (!buf) return STATUS_SUCCESS;
+        if (size < sizeof(tag_length)) return STATUS_BUFFER_TOO_SMALL;
+        memcpy( buf, &tag_length, sizeof(tag_length) );
+        return STATUS_SUCCESS;
+    }
+
+    FIXME( "unsupported property %s\n", debugstr_w(prop) );
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+NTSTATUS WINAPI BCryptGetProperty( BCRYPT_HANDLE handle, LPCWSTR prop, UCHAR *buffer, ULONG count, ULONG *res, ULONG flags )
+{
+    struct object *object = handle;
+
+    TRACE( "%p, %s, %p, %u, %p, %08x\n", handle, debugstr_w(prop), buffer, count, res, flags );
+
+    if (!object) return STATUS_INVALID_HANDLE;
+    if (!prop || !res) return STATUS_INVALID_PARAMETER;
+
+    switch (object->magic)
+    {
+    case MAGIC_ALG:
+    {
+        const struct algorithm *alg = (const struct algorithm *)object;
+        return get_alg_property( alg->id, alg->mode, prop, buffer, count, res );
+    }
+    case MAGIC_HASH:
+    {
+        const struct hash *hash = (const struct hash *)object;
+        return get_alg_property( hash->alg_id, MODE_ID_NA, prop, buffer, count, res );
+    }
+    case MAGIC_KEY:
+    {
+        const struct key *key = (const struct key *)object;
+        return get_alg_property( key->alg_id, key->mode, prop, buffer, count, res );
+    }
+    default:
+        WARN( "unknown magic %08x\n", object->magic );
+        return STATUS_INVALID_HANDLE;
+    }
+}
+
+static NTSTATUS set_chaining_mode( enum alg_id id, enum mode_id *mode, const WCHAR *value )
+{
+    enum mode_id i;
+
+    if (id != ALG_ID_AES) return STATUS_NOT_SUPPORTED;
+    for (i = MODE_ID_CBC; i < sizeof(mode_names) / sizeof(mode_names[0]); i++)
+    {
+        if (!strcmpW( value, mode_names[i] ))
+        {
+            *mode = i;
+            return STATUS_SUCCESS;
+        }
+    }
+
+    FIXME( "unsupported mode %s\n", debugstr_w(value) );
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS WINAPI BCryptSetProperty( BCRYPT_HANDLE handle, LPCWSTR prop, UCHAR *value, ULONG size, ULONG flags )
+{
+    struct object *object = handle;
+
+    TRACE( "%p, %s, %p, %u, %08x\n", handle, debugstr_w(prop), value, size, flags );
+
+    if (!object) return STATUS_INVALID_HANDLE;
+    if (!prop || !value) return STATUS_INVALID_PARAMETER;
+
+    if (strcmpW( prop, BCRYPT_CHAINING_MODE ))
+    {
+        FIXME( "unsupported property %s\n", debugstr_w(prop) );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    switch (object->magic)
+    {
+    case MAGIC_ALG:
+    {
+        struct algorithm *alg = (struct algorithm *)object;
+        return set_chaining_mode( alg->id, &alg->mode, (const WCHAR *)value );
+    }
+    case MAGIC_KEY:
+    {
+        struct key *key = (struct key *)object;
+        enum mode_id mode = key->mode;
+        NTSTATUS status;
+
+        if ((status = set_chaining_mode( key->alg_id, &mode, (const WCHAR *)value ))) return status;
+#ifdef SONAME_LIBGNUTLS
+        /* the GnuTLS cipher depends on the mode and is recreated on next use */
+        if (mode != key->mode && key->handle)
+        {
+            pgnutls_cipher_deinit( key->handle );
+            key->handle = NULL;
+        }
+#endif
+        key->mode = mode;
+        return STATUS_SUCCESS;
+    }
+    default:
+        FIXME( "unsupported object %p\n", object );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+}
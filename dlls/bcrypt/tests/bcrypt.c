@@ -0,0 +1,418 @@
+/*
+ * Unit tests for bcrypt functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdio.h>
+#include <ntstatus.h>
+#define WIN32_NO_STATUS
+#include <windows.h>
+#include <bcrypt.h>
+
+#include "wine/test.h"
+
+static NTSTATUS (WINAPI *pBCryptCloseAlgorithmProvider)(BCRYPT_ALG_HANDLE, ULONG);
+static NTSTATUS (WINAPI *pBCryptCreateHash)(BCRYPT_ALG_HANDLE, BCRYPT_HASH_HANDLE *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptDecrypt)(BCRYPT_KEY_HANDLE, PUCHAR, ULONG, VOID *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG *, ULONG);
+static NTSTATUS (WINAPI *pBCryptDestroyHash)(BCRYPT_HASH_HANDLE);
+static NTSTATUS (WINAPI *pBCryptDestroyKey)(BCRYPT_KEY_HANDLE);
+static NTSTATUS (WINAPI *pBCryptDuplicateHash)(BCRYPT_HASH_HANDLE, BCRYPT_HASH_HANDLE *, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptEncrypt)(BCRYPT_KEY_HANDLE, PUCHAR, ULONG, VOID *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG *, ULONG);
+static NTSTATUS (WINAPI *pBCryptFinishHash)(BCRYPT_HASH_HANDLE, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptGenerateSymmetricKey)(BCRYPT_ALG_HANDLE, BCRYPT_KEY_HANDLE *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptGenRandom)(BCRYPT_ALG_HANDLE, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptGetProperty)(BCRYPT_HANDLE, LPCWSTR, PUCHAR, ULONG, ULONG *, ULONG);
+static NTSTATUS (WINAPI *pBCryptHashData)(BCRYPT_HASH_HANDLE, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptOpenAlgorithmProvider)(BCRYPT_ALG_HANDLE *, LPCWSTR, LPCWSTR, ULONG);
+static NTSTATUS (WINAPI *pBCryptSetProperty)(BCRYPT_HANDLE, LPCWSTR, PUCHAR, ULONG, ULONG);
+
+static void format_hash(const UCHAR *bytes, ULONG size, char *buf)
+{
+    ULONG i;
+    buf[0] = 0;
+    for (i = 0; i < size; i++)
+        sprintf(buf + i * 2, "%02x", bytes[i]);
+}
+
+static void test_BCryptGenRandom(void)
+{
+    NTSTATUS ret;
+    UCHAR buffer[16];
+
+    ret = pBCryptGenRandom(NULL, NULL, 0, 0);
+    ok(ret == STATUS_INVALID_HANDLE, "Expected STATUS_INVALID_HANDLE, got 0x%x\n", ret);
+    ret = pBCryptGenRandom(NULL, buffer, 0, 0);
+    ok(ret == STATUS_INVALID_HANDLE, "Expected STATUS_INVALID_HANDLE, got 0x%x\n", ret);
+
+    memset(buffer, 0, sizeof(buffer));
+    ret = pBCryptGenRandom(NULL, buffer, sizeof(buffer), BCRYPT_USE_SYSTEM_PREFERRED_RNG);
+    ok(ret == STATUS_SUCCESS, "Expected success, got 0x%x\n", ret);
+    ok(memcmp(buffer, buffer + 8, 8), "Expected a random number, got 0\n");
+}
+
+static void test_hash(const WCHAR *alg_name, ULONG hash_len, const char *expected)
+{
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_HASH_HANDLE hash, hash2;
+    UCHAR buf[64];
+    char str[129];
+    ULONG len, size;
+    NTSTATUS ret;
+
+    alg = NULL;
+    ret = pBCryptOpenAlgorithmProvider(&alg, alg_name, MS_PRIMITIVE_PROVIDER, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(alg != NULL, "alg not set\n");
+
+    len = size = 0xdeadbeef;
+    ret = pBCryptGetProperty(alg, BCRYPT_OBJECT_LENGTH, (UCHAR *)&len, sizeof(len), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(len), "got %u\n", size);
+
+    len = size = 0xdeadbeef;
+    ret = pBCryptGetProperty(alg, BCRYPT_HASH_LENGTH, (UCHAR *)&len, sizeof(len), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(len == hash_len, "got %u\n", len);
+
+    hash = NULL;
+    ret = pBCryptCreateHash(alg, &hash, NULL, 0, NULL, 0, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(hash != NULL, "hash not set\n");
+
+    ret = pBCryptHashData(hash, (UCHAR *)"te", 2, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    hash2 = NULL;
+    ret = pBCryptDuplicateHash(hash, &hash2, NULL, 0, 0);
+    if (ret == STATUS_NOT_IMPLEMENTED) /* GnuTLS without gnutls_hash_copy */
+        skip("BCryptDuplicateHash not supported\n");
+    else
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    ret = pBCryptHashData(hash, (UCHAR *)"st", 2, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    ret = pBCryptFinishHash(hash, buf, hash_len - 1, 0);
+    ok(ret == STATUS_INVALID_PARAMETER, "got %08x\n", ret);
+
+    memset(buf, 0, sizeof(buf));
+    ret = pBCryptFinishHash(hash, buf, hash_len, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    format_hash(buf, hash_len, str);
+    ok(!strcmp(str, expected), "got %s\n", str);
+
+    if (hash2)
+    {
+        ret = pBCryptHashData(hash2, (UCHAR *)"st", 2, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        memset(buf, 0, sizeof(buf));
+        ret = pBCryptFinishHash(hash2, buf, hash_len, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        format_hash(buf, hash_len, str);
+        ok(!strcmp(str, expected), "got %s\n", str);
+        ret = pBCryptDestroyHash(hash2);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    }
+
+    ret = pBCryptDestroyHash(hash);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    /* reusable hashes are reset by BCryptFinishHash */
+    hash = NULL;
+    ret = pBCryptCreateHash(alg, &hash, NULL, 0, NULL, 0, BCRYPT_HASH_REUSABLE_FLAG);
+    if (ret == STATUS_INVALID_PARAMETER)
+    {
+        win_skip("BCRYPT_HASH_REUSABLE_FLAG not supported\n");
+    }
+    else
+    {
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        ret = pBCryptHashData(hash, (UCHAR *)"junk", 4, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        ret = pBCryptFinishHash(hash, buf, hash_len, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+        ret = pBCryptHashData(hash, (UCHAR *)"test", 4, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        memset(buf, 0, sizeof(buf));
+        ret = pBCryptFinishHash(hash, buf, hash_len, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        format_hash(buf, hash_len, str);
+        ok(!strcmp(str, expected), "got %s\n", str);
+
+        ret = pBCryptDestroyHash(hash);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    }
+
+    ret = pBCryptCloseAlgorithmProvider(alg, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+}
+
+static void test_hashes(void)
+{
+    test_hash(BCRYPT_MD5_ALGORITHM, 16, "098f6bcd4621d373cade4e832627b4f6");
+    test_hash(BCRYPT_SHA1_ALGORITHM, 20, "a94a8fe5ccb19ba61c4c0873d391e987982fbbd3");
+    test_hash(BCRYPT_SHA256_ALGORITHM, 32,
+              "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08");
+    test_hash(BCRYPT_SHA384_ALGORITHM, 48,
+              "768412320f7b0aa5812fce428dc4706b3cae50e02a64caa16a782249bfe8efc4"
+              "b7ef1ccb126255d196047dfedf17a0a9");
+    test_hash(BCRYPT_SHA512_ALGORITHM, 64,
+              "ee26b0dd4af7e749aa1a8ee3c10ae9923f618980772e473f8819a5d4940e0db2"
+              "7ac185f8a0e1d5f84f88bc887fd67b143732c304cc5fa9ad8e6f57f50028a8ff");
+}
+
+static void test_aes(void)
+{
+    static UCHAR secret[] =
+        {0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c};
+    static UCHAR data[] =
+        {0x6b,0xc1,0xbe,0xe2,0x2e,0x40,0x9f,0x96,0xe9,0x3d,0x7e,0x11,0x73,0x93,0x17,0x2a};
+    static const UCHAR iv_init[] =
+        {0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f};
+    static const UCHAR expected_cbc[] =
+        {0x76,0x49,0xab,0xac,0x81,0x19,0xb2,0x46,0xce,0xe9,0x8e,0x9b,0x12,0xe9,0x19,0x7d,
+         0x89,0x64,0xe0,0xb1,0x49,0xc1,0x0b,0x7b,0x68,0x2e,0x6e,0x39,0xaa,0xeb,0x73,0x1c};
+    static const UCHAR expected_ecb[] =
+        {0x3a,0xd7,0x7b,0xb4,0x0d,0x7a,0x36,0x60,0xa8,0x9e,0xca,0xf3,0x24,0x66,0xef,0x97};
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_KEY_HANDLE key;
+    UCHAR iv[16], ciphertext[48], plaintext[48];
+    WCHAR mode[32];
+    ULONG size, len;
+    NTSTATUS ret;
+
+    alg = NULL;
+    ret = pBCryptOpenAlgorithmProvider(&alg, BCRYPT_AES_ALGORITHM, NULL, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    size = 0;
+    ret = pBCryptGetProperty(alg, BCRYPT_CHAINING_MODE, (UCHAR *)mode, sizeof(mode), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(!lstrcmpW(mode, BCRYPT_CHAIN_MODE_CBC), "got %s\n", wine_dbgstr_w(mode));
+
+    len = 0;
+    ret = pBCryptGetProperty(alg, BCRYPT_BLOCK_LENGTH, (UCHAR *)&len, sizeof(len), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(len == 16, "got %u\n", len);
+
+    key = NULL;
+    ret = pBCryptGenerateSymmetricKey(alg, &key, NULL, 0, secret, sizeof(secret), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(key != NULL, "key not set\n");
+
+    /* CBC without padding */
+    memcpy(iv, iv_init, sizeof(iv));
+    size = 0;
+    memset(ciphertext, 0, sizeof(ciphertext));
+    ret = pBCryptEncrypt(key, data, 16, NULL, iv, 16, ciphertext, sizeof(ciphertext), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == 16, "got %u\n", size);
+    ok(!memcmp(ciphertext, expected_cbc, 16), "wrong data\n");
+    ok(!memcmp(iv, expected_cbc, 16), "iv not updated\n");
+
+    ret = pBCryptEncrypt(key, data, 15, NULL, iv, 16, ciphertext, sizeof(ciphertext), &size, 0);
+    ok(ret == STATUS_INVALID_BUFFER_SIZE, "got %08x\n", ret);
+
+    /* CBC with padding */
+    memcpy(iv, iv_init, sizeof(iv));
+    size = 0;
+    ret = pBCryptEncrypt(key, data, 16, NULL, iv, 16, NULL, 0, &size, BCRYPT_BLOCK_PADDING);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == 32, "got %u\n", size);
+
+    size = 0;
+    memset(ciphertext, 0, sizeof(ciphertext));
+    ret = pBCryptEncrypt(key, data, 16, NULL, iv, 16, ciphertext, sizeof(ciphertext), &size, BCRYPT_BLOCK_PADDING);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == 32, "got %u\n", size);
+    ok(!memcmp(ciphertext, expected_cbc, sizeof(expected_cbc)), "wrong data\n");
+
+    memcpy(iv, iv_init, sizeof(iv));
+    size = 0;
+    memset(plaintext, 0, sizeof(plaintext));
+    ret = pBCryptDecrypt(key, ciphertext, 32, NULL, iv, 16, plaintext, sizeof(plaintext), &size, BCRYPT_BLOCK_PADDING);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == 16, "got %u\n", size);
+    ok(!memcmp(plaintext, data, sizeof(data)), "wrong data\n");
+
+    memcpy(iv, iv_init, sizeof(iv));
+    size = 0;
+    memset(plaintext, 0, sizeof(plaintext));
+    ret = pBCryptDecrypt(key, ciphertext, 32, NULL, iv, 16, plaintext, sizeof(plaintext), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == 32, "got %u\n", size);
+    ok(!memcmp(plaintext, data, sizeof(data)), "wrong data\n");
+    ok(plaintext[16] == 16 && plaintext[31] == 16, "wrong padding\n");
+
+    /* CBC with padding, decrypting in place */
+    memcpy(plaintext, data, sizeof(data));
+    memcpy(plaintext + sizeof(data), data, sizeof(data));
+    memcpy(iv, iv_init, sizeof(iv));
+    size = 0;
+    memset(ciphertext, 0, sizeof(ciphertext));
+    ret = pBCryptEncrypt(key, plaintext, 32, NULL, iv, 16, ciphertext, sizeof(ciphertext), &size, BCRYPT_BLOCK_PADDING);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == 48, "got %u\n", size);
+
+    memcpy(iv, iv_init, sizeof(iv));
+    size = 0;
+    ret = pBCryptDecrypt(key, ciphertext, 48, NULL, iv, 16, ciphertext, sizeof(ciphertext), &size, BCRYPT_BLOCK_PADDING);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == 32, "got %u\n", size);
+    ok(!memcmp(ciphertext, plaintext, 32), "wrong data\n");
+
+    ret = pBCryptDestroyKey(key);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    /* ECB */
+    ret = pBCryptSetProperty(alg, BCRYPT_CHAINING_MODE, (UCHAR *)BCRYPT_CHAIN_MODE_ECB,
+                             sizeof(BCRYPT_CHAIN_MODE_ECB), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    key = NULL;
+    ret = pBCryptGenerateSymmetricKey(alg, &key, NULL, 0, secret, sizeof(secret), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    size = 0;
+    memset(ciphertext, 0, sizeof(ciphertext));
+    ret = pBCryptEncrypt(key, data, 16, NULL, NULL, 0, ciphertext, sizeof(ciphertext), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == 16, "got %u\n", size);
+    ok(!memcmp(ciphertext, expected_ecb, sizeof(expected_ecb)), "wrong data\n");
+
+    size = 0;
+    memset(plaintext, 0, sizeof(plaintext));
+    ret = pBCryptDecrypt(key, ciphertext, 16, NULL, NULL, 0, plaintext, sizeof(plaintext), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == 16, "got %u\n", size);
+    ok(!memcmp(plaintext, data, sizeof(data)), "wrong data\n");
+
+    ret = pBCryptDestroyKey(key);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    ret = pBCryptCloseAlgorithmProvider(alg, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+}
+
+static void test_aes_gcm(void)
+{
+    static UCHAR secret[16];
+    static UCHAR nonce[12];
+    static UCHAR data[16];
+    static const UCHAR expected[] =
+        {0x03,0x88,0xda,0xce,0x60,0xb6,0xa3,0x92,0xf3,0x28,0xc2,0xb9,0x71,0xb2,0xfe,0x78};
+    static const UCHAR expected_tag[] =
+        {0xab,0x6e,0x47,0xd4,0x2c,0xec,0x13,0xbd,0xf5,0x3a,0x67,0xb2,0x12,0x57,0xbd,0xdf};
+    BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO auth_info;
+    BCRYPT_AUTH_TAG_LENGTHS_STRUCT tag_length;
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_KEY_HANDLE key;
+    UCHAR ciphertext[16], plaintext[16], tag[16];
+    ULONG size;
+    NTSTATUS ret;
+
+    alg = NULL;
+    ret = pBCryptOpenAlgorithmProvider(&alg, BCRYPT_AES_ALGORITHM, NULL, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    ret = pBCryptSetProperty(alg, BCRYPT_CHAINING_MODE, (UCHAR *)BCRYPT_CHAIN_MODE_GCM,
+                             sizeof(BCRYPT_CHAIN_MODE_GCM), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    size = 0;
+    ret = pBCryptGetProperty(alg, BCRYPT_AUTH_TAG_LENGTH, (UCHAR *)&tag_length, sizeof(tag_length), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(tag_length), "got %u\n", size);
+    ok(tag_length.dwMinLength == 12 && tag_length.dwMaxLength == 16, "got %u-%u\n",
+       tag_length.dwMinLength, tag_length.dwMaxLength);
+
+    key = NULL;
+    ret = pBCryptGenerateSymmetricKey(alg, &key, NULL, 0, secret, sizeof(secret), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    BCRYPT_INIT_AUTH_MODE_INFO(auth_info);
+    auth_info.pbNonce = nonce;
+    auth_info.cbNonce = sizeof(nonce);
+    auth_info.pbTag   = tag;
+    auth_info.cbTag   = sizeof(tag);
+
+    size = 0;
+    memset(tag, 0, sizeof(tag));
+    ret = pBCryptEncrypt(key, data, sizeof(data), &auth_info, NULL, 0, ciphertext, sizeof(ciphertext), &size, 0);
+    if (ret == STATUS_NOT_SUPPORTED)
+    {
+        skip("AES-GCM not supported\n");
+        pBCryptDestroyKey(key);
+        pBCryptCloseAlgorithmProvider(alg, 0);
+        return;
+    }
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(data), "got %u\n", size);
+    ok(!memcmp(ciphertext, expected, sizeof(expected)), "wrong data\n");
+    ok(!memcmp(tag, expected_tag, sizeof(expected_tag)), "wrong tag\n");
+
+    size = 0;
+    ret = pBCryptDecrypt(key, ciphertext, sizeof(ciphertext), &auth_info, NULL, 0, plaintext, sizeof(plaintext), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(!memcmp(plaintext, data, sizeof(data)), "wrong data\n");
+
+    tag[0] ^= 1;
+    ret = pBCryptDecrypt(key, ciphertext, sizeof(ciphertext), &auth_info, NULL, 0, plaintext, sizeof(plaintext), &size, 0);
+    ok(ret == STATUS_AUTH_TAG_MISMATCH, "got %08x\n", ret);
+
+    ret = pBCryptDestroyKey(key);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    ret = pBCryptCloseAlgorithmProvider(alg, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+}
+
+START_TEST(bcrypt)
+{
+    HMODULE module;
+
+    module = LoadLibraryA("bcrypt.dll");
+    if (!module)
+    {
+        win_skip("bcrypt.dll not found\n");
+        return;
+    }
+
+#define LOAD_FUNCPTR(f) p##f = (void *)GetProcAddress(module, #f)
+    LOAD_FUNCPTR(BCryptCloseAlgorithmProvider);
+    LOAD_FUNCPTR(BCryptCreateHash);
+    LOAD_FUNCPTR(BCryptDecrypt);
+    LOAD_FUNCPTR(BCryptDestroyHash);
+    LOAD_FUNCPTR(BCryptDestroyKey);
+    LOAD_FUNCPTR(BCryptDuplicateHash);
+    LOAD_FUNCPTR(BCryptEncrypt);
+    LOAD_FUNCPTR(BCryptFinishHash);
+    LOAD_FUNCPTR(BCryptGenerateSymmetricKey);
+    LOAD_FUNCPTR(BCryptGenRandom);
+    LOAD_FUNCPTR(BCryptGetProperty);
+    LOAD_FUNCPTR(BCryptHashData);
+    LOAD_FUNCPTR(BCryptOpenAlgorithmProvider);
+    LOAD_FUNCPTR(BCryptSetProperty);
+#undef LOAD_FUNCPTR
+
+    test_BCryptGenRandom();
+    test_hashes();
+    test_aes();
+    test_aes_gcm();
+
+    FreeLibrary(module);
+}
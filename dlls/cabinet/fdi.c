@@ -134,6 +134,9 @@ typedef struct
  * for now.  This implementation has significant semantic differences anyhow.
  */
 
+/* size of the chunks the CFDATA blocks are read from the cabinet in */
+#define FDI_READAHEAD 0x10000
+
 typedef struct fdi_cds_fwd {
   FDI_Int *fdi;                    /* the hfdi we are using                 */
   INT_PTR filehf, cabhf;           /* file handle we are using              */
@@ -161,6 +164,8 @@ typedef struct fdi_cds_fwd {
   struct fdi_folder *firstfol; 
   struct fdi_file   *firstfile;
   struct fdi_cds_fwd *next;
+  cab_ULONG readpos, readlen;      /* position and fill of readbuf          */
+  cab_UBYTE readbuf[FDI_READAHEAD]; /* read-ahead of the CFDATA blocks      */
 } fdi_decomp_state;
 
 #define ZIPNEEDBITS(n) {while(k<(n)){cab_LONG c=*(ZIP(inpos)++);\
@@ -184,6 +189,26 @@ typedef struct fdi_cds_fwd {
 #define DECR_OUTPUT       (6)
 #define DECR_USERABORT    (7)
 
+/* copy a match of len bytes from src to dest within a decompression window.
+ * Matches closer than their length repeat the bytes between src and dest,
+ * so those are copied period by period, doubling the period each time. */
+static inline void fdi_copy_run(cab_UBYTE *dest, const cab_UBYTE *src, cab_ULONG len)
+{
+  cab_ULONG dist;
+
+  if (src > dest || (dist = dest - src) >= len) {
+    memmove(dest, src, len);
+    return;
+  }
+  while (len > dist) {
+    memcpy(dest, src, dist);
+    dest += dist;
+    len -= dist;
+    dist <<= 1;
+  }
+  memcpy(dest, src, len);
+}
+
 static void set_error( FDI_Int *fdi, int oper, int err )
 {
     fdi->perf->erfOper = oper;
@@ -1171,11 +1196,12 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
         d &= ZIPWSIZE - 1;
         e = ZIPWSIZE - max(d, w);
         e = min(e, n);
+        if (!e)
+          return 1;
         n -= e;
-        do
-        {
-          CAB(outbuf)[w++] = CAB(outbuf)[d++];
-        } while (--e);
+        fdi_copy_run(CAB(outbuf) + w, CAB(outbuf) + d, e);
+        w += e;
+        d += e;
       } while (n);
     }
   }
@@ -1218,13 +1244,21 @@ static cab_LONG fdi_Zipinflate_stored(fdi_decomp_state *decomp_state)
     return 1;                   /* error in compressed data */
   ZIPDUMPBITS(16)
 
-  /* read and output the compressed data */
-  while(n--)
+  if (w + n > ZIPWSIZE)
+    return 1;
+
+  /* read and output the compressed data, draining the bit buffer first */
+  while(n && k)
   {
-    ZIPNEEDBITS(8)
     CAB(outbuf)[w++] = (cab_UBYTE)b;
     ZIPDUMPBITS(8)
+    n--;
   }
+  if (ZIP(inpos) + n > CAB(inbuf) + sizeof(CAB(inbuf)))
+    return 1;
+  memcpy(CAB(outbuf) + w, ZIP(inpos), n);
+  ZIP(inpos) += n;
+  w += n;
 
   /* restore the globals from the locals */
   ZIP(window_posn) = w;              /* restore global window pointer */
@@ -1578,14 +1612,15 @@ static int QTMfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
         if (copy_length < match_length) {
           match_length -= copy_length;
           window_posn += copy_length;
-          while (copy_length-- > 0) *rundest++ = *runsrc++;
+          fdi_copy_run(rundest, runsrc, copy_length);
+          rundest += copy_length;
           runsrc = window;
         }
       }
       window_posn += match_length;
 
       /* copy match data - no worries about destination wraps */
-      while (match_length-- > 0) *rundest++ = *runsrc++;
+      fdi_copy_run(rundest, runsrc, match_length);
     }
   } /* while (togo > 0) */
 
@@ -1816,14 +1851,15 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
               if (copy_length < match_length) {
                 match_length -= copy_length;
                 window_posn += copy_length;
-                while (copy_length-- > 0) *rundest++ = *runsrc++;
+                fdi_copy_run(rundest, runsrc, copy_length);
+                rundest += copy_length;
                 runsrc = window;
               }
             }
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            fdi_copy_run(rundest, runsrc, match_length);
           }
         }
         break;
@@ -1905,14 +1941,15 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
               if (copy_length < match_length) {
                 match_length -= copy_length;
                 window_posn += copy_length;
-                while (copy_length-- > 0) *rundest++ = *runsrc++;
+                fdi_copy_run(rundest, runsrc, copy_length);
+                rundest += copy_length;
                 runsrc = window;
               }
             }
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            fdi_copy_run(rundest, runsrc, match_length);
           }
         }
         break;
@@ -1983,6 +2020,49 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
  * is also where we jump to additional cabinets in the case of split
  * cab's, and provide (some of) the NEXT_CABINET notification semantics.
  */
+/*******************************************************************
+ * fdi_read_blocks (internal)
+ *
+ * Reads len bytes of CFDATA from the cabinet into buf, or skips them if buf
+ * is NULL.  The data is read ahead in FDI_READAHEAD sized chunks, so that
+ * the block headers and their data don't each cost a call to the read
+ * callback; seeking the cabinet must be paired with fdi_reset_blocks.
+ */
+static BOOL fdi_read_blocks(fdi_decomp_state *cab, void *buf, cab_ULONG len)
+{
+  cab_UBYTE *out = buf;
+  cab_ULONG avail;
+  UINT got;
+
+  while (len) {
+    if (cab->readpos == cab->readlen) {
+      /* large reads go straight to the caller's buffer */
+      if (out && len >= FDI_READAHEAD)
+        return cab->fdi->read(cab->cabhf, out, len) == len;
+
+      got = cab->fdi->read(cab->cabhf, cab->readbuf, FDI_READAHEAD);
+      if (!got || got == (UINT)-1 || got > FDI_READAHEAD)
+        return FALSE;
+      cab->readpos = 0;
+      cab->readlen = got;
+    }
+
+    avail = min(len, cab->readlen - cab->readpos);
+    if (out) {
+      memcpy(out, cab->readbuf + cab->readpos, avail);
+      out += avail;
+    }
+    cab->readpos += avail;
+    len -= avail;
+  }
+  return TRUE;
+}
+
+static inline void fdi_reset_blocks(fdi_decomp_state *cab)
+{
+  cab->readpos = cab->readlen = 0;
+}
+
 static int fdi_decomp(const struct fdi_file *fi, int savemode, fdi_decomp_state *decomp_state,
   char *pszCabPath, PFNFDINOTIFY pfnfdin, void *pvUser)
 {
@@ -2014,10 +2094,10 @@ static int fdi_decomp(const struct fdi_file *fi, int savemode, fdi_decomp_state
     inlen = outlen = 0;
     while (outlen == 0) {
       /* read the block header, skip the reserved part */
-      if (CAB(fdi)->read(cab->cabhf, buf, cfdata_SIZEOF) != cfdata_SIZEOF)
+      if (!fdi_read_blocks(cab, buf, cfdata_SIZEOF))
         return DECR_INPUT;
 
-      if (CAB(fdi)->seek(cab->cabhf, cab->mii.block_resv, SEEK_CUR) == -1)
+      if (!fdi_read_blocks(cab, NULL, cab->mii.block_resv))
         return DECR_INPUT;
 
       /* we shouldn't get blocks over CAB_INPUTMAX in size */
@@ -2025,7 +2105,7 @@ static int fdi_decomp(const struct fdi_file *fi, int savemode, fdi_decomp_state
       len = EndGetI16(buf+cfdata_CompressedSize);
       inlen += len;
       if (inlen > CAB_INPUTMAX) return DECR_INPUT;
-      if (CAB(fdi)->read(cab->cabhf, data, len) != len)
+      if (!fdi_read_blocks(cab, data, len))
         return DECR_INPUT;
 
       /* clear two bytes after read-in data */
@@ -2229,6 +2309,7 @@ static int fdi_decomp(const struct fdi_file *fi, int savemode, fdi_decomp_state
               success = TRUE;
               if (CAB(fdi)->seek(cab->cabhf, cab->firstfol->offset, SEEK_SET) == -1)
                 return DECR_INPUT;
+              fdi_reset_blocks(cab);
               break;
             }
           }
@@ -2745,6 +2826,7 @@ BOOL __cdecl FDICopy(
 
         CAB(decomp_cab) = NULL;
         CAB(fdi)->seek(CAB(cabhf), fol->offset, SEEK_SET);
+        fdi_reset_blocks(decomp_state);
         CAB(offset) = 0;
         CAB(outlen) = 0;
 
@@ -650,6 +650,101 @@ static void test_FDICopy(void)
     DeleteFileA(name);
 }
 
+static INT_PTR __cdecl CopyDataNotify(FDINOTIFICATIONTYPE fdint, PFDINOTIFICATION pfdin)
+{
+    switch (fdint)
+    {
+    case fdintCOPY_FILE:
+        ok(!lstrcmpA(pfdin->psz1, "data.bin"), "Expected data.bin, got %s\n", pfdin->psz1);
+        return (INT_PTR)CreateFileA("extracted.bin", GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    case fdintCLOSE_FILE_INFO:
+        CloseHandle((HANDLE)pfdin->hf);
+        return TRUE;
+    default:
+        return 0;
+    }
+}
+
+static void test_FDICopy_data(void)
+{
+    static const DWORD size = 0x20000;
+    static CHAR data_bin[] = "data.bin";
+    CCAB cabParams;
+    HFDI hfdi;
+    HFCI hfci;
+    ERF erf;
+    BOOL ret;
+    HANDLE file;
+    BYTE *data, *extracted;
+    DWORD i, seed = 1, written, read = 0;
+    char name[] = "extract.cab";
+    char path[MAX_PATH + 1];
+
+    /* incompressible, run-length and short period data in separate blocks,
+     * so that stored blocks and overlapping matches are all decompressed */
+    data = HeapAlloc(GetProcessHeap(), 0, size);
+    extracted = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, size);
+    for (i = 0; i < size; i++)
+    {
+        switch ((i / 0x8000) % 3)
+        {
+        case 0:
+            seed = seed * 1103515245 + 12345;
+            data[i] = seed >> 16;
+            break;
+        case 1:
+            data[i] = 'x';
+            break;
+        default:
+            data[i] = "abcdefg"[i % 7];
+            break;
+        }
+    }
+
+    file = CreateFileA(data_bin, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to create %s\n", data_bin);
+    WriteFile(file, data, size, &written, NULL);
+    CloseHandle(file);
+
+    set_cab_parameters(&cabParams);
+
+    hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                     fci_read, fci_write, fci_close, fci_seek,
+                     fci_delete, get_temp_file, &cabParams, NULL);
+    ok(hfci != NULL, "Failed to create an FCI context\n");
+
+    add_file(hfci, data_bin);
+
+    ret = FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+    ok(ret, "Failed to flush the cabinet\n");
+
+    FCIDestroy(hfci);
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_open, fdi_read,
+                     fdi_write, fdi_close, fdi_seek,
+                     cpuUNKNOWN, &erf);
+
+    ret = FDICopy(hfdi, name, path, 0, CopyDataNotify, NULL, 0);
+    ok(ret == TRUE, "Expected TRUE, got %d\n", ret);
+
+    FDIDestroy(hfdi);
+
+    file = CreateFileA("extracted.bin", GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open extracted.bin\n");
+    ReadFile(file, extracted, size, &read, NULL);
+    CloseHandle(file);
+    ok(read == size, "Expected %u bytes, got %u\n", size, read);
+    ok(!memcmp(data, extracted, size), "Extracted data differs\n");
+
+    HeapFree(GetProcessHeap(), 0, data);
+    HeapFree(GetProcessHeap(), 0, extracted);
+    DeleteFileA("extracted.bin");
+    DeleteFileA(data_bin);
+    DeleteFileA(name);
+}
 
 START_TEST(fdi)
 {
@@ -657,4 +752,5 @@ START_TEST(fdi)
     test_FDIDestroy();
     test_FDIIsCabinet();
     test_FDICopy();
+    test_FDICopy_data();
 }
@@ -49,6 +49,11 @@ static BOOL CertContext_GetProperty(void *context, DWORD dwPropId,
 static BOOL CertContext_SetProperty(void *context, DWORD dwPropId,
  DWORD dwFlags, const void *pvData);
 
+/* Changed whenever a property used as an index key is set explicitly, so
+ * stores' indexes are rebuilt.
+ */
+static LONG cert_index_stamp;
+
 BOOL WINAPI CertAddEncodedCertificateToStore(HCERTSTORE hCertStore,
  DWORD dwCertEncodingType, const BYTE *pbCertEncoded, DWORD cbCertEncoded,
  DWORD dwAddDisposition, PCCERT_CONTEXT *ppCertContext)
@@ -656,6 +661,9 @@ BOOL WINAPI CertSetCertificateContextProperty(PCCERT_CONTEXT pCertContext,
     }
     ret = CertContext_SetProperty((void *)pCertContext, dwPropId, dwFlags,
      pvData);
+    if (dwPropId == CERT_SHA1_HASH_PROP_ID ||
+     dwPropId == CERT_KEY_IDENTIFIER_PROP_ID)
+        InterlockedIncrement(&cert_index_stamp);
     TRACE("returning %d\n", ret);
     return ret;
 }
@@ -1378,6 +1386,120 @@ static inline PCCERT_CONTEXT cert_compare_certs_in_store(HCERTSTORE store,
     return ret;
 }
 
+static DWORD cert_index_hash(const BYTE *data, DWORD size)
+{
+    DWORD hash = 2166136261u, i;
+
+    for (i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 16777619;
+    return hash;
+}
+
+static BOOL cert_get_index_hash(const void *context, ContextIndexKey key,
+ DWORD *hash)
+{
+    PCCERT_CONTEXT cert = context;
+    BYTE buf[64], *data = buf;
+    DWORD propId, size = sizeof(buf);
+    BOOL ret;
+
+    switch (key)
+    {
+    case IndexKeySubject:
+        *hash = cert_index_hash(cert->pCertInfo->Subject.pbData,
+         cert->pCertInfo->Subject.cbData);
+        return TRUE;
+    case IndexKeyKeyId:
+        propId = CERT_KEY_IDENTIFIER_PROP_ID;
+        break;
+    case IndexKeySha1Hash:
+        propId = CERT_SHA1_HASH_PROP_ID;
+        break;
+    default:
+        return FALSE;
+    }
+    ret = CertGetCertificateContextProperty(cert, propId, data, &size);
+    if (!ret && GetLastError() == ERROR_MORE_DATA)
+    {
+        data = CryptMemAlloc(size);
+        if (data)
+            ret = CertGetCertificateContextProperty(cert, propId, data, &size);
+    }
+    if (ret)
+        *hash = cert_index_hash(data, size);
+    if (data != buf)
+        CryptMemFree(data);
+    return ret;
+}
+
+struct cert_match_para
+{
+    CertCompareFunc compare;
+    DWORD           dwType;
+    DWORD           dwFlags;
+    const void     *pvPara;
+};
+
+static BOOL cert_match(const void *context, const void *para)
+{
+    const struct cert_match_para *match = para;
+
+    return match->compare(context, match->dwType, match->dwFlags,
+     match->pvPara);
+}
+
+/* Uses the store's index to find the next cert after prev matching compare,
+ * if the store has one and the search is by one of its keys.  Returns FALSE
+ * if the store must be enumerated instead.
+ */
+static BOOL cert_find_indexed(HCERTSTORE store, PCCERT_CONTEXT prev,
+ CertCompareFunc compare, DWORD dwType, DWORD dwFlags, const void *pvPara,
+ PCCERT_CONTEXT *found)
+{
+    WINECRYPT_CERTSTORE *hcs = store;
+    struct cert_match_para para = { compare, dwType, dwFlags, pvPara };
+    const CRYPT_DATA_BLOB *blob = NULL;
+    CONTEXT_QUERY query;
+
+    if (!hcs || hcs->dwMagic != WINE_CRYPTCERTSTORE_MAGIC ||
+     !hcs->certs.findContext)
+        return FALSE;
+    if (compare == compare_cert_by_sha1_hash)
+    {
+        query.key = IndexKeySha1Hash;
+        blob = pvPara;
+    }
+    else if (compare == compare_cert_by_name &&
+     (dwType & CERT_INFO_SUBJECT_FLAG))
+    {
+        query.key = IndexKeySubject;
+        blob = pvPara;
+    }
+    else if (compare == compare_cert_by_cert_id)
+    {
+        const CERT_ID *id = pvPara;
+
+        if (id->dwIdChoice == CERT_ID_KEY_IDENTIFIER)
+        {
+            query.key = IndexKeyKeyId;
+            blob = &id->u.KeyId;
+        }
+        else if (id->dwIdChoice == CERT_ID_SHA1_HASH)
+        {
+            query.key = IndexKeySha1Hash;
+            blob = &id->u.HashId;
+        }
+    }
+    if (!blob)
+        return FALSE;
+    query.hash = cert_index_hash(blob->pbData, blob->cbData);
+    query.stamp = cert_index_stamp;
+    query.getHash = cert_get_index_hash;
+    query.match = cert_match;
+    query.para = &para;
+    return hcs->certs.findContext(hcs, &query, (void *)prev, (void **)found);
+}
+
 typedef PCCERT_CONTEXT (*CertFindFunc)(HCERTSTORE store, DWORD dwType,
  DWORD dwFlags, const void *pvPara, PCCERT_CONTEXT prev);
 
@@ -1637,8 +1759,12 @@ PCCERT_CONTEXT WINAPI CertFindCertificateInStore(HCERTSTORE hCertStore,
     if (find)
         ret = find(hCertStore, dwFlags, dwType, pvPara, pPrevCertContext);
     else if (compare)
-        ret = cert_compare_certs_in_store(hCertStore, pPrevCertContext,
-         compare, dwType, dwFlags, pvPara);
+    {
+        if (!cert_find_indexed(hCertStore, pPrevCertContext, compare, dwType,
+         dwFlags, pvPara, &ret))
+            ret = cert_compare_certs_in_store(hCertStore, pPrevCertContext,
+             compare, dwType, dwFlags, pvPara);
+    }
     else
         ret = NULL;
     if (!ret)
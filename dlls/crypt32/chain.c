@@ -25,6 +25,7 @@
 #include "wincrypt.h"
 #include "wininet.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 #include "crypt32_private.h"
 
@@ -32,6 +33,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(crypt);
 WINE_DECLARE_DEBUG_CHANNEL(chain);
 
 #define DEFAULT_CYCLE_MODULUS 7
+#define DEFAULT_MAX_CACHED_CHAINS 64
 
 static HCERTCHAINENGINE CRYPT_defaultChainEngine;
 
@@ -49,8 +51,33 @@ typedef struct _CertificateChainEngine
     DWORD      dwUrlRetrievalTimeout;
     DWORD      MaximumCachedCertificates;
     DWORD      CycleDetectionModulus;
+    CRITICAL_SECTION cs;
+    struct list      cache;
+    DWORD            cCached;
 } CertificateChainEngine, *PCertificateChainEngine;
 
+/* Identifies the inputs a chain was built from:  the end cert's hash, the
+ * generation of the engine's world store, and the hashes of the certs in the
+ * additional store.
+ */
+typedef struct _CertificateChainCacheKey
+{
+    BYTE  hash[20];
+    DWORD generation;
+    DWORD cAdditional;
+    BYTE *additional;
+} CertificateChainCacheKey;
+
+/* A chain built with CERT_CHAIN_CACHE_END_CERT, as it was before revocation
+ * and usage checking.  Kept in most recently used order.
+ */
+typedef struct _CertificateChainCacheEntry
+{
+    struct list               entry;
+    CertificateChainCacheKey  key;
+    struct _CertificateChain *chain;
+} CertificateChainCacheEntry;
+
 static inline void CRYPT_AddStoresToCollection(HCERTSTORE collection,
  DWORD cStores, HCERTSTORE *stores)
 {
@@ -149,6 +176,10 @@ HCERTCHAINENGINE CRYPT_CreateChainEngine(HCERTSTORE root,
             engine->CycleDetectionModulus = pConfig->CycleDetectionModulus;
         else
             engine->CycleDetectionModulus = DEFAULT_CYCLE_MODULUS;
+        InitializeCriticalSection(&engine->cs);
+        engine->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": CertificateChainEngine.cs");
+        list_init(&engine->cache);
+        engine->cCached = 0;
     }
     return engine;
 }
@@ -214,6 +245,17 @@ VOID WINAPI CertFreeCertificateChainEngine(HCERTCHAINENGINE hChainEngine)
 
     if (engine && InterlockedDecrement(&engine->ref) == 0)
     {
+        CertificateChainCacheEntry *entry, *next;
+
+        LIST_FOR_EACH_ENTRY_SAFE(entry, next, &engine->cache,
+         CertificateChainCacheEntry, entry)
+        {
+            CertFreeCertificateChain((PCCERT_CHAIN_CONTEXT)entry->chain);
+            CryptMemFree(entry->key.additional);
+            CryptMemFree(entry);
+        }
+        engine->cs.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&engine->cs);
         CertCloseStore(engine->hWorld, 0);
         CertCloseStore(engine->hRoot, 0);
         CryptMemFree(engine);
@@ -2794,13 +2836,225 @@ static void dump_chain_para(const CERT_CHAIN_PARA *pChainPara)
     }
 }
 
+/* Gets the key under which a chain for cert, built with hAdditionalStore,
+ * is cached.  Returns FALSE if it can't.
+ */
+static BOOL CRYPT_GetChainCacheKey(const CertificateChainEngine *engine,
+ PCCERT_CONTEXT cert, HCERTSTORE hAdditionalStore,
+ CertificateChainCacheKey *key)
+{
+    WINECRYPT_CERTSTORE *world = engine->hWorld;
+    DWORD size = sizeof(key->hash);
+    BOOL ret;
+
+    key->generation = world->certs.getGeneration(world);
+    key->cAdditional = 0;
+    key->additional = NULL;
+    ret = CertGetCertificateContextProperty(cert, CERT_HASH_PROP_ID,
+     key->hash, &size);
+    if (ret && hAdditionalStore)
+    {
+        PCCERT_CONTEXT additional = NULL;
+        DWORD cMax = 0;
+
+        while (ret && (additional = CertEnumCertificatesInStore(
+         hAdditionalStore, additional)))
+        {
+            if (key->cAdditional == cMax)
+            {
+                BYTE *buf;
+
+                cMax = cMax ? cMax * 2 : 4;
+                if (key->additional)
+                    buf = CryptMemRealloc(key->additional,
+                     cMax * sizeof(key->hash));
+                else
+                    buf = CryptMemAlloc(cMax * sizeof(key->hash));
+                if (!buf)
+                {
+                    ret = FALSE;
+                    break;
+                }
+                key->additional = buf;
+            }
+            size = sizeof(key->hash);
+            ret = CertGetCertificateContextProperty(additional,
+             CERT_HASH_PROP_ID,
+             key->additional + key->cAdditional * sizeof(key->hash), &size);
+            key->cAdditional++;
+        }
+        if (additional)
+            CertFreeCertificateContext(additional);
+        if (!ret)
+        {
+            CryptMemFree(key->additional);
+            key->additional = NULL;
+        }
+    }
+    return ret;
+}
+
+static BOOL CRYPT_ChainCacheKeysEqual(const CertificateChainCacheKey *key1,
+ const CertificateChainCacheKey *key2)
+{
+    return !memcmp(key1->hash, key2->hash, sizeof(key1->hash)) &&
+     key1->generation == key2->generation &&
+     key1->cAdditional == key2->cAdditional &&
+     (!key1->cAdditional || !memcmp(key1->additional, key2->additional,
+     key1->cAdditional * sizeof(key1->hash)));
+}
+
+/* Makes and returns a copy of chain, including its trust status, with cert
+ * as its end cert.
+ */
+static PCertificateChain CRYPT_CopyCachedChain(const CertificateChain *chain,
+ PCCERT_CONTEXT cert)
+{
+    PCertificateChain copy = CryptMemAlloc(sizeof(CertificateChain));
+
+    if (copy)
+    {
+        DWORD i, j;
+
+        copy->ref = 1;
+        copy->world = CertDuplicateStore(chain->world);
+        copy->context = chain->context;
+        copy->context.cChain = 0;
+        copy->context.rgpChain = CryptMemAlloc(
+         chain->context.cChain * sizeof(PCERT_SIMPLE_CHAIN));
+        for (i = 0; copy->context.rgpChain && i < chain->context.cChain; i++)
+        {
+            const CERT_SIMPLE_CHAIN *simpleChain = chain->context.rgpChain[i];
+            PCERT_SIMPLE_CHAIN simpleCopy = CRYPT_CopySimpleChainToElement(
+             simpleChain, simpleChain->cElement - 1);
+
+            if (!simpleCopy)
+                break;
+            simpleCopy->TrustStatus = simpleChain->TrustStatus;
+            for (j = 0; j < simpleChain->cElement; j++)
+                simpleCopy->rgpElement[j]->TrustStatus =
+                 simpleChain->rgpElement[j]->TrustStatus;
+            copy->context.rgpChain[copy->context.cChain++] = simpleCopy;
+        }
+        if (copy->context.cChain == chain->context.cChain)
+        {
+            PCERT_CHAIN_ELEMENT element =
+             copy->context.rgpChain[0]->rgpElement[0];
+
+            CertFreeCertificateContext(element->pCertContext);
+            element->pCertContext = CertDuplicateCertificateContext(cert);
+        }
+        else
+        {
+            CRYPT_FreeChainContext(copy);
+            copy = NULL;
+        }
+    }
+    return copy;
+}
+
+static BOOL CRYPT_IsChainTimeValid(const CertificateChain *chain,
+ LPFILETIME pTime)
+{
+    DWORD i, j;
+
+    for (i = 0; i < chain->context.cChain; i++)
+        for (j = 0; j < chain->context.rgpChain[i]->cElement; j++)
+            if (CertVerifyTimeValidity(pTime,
+             chain->context.rgpChain[i]->rgpElement[j]->pCertContext->pCertInfo))
+                return FALSE;
+    return TRUE;
+}
+
+static void CRYPT_FreeChainCacheEntry(CertificateChainCacheEntry *entry)
+{
+    CertFreeCertificateChain((PCCERT_CHAIN_CONTEXT)entry->chain);
+    CryptMemFree(entry->key.additional);
+    CryptMemFree(entry);
+}
+
+/* Returns a copy of the chain cached under key for cert, or NULL if there is
+ * none.  A cached chain is only used while all its certs are time valid.
+ */
+static PCertificateChain CRYPT_FindCachedChain(PCertificateChainEngine engine,
+ const CertificateChainCacheKey *key, PCCERT_CONTEXT cert, LPFILETIME pTime)
+{
+    CertificateChainCacheEntry *entry;
+    PCertificateChain chain = NULL;
+
+    EnterCriticalSection(&engine->cs);
+    LIST_FOR_EACH_ENTRY(entry, &engine->cache, CertificateChainCacheEntry,
+     entry)
+    {
+        if (CRYPT_ChainCacheKeysEqual(&entry->key, key))
+        {
+            list_remove(&entry->entry);
+            if (CRYPT_IsChainTimeValid(entry->chain, pTime))
+            {
+                list_add_head(&engine->cache, &entry->entry);
+                chain = CRYPT_CopyCachedChain(entry->chain, cert);
+            }
+            else
+            {
+                CRYPT_FreeChainCacheEntry(entry);
+                engine->cCached--;
+            }
+            break;
+        }
+    }
+    LeaveCriticalSection(&engine->cs);
+    if (chain)
+        TRACE_(chain)("using cached chain\n");
+    return chain;
+}
+
+/* Caches a copy of chain under key.  Only chains without errors are cached,
+ * so a cached chain remains the best one as long as its certs are time valid.
+ * Takes ownership of key's additional hashes if the chain is cached.
+ */
+static void CRYPT_CacheChain(PCertificateChainEngine engine,
+ CertificateChainCacheKey *key, const CertificateChain *chain)
+{
+    CertificateChainCacheEntry *entry;
+    DWORD maxCached = engine->MaximumCachedCertificates ?
+     engine->MaximumCachedCertificates : DEFAULT_MAX_CACHED_CHAINS;
+
+    if (chain->context.TrustStatus.dwErrorStatus ||
+     chain->context.cLowerQualityChainContext)
+        return;
+    if (!(entry = CryptMemAlloc(sizeof(CertificateChainCacheEntry))))
+        return;
+    entry->chain = CRYPT_CopyCachedChain(chain,
+     chain->context.rgpChain[0]->rgpElement[0]->pCertContext);
+    if (!entry->chain)
+    {
+        CryptMemFree(entry);
+        return;
+    }
+    entry->key = *key;
+    key->additional = NULL;
+    EnterCriticalSection(&engine->cs);
+    list_add_head(&engine->cache, &entry->entry);
+    engine->cCached++;
+    while (engine->cCached > maxCached)
+    {
+        entry = LIST_ENTRY(list_tail(&engine->cache),
+         CertificateChainCacheEntry, entry);
+        list_remove(&entry->entry);
+        CRYPT_FreeChainCacheEntry(entry);
+        engine->cCached--;
+    }
+    LeaveCriticalSection(&engine->cs);
+}
+
 BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
  PCCERT_CONTEXT pCertContext, LPFILETIME pTime, HCERTSTORE hAdditionalStore,
  PCERT_CHAIN_PARA pChainPara, DWORD dwFlags, LPVOID pvReserved,
  PCCERT_CHAIN_CONTEXT* ppChainContext)
 {
-    BOOL ret;
+    BOOL ret, cache = FALSE;
     PCertificateChain chain = NULL;
+    CertificateChainCacheKey key;
 
     TRACE("(%p, %p, %s, %p, %p, %08x, %p, %p)\n", hChainEngine, pCertContext,
      debugstr_filetime(pTime), hAdditionalStore, pChainPara, dwFlags,
@@ -2824,12 +3078,22 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
     if (TRACE_ON(chain))
         dump_chain_para(pChainPara);
     /* FIXME: what about HCCE_LOCAL_MACHINE? */
-    ret = CRYPT_BuildCandidateChainFromCert(hChainEngine, pCertContext, pTime,
-     hAdditionalStore, &chain);
-    if (ret)
+    /* The cache only holds chains without lower quality contexts. */
+    if ((dwFlags & CERT_CHAIN_CACHE_END_CERT) &&
+     !(dwFlags & CERT_CHAIN_RETURN_LOWER_QUALITY_CONTEXTS))
+    {
+        cache = CRYPT_GetChainCacheKey(hChainEngine, pCertContext,
+         hAdditionalStore, &key);
+        if (cache)
+            chain = CRYPT_FindCachedChain(hChainEngine, &key, pCertContext,
+             pTime);
+    }
+    if (chain)
+        ret = TRUE;
+    else if ((ret = CRYPT_BuildCandidateChainFromCert(hChainEngine,
+     pCertContext, pTime, hAdditionalStore, &chain)))
     {
         PCertificateChain alternate = NULL;
-        PCERT_CHAIN_CONTEXT pChain;
 
         do {
             alternate = CRYPT_BuildAlternateContextFromChain(hChainEngine,
@@ -2845,7 +3109,15 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
         chain = CRYPT_ChooseHighestQualityChain(chain);
         if (!(dwFlags & CERT_CHAIN_RETURN_LOWER_QUALITY_CONTEXTS))
             CRYPT_FreeLowerQualityChains(chain);
-        pChain = (PCERT_CHAIN_CONTEXT)chain;
+        if (ret && cache)
+            CRYPT_CacheChain(hChainEngine, &key, chain);
+    }
+    if (cache)
+        CryptMemFree(key.additional);
+    if (chain)
+    {
+        PCERT_CHAIN_CONTEXT pChain = (PCERT_CHAIN_CONTEXT)chain;
+
         CRYPT_VerifyChainRevocation(pChain, pTime, hAdditionalStore,
          pChainPara, dwFlags);
         CRYPT_CheckUsages(pChain, pChainPara);
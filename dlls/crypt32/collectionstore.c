@@ -38,6 +38,7 @@ typedef struct _WINE_COLLECTIONSTORE
     WINECRYPT_CERTSTORE hdr;
     CRITICAL_SECTION    cs;
     struct list         stores;
+    DWORD               generation;
 } WINE_COLLECTIONSTORE, *PWINE_COLLECTIONSTORE;
 
 static void WINAPI CRYPT_CollectionCloseStore(HCERTSTORE store, DWORD dwFlags)
@@ -251,6 +252,90 @@ static void *CRYPT_CollectionEnumCert(PWINECRYPT_CERTSTORE store, void *pPrev)
     return ret;
 }
 
+static BOOL CRYPT_CollectionFindCert(PWINECRYPT_CERTSTORE store,
+ const CONTEXT_QUERY *query, void *pPrev, void **ppContext)
+{
+    PWINE_COLLECTIONSTORE cs = (PWINE_COLLECTIONSTORE)store;
+    PWINE_STORE_LIST_ENTRY storeEntry;
+    struct list *cursor;
+    void *child = NULL;
+    BOOL ret = TRUE;
+
+    TRACE("(%p, %p, %p)\n", store, query, pPrev);
+
+    EnterCriticalSection(&cs->cs);
+    LIST_FOR_EACH_ENTRY(storeEntry, &cs->stores, WINE_STORE_LIST_ENTRY, entry)
+    {
+        if (!storeEntry->store->certs.findContext)
+        {
+            ret = FALSE;
+            break;
+        }
+    }
+    if (ret)
+    {
+        if (pPrev)
+        {
+            void *prevChild = Context_GetLinkedContext(pPrev,
+             sizeof(CERT_CONTEXT));
+
+            storeEntry = *(PWINE_STORE_LIST_ENTRY *)Context_GetExtra(pPrev,
+             sizeof(CERT_CONTEXT));
+            /* As in CRYPT_CollectionAdvanceEnum, the child is addref'd
+             * because freeing pPrev also releases it.
+             */
+            CertDuplicateCertificateContext(prevChild);
+            ret = storeEntry->store->certs.findContext(storeEntry->store,
+             query, prevChild, &child);
+            if (ret)
+                CertFreeCertificateContext(pPrev);
+            else
+                CertFreeCertificateContext(prevChild);
+            cursor = &storeEntry->entry;
+        }
+        else
+            cursor = &cs->stores;
+        while (ret && !child && (cursor = list_next(&cs->stores, cursor)))
+        {
+            storeEntry = LIST_ENTRY(cursor, WINE_STORE_LIST_ENTRY, entry);
+            ret = storeEntry->store->certs.findContext(storeEntry->store,
+             query, NULL, &child);
+        }
+    }
+    if (ret)
+    {
+        if (child)
+        {
+            *ppContext = CRYPT_CollectionCreateContextFromChild(cs,
+             storeEntry, child, sizeof(CERT_CONTEXT), FALSE);
+            if (*ppContext)
+                ((PCERT_CONTEXT)*ppContext)->hCertStore = store;
+        }
+        else
+            *ppContext = NULL;
+    }
+    LeaveCriticalSection(&cs->cs);
+    TRACE("returning %d\n", ret);
+    return ret;
+}
+
+static DWORD CRYPT_CollectionCertGeneration(PWINECRYPT_CERTSTORE store)
+{
+    PWINE_COLLECTIONSTORE cs = (PWINE_COLLECTIONSTORE)store;
+    PWINE_STORE_LIST_ENTRY storeEntry;
+    DWORD ret;
+
+    EnterCriticalSection(&cs->cs);
+    ret = cs->generation;
+    LIST_FOR_EACH_ENTRY(storeEntry, &cs->stores, WINE_STORE_LIST_ENTRY, entry)
+    {
+        if (storeEntry->store->certs.getGeneration)
+            ret += storeEntry->store->certs.getGeneration(storeEntry->store);
+    }
+    LeaveCriticalSection(&cs->cs);
+    return ret;
+}
+
 static BOOL CRYPT_CollectionDeleteCert(PWINECRYPT_CERTSTORE store,
  void *pCertContext)
 {
@@ -501,6 +586,8 @@ PWINECRYPT_CERTSTORE CRYPT_CollectionOpenStore(HCRYPTPROV hCryptProv,
             store->hdr.certs.addContext    = CRYPT_CollectionAddCert;
             store->hdr.certs.enumContext   = CRYPT_CollectionEnumCert;
             store->hdr.certs.deleteContext = CRYPT_CollectionDeleteCert;
+            store->hdr.certs.findContext   = CRYPT_CollectionFindCert;
+            store->hdr.certs.getGeneration = CRYPT_CollectionCertGeneration;
             store->hdr.crls.addContext     = CRYPT_CollectionAddCRL;
             store->hdr.crls.enumContext    = CRYPT_CollectionEnumCRL;
             store->hdr.crls.deleteContext  = CRYPT_CollectionDeleteCRL;
@@ -576,6 +663,7 @@ BOOL WINAPI CertAddStoreToCollection(HCERTSTORE hCollectionStore,
         }
         else
             list_add_tail(&collection->stores, &entry->entry);
+        collection->generation++;
         LeaveCriticalSection(&collection->cs);
         ret = TRUE;
     }
@@ -614,6 +702,12 @@ void WINAPI CertRemoveStoreFromCollection(HCERTSTORE hCollectionStore,
         if (store->store == sibling)
         {
             list_remove(&store->entry);
+            /* Keep the collection's generation increasing, even though the
+             * sibling's no longer contributes to it.
+             */
+            if (sibling->certs.getGeneration)
+                collection->generation += sibling->certs.getGeneration(sibling);
+            collection->generation++;
             CertCloseStore(store->store, 0);
             CryptMemFree(store);
             break;
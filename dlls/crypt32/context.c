@@ -212,12 +212,36 @@ void Context_CopyProperties(const void *to, const void *from,
     ContextPropertyList_Copy(toProperties, fromProperties);
 }
 
+struct ContextIndexEntry
+{
+    ContextIndexKey key;
+    DWORD           hash;
+    struct list    *entry;
+    int             next; /* next entry in the same bucket, or -1 */
+};
+
+/* A hash table of the keys of a list's contexts.  Each bucket's entries are
+ * in list order, so a search of a bucket visits contexts in the same order
+ * as an enumeration.
+ */
+struct ContextIndex
+{
+    DWORD                    generation;
+    DWORD                    stamp;
+    DWORD                    cBucket;
+    int                     *buckets;
+    DWORD                    cEntry;
+    struct ContextIndexEntry entries[1];
+};
+
 struct ContextList
 {
     PCWINE_CONTEXT_INTERFACE contextInterface;
     size_t contextSize;
     CRITICAL_SECTION cs;
     struct list contexts;
+    DWORD generation;
+    struct ContextIndex *index;
 };
 
 struct ContextList *ContextList_Create(
@@ -232,6 +256,8 @@ struct ContextList *ContextList_Create(
         InitializeCriticalSection(&list->cs);
         list->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": ContextList.cs");
         list_init(&list->contexts);
+        list->generation = 0;
+        list->index = NULL;
     }
     return list;
 }
@@ -281,6 +307,7 @@ void *ContextList_Add(struct ContextList *list, void *toLink, void *toReplace)
         }
         else
             list_add_head(&list->contexts, entry);
+        list->generation++;
         LeaveCriticalSection(&list->cs);
     }
     return context;
@@ -322,6 +349,7 @@ BOOL ContextList_Remove(struct ContextList *list, void *context)
     if (!list_empty(entry))
     {
         list_remove(entry);
+        list->generation++;
         inList = TRUE;
     }
     LeaveCriticalSection(&list->cs);
@@ -330,6 +358,158 @@ BOOL ContextList_Remove(struct ContextList *list, void *context)
     return inList;
 }
 
+static inline DWORD ContextList_Bucket(const struct ContextIndex *index,
+ ContextIndexKey key, DWORD hash)
+{
+    return (hash ^ (key * 0x9e3779b9)) & (index->cBucket - 1);
+}
+
+/* Builds an index of the keys of every context in the list.  Assumes the
+ * list's lock is held.
+ */
+static struct ContextIndex *ContextList_BuildIndex(struct ContextList *list,
+ const CONTEXT_QUERY *query)
+{
+    struct ContextIndex *index;
+    struct list *entry;
+    DWORD count = 0, i;
+    int *tails;
+
+    LIST_FOR_EACH(entry, &list->contexts)
+        count++;
+    index = CryptMemAlloc(FIELD_OFFSET(struct ContextIndex,
+     entries[count * IndexKeyCount + 1]));
+    if (!index)
+        return NULL;
+    index->generation = list->generation;
+    index->stamp = query->stamp;
+    for (index->cBucket = 16; index->cBucket < count * IndexKeyCount;
+     index->cBucket <<= 1)
+        ;
+    index->buckets = CryptMemAlloc(index->cBucket * sizeof(int));
+    tails = CryptMemAlloc(index->cBucket * sizeof(int));
+    if (!index->buckets || !tails)
+    {
+        CryptMemFree(tails);
+        CryptMemFree(index->buckets);
+        CryptMemFree(index);
+        return NULL;
+    }
+    for (i = 0; i < index->cBucket; i++)
+        index->buckets[i] = tails[i] = -1;
+    index->cEntry = 0;
+    LIST_FOR_EACH(entry, &list->contexts)
+    {
+        const void *context = ContextList_EntryToContext(list, entry);
+        ContextIndexKey key;
+
+        for (key = 0; key < IndexKeyCount; key++)
+        {
+            struct ContextIndexEntry *indexEntry =
+             &index->entries[index->cEntry];
+            DWORD bucket;
+
+            if (!query->getHash(context, key, &indexEntry->hash))
+                continue;
+            indexEntry->key = key;
+            indexEntry->entry = entry;
+            indexEntry->next = -1;
+            bucket = ContextList_Bucket(index, key, indexEntry->hash);
+            if (tails[bucket] == -1)
+                index->buckets[bucket] = index->cEntry;
+            else
+                index->entries[tails[bucket]].next = index->cEntry;
+            tails[bucket] = index->cEntry++;
+        }
+    }
+    CryptMemFree(tails);
+    TRACE("indexed %d keys of %d contexts\n", index->cEntry, count);
+    return index;
+}
+
+static void ContextList_FreeIndex(struct ContextIndex *index)
+{
+    if (index)
+    {
+        CryptMemFree(index->buckets);
+        CryptMemFree(index);
+    }
+}
+
+BOOL ContextList_Find(struct ContextList *list, const CONTEXT_QUERY *query,
+ void *pPrev, void **ppContext)
+{
+    BOOL found = !pPrev;
+    void *ret = NULL;
+
+    TRACE("(%p, %d, %08x, %p)\n", list, query->key, query->hash, pPrev);
+
+    EnterCriticalSection(&list->cs);
+    if (list->index && (list->index->generation != list->generation ||
+     list->index->stamp != query->stamp))
+    {
+        ContextList_FreeIndex(list->index);
+        list->index = NULL;
+    }
+    if (!list->index)
+        list->index = ContextList_BuildIndex(list, query);
+    if (list->index)
+    {
+        const struct ContextIndex *index = list->index;
+        int i;
+
+        for (i = index->buckets[ContextList_Bucket(index, query->key,
+         query->hash)]; !ret && i != -1; i = index->entries[i].next)
+        {
+            const struct ContextIndexEntry *indexEntry = &index->entries[i];
+            void *context;
+
+            if (indexEntry->key != query->key ||
+             indexEntry->hash != query->hash)
+                continue;
+            context = ContextList_EntryToContext(list, indexEntry->entry);
+            if (!found)
+                found = context == pPrev;
+            else if (query->match(context, query->para))
+                ret = context;
+        }
+    }
+    else
+    {
+        struct list *entry;
+
+        /* Couldn't allocate the index, so fall back to walking the list */
+        LIST_FOR_EACH(entry, &list->contexts)
+        {
+            void *context = ContextList_EntryToContext(list, entry);
+
+            if (!found)
+                found = context == pPrev;
+            else if (query->match(context, query->para))
+            {
+                ret = context;
+                break;
+            }
+        }
+    }
+    if (found)
+    {
+        if (ret)
+            list->contextInterface->duplicate(ret);
+        if (pPrev)
+            list->contextInterface->free(pPrev);
+        *ppContext = ret;
+    }
+    LeaveCriticalSection(&list->cs);
+    TRACE("returning %d (%p)\n", found, ret);
+    return found;
+}
+
+DWORD ContextList_GetGeneration(struct ContextList *list)
+{
+    return list->generation;
+}
+
 static void ContextList_Empty(struct ContextList *list)
 {
     struct list *entry, *next;
@@ -343,12 +523,14 @@ static void ContextList_Empty(struct ContextList *list)
         list_remove(entry);
         list->contextInterface->free(context);
     }
+    list->generation++;
     LeaveCriticalSection(&list->cs);
 }
 
 void ContextList_Free(struct ContextList *list)
 {
     ContextList_Empty(list);
+    ContextList_FreeIndex(list->index);
     list->cs.DebugInfo->Spare[0] = 0;
     DeleteCriticalSection(&list->cs);
     CryptMemFree(list);
@@ -221,11 +221,58 @@ typedef BOOL (*AddFunc)(struct WINE_CRYPTCERTSTORE *store, void *context,
 
 typedef BOOL (*DeleteFunc)(struct WINE_CRYPTCERTSTORE *store, void *context);
 
+/* The keys by which a context list may be indexed. */
+typedef enum _ContextIndexKey {
+    IndexKeySubject,
+    IndexKeyKeyId,
+    IndexKeySha1Hash,
+    IndexKeyCount
+} ContextIndexKey;
+
+/* Computes the hash of context's key of type key.  Returns FALSE if context
+ * has no such key.
+ */
+typedef BOOL (*ContextHashFunc)(const void *context, ContextIndexKey key,
+ DWORD *hash);
+
+/* Returns TRUE if context matches the query's para. */
+typedef BOOL (*ContextMatchFunc)(const void *context, const void *para);
+
+/* A search for contexts whose key of type key hashes to hash.  Any index
+ * built with a different stamp is considered out of date.
+ */
+typedef struct _CONTEXT_QUERY
+{
+    ContextIndexKey  key;
+    DWORD            hash;
+    DWORD            stamp;
+    ContextHashFunc  getHash;
+    ContextMatchFunc match;
+    const void      *para;
+} CONTEXT_QUERY;
+
+/* Called to find the next context after pPrev matching query, in enumeration
+ * order.  On success, frees pPrev, as EnumFunc does, and returns the matching
+ * context, or NULL if there is none, in *ppContext.  Returns FALSE, leaving
+ * pPrev untouched, if pPrev can't be located using the query, in which case
+ * the caller must enumerate the store instead.  Must not fail if pPrev is
+ * NULL.
+ */
+typedef BOOL (*FindFunc)(struct WINE_CRYPTCERTSTORE *store,
+ const CONTEXT_QUERY *query, void *pPrev, void **ppContext);
+
+/* Returns a counter that increases whenever a context is added to or removed
+ * from the store, or any store it contains.
+ */
+typedef DWORD (*GenerationFunc)(struct WINE_CRYPTCERTSTORE *store);
+
 typedef struct _CONTEXT_FUNCS
 {
-    AddFunc    addContext;
-    EnumFunc   enumContext;
-    DeleteFunc deleteContext;
+    AddFunc        addContext;
+    EnumFunc       enumContext;
+    DeleteFunc     deleteContext;
+    FindFunc       findContext;   /* optional */
+    GenerationFunc getGeneration; /* optional */
 } CONTEXT_FUNCS, *PCONTEXT_FUNCS;
 
 typedef enum _CertStoreType {
@@ -416,6 +463,18 @@ void *ContextList_Enum(struct ContextList *list, void *pPrev) DECLSPEC_HIDDEN;
  */
 BOOL ContextList_Remove(struct ContextList *list, void *context) DECLSPEC_HIDDEN;
 
+/* Finds the next context after pPrev matching query.  The list builds an
+ * index of its contexts' keys the first time it's searched after being
+ * modified.  Has the same semantics as FindFunc.
+ */
+BOOL ContextList_Find(struct ContextList *list, const CONTEXT_QUERY *query,
+ void *pPrev, void **ppContext) DECLSPEC_HIDDEN;
+
+/* Returns a counter that increases whenever a context is added to or removed
+ * from the list.
+ */
+DWORD ContextList_GetGeneration(struct ContextList *list) DECLSPEC_HIDDEN;
+
 void ContextList_Free(struct ContextList *list) DECLSPEC_HIDDEN;
 
 /**
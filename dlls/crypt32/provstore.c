@@ -99,6 +99,29 @@ static void *CRYPT_ProvEnumCert(PWINECRYPT_CERTSTORE store, void *pPrev)
     return ret;
 }
 
+static BOOL CRYPT_ProvFindCert(PWINECRYPT_CERTSTORE store,
+ const CONTEXT_QUERY *query, void *pPrev, void **ppContext)
+{
+    PWINE_PROVIDERSTORE ps = (PWINE_PROVIDERSTORE)store;
+    BOOL ret;
+
+    ret = ps->memStore->certs.findContext(ps->memStore, query, pPrev,
+     ppContext);
+    if (ret && *ppContext)
+    {
+        /* same dirty trick as CRYPT_ProvEnumCert */
+        ((PCERT_CONTEXT)*ppContext)->hCertStore = store;
+    }
+    return ret;
+}
+
+static DWORD CRYPT_ProvCertGeneration(PWINECRYPT_CERTSTORE store)
+{
+    PWINE_PROVIDERSTORE ps = (PWINE_PROVIDERSTORE)store;
+
+    return ps->memStore->certs.getGeneration(ps->memStore);
+}
+
 static BOOL CRYPT_ProvDeleteCert(PWINECRYPT_CERTSTORE store, void *cert)
 {
     PWINE_PROVIDERSTORE ps = (PWINE_PROVIDERSTORE)store;
@@ -283,12 +306,26 @@ PWINECRYPT_CERTSTORE CRYPT_ProvCreateStore(DWORD dwFlags,
         ret->hdr.certs.addContext = CRYPT_ProvAddCert;
         ret->hdr.certs.enumContext = CRYPT_ProvEnumCert;
         ret->hdr.certs.deleteContext = CRYPT_ProvDeleteCert;
+        if (ret->memStore && ret->memStore->certs.findContext)
+        {
+            ret->hdr.certs.findContext = CRYPT_ProvFindCert;
+            ret->hdr.certs.getGeneration = CRYPT_ProvCertGeneration;
+        }
+        else
+        {
+            ret->hdr.certs.findContext = NULL;
+            ret->hdr.certs.getGeneration = NULL;
+        }
         ret->hdr.crls.addContext = CRYPT_ProvAddCRL;
         ret->hdr.crls.enumContext = CRYPT_ProvEnumCRL;
         ret->hdr.crls.deleteContext = CRYPT_ProvDeleteCRL;
+        ret->hdr.crls.findContext = NULL;
+        ret->hdr.crls.getGeneration = NULL;
         ret->hdr.ctls.addContext = CRYPT_ProvAddCTL;
         ret->hdr.ctls.enumContext = CRYPT_ProvEnumCTL;
         ret->hdr.ctls.deleteContext = CRYPT_ProvDeleteCTL;
+        ret->hdr.ctls.findContext = NULL;
+        ret->hdr.ctls.getGeneration = NULL;
         ret->hdr.control = CRYPT_ProvControl;
         if (pProvInfo->cStoreProvFunc > CERT_STORE_PROV_CLOSE_FUNC)
             ret->provCloseStore =
@@ -193,6 +193,23 @@ static BOOL CRYPT_MemDeleteCert(PWINECRYPT_CERTSTORE store, void *pCertContext)
     return ret;
 }
 
+static BOOL CRYPT_MemFindCert(PWINECRYPT_CERTSTORE store,
+ const CONTEXT_QUERY *query, void *pPrev, void **ppContext)
+{
+    WINE_MEMSTORE *ms = (WINE_MEMSTORE *)store;
+
+    TRACE("(%p, %p, %p)\n", store, query, pPrev);
+
+    return ContextList_Find(ms->certs, query, pPrev, ppContext);
+}
+
+static DWORD CRYPT_MemCertGeneration(PWINECRYPT_CERTSTORE store)
+{
+    WINE_MEMSTORE *ms = (WINE_MEMSTORE *)store;
+
+    return ContextList_GetGeneration(ms->certs);
+}
+
 static BOOL CRYPT_MemAddCrl(PWINECRYPT_CERTSTORE store, void *crl,
  void *toReplace, const void **ppStoreContext)
 {
@@ -327,6 +344,8 @@ static WINECRYPT_CERTSTORE *CRYPT_MemOpenStore(HCRYPTPROV hCryptProv,
             store->hdr.certs.addContext    = CRYPT_MemAddCert;
             store->hdr.certs.enumContext   = CRYPT_MemEnumCert;
             store->hdr.certs.deleteContext = CRYPT_MemDeleteCert;
+            store->hdr.certs.findContext   = CRYPT_MemFindCert;
+            store->hdr.certs.getGeneration = CRYPT_MemCertGeneration;
             store->hdr.crls.addContext     = CRYPT_MemAddCrl;
             store->hdr.crls.enumContext    = CRYPT_MemEnumCrl;
             store->hdr.crls.deleteContext  = CRYPT_MemDeleteCrl;
@@ -1056,7 +1056,7 @@ static BYTE iTunesSerialNum[] = {
 
 static void testFindCert(void)
 {
-    HCERTSTORE store;
+    HCERTSTORE store, store2, collection;
     PCCERT_CONTEXT context = NULL, subject;
     BOOL ret;
     CERT_INFO certInfo = { 0 };
@@ -1221,6 +1221,61 @@ static void testFindCert(void)
     ok(GetLastError() == CRYPT_E_NOT_FOUND,
      "expected CRYPT_E_NOT_FOUND, got %08x\n", GetLastError());
 
+    /* Searches see certs deleted from and added to a collection's siblings */
+    collection = CertOpenStore(CERT_STORE_PROV_COLLECTION, 0, 0,
+     CERT_STORE_CREATE_NEW_FLAG, NULL);
+    store2 = CertOpenStore(CERT_STORE_PROV_MEMORY, 0, 0,
+     CERT_STORE_CREATE_NEW_FLAG, NULL);
+    CertAddStoreToCollection(collection, store, 0, 0);
+    CertAddStoreToCollection(collection, store2, 0, 0);
+    blob.pbData = bigCertHash;
+    blob.cbData = sizeof(bigCertHash);
+    context = CertFindCertificateInStore(collection, X509_ASN_ENCODING, 0,
+     CERT_FIND_SHA1_HASH, &blob, NULL);
+    ok(context != NULL, "CertFindCertificateInStore failed: %08x\n",
+     GetLastError());
+    if (context)
+    {
+        ok(context->hCertStore == collection, "unexpected store %p\n",
+         context->hCertStore);
+        ret = CertDeleteCertificateFromStore(context);
+        ok(ret, "CertDeleteCertificateFromStore failed: %08x\n",
+         GetLastError());
+    }
+    SetLastError(0xdeadbeef);
+    context = CertFindCertificateInStore(collection, X509_ASN_ENCODING, 0,
+     CERT_FIND_SHA1_HASH, &blob, NULL);
+    ok(!context, "expected no certs\n");
+    ok(GetLastError() == CRYPT_E_NOT_FOUND,
+     "expected CRYPT_E_NOT_FOUND, got %08x\n", GetLastError());
+    ret = CertAddEncodedCertificateToStore(store2, X509_ASN_ENCODING,
+     bigCert, sizeof(bigCert), CERT_STORE_ADD_NEW, NULL);
+    ok(ret, "CertAddEncodedCertificateToStore failed: %08x\n",
+     GetLastError());
+    context = CertFindCertificateInStore(collection, X509_ASN_ENCODING, 0,
+     CERT_FIND_SHA1_HASH, &blob, NULL);
+    ok(context != NULL, "CertFindCertificateInStore failed: %08x\n",
+     GetLastError());
+    CertFreeCertificateContext(context);
+    ret = CertAddEncodedCertificateToStore(store, X509_ASN_ENCODING,
+     bigCert, sizeof(bigCert), CERT_STORE_ADD_NEW, NULL);
+    ok(ret, "CertAddEncodedCertificateToStore failed: %08x\n",
+     GetLastError());
+    /* Both siblings are searched, in order */
+    certInfo.Subject.pbData = subjectName;
+    certInfo.Subject.cbData = sizeof(subjectName);
+    count = 0;
+    context = NULL;
+    do {
+        context = CertFindCertificateInStore(collection, X509_ASN_ENCODING, 0,
+         CERT_FIND_SUBJECT_NAME, &certInfo.Subject, context);
+        if (context)
+            count++;
+    } while (context);
+    ok(count == 3, "expected 3 contexts, got %d\n", count);
+    CertCloseStore(store2, 0);
+    CertCloseStore(collection, 0);
+
     CertCloseStore(store, 0);
 
     /* Another subject cert search, using iTunes's certs */
@@ -4651,6 +4651,78 @@ static void testVerifyCertChainPolicy(void)
      basicConstraintsPolicyCheck, &oct2007, NULL);
 }
 
+static void test_chain_cache(void)
+{
+    CERT_CHAIN_ENGINE_CONFIG engineConfig = { sizeof(engineConfig), 0 };
+    CERT_CHAIN_PARA chainPara = { sizeof(chainPara), { 0 } };
+    PCCERT_CHAIN_CONTEXT chain, cached;
+    HCERTCHAINENGINE engine;
+    HCERTSTORE testRoot;
+    PCCERT_CONTEXT cert;
+    FILETIME fileTime;
+    BOOL ret;
+
+    testRoot = CertOpenStore(CERT_STORE_PROV_MEMORY, 0, 0,
+     CERT_STORE_CREATE_NEW_FLAG, NULL);
+    ret = CertAddEncodedCertificateToStore(testRoot, X509_ASN_ENCODING,
+     chain0_0, sizeof(chain0_0), CERT_STORE_ADD_ALWAYS, &cert);
+    ok(ret, "CertAddEncodedCertificateToStore failed: %08x\n",
+     GetLastError());
+    engineConfig.hExclusiveRoot = testRoot;
+    if (!pCertCreateCertificateChainEngine(&engineConfig, &engine))
+    {
+        skip("Couldn't create chain engine\n");
+        CertFreeCertificateContext(cert);
+        CertCloseStore(testRoot, 0);
+        return;
+    }
+
+    SystemTimeToFileTime(&oct2007, &fileTime);
+    ret = pCertGetCertificateChain(engine, cert, &fileTime, NULL, &chainPara,
+     CERT_CHAIN_CACHE_END_CERT, NULL, &chain);
+    ok(ret, "CertGetCertificateChain failed: %08x\n", GetLastError());
+    ret = pCertGetCertificateChain(engine, cert, &fileTime, NULL, &chainPara,
+     CERT_CHAIN_CACHE_END_CERT, NULL, &cached);
+    ok(ret, "CertGetCertificateChain failed: %08x\n", GetLastError());
+    if (chain && cached)
+    {
+        ok(cached->TrustStatus.dwErrorStatus ==
+         chain->TrustStatus.dwErrorStatus, "expected %08x, got %08x\n",
+         chain->TrustStatus.dwErrorStatus, cached->TrustStatus.dwErrorStatus);
+        ok(cached->TrustStatus.dwInfoStatus ==
+         chain->TrustStatus.dwInfoStatus, "expected %08x, got %08x\n",
+         chain->TrustStatus.dwInfoStatus, cached->TrustStatus.dwInfoStatus);
+        ok(cached->cChain == chain->cChain, "expected %d chains, got %d\n",
+         chain->cChain, cached->cChain);
+        ok(cached->rgpChain[0]->cElement == chain->rgpChain[0]->cElement,
+         "expected %d elements, got %d\n", chain->rgpChain[0]->cElement,
+         cached->rgpChain[0]->cElement);
+    }
+    if (cached)
+        pCertFreeCertificateChain(cached);
+
+    /* The root is no longer valid in 2009, whether or not a chain was cached
+     * for it.
+     */
+    SystemTimeToFileTime(&oct2009, &fileTime);
+    ret = pCertGetCertificateChain(engine, cert, &fileTime, NULL, &chainPara,
+     CERT_CHAIN_CACHE_END_CERT, NULL, &cached);
+    ok(ret, "CertGetCertificateChain failed: %08x\n", GetLastError());
+    if (cached)
+    {
+        ok(cached->TrustStatus.dwErrorStatus & CERT_TRUST_IS_NOT_TIME_VALID,
+         "expected CERT_TRUST_IS_NOT_TIME_VALID, got %08x\n",
+         cached->TrustStatus.dwErrorStatus);
+        pCertFreeCertificateChain(cached);
+    }
+    if (chain)
+        pCertFreeCertificateChain(chain);
+
+    pCertFreeCertificateChainEngine(engine);
+    CertFreeCertificateContext(cert);
+    CertCloseStore(testRoot, 0);
+}
+
 START_TEST(chain)
 {
     HMODULE hCrypt32 = GetModuleHandleA("crypt32.dll");
@@ -4670,5 +4742,7 @@ START_TEST(chain)
         testVerifyCertChainPolicy();
         testGetCertChain();
         test_CERT_CHAIN_PARA_cbSize();
+        if (pCertCreateCertificateChainEngine)
+            test_chain_cache();
     }
 }
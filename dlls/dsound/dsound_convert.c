@@ -104,6 +104,104 @@ static float getieee32(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD chann
 
 const bitsgetfunc getbpp[5] = {get8, get16, get24, get32, getieee32};
 
+/*
+ * The run functions convert count consecutive frames of one channel, starting
+ * at byte offset pos, and store them stride floats apart. The caller makes sure
+ * that they don't run past the end of the buffer.
+ */
+static void get8_run(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel,
+        float *dst, UINT stride, UINT count)
+{
+    const BYTE* buf = dsb->buffer->memory;
+    UINT istride = dsb->pwfx->nBlockAlign;
+
+    buf += pos + channel;
+    while (count--)
+    {
+        *dst = (buf[0] - 0x80) / (float)0x80;
+        buf += istride;
+        dst += stride;
+    }
+}
+
+static void get16_run(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel,
+        float *dst, UINT stride, UINT count)
+{
+    const BYTE* buf = dsb->buffer->memory;
+    UINT istride = dsb->pwfx->nBlockAlign;
+
+    buf += pos + 2 * channel;
+    while (count--)
+    {
+        SHORT sample = (SHORT)le16(*(const SHORT*)buf);
+        *dst = sample / (float)0x8000;
+        buf += istride;
+        dst += stride;
+    }
+}
+
+static void get24_run(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel,
+        float *dst, UINT stride, UINT count)
+{
+    const BYTE* buf = dsb->buffer->memory;
+    UINT istride = dsb->pwfx->nBlockAlign;
+
+    buf += pos + 3 * channel;
+    while (count--)
+    {
+        LONG sample = (buf[0] << 8) | (buf[1] << 16) | (buf[2] << 24);
+        *dst = sample / (float)0x80000000U;
+        buf += istride;
+        dst += stride;
+    }
+}
+
+static void get32_run(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel,
+        float *dst, UINT stride, UINT count)
+{
+    const BYTE* buf = dsb->buffer->memory;
+    UINT istride = dsb->pwfx->nBlockAlign;
+
+    buf += pos + 4 * channel;
+    while (count--)
+    {
+        LONG sample = le32(*(const LONG*)buf);
+        *dst = sample / (float)0x80000000U;
+        buf += istride;
+        dst += stride;
+    }
+}
+
+static void getieee32_run(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel,
+        float *dst, UINT stride, UINT count)
+{
+    const BYTE* buf = dsb->buffer->memory;
+    UINT istride = dsb->pwfx->nBlockAlign;
+
+    buf += pos + 4 * channel;
+    while (count--)
+    {
+        *dst = *(const float*)buf;
+        buf += istride;
+        dst += stride;
+    }
+}
+
+const bitsgetrunfunc getrunbpp[5] = {get8_run, get16_run, get24_run, get32_run, getieee32_run};
+
+void get_run_generic(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel,
+        float *dst, UINT stride, UINT count)
+{
+    UINT istride = dsb->pwfx->nBlockAlign;
+
+    while (count--)
+    {
+        *dst = dsb->get(dsb, pos, channel);
+        pos += istride;
+        dst += stride;
+    }
+}
+
 float get_mono(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel)
 {
     DWORD channels = dsb->pwfx->nChannels;
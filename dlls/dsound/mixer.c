@@ -146,6 +146,7 @@ void DSOUND_RecalcFormat(IDirectSoundBufferImpl *dsb)
 
 	dsb->get = dsb->get_aux;
 	dsb->put = dsb->put_aux;
+	dsb->get_run = ieee ? getrunbpp[4] : getrunbpp[dsb->pwfx->wBitsPerSample/8 - 1];
 
 	if (ichannels == ochannels)
 	{
@@ -164,6 +165,7 @@ void DSOUND_RecalcFormat(IDirectSoundBufferImpl *dsb)
 	{
 		dsb->mix_channels = 1;
 		dsb->get = get_mono;
+		dsb->get_run = get_run_generic;
 	}
 	else
 	{
@@ -227,31 +229,108 @@ void DSOUND_CheckEvent(const IDirectSoundBufferImpl *dsb, DWORD playpos, int len
 	}
 }
 
-static inline float get_current_sample(const IDirectSoundBufferImpl *dsb,
-        DWORD mixpos, DWORD channel)
+/**
+ * Convert count frames of one channel, starting at mixpos, into dst with
+ * the given stride. Handles wrapping around looping buffers and reads
+ * silence past the end of non-looping ones.
+ */
+static void get_samples(const IDirectSoundBufferImpl *dsb, DWORD mixpos, DWORD channel,
+        float *dst, UINT stride, UINT count)
 {
-    if (mixpos >= dsb->buflen && !(dsb->playflags & DSBPLAY_LOOPING))
-        return 0.0f;
-    return dsb->get(dsb, mixpos % dsb->buflen, channel);
+    UINT istride = dsb->pwfx->nBlockAlign;
+    UINT run;
+
+    while (count)
+    {
+        if (mixpos >= dsb->buflen)
+        {
+            if (!(dsb->playflags & DSBPLAY_LOOPING))
+            {
+                while (count--)
+                {
+                    *dst = 0.0f;
+                    dst += stride;
+                }
+                return;
+            }
+            mixpos %= dsb->buflen;
+        }
+
+        run = (dsb->buflen - mixpos + istride - 1) / istride;
+        if (run > count)
+            run = count;
+
+        dsb->get_run(dsb, mixpos, channel, dst, stride, run);
+        dst += run * stride;
+        mixpos += run * istride;
+        count -= run;
+    }
 }
 
 static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
 {
-    UINT istride = dsb->pwfx->nBlockAlign;
-    UINT ostride = dsb->device->pwfx->nChannels * sizeof(float);
+    UINT ochannels = dsb->device->pwfx->nChannels;
+    float *obuf = dsb->device->tmp_buffer;
     DWORD channel, i;
-    for (i = 0; i < count; i++)
-        for (channel = 0; channel < dsb->mix_channels; channel++)
-            dsb->put(dsb, i * ostride, channel, get_current_sample(dsb,
-                    dsb->sec_mixpos + i * istride, channel));
+
+    for (channel = 0; channel < dsb->mix_channels; channel++)
+        get_samples(dsb, dsb->sec_mixpos, channel, obuf + channel, ochannels, count);
+
+    if (dsb->put == put_mono2stereo)
+        for (i = 0; i < count; i++)
+            obuf[i * ochannels + 1] = obuf[i * ochannels];
+
     return count;
 }
 
+/* Reserve the resampler scratch space shared by all buffers of the device. */
+static float *get_cp_buffer(DirectSoundDevice *device, UINT len)
+{
+    float *buffer;
+
+    if (device->cp_buffer_len >= len)
+        return device->cp_buffer;
+
+    if (device->cp_buffer)
+        buffer = HeapReAlloc(GetProcessHeap(), 0, device->cp_buffer, len * sizeof(float));
+    else
+        buffer = HeapAlloc(GetProcessHeap(), 0, len * sizeof(float));
+    if (!buffer)
+        return NULL;
+
+    device->cp_buffer = buffer;
+    device->cp_buffer_len = len;
+    return buffer;
+}
+
+/**
+ * Multiply-accumulate using four independent partial sums, so that the
+ * compiler is free to keep them in vector registers.
+ */
+static inline float fir_dot(const float *fir, const float *input, int len)
+{
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+    int j;
+
+    for (j = 0; j + 4 <= len; j += 4)
+    {
+        sum0 += fir[j] * input[j];
+        sum1 += fir[j + 1] * input[j + 1];
+        sum2 += fir[j + 2] * input[j + 2];
+        sum3 += fir[j + 3] * input[j + 3];
+    }
+    for (; j < len; j++)
+        sum0 += fir[j] * input[j];
+
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
 static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, float *freqAcc)
 {
     UINT i, channel;
-    UINT istride = dsb->pwfx->nBlockAlign;
-    UINT ostride = dsb->device->pwfx->nChannels * sizeof(float);
+    UINT ochannels = dsb->device->pwfx->nChannels;
+    float *obuf = dsb->device->tmp_buffer;
+    BOOL mono2stereo = dsb->put == put_mono2stereo;
 
     float freqAdjust = dsb->freqAdjust;
     float freqAcc_start = *freqAcc;
@@ -263,21 +342,25 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, float *f
     UINT fir_cachesize = (fir_len + dsbfirstep - 2) / dsbfirstep;
     UINT required_input = max_ipos + fir_cachesize;
 
-    float* intermediate = HeapAlloc(GetProcessHeap(), 0,
-            sizeof(float) * required_input * channels);
+    float *intermediate, *fir_copy;
 
-    float* fir_copy = HeapAlloc(GetProcessHeap(), 0,
-            sizeof(float) * fir_cachesize);
+    intermediate = get_cp_buffer(dsb->device, required_input * channels + fir_cachesize);
+    if (!intermediate)
+    {
+        ERR("out of memory\n");
+        memset(obuf, 0, count * ochannels * sizeof(float));
+        *freqAcc = freqAcc_end - (int)freqAcc_end;
+        return max_ipos;
+    }
+    fir_copy = intermediate + required_input * channels;
 
     /* Important: this buffer MUST be non-interleaved
      * if you want -msse3 to have any effect.
      * This is good for CPU cache effects, too.
      */
-    float* itmp = intermediate;
     for (channel = 0; channel < channels; channel++)
-        for (i = 0; i < required_input; i++)
-            *(itmp++) = get_current_sample(dsb,
-                    dsb->sec_mixpos + i * istride, channel);
+        get_samples(dsb, dsb->sec_mixpos, channel,
+                intermediate + channel * required_input, 1, required_input);
 
     for(i = 0; i < count; ++i) {
         float total_fir_steps = (freqAcc_start + i * freqAdjust) * dsbfirstep;
@@ -296,22 +379,17 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, float *f
         assert(fir_used <= fir_cachesize);
         assert(ipos + fir_used <= required_input);
 
-        for (channel = 0; channel < dsb->mix_channels; channel++) {
-            int j;
-            float sum = 0.0;
+        for (channel = 0; channel < channels; channel++) {
             float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
-            dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
+            obuf[i * ochannels + channel] = fir_dot(fir_copy, cache, fir_used) * dsb->firgain;
         }
+        if (mono2stereo)
+            obuf[i * ochannels + 1] = obuf[i * ochannels];
     }
 
     freqAcc_end -= (int)freqAcc_end;
     *freqAcc = freqAcc_end;
 
-    HeapFree(GetProcessHeap(), 0, fir_copy);
-    HeapFree(GetProcessHeap(), 0, intermediate);
-
     return max_ipos;
 }
 
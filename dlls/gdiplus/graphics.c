@@ -359,14 +359,33 @@ static GpStatus alpha_blend_bmp_pixels(GpGraphics *graphics, INT dst_x, INT dst_
     GpBitmap *dst_bitmap = (GpBitmap*)graphics->image;
     INT x, y;
 
-    for (x=0; x<src_width; x++)
+    if (dst_bitmap->bits && dst_bitmap->format == PixelFormat32bppARGB)
     {
-        for (y=0; y<src_height; y++)
+        /* blend straight into the DIB, skipping pixels outside the bitmap */
+        INT left = max(dst_x, 0), right = min(dst_x + src_width, dst_bitmap->width);
+        INT top = max(dst_y, 0), bottom = min(dst_y + src_height, dst_bitmap->height);
+
+        for (y=top; y<bottom; y++)
         {
-            ARGB dst_color, src_color;
+            const ARGB *src_row = (const ARGB*)(src + src_stride * (y - dst_y));
+            ARGB *dst_row = (ARGB*)(dst_bitmap->bits + dst_bitmap->stride * y);
+
+            for (x=left; x<right; x++)
+                dst_row[x] = color_over(dst_row[x], src_row[x - dst_x]);
+        }
+
+        return Ok;
+    }
+
+    for (y=0; y<src_height; y++)
+    {
+        const ARGB *src_row = (const ARGB*)(src + src_stride * y);
+
+        for (x=0; x<src_width; x++)
+        {
+            ARGB dst_color;
             GdipBitmapGetPixel(dst_bitmap, x+dst_x, y+dst_y, &dst_color);
-            src_color = ((ARGB*)(src + src_stride * y))[x];
-            GdipBitmapSetPixel(dst_bitmap, x+dst_x, y+dst_y, color_over(dst_color, src_color));
+            GdipBitmapSetPixel(dst_bitmap, x+dst_x, y+dst_y, color_over(dst_color, src_row[x]));
         }
     }
 
@@ -1035,9 +1054,15 @@ static GpStatus brush_fill_pixels(GpGraphics *graphics, GpBrush *brush,
     {
         int x, y;
         GpSolidFill *fill = (GpSolidFill*)brush;
+
+        if (fill_area->Width <= 0)
+            return Ok;
+
+        /* fill the first row, then copy it to the others */
         for (x=0; x<fill_area->Width; x++)
-            for (y=0; y<fill_area->Height; y++)
-                argb_pixels[x + y*cdwStride] = fill->color;
+            argb_pixels[x] = fill->color;
+        for (y=1; y<fill_area->Height; y++)
+            memcpy(argb_pixels + y*cdwStride, argb_pixels, fill_area->Width * sizeof(DWORD));
         return Ok;
     }
     case BrushTypeHatchFill:
@@ -1049,20 +1074,22 @@ static GpStatus brush_fill_pixels(GpGraphics *graphics, GpBrush *brush,
         if (get_hatch_data(fill->hatchstyle, &hatch_data) != Ok)
             return NotImplemented;
 
-        for (x=0; x<fill_area->Width; x++)
-            for (y=0; y<fill_area->Height; y++)
-            {
-                int hx, hy;
+        for (y=0; y<fill_area->Height; y++)
+        {
+            DWORD *row = argb_pixels + y*cdwStride;
+            char hatch_row;
 
-                /* FIXME: Account for the rendering origin */
-                hx = (x + fill_area->X) % 8;
-                hy = (y + fill_area->Y) % 8;
+            /* FIXME: Account for the rendering origin */
+            hatch_row = hatch_data[7 - (y + fill_area->Y) % 8];
 
-                if ((hatch_data[7-hy] & (0x80 >> hx)) != 0)
-                    argb_pixels[x + y*cdwStride] = fill->forecol;
+            for (x=0; x<fill_area->Width; x++)
+            {
+                if ((hatch_row & (0x80 >> ((x + fill_area->X) % 8))) != 0)
+                    row[x] = fill->forecol;
                 else
-                    argb_pixels[x + y*cdwStride] = fill->backcol;
+                    row[x] = fill->backcol;
             }
+        }
 
         return Ok;
     }
@@ -3031,23 +3058,22 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
             y_dx = dst_to_src_points[2].X - dst_to_src_points[0].X;
             y_dy = dst_to_src_points[2].Y - dst_to_src_points[0].Y;
 
-            for (x=dst_area.left; x<dst_area.right; x++)
+            for (y=dst_area.top; y<dst_area.bottom; y++)
             {
-                for (y=dst_area.top; y<dst_area.bottom; y++)
+                ARGB *dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top));
+
+                for (x=dst_area.left; x<dst_area.right; x++)
                 {
                     GpPointF src_pointf;
-                    ARGB *dst_color;
 
                     src_pointf.X = dst_to_src_points[0].X + x * x_dx + y * y_dx;
                     src_pointf.Y = dst_to_src_points[0].Y + x * x_dy + y * y_dy;
 
-                    dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top) + sizeof(ARGB) * (x - dst_area.left));
-
                     if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth && src_pointf.Y >= srcy && src_pointf.Y < srcy+srcheight)
-                        *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf,
-                                                           imageAttributes, interpolation, offset_mode);
+                        *dst_color++ = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf,
+                                                             imageAttributes, interpolation, offset_mode);
                     else
-                        *dst_color = 0;
+                        *dst_color++ = 0;
                 }
             }
 
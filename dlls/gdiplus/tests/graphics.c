@@ -4521,6 +4521,66 @@ static void test_bitmapfromgraphics(void)
     GdipDisposeImage((GpImage*)bitmap);
 }
 
+static void test_fill_bitmap(void)
+{
+    GpStatus status;
+    GpBitmap *bitmap;
+    GpGraphics *graphics;
+    GpSolidFill *brush;
+    ARGB color;
+
+    status = GdipCreateBitmapFromScan0(8, 8, 0, PixelFormat32bppARGB, NULL, &bitmap);
+    expect(Ok, status);
+
+    status = GdipGetImageGraphicsContext((GpImage*)bitmap, &graphics);
+    expect(Ok, status);
+
+    status = GdipCreateSolidFill(0xff00ff00, &brush);
+    expect(Ok, status);
+
+    status = GdipFillRectangleI(graphics, (GpBrush*)brush, 2, 2, 4, 4);
+    expect(Ok, status);
+
+    status = GdipBitmapGetPixel(bitmap, 1, 1, &color);
+    expect(Ok, status);
+    expect(0, color);
+
+    status = GdipBitmapGetPixel(bitmap, 2, 2, &color);
+    expect(Ok, status);
+    expect(0xff00ff00, color);
+
+    status = GdipBitmapGetPixel(bitmap, 5, 5, &color);
+    expect(Ok, status);
+    expect(0xff00ff00, color);
+
+    status = GdipBitmapGetPixel(bitmap, 6, 6, &color);
+    expect(Ok, status);
+    expect(0, color);
+
+    /* partly outside of the bitmap */
+    status = GdipSetSolidFillColor(brush, 0xff0000ff);
+    expect(Ok, status);
+
+    status = GdipFillRectangleI(graphics, (GpBrush*)brush, -2, -2, 4, 4);
+    expect(Ok, status);
+
+    status = GdipBitmapGetPixel(bitmap, 0, 0, &color);
+    expect(Ok, status);
+    expect(0xff0000ff, color);
+
+    status = GdipBitmapGetPixel(bitmap, 1, 1, &color);
+    expect(Ok, status);
+    expect(0xff0000ff, color);
+
+    status = GdipBitmapGetPixel(bitmap, 2, 2, &color);
+    expect(Ok, status);
+    expect(0xff00ff00, color);
+
+    GdipDeleteBrush((GpBrush*)brush);
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage*)bitmap);
+}
+
 static void test_clipping(void)
 {
     HDC hdc;
@@ -4783,6 +4843,7 @@ START_TEST(graphics)
     test_getdc_scaled();
     test_alpha_hdc();
     test_bitmapfromgraphics();
+    test_fill_bitmap();
 
     GdiplusShutdown(gdiplusToken);
     DestroyWindow( hwnd );
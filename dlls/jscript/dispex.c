@@ -1053,6 +1053,31 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+/*
+ * Property DISPIDs are indexes into the props array, which never shrinks and whose
+ * names are unique within an object. Objects built the same way get the same layout,
+ * so a DISPID cached at a call site is likely to be valid for the next object as well
+ * and may be verified with a single name comparison.
+ */
+HRESULT jsdisp_get_id_cached(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *cache, DISPID *id)
+{
+    dispex_prop_t *prop;
+    HRESULT hres;
+
+    if(*cache > 0 && *cache < jsdisp->prop_cnt) {
+        prop = jsdisp->props + *cache;
+        if(prop->type != PROP_DELETED && !strcmpW(prop->name, name)) {
+            *id = *cache;
+            return S_OK;
+        }
+    }
+
+    hres = jsdisp_get_id(jsdisp, name, flags, id);
+    if(SUCCEEDED(hres))
+        *cache = *id;
+    return hres;
+}
+
 HRESULT jsdisp_call_value(jsdisp_t *jsfunc, IDispatch *jsthis, WORD flags, unsigned argc, jsval_t *argv, jsval_t *r)
 {
     HRESULT hres;
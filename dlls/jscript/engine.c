@@ -346,13 +346,17 @@ void exec_release(exec_ctx_t *ctx)
     heap_free(ctx);
 }
 
-static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr, DWORD flags, DISPID *id)
+static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr, DWORD flags,
+        DISPID *cache, DISPID *id)
 {
     IDispatchEx *dispex;
     jsdisp_t *jsdisp;
     BSTR bstr;
     HRESULT hres;
 
+    if(cache && (jsdisp = to_jsdisp(disp)))
+        return jsdisp_get_id_cached(jsdisp, name, flags, cache, id);
+
     jsdisp = iface_to_jsdisp((IUnknown*)disp);
     if(jsdisp) {
         hres = jsdisp_get_id(jsdisp, name, flags, id);
@@ -479,7 +483,7 @@ static BOOL lookup_global_members(script_ctx_t *ctx, BSTR identifier, exprval_t
 
     for(item = ctx->named_items; item; item = item->next) {
         if(item->flags & SCRIPTITEM_GLOBALMEMBERS) {
-            hres = disp_get_id(ctx, item->disp, identifier, identifier, 0, &id);
+            hres = disp_get_id(ctx, item->disp, identifier, identifier, 0, NULL, &id);
             if(SUCCEEDED(hres)) {
                 if(ret)
                     exprval_set_idref(ret, item->disp, id);
@@ -505,7 +509,7 @@ static HRESULT identifier_eval(script_ctx_t *ctx, BSTR identifier, exprval_t *re
         if(scope->jsobj)
             hres = jsdisp_get_id(scope->jsobj, identifier, fdexNameImplicit, &id);
         else
-            hres = disp_get_id(ctx, scope->obj, identifier, identifier, fdexNameImplicit, &id);
+            hres = disp_get_id(ctx, scope->obj, identifier, identifier, fdexNameImplicit, NULL, &id);
         if(SUCCEEDED(hres)) {
             exprval_set_idref(ret, scope->obj, id);
             return S_OK;
@@ -571,6 +575,10 @@ static inline jsstr_t *get_op_str(exec_ctx_t *ctx, int i){
     return ctx->code->instrs[ctx->ip].u.arg[i].str;
 }
 
+static inline DISPID *get_op_cache(exec_ctx_t *ctx, int i){
+    return &ctx->code->instrs[ctx->ip].u.arg[i].lng;
+}
+
 static inline double get_op_double(exec_ctx_t *ctx){
     return ctx->code->instrs[ctx->ip].u.dbl;
 }
@@ -827,11 +835,36 @@ static HRESULT interp_func(exec_ctx_t *ctx)
     return stack_push(ctx, jsval_obj(dispex));
 }
 
+/*
+ * Converts a property name to a flat string. Array indexes are formatted into buf
+ * (which has to hold 11 characters), so that no string has to be allocated for them.
+ */
+static HRESULT to_prop_name(script_ctx_t *ctx, jsval_t val, WCHAR *buf, jsstr_t **name_str, const WCHAR **name)
+{
+    if(is_number(val) && is_int32(get_number(val)) && get_number(val) >= 0) {
+        DWORD idx = get_number(val);
+        WCHAR *ptr = buf+10;
+
+        *ptr = 0;
+        do {
+            *--ptr = '0' + idx%10;
+            idx /= 10;
+        }while(idx);
+
+        *name_str = NULL;
+        *name = ptr;
+        return S_OK;
+    }
+
+    return to_flat_string(ctx, val, name_str, name);
+}
+
 /* ECMA-262 3rd Edition    11.2.1 */
 static HRESULT interp_array(exec_ctx_t *ctx)
 {
     jsstr_t *name_str;
     const WCHAR *name;
+    WCHAR buf[11];
     jsval_t v, namev;
     IDispatch *obj;
     DISPID id;
@@ -847,15 +880,16 @@ static HRESULT interp_array(exec_ctx_t *ctx)
         return hres;
     }
 
-    hres = to_flat_string(ctx->script, namev, &name_str, &name);
+    hres = to_prop_name(ctx->script, namev, buf, &name_str, &name);
     jsval_release(namev);
     if(FAILED(hres)) {
         IDispatch_Release(obj);
         return hres;
     }
 
-    hres = disp_get_id(ctx->script, obj, name, NULL, 0, &id);
-    jsstr_release(name_str);
+    hres = disp_get_id(ctx->script, obj, name, NULL, 0, NULL, &id);
+    if(name_str)
+        jsstr_release(name_str);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx->script, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
@@ -884,7 +918,7 @@ static HRESULT interp_member(exec_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx->script, obj, arg, arg, 0, &id);
+    hres = disp_get_id(ctx->script, obj, arg, arg, 0, get_op_cache(ctx, 1), &id);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx->script, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
@@ -905,6 +939,7 @@ static HRESULT interp_memberid(exec_ctx_t *ctx)
     jsval_t objv, namev;
     const WCHAR *name;
     jsstr_t *name_str;
+    WCHAR buf[11];
     IDispatch *obj;
     DISPID id;
     HRESULT hres;
@@ -917,7 +952,7 @@ static HRESULT interp_memberid(exec_ctx_t *ctx)
     hres = to_object(ctx->script, objv, &obj);
     jsval_release(objv);
     if(SUCCEEDED(hres)) {
-        hres = to_flat_string(ctx->script, namev, &name_str, &name);
+        hres = to_prop_name(ctx->script, namev, buf, &name_str, &name);
         if(FAILED(hres))
             IDispatch_Release(obj);
     }
@@ -925,8 +960,9 @@ static HRESULT interp_memberid(exec_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx->script, obj, name, NULL, arg, &id);
-    jsstr_release(name_str);
+    hres = disp_get_id(ctx->script, obj, name, NULL, arg, get_op_cache(ctx, 1), &id);
+    if(name_str)
+        jsstr_release(name_str);
     if(FAILED(hres)) {
         IDispatch_Release(obj);
         if(hres == DISP_E_UNKNOWNNAME && !(arg & fdexNameEnsure)) {
@@ -1419,7 +1455,7 @@ static HRESULT interp_in(exec_ctx_t *ctx)
         return hres;
     }
 
-    hres = disp_get_id(ctx->script, get_object(obj), str, NULL, 0, &id);
+    hres = disp_get_id(ctx->script, get_object(obj), str, NULL, 0, NULL, &id);
     IDispatch_Release(get_object(obj));
     jsstr_release(jsstr);
     if(SUCCEEDED(hres))
@@ -1439,6 +1439,48 @@ function returnTest() {
 
 ok(returnTest() === undefined, "returnTest = " + returnTest());
 
+function testMemberCache() {
+    var objs = [{x: 1, y: 2}, {y: 3, x: 4}, {z: 5}, {a: 0, x: 6}], i, r = "";
+
+    for(i = 0; i < objs.length; i++)
+        r += objs[i].x + ",";
+    ok(r === "1,4,undefined,6,", "r = " + r);
+
+    var o = {x: 1};
+    for(i = 0; i < 3; i++) {
+        if(i == 1)
+            delete o.x;
+        if(i == 2)
+            o.x = 7;
+        r = o.x;
+    }
+    ok(r === 7, "o.x = " + r);
+
+    function C() {}
+    C.prototype.v = 1;
+    var c = new C();
+    r = "";
+    for(i = 0; i < 3; i++) {
+        if(i == 1)
+            C.prototype.v = 2;
+        if(i == 2)
+            c.v = 3;
+        r += c.v;
+    }
+    ok(r === "123", "c.v = " + r);
+
+    var arr = [5, 6, 7];
+    arr[2.5] = 8;
+    arr[-1] = 9;
+    ok(arr[0] === 5 && arr[2] === 7, "arr[0] = " + arr[0] + " arr[2] = " + arr[2]);
+    ok(arr["2.5"] === 8 && arr[-1] === 9, "arr[2.5] = " + arr[2.5] + " arr[-1] = " + arr[-1]);
+    ok(arr[-0] === 5, "arr[-0] = " + arr[-0]);
+    arr[1]++;
+    ok(arr[1] === 7, "arr[1] = " + arr[1]);
+}
+
+testMemberCache();
+
 /* Keep this test in the end of file */
 undefined = 6;
 ok(undefined === 6, "undefined = " + undefined);
@@ -1078,6 +1078,116 @@ nt4_is_broken:
     }
 }
 
+static BOOL write_test_dll(const char *dll_name, ULONG_PTR image_base, DWORD page_size)
+{
+    static const char filler[0x1000];
+    static const char section_data[0x10] = "section data";
+    DWORD dummy, file_align;
+    HANDLE hfile;
+    BOOL ret;
+
+    hfile = CreateFileA(dll_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, 0);
+    if (hfile == INVALID_HANDLE_VALUE) return FALSE;
+
+    nt_header.FileHeader.NumberOfSections = 1;
+    nt_header.FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+    nt_header.FileHeader.Characteristics = IMAGE_FILE_EXECUTABLE_IMAGE | IMAGE_FILE_DLL | IMAGE_FILE_RELOCS_STRIPPED;
+
+    nt_header.OptionalHeader.ImageBase = image_base;
+    nt_header.OptionalHeader.SectionAlignment = page_size;
+    nt_header.OptionalHeader.FileAlignment = 0x200;
+    nt_header.OptionalHeader.SizeOfImage = sizeof(dos_header) + sizeof(nt_header) + sizeof(IMAGE_SECTION_HEADER) + page_size;
+    nt_header.OptionalHeader.SizeOfHeaders = sizeof(dos_header) + sizeof(nt_header) + sizeof(IMAGE_SECTION_HEADER);
+
+    section.SizeOfRawData = sizeof(section_data);
+    section.PointerToRawData = nt_header.OptionalHeader.FileAlignment;
+    section.VirtualAddress = nt_header.OptionalHeader.SectionAlignment;
+    section.Misc.VirtualSize = section.SizeOfRawData;
+    section.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ;
+
+    file_align = nt_header.OptionalHeader.FileAlignment - nt_header.OptionalHeader.SizeOfHeaders;
+    assert(file_align < sizeof(filler));
+
+    ret = WriteFile(hfile, &dos_header, sizeof(dos_header), &dummy, NULL) &&
+          WriteFile(hfile, &nt_header, sizeof(DWORD) + sizeof(IMAGE_FILE_HEADER), &dummy, NULL) &&
+          WriteFile(hfile, &nt_header.OptionalHeader, sizeof(IMAGE_OPTIONAL_HEADER), &dummy, NULL) &&
+          WriteFile(hfile, &section, sizeof(section), &dummy, NULL) &&
+          WriteFile(hfile, filler, file_align, &dummy, NULL) &&
+          WriteFile(hfile, section_data, sizeof(section_data), &dummy, NULL);
+    CloseHandle(hfile);
+
+    nt_header.OptionalHeader.ImageBase = 0x10000000;
+    return ret;
+}
+
+static void test_same_basename(void)
+{
+    static const char base_name[] = "ldr_same.dll";
+    char temp_path[MAX_PATH], dir[2][MAX_PATH], dll_name[2][MAX_PATH];
+    HMODULE hlib[2], hmod;
+    SYSTEM_INFO si;
+    BOOL ret;
+    int i;
+
+    GetSystemInfo(&si);
+    SetErrorMode(SEM_FAILCRITICALERRORS);
+    GetTempPath(MAX_PATH, temp_path);
+
+    for (i = 0; i < 2; i++)
+    {
+        sprintf(dir[i], "%sldr_same%d", temp_path, i);
+        sprintf(dll_name[i], "%s\\%s", dir[i], base_name);
+        hlib[i] = 0;
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        CreateDirectoryA(dir[i], NULL);
+        if (!write_test_dll(dll_name[i], 0x10000000 + i * 0x1000000, si.dwPageSize))
+        {
+            ok(0, "could not create %s\n", dll_name[i]);
+            goto done;
+        }
+    }
+
+    ok(!GetModuleHandleA(base_name), "%s is already loaded\n", base_name);
+
+    for (i = 0; i < 2; i++)
+    {
+        SetLastError(0xdeadbeef);
+        hlib[i] = LoadLibraryA(dll_name[i]);
+        ok(hlib[i] != 0, "LoadLibrary(%s) error %d\n", dll_name[i], GetLastError());
+    }
+    if (!hlib[0] || !hlib[1]) goto done;
+    ok(hlib[0] != hlib[1], "both paths loaded at %p\n", hlib[0]);
+
+    /* lookups by base name find the module that was loaded first */
+    hmod = GetModuleHandleA(base_name);
+    ok(hmod == hlib[0], "GetModuleHandle returned %p, expected %p\n", hmod, hlib[0]);
+    hmod = LoadLibraryA(base_name);
+    ok(hmod == hlib[0], "LoadLibrary returned %p, expected %p\n", hmod, hlib[0]);
+    if (hmod) FreeLibrary(hmod);
+
+    ret = FreeLibrary(hlib[0]);
+    ok(ret, "FreeLibrary error %d\n", GetLastError());
+    hlib[0] = 0;
+    hmod = GetModuleHandleA(base_name);
+    ok(hmod == hlib[1], "GetModuleHandle returned %p, expected %p\n", hmod, hlib[1]);
+
+    ret = FreeLibrary(hlib[1]);
+    ok(ret, "FreeLibrary error %d\n", GetLastError());
+    hlib[1] = 0;
+    ok(!GetModuleHandleA(base_name), "%s is still loaded\n", base_name);
+
+done:
+    for (i = 0; i < 2; i++)
+    {
+        if (hlib[i]) FreeLibrary(hlib[i]);
+        DeleteFileA(dll_name[i]);
+        RemoveDirectoryA(dir[i]);
+    }
+}
+
 #define MAX_COUNT 10
 static HANDLE attached_thread[MAX_COUNT];
 static DWORD attached_thread_count;
@@ -2224,5 +2334,6 @@ START_TEST(loader)
     test_Loader();
     test_ImportDescriptors();
     test_section_access();
+    test_same_basename();
     test_ExitProcess();
 }
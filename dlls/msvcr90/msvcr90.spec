@@ -477,7 +477,7 @@
 @ cdecl _fputchar(long) msvcrt._fputchar
 @ stub _fputwc_nolock
 @ cdecl _fputwchar(long) msvcrt._fputwchar
-@ stub _fread_nolock
+@ cdecl _fread_nolock(ptr long long ptr) msvcrt._fread_nolock
 @ stub _fread_nolock_s
 @ cdecl _free_locale(ptr) msvcrt._free_locale
 @ stub _freea
@@ -508,7 +508,7 @@
 @ stub _fwprintf_p
 @ stub _fwprintf_p_l
 @ stub _fwprintf_s_l
-@ stub _fwrite_nolock
+@ cdecl _fwrite_nolock(ptr long long ptr) msvcrt._fwrite_nolock
 @ varargs _fwscanf_l(ptr wstr ptr) msvcrt._fwscanf_l
 @ varargs _fwscanf_s_l(ptr wstr ptr) msvcrt._fwscanf_s_l
 @ cdecl _gcvt(double long str) msvcrt._gcvt
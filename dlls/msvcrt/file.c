@@ -577,9 +577,9 @@ static BOOL msvcrt_alloc_buffer(MSVCRT_FILE* file)
             && MSVCRT__isatty(file->_file))
         return FALSE;
 
-    file->_base = MSVCRT_calloc(MSVCRT_BUFSIZ,1);
+    file->_base = MSVCRT_calloc(MSVCRT_INTERNAL_BUFSIZ,1);
     if(file->_base) {
-        file->_bufsiz = MSVCRT_BUFSIZ;
+        file->_bufsiz = MSVCRT_INTERNAL_BUFSIZ;
         file->_flag |= MSVCRT__IOMYBUF;
     } else {
         file->_base = (char*)(&file->_charbuf);
@@ -3238,10 +3238,31 @@ char * CDECL MSVCRT_fgets(char *s, int size, MSVCRT_FILE* file)
 
   MSVCRT__lock_file(file);
 
-  while ((size >1) && (cc = MSVCRT_fgetc(file)) != MSVCRT_EOF && cc != '\n')
+  while (size > 1)
     {
+      if (file->_cnt > 0)
+        {
+          /* copy up to the end of the line straight from the buffer */
+          int len = min(file->_cnt, size - 1);
+          char *nl = memchr(file->_ptr, '\n', len);
+
+          if (nl) len = nl - file->_ptr + 1;
+          memcpy(s, file->_ptr, len);
+          file->_ptr += len;
+          file->_cnt -= len;
+          s += len;
+          size -= len;
+          cc = (unsigned char)s[-1];
+          if (nl) break;
+          continue;
+        }
+
+      if ((cc = MSVCRT__filbuf(file)) == MSVCRT_EOF)
+        break;
       *s++ = (char)cc;
-      size --;
+      size--;
+      if (cc == '\n')
+        break;
     }
   if ((cc == MSVCRT_EOF) && (s == buf_start)) /* If nothing read, return 0*/
   {
@@ -3249,8 +3270,6 @@ char * CDECL MSVCRT_fgets(char *s, int size, MSVCRT_FILE* file)
     MSVCRT__unlock_file(file);
     return NULL;
   }
-  if ((cc != MSVCRT_EOF) && (size > 1))
-    *s++ = cc;
   *s = '\0';
   TRACE(":got %s\n", debugstr_a(buf_start));
   MSVCRT__unlock_file(file);
@@ -3387,55 +3406,83 @@ MSVCRT_wchar_t * CDECL MSVCRT_fgetws(MSVCRT_wchar_t *s, int size, MSVCRT_FILE* f
 }
 
 /*********************************************************************
- *		fwrite (MSVCRT.@)
+ *		_fwrite_nolock (MSVCR80.@)
  */
-MSVCRT_size_t CDECL MSVCRT_fwrite(const void *ptr, MSVCRT_size_t size, MSVCRT_size_t nmemb, MSVCRT_FILE* file)
+MSVCRT_size_t CDECL MSVCRT__fwrite_nolock(const void *ptr, MSVCRT_size_t size, MSVCRT_size_t nmemb, MSVCRT_FILE* file)
 {
     MSVCRT_size_t wrcnt=size * nmemb;
     int written = 0;
     if (size == 0)
         return 0;
 
-    MSVCRT__lock_file(file);
-    if(file->_cnt) {
-        int pcnt=(file->_cnt>wrcnt)? wrcnt: file->_cnt;
-        memcpy(file->_ptr, ptr, pcnt);
-        file->_cnt -= pcnt;
-        file->_ptr += pcnt;
-        written = pcnt;
-        wrcnt -= pcnt;
-        ptr = (const char*)ptr + pcnt;
-    } else if(!(file->_flag & MSVCRT__IOWRT)) {
-        if(file->_flag & MSVCRT__IORW) {
-            file->_flag |= MSVCRT__IOWRT;
-        } else {
-            MSVCRT__unlock_file(file);
-            return 0;
+    while(wrcnt) {
+        int pcnt, pwritten;
+
+        if(file->_cnt > 0) {
+            pcnt = (file->_cnt>wrcnt)? wrcnt: file->_cnt;
+            memcpy(file->_ptr, ptr, pcnt);
+            file->_cnt -= pcnt;
+            file->_ptr += pcnt;
+            written += pcnt;
+            wrcnt -= pcnt;
+            ptr = (const char*)ptr + pcnt;
+            continue;
+        }
+
+        if(!(file->_flag & MSVCRT__IOWRT)) {
+            if(file->_flag & MSVCRT__IORW)
+                file->_flag |= MSVCRT__IOWRT;
+            else
+                break;
         }
-    }
-    if(wrcnt) {
-        int res;
 
         if(file->_bufsiz == 0 && !(file->_flag & MSVCRT__IONBF))
             msvcrt_alloc_buffer(file);
 
         /* Flush buffer */
-        res=msvcrt_flush_buffer(file);
-        if(!res) {
-            int pwritten = MSVCRT__write(file->_file, ptr, wrcnt);
-            if (pwritten <= 0)
-            {
-                file->_flag |= MSVCRT__IOERR;
-                pwritten=0;
-            }
-            written += pwritten;
+        if(msvcrt_flush_buffer(file))
+            break;
+
+        /* the rest fits in the buffer */
+        if(file->_bufsiz && wrcnt < file->_bufsiz)
+            continue;
+
+        /* write whole buffers directly, the tail is buffered */
+        pcnt = wrcnt > INT_MAX ? INT_MAX : wrcnt;
+        if(file->_bufsiz)
+            pcnt -= pcnt % file->_bufsiz;
+        pwritten = MSVCRT__write(file->_file, ptr, pcnt);
+        if (pwritten <= 0)
+        {
+            file->_flag |= MSVCRT__IOERR;
+            break;
+        }
+        written += pwritten;
+        wrcnt -= pwritten;
+        ptr = (const char*)ptr + pwritten;
+        if (pwritten != pcnt)
+        {
+            file->_flag |= MSVCRT__IOERR;
+            break;
         }
     }
 
-    MSVCRT__unlock_file(file);
     return written / size;
 }
 
+/*********************************************************************
+ *		fwrite (MSVCRT.@)
+ */
+MSVCRT_size_t CDECL MSVCRT_fwrite(const void *ptr, MSVCRT_size_t size, MSVCRT_size_t nmemb, MSVCRT_FILE* file)
+{
+    MSVCRT_size_t ret;
+
+    MSVCRT__lock_file(file);
+    ret = MSVCRT__fwrite_nolock(ptr, size, nmemb, file);
+    MSVCRT__unlock_file(file);
+    return ret;
+}
+
 /*********************************************************************
  *		fputwc (MSVCRT.@)
  */
@@ -3664,9 +3711,9 @@ int CDECL MSVCRT__fputchar(int c)
 }
 
 /*********************************************************************
- *		fread (MSVCRT.@)
+ *		_fread_nolock (MSVCR80.@)
  */
-MSVCRT_size_t CDECL MSVCRT_fread(void *ptr, MSVCRT_size_t size, MSVCRT_size_t nmemb, MSVCRT_FILE* file)
+MSVCRT_size_t CDECL MSVCRT__fread_nolock(void *ptr, MSVCRT_size_t size, MSVCRT_size_t nmemb, MSVCRT_FILE* file)
 {
   MSVCRT_size_t rcnt=size * nmemb;
   MSVCRT_size_t read=0;
@@ -3675,8 +3722,6 @@ MSVCRT_size_t CDECL MSVCRT_fread(void *ptr, MSVCRT_size_t size, MSVCRT_size_t nm
   if(!rcnt)
 	return 0;
 
-  MSVCRT__lock_file(file);
-
   /* first buffered data */
   if(file->_cnt>0) {
 	int pcnt= (rcnt>file->_cnt)? file->_cnt:rcnt;
@@ -3690,15 +3735,14 @@ MSVCRT_size_t CDECL MSVCRT_fread(void *ptr, MSVCRT_size_t size, MSVCRT_size_t nm
 	if(file->_flag & MSVCRT__IORW) {
 		file->_flag |= MSVCRT__IOREAD;
 	} else {
-        MSVCRT__unlock_file(file);
         return 0;
     }
   }
   while(rcnt>0)
   {
     int i;
-    if (!file->_cnt && rcnt<MSVCRT_BUFSIZ && !(file->_flag & MSVCRT__IONBF)
-            && (file->_bufsiz != 0 || msvcrt_alloc_buffer(file))) {
+    if (!file->_cnt && !(file->_flag & MSVCRT__IONBF)
+            && (file->_bufsiz != 0 || msvcrt_alloc_buffer(file)) && rcnt<file->_bufsiz) {
       file->_cnt = MSVCRT__read(file->_file, file->_base, file->_bufsiz);
       file->_ptr = file->_base;
       i = (file->_cnt<rcnt) ? file->_cnt : rcnt;
@@ -3736,10 +3780,22 @@ MSVCRT_size_t CDECL MSVCRT_fread(void *ptr, MSVCRT_size_t size, MSVCRT_size_t nm
     if (i < 1) break;
   }
   read+=pread;
-  MSVCRT__unlock_file(file);
   return read / size;
 }
 
+/*********************************************************************
+ *		fread (MSVCRT.@)
+ */
+MSVCRT_size_t CDECL MSVCRT_fread(void *ptr, MSVCRT_size_t size, MSVCRT_size_t nmemb, MSVCRT_FILE* file)
+{
+  MSVCRT_size_t ret;
+
+  MSVCRT__lock_file(file);
+  ret = MSVCRT__fread_nolock(ptr, size, nmemb, file);
+  MSVCRT__unlock_file(file);
+  return ret;
+}
+
 
 /* fread_s - not exported in native msvcrt */
 MSVCRT_size_t CDECL fread_s(void *buf, MSVCRT_size_t buf_size, MSVCRT_size_t elem_size,
@@ -3994,7 +4050,7 @@ int CDECL MSVCRT_fputs(const char *s, MSVCRT_FILE* file)
     int ret;
 
     MSVCRT__lock_file(file);
-    ret = MSVCRT_fwrite(s, sizeof(*s), len, file) == len ? 0 : MSVCRT_EOF;
+    ret = MSVCRT__fwrite_nolock(s, sizeof(*s), len, file) == len ? 0 : MSVCRT_EOF;
     MSVCRT__unlock_file(file);
     return ret;
 }
@@ -4209,12 +4265,17 @@ int CDECL MSVCRT_setvbuf(MSVCRT_FILE* file, char *buf, int mode, MSVCRT_size_t s
 {
   MSVCRT__lock_file(file);
   if(file->_bufsiz) {
-	MSVCRT_free(file->_base);
+	if(file->_flag & MSVCRT__IOMYBUF)
+		MSVCRT_free(file->_base);
+	file->_flag &= ~MSVCRT__IOMYBUF;
 	file->_bufsiz = 0;
 	file->_cnt = 0;
   }
   if(mode == MSVCRT__IOFBF) {
 	file->_flag &= ~MSVCRT__IONBF;
+	/* allocate a buffer of the requested size */
+	if(!buf && size >= 2 && size <= INT_MAX && (buf = MSVCRT_malloc(size)))
+		file->_flag |= MSVCRT__IOMYBUF;
   	file->_base = file->_ptr = buf;
   	if(buf) {
 		file->_bufsiz = size;
@@ -1035,7 +1035,20 @@ unsigned char* CDECL _mbscpy( unsigned char *dst, const unsigned char *src )
  */
 unsigned char * CDECL _mbsstr(const unsigned char *haystack, const unsigned char *needle)
 {
-    return (unsigned char *)strstr( (const char *)haystack, (const char *)needle );
+    const unsigned char *match;
+
+    if (!get_mbcinfo()->ismbcodepage)
+        return (unsigned char *)strstr( (const char *)haystack, (const char *)needle );
+
+    /* strstr() may match on a trail byte, only accept matches that
+     * start on a character boundary and retry after the others */
+    while ((match = (const unsigned char *)strstr( (const char *)haystack, (const char *)needle )))
+    {
+        while (haystack < match)
+            haystack += (_ismbblead(*haystack) && haystack[1]) ? 2 : 1;
+        if (haystack == match) return (unsigned char *)match;
+    }
+    return NULL;
 }
 
 /*********************************************************************
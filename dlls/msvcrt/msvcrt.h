@@ -627,6 +627,7 @@ struct MSVCRT__stat64 {
 #define MSVCRT_TMP_MAX   0x7fff
 #define MSVCRT_RAND_MAX  0x7fff
 #define MSVCRT_BUFSIZ    512
+#define MSVCRT_INTERNAL_BUFSIZ 4096
 
 #define MSVCRT_STDIN_FILENO  0
 #define MSVCRT_STDOUT_FILENO 1
@@ -1532,5 +1532,7 @@
 @ cdecl _set_printf_count_output(long) MSVCRT__set_printf_count_output
 @ cdecl _getptd()
 @ cdecl fread_s(ptr long long long ptr)
+@ cdecl _fread_nolock(ptr long long ptr) MSVCRT__fread_nolock
+@ cdecl _fwrite_nolock(ptr long long ptr) MSVCRT__fwrite_nolock
 @ cdecl _fstat32(long ptr)
 @ cdecl _fstat64i32(long ptr)
@@ -298,6 +298,58 @@ static inline void FUNC_NAME(pf_integer_conv)(APICHAR *buf, int buf_len,
     }
 }
 
+/* pf_fixed_conv:  prints a non-negative double in %f format using integer
+   arithmetic, rounding ties to even like the host sprintf does. Returns
+   -1 for values that can't be represented exactly in 60 fractional bits */
+static inline int FUNC_NAME(pf_fixed_conv)(char *buf, double val, int prec, APICHAR alternate)
+{
+    union { double f; ULONGLONG i; } u;
+    ULONGLONG ip, frac = 0;
+    char digits[20];
+    int i, n = 0, len = 0;
+
+    u.f = val;
+    if(u.i && !(val >= 1.0/256 && val < 9223372036854775808.0))
+        return -1;
+    if(prec > 17)
+        return -1;
+
+    ip = val;
+    /* the fraction has at most 60 significant bits, the scaling is exact */
+    if(u.i)
+        frac = (val - (double)ip) * 1152921504606846976.0;
+
+    for(i=0; i<prec; i++) {
+        frac *= 10;
+        buf[i] = '0' + (frac >> 60);
+        frac &= ((ULONGLONG)1 << 60) - 1;
+    }
+
+    if(frac > (ULONGLONG)1 << 59 || (frac == (ULONGLONG)1 << 59 &&
+                ((prec ? buf[prec-1]-'0' : ip) & 1))) {
+        for(i=prec-1; i>=0 && buf[i]=='9'; i--)
+            buf[i] = '0';
+        if(i >= 0)
+            buf[i]++;
+        else
+            ip++;
+    }
+
+    do {
+        digits[n++] = '0' + ip%10;
+        ip /= 10;
+    } while(ip);
+
+    memmove(buf+n+(prec || alternate), buf, prec);
+    while(n)
+        buf[len++] = digits[--n];
+    if(prec || alternate)
+        buf[len++] = '.';
+    len += prec;
+    buf[len] = 0;
+    return len;
+}
+
 static inline void FUNC_NAME(pf_fixup_exponent)(char *buf)
 {
     char* tmp = buf;
@@ -533,37 +585,44 @@ int FUNC_NAME(pf_printf)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx, const API
             if(tmp != buf)
                 HeapFree(GetProcessHeap(), 0, tmp);
         } else if(flags.Format && strchr("aeEfgG", flags.Format)) {
-            char float_fmt[20], buf_a[32], *tmp = buf_a, *decimal_point;
-            int len = flags.Precision + 10;
+            char float_fmt[20], buf_a[48], *tmp = buf_a, *decimal_point;
+            int len = -1;
             double val = pf_args(args_ctx, pos, VT_R8, valist).get_double;
             int r;
 
-            if(flags.Format=='f') {
-                if(val>-10.0 && val<10.0)
-                    i = 1;
-                else
-                    i = 1 + log10(val<0 ? -val : val);
-                /* Default precision is 6, additional space for sign, separator and nullbyte is required */
-                i += (flags.Precision==-1 ? 6 : flags.Precision) + 3;
-
-                if(i > len)
-                    len = i;
-            }
-
-            if(len > sizeof(buf_a))
-                tmp = HeapAlloc(GetProcessHeap(), 0, len);
-            if(!tmp)
-                return -1;
-
-            FUNC_NAME(pf_rebuild_format_string)(float_fmt, &flags);
             if(val < 0) {
                 flags.Sign = '-';
                 val = -val;
             }
 
-            sprintf(tmp, float_fmt, val);
-            if(toupper(flags.Format)=='E' || toupper(flags.Format)=='G')
-                FUNC_NAME(pf_fixup_exponent)(tmp);
+            if(flags.Format=='f')
+                len = FUNC_NAME(pf_fixed_conv)(tmp, val,
+                        flags.Precision==-1 ? 6 : flags.Precision, flags.Alternate);
+
+            if(len < 0) {
+                len = flags.Precision + 10;
+                if(flags.Format=='f') {
+                    if(val<10.0)
+                        i = 1;
+                    else
+                        i = 1 + log10(val);
+                    /* Default precision is 6, additional space for sign, separator and nullbyte is required */
+                    i += (flags.Precision==-1 ? 6 : flags.Precision) + 3;
+
+                    if(i > len)
+                        len = i;
+                }
+
+                if(len > sizeof(buf_a))
+                    tmp = HeapAlloc(GetProcessHeap(), 0, len);
+                if(!tmp)
+                    return -1;
+
+                FUNC_NAME(pf_rebuild_format_string)(float_fmt, &flags);
+                sprintf(tmp, float_fmt, val);
+                if(toupper(flags.Format)=='E' || toupper(flags.Format)=='G')
+                    FUNC_NAME(pf_fixup_exponent)(tmp);
+            }
 
             decimal_point = strchr(tmp, '.');
             if(decimal_point)
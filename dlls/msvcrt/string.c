@@ -280,16 +280,24 @@ void CDECL MSVCRT__swab(char* src, char* dst, int len)
   }
 }
 
+/* enough significant digits to always round correctly, the remaining
+ * ones are only recorded as a sticky nonzero digit */
+#define STRTOD_MAX_DIGITS 780
+
 static double strtod_helper(const char *str, char **end, MSVCRT__locale_t locale, int *err)
 {
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
     MSVCRT_pthreadlocinfo locinfo;
-    unsigned __int64 d=0, hlp;
+    char digits[STRTOD_MAX_DIGITS + 16];
+    unsigned __int64 d=0;
     unsigned fpcontrol;
-    int exp=0, sign=1;
+    int exp=0, sign=1, nd=0, i;
     const char *p;
     double ret;
-    long double lret=1, expcnt = 10;
-    BOOL found_digit = FALSE, negexp;
+    BOOL found_digit = FALSE, sticky = FALSE;
 
     if(err)
         *err = 0;
@@ -312,34 +320,41 @@ static double strtod_helper(const char *str, char **end, MSVCRT__locale_t locale
     } else  if(*p == '+')
         p++;
 
-    while(isdigit(*p)) {
+    /* the value is digits[0..nd) * 10^exp, leading zeros are skipped */
+    while(*p == '0') {
         found_digit = TRUE;
-        hlp = d*10+*(p++)-'0';
-        if(d>MSVCRT_UI64_MAX/10 || hlp<d) {
-            exp++;
-            break;
-        } else
-            d = hlp;
+        p++;
     }
     while(isdigit(*p)) {
-        exp++;
+        found_digit = TRUE;
+        if(nd < STRTOD_MAX_DIGITS)
+            digits[nd++] = *p;
+        else {
+            if(*p != '0') sticky = TRUE;
+            exp++;
+        }
         p++;
     }
 
     if(*p == *locinfo->lconv->decimal_point)
         p++;
 
+    if(!nd) {
+        while(*p == '0') {
+            found_digit = TRUE;
+            exp--;
+            p++;
+        }
+    }
     while(isdigit(*p)) {
         found_digit = TRUE;
-        hlp = d*10+*(p++)-'0';
-        if(d>MSVCRT_UI64_MAX/10 || hlp<d)
-            break;
-
-        d = hlp;
-        exp--;
-    }
-    while(isdigit(*p))
+        if(nd < STRTOD_MAX_DIGITS) {
+            digits[nd++] = *p;
+            exp--;
+        } else if(*p != '0')
+            sticky = TRUE;
         p++;
+    }
 
     if(!found_digit) {
         if(end)
@@ -375,33 +390,42 @@ static double strtod_helper(const char *str, char **end, MSVCRT__locale_t locale
         }
     }
 
+    if(end)
+        *end = (char*)p;
+
+    if(!nd)
+        return sign * 0.0;
+
+    for(i=0; i<nd && i<19; i++)
+        d = d*10 + digits[i]-'0';
+
     fpcontrol = _control87(0, 0);
     _control87(MSVCRT__EM_DENORMAL|MSVCRT__EM_INVALID|MSVCRT__EM_ZERODIVIDE
-            |MSVCRT__EM_OVERFLOW|MSVCRT__EM_UNDERFLOW|MSVCRT__EM_INEXACT, 0xffffffff);
-
-    negexp = (exp < 0);
-    if(negexp)
-        exp = -exp;
-    while(exp) {
-        if(exp & 1)
-            lret *= expcnt;
-        exp /= 2;
-        expcnt = expcnt*expcnt;
+            |MSVCRT__EM_OVERFLOW|MSVCRT__EM_UNDERFLOW|MSVCRT__EM_INEXACT
+            |MSVCRT__PC_53, 0xffffffff);
+
+    if(nd<=19 && d<=((unsigned __int64)1<<53) && exp>=-22 && exp<=22) {
+        /* both operands are exact, so a single rounding gives the correctly rounded result */
+        ret = exp<0 ? (double)d/pow10[-exp] : (double)d*pow10[exp];
+    } else {
+        if(sticky && exp>INT_MIN) {
+            digits[nd++] = '1';
+            exp--;
+        }
+        sprintf(digits+nd, "e%d", exp);
+        ret = strtod(digits, NULL);
     }
-    ret = (long double)sign * (negexp ? d/lret : d*lret);
+    ret *= sign;
 
     _control87(fpcontrol, 0xffffffff);
 
-    if((d && ret==0.0) || isinf(ret)) {
+    if(ret==0.0 || isinf(ret)) {
         if(err)
             *err = MSVCRT_ERANGE;
         else
             *MSVCRT__errno() = MSVCRT_ERANGE;
     }
 
-    if(end)
-        *end = (char*)p;
-
     return ret;
 }
 
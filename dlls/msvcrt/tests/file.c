@@ -506,6 +506,75 @@ static void test_readboundary(void)
   ok(strcmp(buf, rbuf) == 0,"CRLF on buffer boundary failure\n");
   }
 
+static void test_fgets_long_lines(void)
+{
+  static const int lens[] = {1, 700, 5000, 10000};
+  char *tempf, *line, *buf;
+  FILE *tempfh;
+  int i, j, ret;
+
+  line = malloc(10002);
+  buf = malloc(10002);
+
+  tempf=_tempnam(".","wne");
+  tempfh = fopen(tempf,"wt");
+  for (i = 0; i < sizeof(lens)/sizeof(lens[0]); i++)
+  {
+    for (j = 0; j < lens[i]; j++)
+      ok(fputc('a' + (i + j) % 26, tempfh) != EOF, "fputc failed\n");
+    ok(fwrite("\n", 1, 1, tempfh) == 1, "fwrite failed\n");
+  }
+  fclose(tempfh);
+
+  tempfh = fopen(tempf,"rt");
+  for (i = 0; i < sizeof(lens)/sizeof(lens[0]); i++)
+  {
+    for (j = 0; j < lens[i]; j++)
+      line[j] = 'a' + (i + j) % 26;
+    line[j++] = '\n';
+    line[j] = 0;
+
+    ok(fgets(buf, 10002, tempfh) == buf, "fgets failed for line %d\n", i);
+    ok(!strcmp(buf, line), "wrong data in line %d (len %d)\n", i, lstrlenA(buf));
+  }
+  ok(fgets(buf, 10002, tempfh) == NULL, "expected EOF\n");
+  ok(feof(tempfh) != 0, "expected EOF flag\n");
+
+  /* lines longer than the destination are split */
+  rewind(tempfh);
+  ok(fgets(buf, 2, tempfh) == buf, "fgets failed\n");
+  ok(!strcmp(buf, "a"), "got %s\n", buf);
+  ok(fgets(buf, 2, tempfh) == buf, "fgets failed\n");
+  ok(!strcmp(buf, "\n"), "got %s\n", buf);
+  ok(fgets(buf, 100, tempfh) == buf, "fgets failed\n");
+  ok(strlen(buf) == 99, "got %d\n", lstrlenA(buf));
+  ok(ftell(tempfh) == 102, "ftell returned %d\n", ftell(tempfh));
+  fclose(tempfh);
+
+  /* data written through a buffer set by setvbuf must end up in the file */
+  tempfh = fopen(tempf,"wb");
+  ret = setvbuf(tempfh, NULL, _IOFBF, 1000);
+  ok(!ret, "setvbuf returned %d\n", ret);
+  for (i = 0; i < 3000; i++)
+    ok(fwrite(&i, sizeof(i), 1, tempfh) == 1, "fwrite failed\n");
+  fclose(tempfh);
+
+  tempfh = fopen(tempf,"rb");
+  for (i = 0; i < 3000; i++)
+  {
+    ok(fread(&j, sizeof(j), 1, tempfh) == 1, "fread failed\n");
+    if (j != i) break;
+  }
+  ok(i == 3000, "wrong data at %d\n", i);
+  ok(fread(&j, sizeof(j), 1, tempfh) == 0, "expected EOF\n");
+  fclose(tempfh);
+
+  unlink(tempf);
+  free(tempf);
+  free(buf);
+  free(line);
+}
+
 static void test_fgetc( void )
 {
   char* tempf;
@@ -2173,6 +2242,7 @@ START_TEST(file)
     test_readmode(FALSE); /* binary mode */
     test_readmode(TRUE);  /* ascii mode */
     test_readboundary();
+    test_fgets_long_lines();
     test_fgetc();
     test_fputc();
     test_flsbuf();
@@ -512,6 +512,34 @@ static void test_sprintf( void )
     ok(!strcmp(buffer,"1"), "failed\n");
     ok( r==1, "return count wrong\n");
 
+    r = sprintf(buffer, "%f", 123.456);
+    ok(!strcmp(buffer,"123.456000"), "failed: \"%s\"\n", buffer);
+    ok( r==10, "return count wrong\n");
+
+    r = sprintf(buffer, "%.10f", 1.0/3);
+    ok(!strcmp(buffer,"0.3333333333"), "failed: \"%s\"\n", buffer);
+    ok( r==12, "return count wrong\n");
+
+    r = sprintf(buffer, "%.1f", 9.96);
+    ok(!strcmp(buffer,"10.0"), "failed: \"%s\"\n", buffer);
+    ok( r==4, "return count wrong\n");
+
+    r = sprintf(buffer, "%#.0f", 3.0);
+    ok(!strcmp(buffer,"3."), "failed: \"%s\"\n", buffer);
+    ok( r==2, "return count wrong\n");
+
+    r = sprintf(buffer, "%08.2f", -0.001);
+    ok(!strcmp(buffer,"-0000.00"), "failed: \"%s\"\n", buffer);
+    ok( r==8, "return count wrong\n");
+
+    r = sprintf(buffer, "%f", 0.0);
+    ok(!strcmp(buffer,"0.000000"), "failed: \"%s\"\n", buffer);
+    ok( r==8, "return count wrong\n");
+
+    r = sprintf(buffer, "%.3f", 4294967296.0005);
+    ok(!strcmp(buffer,"4294967296.000"), "failed: \"%s\"\n", buffer);
+    ok( r==14, "return count wrong\n");
+
     format = "%2.4e";
     r = sprintf(buffer, format,8.6);
     ok(!strcmp(buffer,"8.6000e+000"), "failed\n");
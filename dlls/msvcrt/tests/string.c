@@ -464,6 +464,31 @@ static void test_mbsspn( void)
     ok( ret==0, "_mbsspn returns %d should be 0\n", ret);
 }
 
+static void test_mbsstr(void)
+{
+    unsigned char str[] = "ab\x82\xa0\x82\xa1" "cd";
+    unsigned char needle1[] = "\xa0\x82";
+    unsigned char needle2[] = "\x82\xa1";
+    unsigned char needle3[] = "cd";
+    unsigned char *ret;
+    unsigned int prev_cp = _getmbcp();
+
+    _setmbcp(1252);
+    ret = _mbsstr(str, needle1);
+    ok(ret == str + 3, "_mbsstr returned %p, expected %p\n", ret, str + 3);
+
+    _setmbcp(932);
+    ret = _mbsstr(str, needle1);
+    ok(ret == NULL, "_mbsstr matched a trail byte at %p\n", ret);
+    ret = _mbsstr(str, needle2);
+    ok(ret == str + 4, "_mbsstr returned %p, expected %p\n", ret, str + 4);
+    ret = _mbsstr(str, needle3);
+    ok(ret == str + 6, "_mbsstr returned %p, expected %p\n", ret, str + 6);
+    ret = _mbsstr(str, (unsigned char *)"");
+    ok(ret == str, "_mbsstr returned %p, expected %p\n", ret, str);
+    _setmbcp(prev_cp);
+}
+
 static void test_mbsspnp( void)
 {
     unsigned char str1[]="cabernet";
@@ -1536,6 +1561,20 @@ static void test__strtod(void)
     ok(almost_equal(d, 0), "d = %lf\n", d);
     ok(end == white_chars, "incorrect end (%d)\n", (int)(end-white_chars));
 
+    /* results are correctly rounded */
+    d = strtod("0.1", NULL);
+    ok(d == 0.1, "d = %.17g\n", d);
+    d = strtod("123.456", NULL);
+    ok(d == 123.456, "d = %.17g\n", d);
+    d = strtod("1e23", NULL);
+    ok(d == 1e23, "d = %.17g\n", d);
+    d = strtod("0.000001234567890123456789", NULL);
+    ok(d == 1.234567890123456789e-6, "d = %.17g\n", d);
+    d = strtod("1.7976931348623157e308", NULL);
+    ok(d == 1.7976931348623157e308, "d = %.17g\n", d);
+    d = strtod("2.2250738585072014e-308", NULL);
+    ok(d == 2.2250738585072014e-308, "d = %.17g\n", d);
+
     /* Set locale with non '.' decimal point (',') */
     if(!setlocale(LC_ALL, "Polish")) {
         win_skip("system with limited locales\n");
@@ -2620,6 +2659,7 @@ START_TEST(string)
    /* test _mbsspn */
     test_mbsspn();
     test_mbsspnp();
+    test_mbsstr();
    /* test _strdup */
     test_strdup();
     test_strcpy_s();
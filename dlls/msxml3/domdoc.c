@@ -86,6 +86,9 @@ typedef struct {
     xmlChar const* selectNsStr;
     LONG selectNsStr_len;
     BOOL XPath;
+    struct list queries;
+    int query_count;
+    CRITICAL_SECTION cs; /* protects the query cache and selection namespaces */
 } domdoc_properties;
 
 typedef struct ConnectionPoint ConnectionPoint;
@@ -222,6 +225,17 @@ typedef struct _select_ns_entry {
     xmlChar href_end;
 } select_ns_entry;
 
+/* Compiled selectNodes()/selectSingleNode() queries. XSLPattern translation
+ * depends on selection namespaces, so the cache is reset when they change. */
+#define QUERY_CACHE_SIZE 32
+
+typedef struct _query_entry {
+    struct list entry;
+    BOOL xpath;
+    xmlChar *query;
+    xmlXPathCompExprPtr comp;
+} query_entry;
+
 static inline xmldoc_priv * priv_from_xmlDocPtr(const xmlDocPtr doc)
 {
     return doc->_private;
@@ -259,6 +273,83 @@ int registerNamespaces(xmlXPathContextPtr ctxt)
     return n;
 }
 
+static void clear_queries(domdoc_properties *properties)
+{
+    query_entry *query, *query2;
+
+    LIST_FOR_EACH_ENTRY_SAFE( query, query2, &properties->queries, query_entry, entry )
+    {
+        xmlXPathFreeCompExpr( query->comp );
+        heap_free( query->query );
+        heap_free( query );
+    }
+    list_init( &properties->queries );
+    properties->query_count = 0;
+}
+
+/* held across lookup, compilation and evaluation of a cached query */
+void lock_queries(xmlDocPtr doc)
+{
+    EnterCriticalSection(&properties_from_xmlDocPtr(doc)->cs);
+}
+
+void unlock_queries(xmlDocPtr doc)
+{
+    LeaveCriticalSection(&properties_from_xmlDocPtr(doc)->cs);
+}
+
+xmlXPathCompExprPtr get_cached_query(xmlDocPtr doc, const xmlChar *str)
+{
+    domdoc_properties *properties = properties_from_xmlDocPtr(doc);
+    query_entry *query;
+
+    LIST_FOR_EACH_ENTRY( query, &properties->queries, query_entry, entry )
+    {
+        if (query->xpath == properties->XPath && xmlStrEqual(query->query, str))
+        {
+            /* keep most recently used queries at the head */
+            list_remove( &query->entry );
+            list_add_head( &properties->queries, &query->entry );
+            return query->comp;
+        }
+    }
+
+    return NULL;
+}
+
+/* on success cache takes ownership of compiled expression */
+BOOL cache_query(xmlDocPtr doc, const xmlChar *str, xmlXPathCompExprPtr comp)
+{
+    domdoc_properties *properties = properties_from_xmlDocPtr(doc);
+    query_entry *query;
+    int len;
+
+    if (properties->query_count == QUERY_CACHE_SIZE)
+    {
+        query = LIST_ENTRY( list_tail( &properties->queries ), query_entry, entry );
+        list_remove( &query->entry );
+        xmlXPathFreeCompExpr( query->comp );
+        heap_free( query->query );
+        properties->query_count--;
+    }
+    else
+        query = heap_alloc( sizeof (*query) );
+
+    len = xmlStrlen(str) + 1;
+    if (!query || !(query->query = heap_alloc(len)))
+    {
+        heap_free( query );
+        return FALSE;
+    }
+
+    memcpy( query->query, str, len );
+    query->xpath = properties->XPath;
+    query->comp = comp;
+    list_add_head( &properties->queries, &query->entry );
+    properties->query_count++;
+    return TRUE;
+}
+
 static inline void clear_selectNsList(struct list* pNsList)
 {
     select_ns_entry *ns, *ns2;
@@ -289,6 +380,10 @@ static domdoc_properties *create_properties(MSXML_VERSION version)
     domdoc_properties *properties = heap_alloc(sizeof(domdoc_properties));
 
     list_init(&properties->selectNsList);
+    list_init(&properties->queries);
+    properties->query_count = 0;
+    InitializeCriticalSection(&properties->cs);
+    properties->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": domdoc_properties.cs");
     properties->preserving = VARIANT_FALSE;
     properties->schemaCache = NULL;
     properties->selectNsStr = heap_alloc_zero(sizeof(xmlChar));
@@ -319,6 +414,10 @@ static domdoc_properties* copy_properties(domdoc_properties const* properties)
         pcopy->XPath = properties->XPath;
         pcopy->selectNsStr_len = properties->selectNsStr_len;
         list_init( &pcopy->selectNsList );
+        list_init( &pcopy->queries );
+        pcopy->query_count = 0;
+        InitializeCriticalSection( &pcopy->cs );
+        pcopy->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": domdoc_properties.cs");
         pcopy->selectNsStr = heap_alloc(len);
         memcpy((xmlChar*)pcopy->selectNsStr, properties->selectNsStr, len);
         offset = pcopy->selectNsStr - properties->selectNsStr;
@@ -344,6 +443,9 @@ static void free_properties(domdoc_properties* properties)
         if (properties->schemaCache)
             IXMLDOMSchemaCollection2_Release(properties->schemaCache);
         clear_selectNsList(&properties->selectNsList);
+        clear_queries(properties);
+        properties->cs.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&properties->cs);
         heap_free((xmlChar*)properties->selectNsStr);
         heap_free(properties);
     }
@@ -2880,8 +2982,10 @@ static HRESULT WINAPI domdoc_setProperty(
 
         hr = S_OK;
 
+        EnterCriticalSection(&This->properties->cs);
         pNsList = &(This->properties->selectNsList);
         clear_selectNsList(pNsList);
+        clear_queries(This->properties);
         heap_free(nsStr);
         nsStr = xmlchar_from_wchar(bstr);
 
@@ -2988,6 +3092,7 @@ static HRESULT WINAPI domdoc_setProperty(
             heap_free(ns_entry);
             xmlXPathFreeContext(ctx);
         }
+        LeaveCriticalSection(&This->properties->cs);
 
         VariantClear(&varStr);
         return hr;
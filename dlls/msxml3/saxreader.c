@@ -284,6 +284,22 @@ static struct saxlexicalhandler_iface *saxreader_get_lexicalhandler(saxreader *r
     return &reader->saxhandlers[SAXLexicalHandler].u.lexical;
 }
 
+/* Element and attribute names repeat a lot within a document, so they are
+   converted once per parse and shared; the strings are owned by the cache. */
+struct name_entry
+{
+    unsigned int hash;
+    xmlChar *name;
+    BSTR bstr;
+};
+
+struct name_cache
+{
+    struct name_entry *entries;
+    unsigned int size;
+    unsigned int count;
+};
+
 typedef struct
 {
     IVBSAXLocator IVBSAXLocator_iface;
@@ -300,6 +316,7 @@ typedef struct
     int column;
     BOOL vbInterface;
     struct list elements;
+    struct name_cache names;
 
     BSTR namespaceUri;
     int attributesSize;
@@ -437,26 +454,113 @@ static BOOL is_namespaces_enabled(const saxreader *reader)
     return (reader->version < MSXML4) || (reader->features & Namespaces);
 }
 
-static BSTR build_qname(BSTR prefix, BSTR local)
+static unsigned int name_hash(const xmlChar *name)
 {
-    if (prefix && *prefix)
+    unsigned int hash = 5381;
+
+    while (*name) hash = hash * 33 + *name++;
+    return hash;
+}
+
+static BOOL name_cache_grow(struct name_cache *cache)
+{
+    struct name_entry *entries;
+    unsigned int size, i, j;
+
+    size = cache->size ? cache->size * 2 : 64;
+    entries = heap_alloc_zero(size * sizeof(*entries));
+    if (!entries) return FALSE;
+
+    for (i = 0; i < cache->size; i++)
     {
-        BSTR qname = SysAllocStringLen(NULL, SysStringLen(prefix) + SysStringLen(local) + 1);
-        WCHAR *ptr;
+        if (!cache->entries[i].bstr) continue;
 
-        ptr = qname;
-        strcpyW(ptr, prefix);
-        ptr += SysStringLen(prefix);
-        *ptr++ = ':';
-        strcpyW(ptr, local);
-        return qname;
+        j = cache->entries[i].hash & (size - 1);
+        while (entries[j].bstr) j = (j + 1) & (size - 1);
+        entries[j] = cache->entries[i];
     }
-    else
-        return SysAllocString(local);
+
+    heap_free(cache->entries);
+    cache->entries = entries;
+    cache->size = size;
+    return TRUE;
+}
+
+static void free_name_cache(struct name_cache *cache)
+{
+    unsigned int i;
+
+    for (i = 0; i < cache->size; i++)
+    {
+        if (!cache->entries[i].bstr) continue;
+        SysFreeString(cache->entries[i].bstr);
+        heap_free(cache->entries[i].name);
+    }
+
+    heap_free(cache->entries);
+    cache->entries = NULL;
+    cache->size = cache->count = 0;
+}
+
+/* returned string is owned by the cache and must not be freed */
+static BSTR name_cache_get(struct name_cache *cache, const xmlChar *name)
+{
+    struct name_entry *entry;
+    unsigned int hash, i;
+    int len;
+
+    if (!name) return NULL;
+
+    if (cache->count * 2 >= cache->size && !name_cache_grow(cache))
+        return NULL;
+
+    hash = name_hash(name);
+    i = hash & (cache->size - 1);
+    while (cache->entries[i].bstr)
+    {
+        if (cache->entries[i].hash == hash && xmlStrEqual(cache->entries[i].name, name))
+            return cache->entries[i].bstr;
+        i = (i + 1) & (cache->size - 1);
+    }
+
+    entry = &cache->entries[i];
+    len = xmlStrlen(name) + 1;
+    if (!(entry->name = heap_alloc(len))) return NULL;
+    memcpy(entry->name, name, len);
+
+    if (!(entry->bstr = bstr_from_xmlChar(name)))
+    {
+        heap_free(entry->name);
+        entry->name = NULL;
+        return NULL;
+    }
+
+    entry->hash = hash;
+    cache->count++;
+    return entry->bstr;
 }
 
-static element_entry* alloc_element_entry(const xmlChar *local, const xmlChar *prefix, int nb_ns,
-    const xmlChar **namespaces)
+static BSTR name_cache_get_qname(struct name_cache *cache, const xmlChar *prefix, const xmlChar *local)
+{
+    xmlChar buf[128], *qname;
+    BSTR ret;
+
+    if (!local) return NULL;
+
+    if (!prefix || !*prefix)
+        return name_cache_get(cache, local);
+
+    qname = xmlBuildQName(local, prefix, buf, sizeof(buf));
+    if (!qname) return NULL;
+
+    ret = name_cache_get(cache, qname);
+    if (qname != buf) xmlFree(qname);
+
+    return ret;
+}
+
+static element_entry* alloc_element_entry(saxlocator *locator, const xmlChar *local, const xmlChar *prefix,
+    int nb_ns, const xmlChar **namespaces)
 {
     element_entry *ret;
     int i;
@@ -464,34 +568,24 @@ static element_entry* alloc_element_entry(const xmlChar *local, const xmlChar *p
     ret = heap_alloc(sizeof(*ret));
     if (!ret) return ret;
 
-    ret->local  = bstr_from_xmlChar(local);
-    ret->prefix = bstr_from_xmlChar(prefix);
-    ret->qname  = build_qname(ret->prefix, ret->local);
+    ret->local  = name_cache_get(&locator->names, local);
+    ret->prefix = name_cache_get(&locator->names, prefix);
+    ret->qname  = name_cache_get_qname(&locator->names, prefix, local);
     ret->ns = nb_ns ? heap_alloc(nb_ns*sizeof(ns)) : NULL;
     ret->ns_count = nb_ns;
 
     for (i=0; i < nb_ns; i++)
     {
-        ret->ns[i].prefix = bstr_from_xmlChar(namespaces[2*i]);
-        ret->ns[i].uri = bstr_from_xmlChar(namespaces[2*i+1]);
+        ret->ns[i].prefix = name_cache_get(&locator->names, namespaces[2*i]);
+        ret->ns[i].uri = name_cache_get(&locator->names, namespaces[2*i+1]);
     }
 
     return ret;
 }
 
+/* element names are owned by locator name cache */
 static void free_element_entry(element_entry *element)
 {
-    int i;
-
-    for (i=0; i<element->ns_count;i++)
-    {
-        SysFreeString(element->ns[i].prefix);
-        SysFreeString(element->ns[i].uri);
-    }
-
-    SysFreeString(element->prefix);
-    SysFreeString(element->local);
-
     heap_free(element->ns);
     heap_free(element);
 }
@@ -519,19 +613,16 @@ static BSTR find_element_uri(saxlocator *locator, const xmlChar *uri)
 
     if (!uri) return NULL;
 
-    uriW = bstr_from_xmlChar(uri);
+    /* namespace uris are cached, so pointer comparison is enough */
+    uriW = name_cache_get(&locator->names, uri);
 
     LIST_FOR_EACH_ENTRY(element, &locator->elements, element_entry, entry)
     {
         for (i=0; i < element->ns_count; i++)
-            if (!strcmpW(uriW, element->ns[i].uri))
-            {
-                SysFreeString(uriW);
+            if (uriW == element->ns[i].uri)
                 return element->ns[i].uri;
-            }
     }
 
-    SysFreeString(uriW);
     ERR("namespace uri not found, %s\n", debugstr_a((char*)uri));
     return NULL;
 }
@@ -615,23 +706,6 @@ static BSTR bstr_from_xmlCharN(const xmlChar *buf, int len)
     return bstr;
 }
 
-static BSTR QName_from_xmlChar(const xmlChar *prefix, const xmlChar *name)
-{
-    xmlChar *qname;
-    BSTR bstr;
-
-    if(!name) return NULL;
-
-    if(!prefix || !*prefix)
-        return bstr_from_xmlChar(name);
-
-    qname = xmlBuildQName(name, prefix, NULL, 0);
-    bstr = bstr_from_xmlChar(qname);
-    xmlFree(qname);
-
-    return bstr;
-}
-
 static BSTR pooled_bstr_from_xmlChar(struct bstrpool *pool, const xmlChar *buf)
 {
     BSTR pool_entry = bstr_from_xmlChar(buf);
@@ -1265,45 +1339,55 @@ static const struct ISAXAttributesVtbl isaxattributes_vtbl =
     isaxattributes_getValueFromQName
 };
 
+/* names and uris are owned by locator name cache, only values are freed */
+static void SAXAttributes_clear(saxlocator *locator)
+{
+    int i;
+
+    for (i = 0; i < locator->nb_attributes; i++)
+        SysFreeString(locator->attributes[i].szValue);
+
+    locator->nb_attributes = 0;
+}
+
 static HRESULT SAXAttributes_populate(saxlocator *locator,
         int nb_namespaces, const xmlChar **xmlNamespaces,
         int nb_attributes, const xmlChar **xmlAttributes)
 {
     static const xmlChar xmlns[] = "xmlns";
-    static const WCHAR xmlnsW[] = { 'x','m','l','n','s',0 };
+    static const xmlChar emptyA[] = "";
 
     struct _attributes *attrs;
     int i;
 
+    SAXAttributes_clear(locator);
+
     /* skip namespace definitions */
     if ((locator->saxreader->features & NamespacePrefixes) == 0)
         nb_namespaces = 0;
 
-    locator->nb_attributes = nb_namespaces + nb_attributes;
-    if(locator->nb_attributes > locator->attributesSize)
+    if(nb_namespaces + nb_attributes > locator->attributesSize)
     {
-        attrs = heap_realloc(locator->attributes, sizeof(struct _attributes)*locator->nb_attributes*2);
+        attrs = heap_realloc(locator->attributes, sizeof(struct _attributes)*(nb_namespaces + nb_attributes)*2);
         if(!attrs)
-        {
-            locator->nb_attributes = 0;
             return E_OUTOFMEMORY;
-        }
         locator->attributes = attrs;
+        locator->attributesSize = (nb_namespaces + nb_attributes)*2;
     }
     else
     {
         attrs = locator->attributes;
     }
 
+    locator->nb_attributes = nb_namespaces + nb_attributes;
+
     for (i = 0; i < nb_namespaces; i++)
     {
-        attrs[nb_attributes+i].szLocalname = SysAllocStringLen(NULL, 0);
+        attrs[nb_attributes+i].szLocalname = name_cache_get(&locator->names, emptyA);
         attrs[nb_attributes+i].szURI = locator->namespaceUri;
         attrs[nb_attributes+i].szValue = bstr_from_xmlChar(xmlNamespaces[2*i+1]);
-        if(!xmlNamespaces[2*i])
-            attrs[nb_attributes+i].szQName = SysAllocString(xmlnsW);
-        else
-            attrs[nb_attributes+i].szQName = QName_from_xmlChar(xmlns, xmlNamespaces[2*i]);
+        attrs[nb_attributes+i].szQName = name_cache_get_qname(&locator->names, xmlNamespaces[2*i] ? xmlns : NULL,
+                xmlNamespaces[2*i] ? xmlNamespaces[2*i] : xmlns);
     }
 
     for (i = 0; i < nb_attributes; i++)
@@ -1311,15 +1395,15 @@ static HRESULT SAXAttributes_populate(saxlocator *locator,
         static const xmlChar xmlA[] = "xml";
 
         if (xmlStrEqual(xmlAttributes[i*5+1], xmlA))
-            attrs[i].szURI = bstr_from_xmlChar(xmlAttributes[i*5+2]);
+            attrs[i].szURI = name_cache_get(&locator->names, xmlAttributes[i*5+2]);
         else
             /* that's an important feature to keep same uri pointer for every reported attribute */
             attrs[i].szURI = find_element_uri(locator, xmlAttributes[i*5+2]);
 
-        attrs[i].szLocalname = bstr_from_xmlChar(xmlAttributes[i*5]);
+        attrs[i].szLocalname = name_cache_get(&locator->names, xmlAttributes[i*5]);
         attrs[i].szValue = bstr_from_xmlCharN(xmlAttributes[i*5+3],
                 xmlAttributes[i*5+4]-xmlAttributes[i*5+3]);
-        attrs[i].szQName = QName_from_xmlChar(xmlAttributes[i*5+1],
+        attrs[i].szQName = name_cache_get_qname(&locator->names, xmlAttributes[i*5+1],
                 xmlAttributes[i*5]);
     }
 
@@ -1420,7 +1504,7 @@ static void libxmlStartElementNS(
     if(This->saxreader->version < MSXML4)
         This->column++;
 
-    element = alloc_element_entry(localname, prefix, nb_namespaces, namespaces);
+    element = alloc_element_entry(This, localname, prefix, nb_namespaces, namespaces);
     push_element_ns(This, element);
 
     if (is_namespaces_enabled(This->saxreader))
@@ -1522,7 +1606,7 @@ static void libxmlEndElementNS(
 
     if (!saxreader_has_handler(This, SAXContentHandler))
     {
-        This->nb_attributes = 0;
+        SAXAttributes_clear(This);
         free_element_entry(element);
         return;
     }
@@ -1543,7 +1627,7 @@ static void libxmlEndElementNS(
                 local, SysStringLen(local),
                 element->qname, SysStringLen(element->qname));
 
-    This->nb_attributes = 0;
+    SAXAttributes_clear(This);
 
     if (sax_callback_failed(This, hr))
     {
@@ -2119,18 +2203,12 @@ static ULONG WINAPI isaxlocator_Release(
     if (ref == 0)
     {
         element_entry *element, *element2;
-        int index;
 
         SysFreeString(This->publicId);
         SysFreeString(This->systemId);
         SysFreeString(This->namespaceUri);
 
-        for(index=0; index<This->nb_attributes; index++)
-        {
-            SysFreeString(This->attributes[index].szLocalname);
-            SysFreeString(This->attributes[index].szValue);
-            SysFreeString(This->attributes[index].szQName);
-        }
+        SAXAttributes_clear(This);
         heap_free(This->attributes);
 
         /* element stack */
@@ -2140,6 +2218,7 @@ static ULONG WINAPI isaxlocator_Release(
             free_element_entry(element);
         }
 
+        free_name_cache(&This->names);
         ISAXXMLReader_Release(&This->saxreader->ISAXXMLReader_iface);
         heap_free( This );
     }
@@ -2273,6 +2352,7 @@ static HRESULT SAXLocator_create(saxreader *reader, saxlocator **ppsaxlocator, B
     }
 
     list_init(&locator->elements);
+    memset(&locator->names, 0, sizeof(locator->names));
 
     *ppsaxlocator = locator;
 
@@ -2365,20 +2445,34 @@ static HRESULT internal_parseBuffer(saxreader *This, const char *buffer, int siz
     return hr;
 }
 
+/* stream is fed to the push parser in large chunks to limit per-call overhead */
+#define STREAM_CHUNK_SIZE 0x10000
+
 static HRESULT internal_parseStream(saxreader *This, ISequentialStream *stream, BOOL vbInterface)
 {
     saxlocator *locator;
-    HRESULT hr;
+    HRESULT hr, read_hr;
     ULONG dataRead;
-    char data[1024];
+    char *data;
     int ret;
 
+    data = heap_alloc(STREAM_CHUNK_SIZE);
+    if(!data) return E_OUTOFMEMORY;
+
     dataRead = 0;
-    hr = ISequentialStream_Read(stream, data, sizeof(data), &dataRead);
-    if(FAILED(hr)) return hr;
+    read_hr = ISequentialStream_Read(stream, data, STREAM_CHUNK_SIZE, &dataRead);
+    if(FAILED(read_hr))
+    {
+        heap_free(data);
+        return read_hr;
+    }
 
     hr = SAXLocator_create(This, &locator, vbInterface);
-    if(FAILED(hr)) return hr;
+    if(FAILED(hr))
+    {
+        heap_free(data);
+        return hr;
+    }
 
     locator->pParserCtxt = xmlCreatePushParserCtxt(
             &locator->saxreader->sax, locator,
@@ -2386,36 +2480,33 @@ static HRESULT internal_parseStream(saxreader *This, ISequentialStream *stream,
     if(!locator->pParserCtxt)
     {
         ISAXLocator_Release(&locator->ISAXLocator_iface);
+        heap_free(data);
         return E_FAIL;
     }
 
     This->isParsing = TRUE;
 
-    if(dataRead != sizeof(data))
+    /* a short read doesn't end the stream, only an empty read or S_FALSE does */
+    while (read_hr == S_OK && dataRead)
     {
-        ret = xmlParseChunk(locator->pParserCtxt, data, 0, 1);
-        hr = ret!=XML_ERR_OK && locator->ret==S_OK ? E_FAIL : locator->ret;
-    }
-    else
-    {
-        while(1)
+        dataRead = 0;
+        read_hr = ISequentialStream_Read(stream, data, STREAM_CHUNK_SIZE, &dataRead);
+        if (FAILED(read_hr))
         {
-            dataRead = 0;
-            hr = ISequentialStream_Read(stream, data, sizeof(data), &dataRead);
-            if (FAILED(hr)) break;
-
-            ret = xmlParseChunk(locator->pParserCtxt, data, dataRead, 0);
-            hr = ret!=XML_ERR_OK && locator->ret==S_OK ? E_FAIL : locator->ret;
+            hr = read_hr;
+            break;
+        }
+        if (!dataRead) break;
 
-            if (hr != S_OK) break;
+        ret = xmlParseChunk(locator->pParserCtxt, data, dataRead, 0);
+        hr = ret!=XML_ERR_OK && locator->ret==S_OK ? E_FAIL : locator->ret;
+        if (hr != S_OK) break;
+    }
 
-            if (dataRead != sizeof(data))
-            {
-                ret = xmlParseChunk(locator->pParserCtxt, data, 0, 1);
-                hr = ret!=XML_ERR_OK && locator->ret==S_OK ? E_FAIL : locator->ret;
-                break;
-            }
-        }
+    if (hr == S_OK)
+    {
+        ret = xmlParseChunk(locator->pParserCtxt, data, 0, 1);
+        hr = ret!=XML_ERR_OK && locator->ret==S_OK ? E_FAIL : locator->ret;
     }
 
     This->isParsing = FALSE;
@@ -2423,6 +2514,7 @@ static HRESULT internal_parseStream(saxreader *This, ISequentialStream *stream,
     xmlFreeParserCtxt(locator->pParserCtxt);
     locator->pParserCtxt = NULL;
     ISAXLocator_Release(&locator->ISAXLocator_iface);
+    heap_free(data);
     return hr;
 }
 
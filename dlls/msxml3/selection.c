@@ -58,6 +58,10 @@ WINE_DEFAULT_DEBUG_CHANNEL(msxml);
 
 int registerNamespaces(xmlXPathContextPtr ctxt);
 xmlChar* XSLPattern_to_XPath(xmlXPathContextPtr ctxt, xmlChar const* xslpat_str);
+xmlXPathCompExprPtr get_cached_query(xmlDocPtr doc, const xmlChar *str);
+BOOL cache_query(xmlDocPtr doc, const xmlChar *str, xmlXPathCompExprPtr comp);
+void lock_queries(xmlDocPtr doc);
+void unlock_queries(xmlDocPtr doc);
 
 typedef struct
 {
@@ -770,6 +774,8 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
 {
     domselection *This = heap_alloc(sizeof(domselection));
     xmlXPathContextPtr ctxt = xmlXPathNewContext(node->doc);
+    xmlXPathCompExprPtr comp;
+    BOOL cached = TRUE;
     HRESULT hr;
 
     TRACE("(%p, %s, %p)\n", node, debugstr_a((char const*)query), out);
@@ -792,17 +798,24 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
 
     ctxt->error = query_serror;
     ctxt->node = node;
+
+    /* Compiled expression is reused for repeated queries, only translation
+       and compilation are cached, not the result. The cache lock is held
+       until evaluation is done, so that the expression can't be evicted
+       or freed by another thread in the meantime. */
+    lock_queries(node->doc);
     registerNamespaces(ctxt);
+    comp = get_cached_query(node->doc, query);
 
     if (is_xpathmode(This->node->doc))
     {
         xmlXPathRegisterAllFunctions(ctxt);
-        This->result = xmlXPathEvalExpression(query, ctxt);
+
+        if (!comp && (comp = xmlXPathCtxtCompile(ctxt, query)))
+            cached = cache_query(node->doc, query, comp);
     }
     else
     {
-        xmlChar* pattern_query = XSLPattern_to_XPath(ctxt, query);
-
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"not", xmlXPathNotFunction);
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"boolean", xmlXPathBooleanFunction);
 
@@ -817,10 +830,20 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"OP_IGt", XSLPattern_OP_IGt);
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"OP_IGEq", XSLPattern_OP_IGEq);
 
-        This->result = xmlXPathEvalExpression(pattern_query, ctxt);
-        xmlFree(pattern_query);
+        if (!comp)
+        {
+            xmlChar* pattern_query = XSLPattern_to_XPath(ctxt, query);
+
+            if ((comp = xmlXPathCtxtCompile(ctxt, pattern_query)))
+                cached = cache_query(node->doc, query, comp);
+            xmlFree(pattern_query);
+        }
     }
 
+    This->result = comp ? xmlXPathCompiledEval(comp, ctxt) : NULL;
+    if (!cached) xmlXPathFreeCompExpr(comp);
+    unlock_queries(node->doc);
+
     if (!This->result || This->result->type != XPATH_NODESET)
     {
         hr = E_FAIL;
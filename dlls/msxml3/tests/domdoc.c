@@ -6936,6 +6936,21 @@ static void test_XSLPattern(void)
     ok(len == 3, "expected 3 entries in list, got %d\n", len);
     IXMLDOMNodeList_Release(list);
 
+    /* same query string evaluated according to current selection language */
+    hr = IXMLDOMDocument2_setProperty(doc, _bstr_("SelectionLanguage"), _variantbstr_("XPath"));
+    EXPECT_HR(hr, S_OK);
+
+    hr = IXMLDOMDocument2_selectNodes(doc, _bstr_("//elem/c"), &list);
+    EXPECT_HR(hr, S_OK);
+    expect_list_and_release(list, "E3.E1.E2.D1 E3.E2.E2.D1");
+
+    hr = IXMLDOMDocument2_setProperty(doc, _bstr_("SelectionLanguage"), _variantbstr_("XSLPattern"));
+    EXPECT_HR(hr, S_OK);
+
+    hr = IXMLDOMDocument2_selectNodes(doc, _bstr_("//elem/c"), &list);
+    EXPECT_HR(hr, S_OK);
+    expect_list_and_release(list, "E3.E1.E2.D1 E3.E2.E2.D1 E3.E3.E2.D1");
+
     while (ptr->query)
     {
         list = NULL;
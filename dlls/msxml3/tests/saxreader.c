@@ -1986,6 +1986,61 @@ static const IStreamVtbl StreamVtbl = {
 
 static IStream mxstream = { &StreamVtbl };
 
+/* stream handing out data in small pieces to test partial reads */
+static const char *partial_stream_data;
+static ULONG partial_stream_pos;
+
+static HRESULT WINAPI partialstream_QueryInterface(ISequentialStream *iface, REFIID riid, void **ppvObject)
+{
+    *ppvObject = NULL;
+
+    if(IsEqualGUID(riid, &IID_ISequentialStream) || IsEqualGUID(riid, &IID_IUnknown))
+        *ppvObject = iface;
+    else
+        return E_NOINTERFACE;
+
+    return S_OK;
+}
+
+static ULONG WINAPI partialstream_AddRef(ISequentialStream *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI partialstream_Release(ISequentialStream *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI partialstream_Read(ISequentialStream *iface, void *pv, ULONG cb, ULONG *pcbRead)
+{
+    ULONG len = strlen(partial_stream_data + partial_stream_pos);
+
+    if (len > 16) len = 16;
+    if (len > cb) len = cb;
+    memcpy(pv, partial_stream_data + partial_stream_pos, len);
+    partial_stream_pos += len;
+
+    if (pcbRead) *pcbRead = len;
+    return S_OK;
+}
+
+static HRESULT WINAPI partialstream_Write(ISequentialStream *iface, const void *pv, ULONG cb, ULONG *pcbWritten)
+{
+    ok(0, "unexpected call\n");
+    return E_NOTIMPL;
+}
+
+static const ISequentialStreamVtbl PartialStreamVtbl = {
+    partialstream_QueryInterface,
+    partialstream_AddRef,
+    partialstream_Release,
+    partialstream_Read,
+    partialstream_Write
+};
+
+static ISequentialStream partialstream = { &PartialStreamVtbl };
+
 static struct msxmlsupported_data_t reader_support_data[] =
 {
     { &CLSID_SAXXMLReader,   "SAXReader"   },
@@ -2155,6 +2210,23 @@ static void test_saxreader(void)
 
         IStream_Release(stream);
 
+        /* same document from a stream returning less data than requested */
+        partial_stream_data = test_attributes;
+        partial_stream_pos = 0;
+        V_VT(&var) = VT_UNKNOWN;
+        V_UNKNOWN(&var) = (IUnknown*)&partialstream;
+
+        set_expected_seq(test_seq);
+        hr = ISAXXMLReader_parse(reader, var);
+        EXPECT_HR(hr, S_OK);
+        ok(partial_stream_pos == sizeof(test_attributes) - 1, "read %u bytes\n", partial_stream_pos);
+
+        if (IsEqualGUID(table->clsid, &CLSID_SAXXMLReader40) ||
+            IsEqualGUID(table->clsid, &CLSID_SAXXMLReader60))
+            ok_sequence(sequences, CONTENT_HANDLER_INDEX, test_seq, "content test attributes: partial reads", FALSE);
+        else
+            ok_sequence(sequences, CONTENT_HANDLER_INDEX, test_seq, "content test attributes: partial reads", TRUE);
+
         V_VT(&var) = VT_BSTR;
         V_BSTR(&var) = SysAllocString(carriage_ret_test);
 
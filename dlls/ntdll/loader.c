@@ -78,6 +78,9 @@ typedef struct _wine_modref
     LDR_MODULE            ldr;
     int                   nDeps;
     struct _wine_modref **deps;
+    struct _wine_modref  *hash_next;  /* next module in the base name hash chain */
+    DWORD                *export_hash;  /* open addressing hash of export name indexes + 1 */
+    DWORD                 export_hash_mask;
 } WINE_MODREF;
 
 /* info about the current builtin dll load */
@@ -111,6 +114,19 @@ static RTL_CRITICAL_SECTION loader_section = { &critsect_debug, -1, 0, 0, 0, 0 }
 
 static WINE_MODREF *cached_modref;
 static WINE_MODREF *current_modref;
+
+/* modules sorted by base address, and hashed by case-insensitive base name */
+struct module_index
+{
+    struct module_index *next;  /* next retired index */
+    unsigned int         count;
+    WINE_MODREF         *modules[1];
+};
+static struct module_index *module_index;
+static struct module_index *retired_module_index;
+static LONG module_index_readers;
+#define MODULE_HASH_SIZE 64
+static WINE_MODREF *module_hash[MODULE_HASH_SIZE];
 static WINE_MODREF *last_failed_modref;
 
 static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_MODREF** pwm );
@@ -319,6 +335,141 @@ static inline ULONG_PTR allocate_stub( const char *dll, const char *name ) { ret
 #endif  /* __i386__ */
 
 
+/*************************************************************************
+ *		hash_basename
+ *
+ * Case-insensitive hash of a module base name.
+ */
+static unsigned int hash_basename( LPCWSTR name, unsigned int len )
+{
+    unsigned int hash = 0;
+
+    while (len--) hash = hash * 31 + tolowerW( *name++ );
+    return hash % MODULE_HASH_SIZE;
+}
+
+
+/*************************************************************************
+ *		find_module_index
+ *
+ * Find the position of the last module whose base address is not above addr.
+ * Returns -1 if there is none.
+ */
+static int find_module_index( const struct module_index *index, const void *addr )
+{
+    int min = 0, max = index ? (int)index->count - 1 : -1;
+
+    while (min <= max)
+    {
+        int pos = (min + max) / 2;
+        if ((const char *)index->modules[pos]->ldr.BaseAddress > (const char *)addr) max = pos - 1;
+        else min = pos + 1;
+    }
+    return max;
+}
+
+
+/*************************************************************************
+ *		set_module_index
+ *
+ * Publish a new address index. LdrFindEntryForAddress can be called without
+ * the loader lock during exception dispatch, so the previous index is only
+ * freed once no such reader can still be using it.
+ * The loader_section must be locked while calling this function.
+ */
+static void set_module_index( struct module_index *index )
+{
+    struct module_index *old = interlocked_xchg_ptr( (void **)&module_index, index );
+
+    if (old)
+    {
+        old->next = retired_module_index;
+        retired_module_index = old;
+    }
+    /* the exchange above is a full barrier, so new readers can only get the new index */
+    if (*(volatile LONG *)&module_index_readers) return;
+    while ((old = retired_module_index))
+    {
+        retired_module_index = old->next;
+        RtlFreeHeap( GetProcessHeap(), 0, old );
+    }
+}
+
+
+/*************************************************************************
+ *		add_module_index
+ *
+ * Add a module to the address index and base name hash.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL add_module_index( WINE_MODREF *wm )
+{
+    unsigned int hash = hash_basename( wm->ldr.BaseDllName.Buffer, wm->ldr.BaseDllName.Length / sizeof(WCHAR) );
+    unsigned int count = module_index ? module_index->count : 0;
+    struct module_index *index;
+    WINE_MODREF **next;
+    int pos;
+
+    if (!(index = RtlAllocateHeap( GetProcessHeap(), 0,
+                                   FIELD_OFFSET( struct module_index, modules[count + 1] ))))
+        return FALSE;
+
+    pos = find_module_index( module_index, wm->ldr.BaseAddress ) + 1;
+    if (pos) memcpy( index->modules, module_index->modules, pos * sizeof(*index->modules) );
+    index->modules[pos] = wm;
+    if (count > pos)
+        memcpy( index->modules + pos + 1, module_index->modules + pos,
+                (count - pos) * sizeof(*index->modules) );
+    index->count = count + 1;
+    set_module_index( index );
+
+    /* append to keep modules with the same base name in load order */
+    for (next = &module_hash[hash]; *next; next = &(*next)->hash_next) ;
+    wm->hash_next = NULL;
+    *next = wm;
+    return TRUE;
+}
+
+
+/*************************************************************************
+ *		remove_module_index
+ *
+ * Remove a module from the address index and base name hash.
+ * The loader_section must be locked while calling this function.
+ */
+static void remove_module_index( WINE_MODREF *wm )
+{
+    unsigned int hash = hash_basename( wm->ldr.BaseDllName.Buffer, wm->ldr.BaseDllName.Length / sizeof(WCHAR) );
+    struct module_index *index;
+    WINE_MODREF **next;
+    int pos;
+
+    pos = find_module_index( module_index, wm->ldr.BaseAddress );
+    if (pos >= 0 && module_index->modules[pos] == wm)
+    {
+        unsigned int count = module_index->count - 1;
+
+        /* if this fails the stale entry stays, it is still sorted */
+        if ((index = RtlAllocateHeap( GetProcessHeap(), 0,
+                                      FIELD_OFFSET( struct module_index, modules[max( count, 1 )] ))))
+        {
+            memcpy( index->modules, module_index->modules, pos * sizeof(*index->modules) );
+            memcpy( index->modules + pos, module_index->modules + pos + 1,
+                    (count - pos) * sizeof(*index->modules) );
+            index->count = count;
+            set_module_index( index );
+        }
+    }
+
+    for (next = &module_hash[hash]; *next; next = &(*next)->hash_next)
+    {
+        if (*next != wm) continue;
+        *next = wm->hash_next;
+        break;
+    }
+}
+
+
 /*************************************************************************
  *		get_modref
  *
@@ -327,19 +478,13 @@ static inline ULONG_PTR allocate_stub( const char *dll, const char *name ) { ret
  */
 static WINE_MODREF *get_modref( HMODULE hmod )
 {
-    PLIST_ENTRY mark, entry;
-    PLDR_MODULE mod;
+    int pos;
 
     if (cached_modref && cached_modref->ldr.BaseAddress == hmod) return cached_modref;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
-    {
-        mod = CONTAINING_RECORD(entry, LDR_MODULE, InMemoryOrderModuleList);
-        if (mod->BaseAddress == hmod)
-            return cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
-        if (mod->BaseAddress > (void*)hmod) break;
-    }
+    pos = find_module_index( module_index, hmod );
+    if (pos >= 0 && module_index->modules[pos]->ldr.BaseAddress == hmod)
+        return cached_modref = module_index->modules[pos];
     return NULL;
 }
 
@@ -352,21 +497,13 @@ static WINE_MODREF *get_modref( HMODULE hmod )
  */
 static WINE_MODREF *find_basename_module( LPCWSTR name )
 {
-    PLIST_ENTRY mark, entry;
+    WINE_MODREF *wm;
 
     if (cached_modref && !strcmpiW( name, cached_modref->ldr.BaseDllName.Buffer ))
         return cached_modref;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
-    {
-        LDR_MODULE *mod = CONTAINING_RECORD(entry, LDR_MODULE, InLoadOrderModuleList);
-        if (!strcmpiW( name, mod->BaseDllName.Buffer ))
-        {
-            cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
-            return cached_modref;
-        }
-    }
+    for (wm = module_hash[hash_basename( name, strlenW(name) )]; wm; wm = wm->hash_next)
+        if (!strcmpiW( name, wm->ldr.BaseDllName.Buffer )) return cached_modref = wm;
     return NULL;
 }
 
@@ -379,21 +516,18 @@ static WINE_MODREF *find_basename_module( LPCWSTR name )
  */
 static WINE_MODREF *find_fullname_module( LPCWSTR name )
 {
-    PLIST_ENTRY mark, entry;
+    const WCHAR *p;
+    WINE_MODREF *wm;
 
     if (cached_modref && !strcmpiW( name, cached_modref->ldr.FullDllName.Buffer ))
         return cached_modref;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
-    {
-        LDR_MODULE *mod = CONTAINING_RECORD(entry, LDR_MODULE, InLoadOrderModuleList);
-        if (!strcmpiW( name, mod->FullDllName.Buffer ))
-        {
-            cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
-            return cached_modref;
-        }
-    }
+    /* modules are hashed by the file name part of their path */
+    if ((p = strrchrW( name, '\\' ))) p++;
+    else p = name;
+
+    for (wm = module_hash[hash_basename( p, strlenW(p) )]; wm; wm = wm->hash_next)
+        if (!strcmpiW( name, wm->ldr.FullDllName.Buffer )) return cached_modref = wm;
     return NULL;
 }
 
@@ -505,6 +639,52 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 }
 
 
+/*************************************************************************
+ *		hash_export_name
+ */
+static inline DWORD hash_export_name( const char *name )
+{
+    DWORD hash = 5381;
+
+    while (*name) hash = hash * 33 + (unsigned char)*name++;
+    return hash;
+}
+
+
+/*************************************************************************
+ *		get_export_hash
+ *
+ * Get the hash of the export names of a module, building it on first use.
+ * Returns NULL for modules with few exports, a binary search is good enough for those.
+ * The loader_section must be locked while calling this function.
+ */
+static const DWORD *get_export_hash( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports, DWORD *mask )
+{
+    const DWORD *names;
+    WINE_MODREF *wm;
+    DWORD i, size, pos;
+
+    if (exports->NumberOfNames < 32) return NULL;
+    if (!(wm = get_modref( module ))) return NULL;
+    *mask = wm->export_hash_mask;
+    if (wm->export_hash) return wm->export_hash;
+
+    for (size = 64; size < exports->NumberOfNames * 2; size *= 2) ;
+    if (!(wm->export_hash = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(DWORD) )))
+        return NULL;
+    *mask = wm->export_hash_mask = size - 1;
+
+    names = get_rva( module, exports->AddressOfNames );
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        pos = hash_export_name( get_rva( module, names[i] )) & wm->export_hash_mask;
+        while (wm->export_hash[pos]) pos = (pos + 1) & wm->export_hash_mask;
+        wm->export_hash[pos] = i + 1;
+    }
+    return wm->export_hash;
+}
+
+
 /*************************************************************************
  *		find_named_export
  *
@@ -516,6 +696,8 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
 {
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
+    const DWORD *hash;
+    DWORD mask, idx;
     int min = 0, max = exports->NumberOfNames - 1;
 
     /* first check the hint */
@@ -526,6 +708,18 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
             return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
     }
 
+    /* then look in the export hash */
+    if ((hash = get_export_hash( module, exports, &mask )))
+    {
+        for (idx = hash_export_name( name ) & mask; hash[idx]; idx = (idx + 1) & mask)
+        {
+            char *ename = get_rva( module, names[hash[idx] - 1] );
+            if (!strcmp( ename, name ))
+                return find_ordinal_export( module, exports, exp_size, ordinals[hash[idx] - 1], load_path );
+        }
+        return NULL;
+    }
+
     /* then do a binary search */
     while (min <= max)
     {
@@ -541,6 +735,47 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
 }
 
 
+/*************************************************************************
+ *		is_import_bound
+ *
+ * Check whether the import address table of a bound import descriptor is
+ * still valid, i.e. the dll was bound to the same version of the imported
+ * module, loaded at its preferred base address.
+ */
+static BOOL is_import_bound( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr,
+                             const char *name, DWORD len, WINE_MODREF *wm )
+{
+    const IMAGE_NT_HEADERS *nt = RtlImageNtHeader( wm->ldr.BaseAddress );
+    const IMAGE_BOUND_IMPORT_DESCRIPTOR *bound;
+    const char *start;
+    DWORD size;
+
+    if (!descr->TimeDateStamp || !nt->FileHeader.TimeDateStamp) return FALSE;
+    /* the entry points need to be wrapped */
+    if (TRACE_ON(relay) || TRACE_ON(snoop)) return FALSE;
+    if (wm->ldr.BaseAddress != (void *)nt->OptionalHeader.ImageBase) return FALSE;
+
+    if (descr->TimeDateStamp != ~0u)  /* old style binding */
+        return descr->ForwarderChain == ~0u && descr->TimeDateStamp == nt->FileHeader.TimeDateStamp;
+
+    if (!(bound = RtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT, &size )))
+        return FALSE;
+
+    start = (const char *)bound;
+    while ((const char *)(bound + 1) <= start + size && bound->OffsetModuleName)
+    {
+        const char *bound_name = start + bound->OffsetModuleName;
+
+        if (!strncasecmp( bound_name, name, len ) && !bound_name[len])
+            return !bound->NumberOfModuleForwarderRefs &&
+                   bound->TimeDateStamp == nt->FileHeader.TimeDateStamp;
+        bound = (const IMAGE_BOUND_IMPORT_DESCRIPTOR *)((const IMAGE_BOUND_FORWARDER_REF *)(bound + 1) +
+                                                        bound->NumberOfModuleForwarderRefs);
+    }
+    return FALSE;
+}
+
+
 /*************************************************************************
  *		import_dll
  *
@@ -598,6 +833,12 @@ static WINE_MODREF *import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *d
         return NULL;
     }
 
+    if (is_import_bound( module, descr, name, len, wmImp ))
+    {
+        TRACE_(imports)("--- using bound imports from %s\n", name );
+        return wmImp;
+    }
+
     /* unprotect the import address table since it can be located in
      * readonly section */
     while (import_list[protect_size].u1.Ordinal) protect_size++;
@@ -720,6 +961,7 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     DWORD size;
     NTSTATUS status;
     ULONG_PTR cookie;
+    LARGE_INTEGER start, end, freq;
 
     if (!(wm->ldr.Flags & LDR_DONT_RESOLVE_REFS)) return STATUS_SUCCESS;  /* already done */
     wm->ldr.Flags &= ~LDR_DONT_RESOLVE_REFS;
@@ -743,6 +985,8 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     /* load the imported modules. They are automatically
      * added to the modref list of the process.
      */
+    if (TRACE_ON(imports)) NtQueryPerformanceCounter( &start, &freq );
+
     prev = current_modref;
     current_modref = wm;
     status = STATUS_SUCCESS;
@@ -752,6 +996,14 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
             status = STATUS_DLL_NOT_FOUND;
     }
     current_modref = prev;
+
+    if (TRACE_ON(imports))
+    {
+        NtQueryPerformanceCounter( &end, NULL );
+        TRACE_(imports)( "resolved %d imports of %s in %u us (including dependencies)\n",
+                         nb_imports, debugstr_w(wm->ldr.BaseDllName.Buffer),
+                         (DWORD)((end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart) );
+    }
     if (wm->ldr.ActivationContext) RtlDeactivateActivationContext( 0, cookie );
     return status;
 }
@@ -812,6 +1064,8 @@ static WINE_MODREF *alloc_module( HMODULE hModule, LPCWSTR filename )
 
     wm->nDeps    = 0;
     wm->deps     = NULL;
+    wm->export_hash = NULL;
+    wm->export_hash_mask = 0;
 
     wm->ldr.BaseAddress   = hModule;
     wm->ldr.EntryPoint    = NULL;
@@ -836,6 +1090,13 @@ static WINE_MODREF *alloc_module( HMODULE hModule, LPCWSTR filename )
             wm->ldr.EntryPoint = (char *)hModule + nt->OptionalHeader.AddressOfEntryPoint;
     }
 
+    if (!add_module_index( wm ))
+    {
+        RtlFreeUnicodeString( &wm->ldr.FullDllName );
+        RtlFreeHeap( GetProcessHeap(), 0, wm );
+        return NULL;
+    }
+
     InsertTailList(&NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList,
                    &wm->ldr.InLoadOrderModuleList);
 
@@ -1265,26 +1526,26 @@ NTSTATUS WINAPI LdrDisableThreadCalloutsForDll(HMODULE hModule)
 /******************************************************************
  *              LdrFindEntryForAddress (NTDLL.@)
  *
- * The loader_section must be locked while calling this function
+ * The loader_section must be locked while calling this function, except
+ * during exception dispatch where it only reads a snapshot of the index.
  */
 NTSTATUS WINAPI LdrFindEntryForAddress(const void* addr, PLDR_MODULE* pmod)
 {
-    PLIST_ENTRY mark, entry;
-    PLDR_MODULE mod;
+    struct module_index *index;
+    PLDR_MODULE mod = NULL;
+    int pos;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
-    {
-        mod = CONTAINING_RECORD(entry, LDR_MODULE, InMemoryOrderModuleList);
-        if (mod->BaseAddress <= addr &&
-            (const char *)addr < (char*)mod->BaseAddress + mod->SizeOfImage)
-        {
-            *pmod = mod;
-            return STATUS_SUCCESS;
-        }
-        if (mod->BaseAddress > addr) break;
-    }
-    return STATUS_NO_MORE_ENTRIES;
+    /* keeps the snapshot alive, see set_module_index */
+    interlocked_xchg_add( &module_index_readers, 1 );
+    index = *(struct module_index * volatile *)&module_index;
+    pos = find_module_index( index, addr );
+    if (pos >= 0) mod = &index->modules[pos]->ldr;
+    interlocked_xchg_add( &module_index_readers, -1 );
+
+    if (!mod || (const char *)addr >= (char*)mod->BaseAddress + mod->SizeOfImage)
+        return STATUS_NO_MORE_ENTRIES;
+    *pmod = mod;
+    return STATUS_SUCCESS;
 }
 
 /******************************************************************
@@ -1480,6 +1741,7 @@ static void load_builtin_callback( void *module, const char *filename )
             /* the module has only be inserted in the load & memory order lists */
             RemoveEntryList(&wm->ldr.InLoadOrderModuleList);
             RemoveEntryList(&wm->ldr.InMemoryOrderModuleList);
+            remove_module_index( wm );
             /* FIXME: free the modref */
             builtin_load_info->status = STATUS_DLL_NOT_FOUND;
             return;
@@ -1552,6 +1814,7 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, LPCWSTR name, HANDLE file,
             /* the module has only be inserted in the load & memory order lists */
             RemoveEntryList(&wm->ldr.InLoadOrderModuleList);
             RemoveEntryList(&wm->ldr.InMemoryOrderModuleList);
+            remove_module_index( wm );
 
             /* FIXME: there are several more dangling references
              * left. Including dlls loaded by this dll before the
@@ -2441,6 +2704,7 @@ static void free_modref( WINE_MODREF *wm )
 {
     RemoveEntryList(&wm->ldr.InLoadOrderModuleList);
     RemoveEntryList(&wm->ldr.InMemoryOrderModuleList);
+    remove_module_index( wm );
     if (wm->ldr.InInitializationOrderModuleList.Flink)
         RemoveEntryList(&wm->ldr.InInitializationOrderModuleList);
 
@@ -2463,6 +2727,7 @@ static void free_modref( WINE_MODREF *wm )
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
     RtlFreeHeap( GetProcessHeap(), 0, wm->deps );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_hash );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
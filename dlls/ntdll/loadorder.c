@@ -27,6 +27,8 @@
 #include <string.h>
 #include <assert.h>
 
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
 #include "windef.h"
 #include "winternl.h"
 #include "ntdll_misc.h"
@@ -53,8 +55,19 @@ struct loadorder_list
 
 static const WCHAR separatorsW[] = {',',' ','\t',0};
 
+/* snapshot of a DllOverrides registry key, refreshed when the key changes */
+struct key_loadorder
+{
+    HANDLE                key;
+    HANDLE                event;  /* signaled by the server when the key is modified */
+    BOOL                  valid;
+    struct loadorder_list list;
+};
+
 static int init_done;
 static struct loadorder_list env_list;
+static struct key_loadorder std_overrides;
+static struct key_loadorder app_overrides;
 
 
 /***************************************************************************
@@ -154,41 +167,41 @@ static enum loadorder parse_load_order( const WCHAR *order )
 /***************************************************************************
  *	add_load_order
  *
- * Adds an entry in the list of environment overrides.
+ * Adds an entry in a list of overrides.
  */
-static void add_load_order( const module_loadorder_t *plo )
+static void add_load_order( struct loadorder_list *list, const module_loadorder_t *plo )
 {
     int i;
 
-    for(i = 0; i < env_list.count; i++)
+    for(i = 0; i < list->count; i++)
     {
-        if(!cmp_sort_func(plo, &env_list.order[i] ))
+        if(!cmp_sort_func(plo, &list->order[i] ))
         {
             /* replace existing option */
-            env_list.order[i].loadorder = plo->loadorder;
+            list->order[i].loadorder = plo->loadorder;
             return;
         }
     }
 
-    if (i >= env_list.alloc)
+    if (i >= list->alloc)
     {
         /* No space in current array, make it larger */
-        env_list.alloc += LOADORDER_ALLOC_CLUSTER;
-        if (env_list.order)
-            env_list.order = RtlReAllocateHeap(GetProcessHeap(), 0, env_list.order,
-                                               env_list.alloc * sizeof(module_loadorder_t));
+        list->alloc += LOADORDER_ALLOC_CLUSTER;
+        if (list->order)
+            list->order = RtlReAllocateHeap(GetProcessHeap(), 0, list->order,
+                                            list->alloc * sizeof(module_loadorder_t));
         else
-            env_list.order = RtlAllocateHeap(GetProcessHeap(), 0,
-                                             env_list.alloc * sizeof(module_loadorder_t));
-        if(!env_list.order)
+            list->order = RtlAllocateHeap(GetProcessHeap(), 0,
+                                          list->alloc * sizeof(module_loadorder_t));
+        if(!list->order)
         {
             MESSAGE("Virtual memory exhausted\n");
             exit(1);
         }
     }
-    env_list.order[i].loadorder  = plo->loadorder;
-    env_list.order[i].modulename = plo->modulename;
-    env_list.count++;
+    list->order[i].loadorder  = plo->loadorder;
+    list->order[i].modulename = plo->modulename;
+    list->count++;
 }
 
 
@@ -216,7 +229,7 @@ static void add_load_order_set( WCHAR *entry )
             WCHAR *ext = strrchrW(entry, '.');
             if (ext) remove_dll_ext( ext );
             ldo.modulename = entry;
-            add_load_order( &ldo );
+            add_load_order( &env_list, &ldo );
             entry = end;
         }
     }
@@ -272,18 +285,18 @@ static void init_load_order(void)
 
 
 /***************************************************************************
- *	get_env_load_order
+ *	get_list_load_order
  *
- * Get the load order for a given module from the WINEDLLOVERRIDES environment variable.
+ * Get the load order for a given module from a sorted list of overrides.
  */
-static inline enum loadorder get_env_load_order( const WCHAR *module )
+static inline enum loadorder get_list_load_order( const struct loadorder_list *list, const WCHAR *module )
 {
     module_loadorder_t tmp, *res;
 
     tmp.modulename = module;
     /* some bsearch implementations (Solaris) are buggy when the number of items is 0 */
-    if (env_list.count &&
-        (res = bsearch(&tmp, env_list.order, env_list.count, sizeof(env_list.order[0]), cmp_sort_func)))
+    if (list->count &&
+        (res = bsearch(&tmp, list->order, list->count, sizeof(list->order[0]), cmp_sort_func)))
         return res->loadorder;
     return LO_INVALID;
 }
@@ -389,6 +402,95 @@ static enum loadorder get_registry_value( HANDLE hkey, const WCHAR *module )
 }
 
 
+/***************************************************************************
+ *	refresh_key_load_order
+ *
+ * Read all the values of a DllOverrides key into a sorted list, unless the
+ * key hasn't changed since the previous call. On failure the values are
+ * queried directly from the registry.
+ */
+static void refresh_key_load_order( struct key_loadorder *lo, HANDLE key )
+{
+    static const LARGE_INTEGER zero;
+    KEY_VALUE_FULL_INFORMATION *info;
+    module_loadorder_t ldo;
+    IO_STATUS_BLOCK io;
+    DWORD size = 256, len, index = 0;
+    WCHAR *name, *data;
+    NTSTATUS status;
+    int i;
+
+    lo->key = key;
+    if (!key) return;
+    if (lo->valid && NtWaitForSingleObject( lo->event, FALSE, &zero ) != STATUS_WAIT_0) return;
+
+    lo->valid = FALSE;
+    for (i = 0; i < lo->list.count; i++)
+        RtlFreeHeap( GetProcessHeap(), 0, (WCHAR *)lo->list.order[i].modulename );
+    lo->list.count = 0;
+
+    if (!lo->event && NtCreateEvent( &lo->event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE ))
+    {
+        lo->event = 0;
+        return;
+    }
+    /* arm the notification before reading so that no change is missed */
+    if (NtNotifyChangeKey( key, lo->event, NULL, NULL, &io,
+                           REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET, TRUE, NULL, 0, FALSE ))
+        return;
+
+    if (!(info = RtlAllocateHeap( GetProcessHeap(), 0, size ))) return;
+    for (;;)
+    {
+        status = NtEnumerateValueKey( key, index, KeyValueFullInformation, info, size, &len );
+        if (status == STATUS_BUFFER_OVERFLOW || status == STATUS_BUFFER_TOO_SMALL)
+        {
+            KEY_VALUE_FULL_INFORMATION *new_info;
+
+            size = len;
+            if (!(new_info = RtlReAllocateHeap( GetProcessHeap(), 0, info, size ))) break;
+            info = new_info;
+            continue;
+        }
+        if (status) break;
+        index++;
+
+        if (!(name = RtlAllocateHeap( GetProcessHeap(), 0,
+                                      info->NameLength + info->DataLength + 2 * sizeof(WCHAR) )))
+            break;
+        memcpy( name, info->Name, info->NameLength );
+        name[info->NameLength / sizeof(WCHAR)] = 0;
+        data = name + info->NameLength / sizeof(WCHAR) + 1;
+        memcpy( data, (char *)info + info->DataOffset, info->DataLength );
+        data[info->DataLength / sizeof(WCHAR)] = 0;
+
+        ldo.modulename = name;
+        ldo.loadorder  = parse_load_order( data );
+        add_load_order( &lo->list, &ldo );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, info );
+
+    if (status == STATUS_NO_MORE_ENTRIES)
+    {
+        if (lo->list.count)
+            qsort( lo->list.order, lo->list.count, sizeof(lo->list.order[0]), cmp_sort_func );
+        lo->valid = TRUE;
+    }
+}
+
+
+/***************************************************************************
+ *	get_key_load_order
+ *
+ * Get the load order for a given module from a DllOverrides key.
+ */
+static enum loadorder get_key_load_order( const struct key_loadorder *lo, const WCHAR *module )
+{
+    if (lo->valid) return get_list_load_order( &lo->list, module );
+    return get_registry_value( lo->key, module );
+}
+
+
 /***************************************************************************
  *	get_load_order_value
  *
@@ -397,23 +499,23 @@ static enum loadorder get_registry_value( HANDLE hkey, const WCHAR *module )
  * 2. The per-application DllOverrides key
  * 3. The standard DllOverrides key
  */
-static enum loadorder get_load_order_value( HANDLE std_key, HANDLE app_key, const WCHAR *module )
+static enum loadorder get_load_order_value( const WCHAR *module )
 {
     enum loadorder ret;
 
-    if ((ret = get_env_load_order( module )) != LO_INVALID)
+    if ((ret = get_list_load_order( &env_list, module )) != LO_INVALID)
     {
         TRACE( "got environment %s for %s\n", debugstr_loadorder(ret), debugstr_w(module) );
         return ret;
     }
 
-    if (app_key && ((ret = get_registry_value( app_key, module )) != LO_INVALID))
+    if (app_overrides.key && ((ret = get_key_load_order( &app_overrides, module )) != LO_INVALID))
     {
         TRACE( "got app defaults %s for %s\n", debugstr_loadorder(ret), debugstr_w(module) );
         return ret;
     }
 
-    if (std_key && ((ret = get_registry_value( std_key, module )) != LO_INVALID))
+    if (std_overrides.key && ((ret = get_key_load_order( &std_overrides, module )) != LO_INVALID))
     {
         TRACE( "got standard key %s for %s\n", debugstr_loadorder(ret), debugstr_w(module) );
         return ret;
@@ -432,14 +534,13 @@ static enum loadorder get_load_order_value( HANDLE std_key, HANDLE app_key, cons
 enum loadorder get_load_order( const WCHAR *app_name, const WCHAR *path )
 {
     enum loadorder ret = LO_INVALID;
-    HANDLE std_key, app_key = 0;
     WCHAR *module, *basename;
     UNICODE_STRING path_str;
     int len;
 
     if (!init_done) init_load_order();
-    std_key = get_standard_key();
-    if (app_name) app_key = get_app_key( app_name );
+    refresh_key_load_order( &std_overrides, get_standard_key() );
+    refresh_key_load_order( &app_overrides, app_name ? get_app_key( app_name ) : 0 );
 
     TRACE("looking for %s\n", debugstr_w(path));
 
@@ -461,16 +562,16 @@ enum loadorder get_load_order( const WCHAR *app_name, const WCHAR *path )
     if (len >= 4) remove_dll_ext( module + 1 + len - 4 );
 
     /* first explicit module name */
-    if ((ret = get_load_order_value( std_key, app_key, module+1 )) != LO_INVALID)
+    if ((ret = get_load_order_value( module+1 )) != LO_INVALID)
         goto done;
 
     /* then module basename preceded by '*' */
     basename[-1] = '*';
-    if ((ret = get_load_order_value( std_key, app_key, basename-1 )) != LO_INVALID)
+    if ((ret = get_load_order_value( basename-1 )) != LO_INVALID)
         goto done;
 
     /* then module basename without '*' (only if explicit path) */
-    if (basename != module+1 && ((ret = get_load_order_value( std_key, app_key, basename )) != LO_INVALID))
+    if (basename != module+1 && ((ret = get_load_order_value( basename )) != LO_INVALID))
         goto done;
 
     /* if loading the main exe with an explicit path, try native first */
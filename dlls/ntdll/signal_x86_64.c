@@ -1896,11 +1896,37 @@ static EXCEPTION_RECORD *setup_exception( ucontext_t *sigcontext, raise_func fun
 }
 
 
+/**********************************************************************
+ *           lookup_history_table
+ *
+ * Look for a function entry cached in the unwind history table.
+ */
+static RUNTIME_FUNCTION *lookup_history_table( ULONG64 pc, ULONG64 *base, UNWIND_HISTORY_TABLE *table )
+{
+    RUNTIME_FUNCTION *func;
+    ULONG i;
+
+    if (!table || !table->Count || pc < table->LowAddress || pc >= table->HighAddress) return NULL;
+
+    for (i = 0; i < table->Count; i++)
+    {
+        func = table->Entry[i].FunctionEntry;
+        if (pc < table->Entry[i].ImageBase + func->BeginAddress) continue;
+        if (pc >= table->Entry[i].ImageBase + func->EndAddress) continue;
+        *base = table->Entry[i].ImageBase;
+        while (func->UnwindData & 1)  /* follow chained entry */
+            func = (RUNTIME_FUNCTION *)(*base + (func->UnwindData & ~1));
+        return func;
+    }
+    return NULL;
+}
+
+
 /**********************************************************************
  *           find_function_info
  */
-static RUNTIME_FUNCTION *find_function_info( ULONG64 pc, HMODULE module,
-                                             RUNTIME_FUNCTION *func, ULONG size )
+static RUNTIME_FUNCTION *find_function_info( ULONG64 pc, HMODULE module, RUNTIME_FUNCTION *func,
+                                             ULONG size, UNWIND_HISTORY_TABLE *table )
 {
     int min = 0;
     int max = size/sizeof(*func) - 1;
@@ -1913,6 +1939,17 @@ static RUNTIME_FUNCTION *find_function_info( ULONG64 pc, HMODULE module,
         else
         {
             func += pos;
+            if (table && table->Count < UNWIND_HISTORY_TABLE_SIZE)
+            {
+                ULONG64 start = (ULONG64)module + func->BeginAddress;
+                ULONG64 end = (ULONG64)module + func->EndAddress;
+
+                if (!table->Count || start < table->LowAddress) table->LowAddress = start;
+                if (!table->Count || end > table->HighAddress) table->HighAddress = end;
+                table->Entry[table->Count].ImageBase = (ULONG64)module;
+                table->Entry[table->Count].FunctionEntry = func;
+                table->Count++;
+            }
             while (func->UnwindData & 1)  /* follow chained entry */
                 func = (RUNTIME_FUNCTION *)((char *)module + (func->UnwindData & ~1));
             return func;
@@ -1922,6 +1959,35 @@ static RUNTIME_FUNCTION *find_function_info( ULONG64 pc, HMODULE module,
 }
 
 
+/**********************************************************************
+ *           lookup_function_info
+ *
+ * Find the PE function entry for a given pc, and the module containing it
+ * when it was not found in the history table.
+ */
+static RUNTIME_FUNCTION *lookup_function_info( ULONG64 pc, ULONG64 *base, LDR_MODULE **module,
+                                               UNWIND_HISTORY_TABLE *table )
+{
+    RUNTIME_FUNCTION *func;
+    ULONG size;
+
+    *module = NULL;
+    if ((func = lookup_history_table( pc, base, table ))) return func;
+
+    *base = 0;
+    if (LdrFindEntryForAddress( (void *)pc, module )) return NULL;
+
+    *base = (ULONG64)(*module)->BaseAddress;
+    if ((func = RtlImageDirectoryEntryToData( (*module)->BaseAddress, TRUE,
+                                              IMAGE_DIRECTORY_ENTRY_EXCEPTION, &size )))
+        return find_function_info( pc, (*module)->BaseAddress, func, size, table );
+
+    if (!((*module)->Flags & LDR_WINE_INTERNAL))
+        WARN( "exception data not found in %s\n", debugstr_w((*module)->BaseDllName.Buffer) );
+    return NULL;
+}
+
+
 /**********************************************************************
  *           call_handler
  *
@@ -2002,10 +2068,11 @@ static NTSTATUS call_stack_handlers( EXCEPTION_RECORD *rec, CONTEXT *orig_contex
     DISPATCHER_CONTEXT dispatch;
     CONTEXT context, new_context;
     LDR_MODULE *module;
-    DWORD size;
     NTSTATUS status;
 
     context = *orig_context;
+    table.Count            = 0;
+    table.Search           = UNWIND_HISTORY_TABLE_NONE;
     dispatch.TargetIp      = 0;
     dispatch.ContextRecord = &context;
     dispatch.HistoryTable  = &table;
@@ -2014,33 +2081,16 @@ static NTSTATUS call_stack_handlers( EXCEPTION_RECORD *rec, CONTEXT *orig_contex
     {
         new_context = context;
 
-        /* FIXME: should use the history table to make things faster */
-
-        module = NULL;
-        dispatch.ImageBase = 0;
-
         /* first look for PE exception information */
 
-        if (!LdrFindEntryForAddress( (void *)context.Rip, &module ))
+        if ((dispatch.FunctionEntry = lookup_function_info( context.Rip, &dispatch.ImageBase,
+                                                            &module, &table )))
         {
-            RUNTIME_FUNCTION *dir;
-
-            dispatch.ImageBase = (ULONG64)module->BaseAddress;
-            if ((dir = RtlImageDirectoryEntryToData( module->BaseAddress, TRUE,
-                                                     IMAGE_DIRECTORY_ENTRY_EXCEPTION, &size )))
-            {
-                if ((dispatch.FunctionEntry = find_function_info( context.Rip, module->BaseAddress,
-                                                                  dir, size )))
-                {
-                    dispatch.LanguageHandler = RtlVirtualUnwind( UNW_FLAG_EHANDLER, dispatch.ImageBase,
-                                                                 context.Rip, dispatch.FunctionEntry,
-                                                                 &new_context, &dispatch.HandlerData,
-                                                                 &dispatch.EstablisherFrame, NULL );
-                    goto unwind_done;
-                }
-            }
-            else if (!(module->Flags & LDR_WINE_INTERNAL))
-                WARN( "exception data not found in %s\n", debugstr_w(module->BaseDllName.Buffer) );
+            dispatch.LanguageHandler = RtlVirtualUnwind( UNW_FLAG_EHANDLER, dispatch.ImageBase,
+                                                         context.Rip, dispatch.FunctionEntry,
+                                                         &new_context, &dispatch.HandlerData,
+                                                         &dispatch.EstablisherFrame, NULL );
+            goto unwind_done;
         }
 
         /* then look for host system exception information */
@@ -2542,7 +2592,7 @@ PRUNTIME_FUNCTION WINAPI RtlLookupFunctionEntry( ULONG64 pc, ULONG64 *base, UNWI
     RUNTIME_FUNCTION *func;
     ULONG size;
 
-    /* FIXME: should use the history table to make things faster */
+    if ((func = lookup_history_table( pc, base, table ))) return func;
 
     if (LdrFindEntryForAddress( (void *)pc, &module ))
     {
@@ -2555,7 +2605,7 @@ PRUNTIME_FUNCTION WINAPI RtlLookupFunctionEntry( ULONG64 pc, ULONG64 *base, UNWI
         WARN( "no exception table found in module %p pc %lx\n", module->BaseAddress, pc );
         return NULL;
     }
-    func = find_function_info( pc, module->BaseAddress, func, size );
+    func = find_function_info( pc, module->BaseAddress, func, size, table );
     if (func) *base = (ULONG64)module->BaseAddress;
     return func;
 }
@@ -2912,11 +2962,12 @@ void WINAPI RtlUnwindEx( PVOID end_frame, PVOID target_ip, EXCEPTION_RECORD *rec
 {
     EXCEPTION_REGISTRATION_RECORD *teb_frame = NtCurrentTeb()->Tib.ExceptionList;
     EXCEPTION_RECORD record;
+    UNWIND_HISTORY_TABLE local_table;
     DISPATCHER_CONTEXT dispatch;
     CONTEXT new_context;
     LDR_MODULE *module;
     NTSTATUS status;
-    DWORD i, size;
+    DWORD i;
 
     RtlCaptureContext( context );
     new_context = *context;
@@ -2950,38 +3001,28 @@ void WINAPI RtlUnwindEx( PVOID end_frame, PVOID target_ip, EXCEPTION_RECORD *rec
     dispatch.EstablisherFrame = context->Rsp;
     dispatch.TargetIp         = (ULONG64)target_ip;
     dispatch.ContextRecord    = context;
+    if (!table)
+    {
+        local_table.Count  = 0;
+        local_table.Search = UNWIND_HISTORY_TABLE_NONE;
+        table = &local_table;
+    }
     dispatch.HistoryTable     = table;
 
     for (;;)
     {
-        /* FIXME: should use the history table to make things faster */
-
-        module = NULL;
-        dispatch.ImageBase = 0;
         dispatch.ScopeIndex = 0; /* FIXME */
 
         /* first look for PE exception information */
 
-        if (!LdrFindEntryForAddress( (void *)context->Rip, &module ))
+        if ((dispatch.FunctionEntry = lookup_function_info( context->Rip, &dispatch.ImageBase,
+                                                            &module, table )))
         {
-            RUNTIME_FUNCTION *dir;
-
-            dispatch.ImageBase = (ULONG64)module->BaseAddress;
-            if ((dir = RtlImageDirectoryEntryToData( module->BaseAddress, TRUE,
-                                                     IMAGE_DIRECTORY_ENTRY_EXCEPTION, &size )))
-            {
-                if ((dispatch.FunctionEntry = find_function_info( context->Rip, module->BaseAddress,
-                                                                  dir, size )))
-                {
-                    dispatch.LanguageHandler = RtlVirtualUnwind( UNW_FLAG_UHANDLER, dispatch.ImageBase,
-                                                                 context->Rip, dispatch.FunctionEntry,
-                                                                 &new_context, &dispatch.HandlerData,
-                                                                 &dispatch.EstablisherFrame, NULL );
-                    goto unwind_done;
-                }
-            }
-            else if (!(module->Flags & LDR_WINE_INTERNAL))
-                WARN( "exception data not found in %s\n", debugstr_w(module->BaseDllName.Buffer) );
+            dispatch.LanguageHandler = RtlVirtualUnwind( UNW_FLAG_UHANDLER, dispatch.ImageBase,
+                                                         context->Rip, dispatch.FunctionEntry,
+                                                         &new_context, &dispatch.HandlerData,
+                                                         &dispatch.EstablisherFrame, NULL );
+            goto unwind_done;
         }
 
         /* then look for host system exception information */
@@ -50,6 +50,9 @@ static NTSTATUS  (WINAPI *pNtTerminateProcess)(HANDLE handle, LONG exit_code);
 static NTSTATUS  (WINAPI *pNtQueryInformationProcess)(HANDLE, PROCESSINFOCLASS, PVOID, ULONG, PULONG);
 static NTSTATUS  (WINAPI *pNtSetInformationProcess)(HANDLE, PROCESSINFOCLASS, PVOID, ULONG);
 static BOOL      (WINAPI *pIsWow64Process)(HANDLE, PBOOL);
+#ifdef __x86_64__
+static RUNTIME_FUNCTION * (WINAPI *pRtlLookupFunctionEntry)(ULONG64, ULONG64*, UNWIND_HISTORY_TABLE*);
+#endif
 
 #ifdef __i386__
 
@@ -1447,6 +1450,44 @@ static void test_virtual_unwind(void)
         call_virtual_unwind( i, &tests[i] );
 }
 
+static void test_lookup_function_entry(void)
+{
+    static const char *names[] = { "RtlUnwindEx", "RtlVirtualUnwind", "NtClose" };
+    HMODULE hntdll = GetModuleHandleA("ntdll.dll");
+    UNWIND_HISTORY_TABLE table;
+    RUNTIME_FUNCTION *func, *func2;
+    ULONG64 base, base2, pc;
+    unsigned int i, j;
+
+    if (!pRtlLookupFunctionEntry)
+    {
+        win_skip( "RtlLookupFunctionEntry not found\n" );
+        return;
+    }
+
+    memset( &table, 0, sizeof(table) );
+    for (j = 0; j < 2; j++)
+    {
+        for (i = 0; i < sizeof(names)/sizeof(names[0]); i++)
+        {
+            pc = (ULONG64)GetProcAddress( hntdll, names[i] ) + 1;
+            base = base2 = 0xdeadbeef;
+            func = pRtlLookupFunctionEntry( pc, &base, NULL );
+            if (!func)
+            {
+                skip( "no function entry for %s\n", names[i] );
+                continue;
+            }
+            ok( base == (ULONG64)hntdll, "%s: wrong base %p/%p\n", names[i], (void *)base, hntdll );
+
+            /* second pass is served from the history table */
+            func2 = pRtlLookupFunctionEntry( pc, &base2, &table );
+            ok( func2 == func, "%u/%s: wrong entry %p/%p\n", j, names[i], func2, func );
+            ok( base2 == base, "%u/%s: wrong base %p/%p\n", j, names[i], (void *)base2, (void *)base );
+        }
+    }
+}
+
 #endif  /* __x86_64__ */
 
 START_TEST(exception)
@@ -1535,7 +1576,10 @@ START_TEST(exception)
 
 #elif defined(__x86_64__)
 
+    pRtlLookupFunctionEntry = (void *)GetProcAddress( hntdll, "RtlLookupFunctionEntry" );
+
     test_virtual_unwind();
+    test_lookup_function_entry();
 
 #endif
 
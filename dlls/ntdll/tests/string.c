@@ -56,6 +56,8 @@ static LPWSTR   (__cdecl *p_wcsupr)(LPWSTR);
 
 static LPWSTR   (WINAPIV *p_wcschr)(LPCWSTR, WCHAR);
 static LPWSTR   (WINAPIV *p_wcsrchr)(LPCWSTR, WCHAR);
+static size_t   (__cdecl *p_wcslen)(LPCWSTR);
+static int      (__cdecl *p_wcscmp)(LPCWSTR, LPCWSTR);
 
 static void     (__cdecl *p_qsort)(void *,size_t,size_t, int(__cdecl *compar)(const void *, const void *) );
 static void*    (__cdecl *p_bsearch)(void *,void*,size_t,size_t, int(__cdecl *compar)(const void *, const void *) );
@@ -94,6 +96,8 @@ static void InitFunctionPtrs(void)
 
 	p_wcschr= (void *)GetProcAddress(hntdll, "wcschr");
 	p_wcsrchr= (void *)GetProcAddress(hntdll, "wcsrchr");
+	p_wcslen= (void *)GetProcAddress(hntdll, "wcslen");
+	p_wcscmp= (void *)GetProcAddress(hntdll, "wcscmp");
 	p_qsort= (void *)GetProcAddress(hntdll, "qsort");
 	p_bsearch= (void *)GetProcAddress(hntdll, "bsearch");
     } /* if */
@@ -1131,6 +1135,38 @@ static void test_wcschr(void)
        "wcschr should have returned NULL\n");
 }
 
+static void test_wcslen_wcscmp(void)
+{
+    WCHAR buf1[40], buf2[40];
+    unsigned int off, len, i;
+
+    /* exercise all alignments and lengths around the machine word size */
+    for (off = 0; off < 8; off++)
+    {
+        for (len = 0; len < 24; len++)
+        {
+            WCHAR *str1 = buf1 + off, *str2 = buf2 + (off * 3) % 8;
+
+            for (i = 0; i < len; i++) str1[i] = str2[i] = 0x8000 | (i + 1);
+            str1[len] = str2[len] = 0;
+
+            ok(p_wcslen(str1) == len, "%u/%u: wcslen returned %u\n", off, len, (UINT)p_wcslen(str1));
+            ok(!p_wcscmp(str1, str2), "%u/%u: strings should be equal\n", off, len);
+            ok(p_wcschr(str1, 0) == str1 + len, "%u/%u: wcschr(0) returned %p, expected %p\n",
+               off, len, p_wcschr(str1, 0), str1 + len);
+            if (!len) continue;
+
+            ok(p_wcschr(str1, str1[len - 1]) == str1 + len - 1, "%u/%u: wcschr returned %p, expected %p\n",
+               off, len, p_wcschr(str1, str1[len - 1]), str1 + len - 1);
+            ok(p_wcschr(str1, 0x7fff) == NULL, "%u/%u: wcschr should have returned NULL\n", off, len);
+            str2[len - 1] = 0xffff;
+            ok(p_wcscmp(str1, str2) < 0, "%u/%u: wcscmp should have returned < 0\n", off, len);
+            str2[len - 1] = 1;
+            ok(p_wcscmp(str1, str2) > 0, "%u/%u: wcscmp should have returned > 0\n", off, len);
+        }
+    }
+}
+
 static void test_wcsrchr(void)
 {
     static const WCHAR teststringW[] = {'a','b','r','a','c','a','d','a','b','r','a',0};
@@ -1294,6 +1330,8 @@ START_TEST(string)
         test_wcschr();
     if (p_wcsrchr)
         test_wcsrchr();
+    if (p_wcschr && p_wcslen && p_wcscmp)
+        test_wcslen_wcscmp();
     if (p_wcslwr && p_wcsupr)
         test_wcslwrupr();
     if (patoi)
@@ -33,6 +33,13 @@
 #include "winternl.h"
 #include "wine/unicode.h"
 
+/* helpers to scan strings one machine word at a time; a word containing
+ * a null WCHAR has the top bit of that WCHAR set in WCS_HAS_ZERO() */
+#define WCS_ONES        (~(ULONG_PTR)0 / 0xffff)
+#define WCS_HIGHS       (WCS_ONES << 15)
+#define WCS_HAS_ZERO(x) (((x) - WCS_ONES) & ~(x) & WCS_HIGHS)
+#define WCS_ALIGNED(p)  (!((ULONG_PTR)(p) & (sizeof(ULONG_PTR) - 1)))
+
 /*********************************************************************
  *           _wcsicmp    (NTDLL.@)
  */
@@ -101,7 +108,19 @@ LPWSTR __cdecl NTDLL_wcscat( LPWSTR dst, LPCWSTR src )
  */
 LPWSTR __cdecl NTDLL_wcschr( LPCWSTR str, WCHAR ch )
 {
-    return strchrW( str, ch );
+    const ULONG_PTR *p;
+    ULONG_PTR mask = ch * WCS_ONES;
+
+    if ((ULONG_PTR)str & 1) return strchrW( str, ch );
+    for (; !WCS_ALIGNED(str); str++)
+    {
+        if (*str == ch) return (LPWSTR)str;
+        if (!*str) return NULL;
+    }
+    /* aligned reads never cross a page boundary */
+    for (p = (const ULONG_PTR *)str; !WCS_HAS_ZERO(*p) && !WCS_HAS_ZERO(*p ^ mask); p++) ;
+    for (str = (LPCWSTR)p; *str != ch; str++) if (!*str) return NULL;
+    return (LPWSTR)str;
 }
 
 
@@ -110,6 +129,18 @@ LPWSTR __cdecl NTDLL_wcschr( LPCWSTR str, WCHAR ch )
  */
 INT __cdecl NTDLL_wcscmp( LPCWSTR str1, LPCWSTR str2 )
 {
+    if (!(((ULONG_PTR)str1 ^ (ULONG_PTR)str2) & (sizeof(ULONG_PTR) - 1)) && !((ULONG_PTR)str1 & 1))
+    {
+        const ULONG_PTR *p1, *p2;
+
+        for (; !WCS_ALIGNED(str1); str1++, str2++)
+            if (*str1 != *str2 || !*str1) return *str1 - *str2;
+        p1 = (const ULONG_PTR *)str1;
+        p2 = (const ULONG_PTR *)str2;
+        while (*p1 == *p2 && !WCS_HAS_ZERO(*p1)) p1++, p2++;
+        str1 = (LPCWSTR)p1;
+        str2 = (LPCWSTR)p2;
+    }
     return strcmpW( str1, str2 );
 }
 
@@ -137,7 +168,14 @@ INT __cdecl NTDLL_wcscspn( LPCWSTR str, LPCWSTR reject )
  */
 INT __cdecl NTDLL_wcslen( LPCWSTR str )
 {
-    return strlenW( str );
+    const WCHAR *s = str;
+    const ULONG_PTR *p;
+
+    if ((ULONG_PTR)str & 1) return strlenW( str );
+    for (; !WCS_ALIGNED(s); s++) if (!*s) return s - str;
+    for (p = (const ULONG_PTR *)s; !WCS_HAS_ZERO(*p); p++) ;
+    for (s = (const WCHAR *)p; *s; s++) ;
+    return s - str;
 }
 
 
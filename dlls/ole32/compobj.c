@@ -1256,7 +1256,7 @@ static DWORD COM_RegReadPath(HKEY hkeyroot, WCHAR * dst, DWORD dstlen)
 
 struct host_object_params
 {
-    HKEY hkeydll;
+    WCHAR dllpath[MAX_PATH+1]; /* path of the dll implementing the object */
     CLSID clsid; /* clsid of object to marshal */
     IID iid; /* interface to marshal */
     HANDLE event; /* event signalling when ready for multi-threaded case */
@@ -1271,18 +1271,10 @@ static HRESULT apartment_hostobject(struct apartment *apt,
     IUnknown *object;
     HRESULT hr;
     static const LARGE_INTEGER llZero;
-    WCHAR dllpath[MAX_PATH+1];
 
     TRACE("clsid %s, iid %s\n", debugstr_guid(&params->clsid), debugstr_guid(&params->iid));
 
-    if (COM_RegReadPath(params->hkeydll, dllpath, ARRAYSIZE(dllpath)) != ERROR_SUCCESS)
-    {
-        /* failure: CLSID is not found in registry */
-        WARN("class %s not registered inproc\n", debugstr_guid(&params->clsid));
-        return REGDB_E_CLASSNOTREG;
-    }
-
-    hr = apartment_getclassobject(apt, dllpath, params->apartment_threaded,
+    hr = apartment_getclassobject(apt, params->dllpath, params->apartment_threaded,
                                   &params->clsid, &params->iid, (void **)&object);
     if (FAILED(hr))
         return hr;
@@ -1372,7 +1364,7 @@ static DWORD CALLBACK apartment_hostobject_thread(LPVOID p)
  * caller of this function */
 static HRESULT apartment_hostobject_in_hostapt(
     struct apartment *apt, BOOL multi_threaded, BOOL main_apartment,
-    HKEY hkeydll, REFCLSID rclsid, REFIID riid, void **ppv)
+    LPCWSTR dllpath, REFCLSID rclsid, REFIID riid, void **ppv)
 {
     struct host_object_params params;
     HWND apartment_hwnd = NULL;
@@ -1442,7 +1434,7 @@ static HRESULT apartment_hostobject_in_hostapt(
         }
     }
 
-    params.hkeydll = hkeydll;
+    lstrcpynW(params.dllpath, dllpath, ARRAYSIZE(params.dllpath));
     params.clsid = *rclsid;
     params.iid = *riid;
     hr = CreateStreamOnHGlobal(NULL, TRUE, &params.stream);
@@ -2597,34 +2589,197 @@ static void get_threading_model(HKEY key, LPWSTR value, DWORD len)
         value[0] = '\0';
 }
 
-static HRESULT get_inproc_class_object(APARTMENT *apt, HKEY hkeydll,
-                                       REFCLSID rclsid, REFIID riid,
-                                       BOOL hostifnecessary, void **ppv)
+/*
+ * Cache of the InprocServer32 and InprocHandler32 registry information of
+ * classes, so that creating an object doesn't have to go through the
+ * registry every time. The cache is flushed whenever something changes under
+ * HKCR\CLSID.
+ */
+struct class_info
 {
+    struct list entry;
+    CLSID clsid;
+    BOOL handler;            /* InprocHandler32 instead of InprocServer32 */
+    HRESULT hr;              /* result of opening the key */
+    BOOL have_path;          /* dllpath could be read */
     WCHAR dllpath[MAX_PATH+1];
+    WCHAR threading_model[10 /* strlenW(L"apartment")+1 */];
+};
+
+#define CLASS_INFO_HASH_SIZE 64
+
+static struct list class_info_cache[CLASS_INFO_HASH_SIZE]; /* protected by csClassInfo */
+static HKEY class_info_key;     /* HKCR\CLSID key watched for changes */
+static HANDLE class_info_event; /* signaled when class_info_key changes */
+
+static CRITICAL_SECTION csClassInfo;
+static CRITICAL_SECTION_DEBUG class_info_cs_debug =
+{
+    0, 0, &csClassInfo,
+    { &class_info_cs_debug.ProcessLocksList, &class_info_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": csClassInfo") }
+};
+static CRITICAL_SECTION csClassInfo = { &class_info_cs_debug, -1, 0, 0, 0, 0 };
+
+static void class_info_flush(void)
+{
+    struct class_info *info, *next;
+    int i;
+
+    for (i = 0; i < CLASS_INFO_HASH_SIZE; i++)
+    {
+        if (!class_info_cache[i].next) continue;
+        LIST_FOR_EACH_ENTRY_SAFE(info, next, &class_info_cache[i], struct class_info, entry)
+        {
+            list_remove(&info->entry);
+            HeapFree(GetProcessHeap(), 0, info);
+        }
+    }
+}
+
+/* checks for registry changes since the last call and flushes the cache if
+ * necessary. Returns FALSE if changes can't be monitored, in which case the
+ * cache mustn't be used. Must be called with csClassInfo held */
+static BOOL class_info_check_changes(void)
+{
+    static const WCHAR wszCLSID[] = {'C','L','S','I','D',0};
+    int i;
+
+    if (class_info_event)
+    {
+        if (WaitForSingleObject(class_info_event, 0) != WAIT_OBJECT_0)
+            return TRUE;
+
+        TRACE("registry changed, flushing class cache\n");
+        class_info_flush();
+    }
+    else
+    {
+        if (open_classes_key(HKEY_CLASSES_ROOT, wszCLSID, KEY_NOTIFY, &class_info_key))
+            return FALSE;
+        if (!(class_info_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        {
+            RegCloseKey(class_info_key);
+            class_info_key = NULL;
+            return FALSE;
+        }
+        for (i = 0; i < CLASS_INFO_HASH_SIZE; i++)
+            list_init(&class_info_cache[i]);
+    }
+
+    /* notifications only fire once, so rearm before reading anything */
+    if (RegNotifyChangeKeyValue(class_info_key, TRUE,
+                                REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET,
+                                class_info_event, TRUE))
+    {
+        WARN("can't monitor class registrations, not caching\n");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void class_info_read(struct class_info *info)
+{
+    static const WCHAR wszInprocServer32[] = {'I','n','p','r','o','c','S','e','r','v','e','r','3','2',0};
+    static const WCHAR wszInprocHandler32[] = {'I','n','p','r','o','c','H','a','n','d','l','e','r','3','2',0};
+    HKEY hkey;
+
+    info->have_path = FALSE;
+    info->dllpath[0] = 0;
+    info->threading_model[0] = 0;
+
+    info->hr = COM_OpenKeyForCLSID(&info->clsid, info->handler ? wszInprocHandler32 : wszInprocServer32,
+                                   KEY_READ, &hkey);
+    if (FAILED(info->hr)) return;
+
+    get_threading_model(hkey, info->threading_model, ARRAYSIZE(info->threading_model));
+    info->have_path = COM_RegReadPath(hkey, info->dllpath, ARRAYSIZE(info->dllpath)) == ERROR_SUCCESS;
+    RegCloseKey(hkey);
+}
+
+/* retrieves the registry information of an in-process server or handler */
+static void get_class_info(REFCLSID rclsid, BOOL handler, struct class_info *ret)
+{
+    struct list *bucket = &class_info_cache[rclsid->Data1 % CLASS_INFO_HASH_SIZE];
+    struct class_info *info;
+
+    EnterCriticalSection(&csClassInfo);
+
+    if (!class_info_check_changes())
+    {
+        LeaveCriticalSection(&csClassInfo);
+        ret->clsid = *rclsid;
+        ret->handler = handler;
+        class_info_read(ret);
+        return;
+    }
+
+    LIST_FOR_EACH_ENTRY(info, bucket, struct class_info, entry)
+    {
+        if (info->handler == handler && IsEqualCLSID(&info->clsid, rclsid))
+        {
+            *ret = *info;
+            LeaveCriticalSection(&csClassInfo);
+            return;
+        }
+    }
+
+    ret->clsid = *rclsid;
+    ret->handler = handler;
+    class_info_read(ret);
+
+    /* only cache definite answers, read errors may be transient */
+    if (ret->hr != REGDB_E_READREGDB &&
+        (info = HeapAlloc(GetProcessHeap(), 0, sizeof(*info))))
+    {
+        *info = *ret;
+        list_add_head(bucket, &info->entry);
+    }
+
+    LeaveCriticalSection(&csClassInfo);
+}
+
+static void class_info_free(void)
+{
+    class_info_flush();
+    if (class_info_event) CloseHandle(class_info_event);
+    if (class_info_key) RegCloseKey(class_info_key);
+    DeleteCriticalSection(&csClassInfo);
+}
+
+static HRESULT get_inproc_class_object(APARTMENT *apt, const struct class_info *info,
+                                       REFIID riid, BOOL hostifnecessary, void **ppv)
+{
+    REFCLSID rclsid = &info->clsid;
     BOOL apartment_threaded;
 
+    if (!info->have_path)
+    {
+        /* failure: CLSID is not found in registry */
+        WARN("class %s not registered inproc\n", debugstr_guid(rclsid));
+        return REGDB_E_CLASSNOTREG;
+    }
+
     if (hostifnecessary)
     {
         static const WCHAR wszApartment[] = {'A','p','a','r','t','m','e','n','t',0};
         static const WCHAR wszFree[] = {'F','r','e','e',0};
         static const WCHAR wszBoth[] = {'B','o','t','h',0};
-        WCHAR threading_model[10 /* strlenW(L"apartment")+1 */];
+        const WCHAR *threading_model = info->threading_model;
 
-        get_threading_model(hkeydll, threading_model, ARRAYSIZE(threading_model));
         /* "Apartment" */
         if (!strcmpiW(threading_model, wszApartment))
         {
             apartment_threaded = TRUE;
             if (apt->multi_threaded)
-                return apartment_hostobject_in_hostapt(apt, FALSE, FALSE, hkeydll, rclsid, riid, ppv);
+                return apartment_hostobject_in_hostapt(apt, FALSE, FALSE, info->dllpath, rclsid, riid, ppv);
         }
         /* "Free" */
         else if (!strcmpiW(threading_model, wszFree))
         {
             apartment_threaded = FALSE;
             if (!apt->multi_threaded)
-                return apartment_hostobject_in_hostapt(apt, TRUE, FALSE, hkeydll, rclsid, riid, ppv);
+                return apartment_hostobject_in_hostapt(apt, TRUE, FALSE, info->dllpath, rclsid, riid, ppv);
         }
         /* everything except "Apartment", "Free" and "Both" */
         else if (strcmpiW(threading_model, wszBoth))
@@ -2636,7 +2791,7 @@ static HRESULT get_inproc_class_object(APARTMENT *apt, HKEY hkeydll,
                     debugstr_w(threading_model), debugstr_guid(rclsid));
 
             if (apt->multi_threaded || !apt->main)
-                return apartment_hostobject_in_hostapt(apt, FALSE, TRUE, hkeydll, rclsid, riid, ppv);
+                return apartment_hostobject_in_hostapt(apt, FALSE, TRUE, info->dllpath, rclsid, riid, ppv);
         }
         else
             apartment_threaded = FALSE;
@@ -2644,14 +2799,7 @@ static HRESULT get_inproc_class_object(APARTMENT *apt, HKEY hkeydll,
     else
         apartment_threaded = !apt->multi_threaded;
 
-    if (COM_RegReadPath(hkeydll, dllpath, ARRAYSIZE(dllpath)) != ERROR_SUCCESS)
-    {
-        /* failure: CLSID is not found in registry */
-        WARN("class %s not registered inproc\n", debugstr_guid(rclsid));
-        return REGDB_E_CLASSNOTREG;
-    }
-
-    return apartment_getclassobject(apt, dllpath, apartment_threaded,
+    return apartment_getclassobject(apt, info->dllpath, apartment_threaded,
                                     rclsid, riid, ppv);
 }
 
@@ -2735,8 +2883,7 @@ HRESULT WINAPI CoGetClassObject(
     /* First try in-process server */
     if (CLSCTX_INPROC_SERVER & dwClsContext)
     {
-        static const WCHAR wszInprocServer32[] = {'I','n','p','r','o','c','S','e','r','v','e','r','3','2',0};
-        HKEY hkey;
+        struct class_info info;
 
         if (IsEqualCLSID(rclsid, &CLSID_InProcFreeMarshaler))
         {
@@ -2744,7 +2891,8 @@ HRESULT WINAPI CoGetClassObject(
             return FTMarshalCF_Create(iid, ppv);
         }
 
-        hres = COM_OpenKeyForCLSID(rclsid, wszInprocServer32, KEY_READ, &hkey);
+        get_class_info(rclsid, FALSE, &info);
+        hres = info.hr;
         if (FAILED(hres))
         {
             if (hres == REGDB_E_CLASSNOTREG)
@@ -2757,11 +2905,8 @@ HRESULT WINAPI CoGetClassObject(
         }
 
         if (SUCCEEDED(hres))
-        {
-            hres = get_inproc_class_object(apt, hkey, rclsid, iid,
+            hres = get_inproc_class_object(apt, &info, iid,
                 !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
-            RegCloseKey(hkey);
-        }
 
         /* return if we got a class, otherwise fall through to one of the
          * other types */
@@ -2775,10 +2920,10 @@ HRESULT WINAPI CoGetClassObject(
     /* Next try in-process handler */
     if (CLSCTX_INPROC_HANDLER & dwClsContext)
     {
-        static const WCHAR wszInprocHandler32[] = {'I','n','p','r','o','c','H','a','n','d','l','e','r','3','2',0};
-        HKEY hkey;
+        struct class_info info;
 
-        hres = COM_OpenKeyForCLSID(rclsid, wszInprocHandler32, KEY_READ, &hkey);
+        get_class_info(rclsid, TRUE, &info);
+        hres = info.hr;
         if (FAILED(hres))
         {
             if (hres == REGDB_E_CLASSNOTREG)
@@ -2791,11 +2936,8 @@ HRESULT WINAPI CoGetClassObject(
         }
 
         if (SUCCEEDED(hres))
-        {
-            hres = get_inproc_class_object(apt, hkey, rclsid, iid,
+            hres = get_inproc_class_object(apt, &info, iid,
                 !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
-            RegCloseKey(hkey);
-        }
 
         /* return if we got a class, otherwise fall through to one of the
          * other types */
@@ -4597,6 +4739,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID reserved)
         COMPOBJ_UninitProcess();
         RPC_UnregisterAllChannelHooks();
         COMPOBJ_DllList_Free();
+        class_info_free();
         DeleteCriticalSection(&csRegisteredClassList);
         DeleteCriticalSection(&csApartment);
 	break;
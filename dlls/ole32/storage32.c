@@ -60,6 +60,9 @@ WINE_DEFAULT_DEBUG_CHANNEL(storage);
 #define OLESTREAM_ID 0x501
 #define OLESTREAM_MAX_STR_LEN 255
 
+/* Size of the chunks used to copy stream contents */
+#define COPY_STREAM_BUFFER_SIZE 0x10000
+
 /*
  * These are signatures to detect the type of Document file.
  */
@@ -4327,11 +4330,16 @@ static HRESULT StorageBaseImpl_CopyStream(
   StorageBaseImpl *src, DirRef src_entry)
 {
   HRESULT hr;
-  BYTE data[4096];
+  BYTE *data;
   DirEntry srcdata;
   ULARGE_INTEGER bytes_copied;
   ULONG bytestocopy, bytesread, byteswritten;
 
+  /* copy in large chunks so that the writes can be coalesced */
+  data = HeapAlloc(GetProcessHeap(), 0, COPY_STREAM_BUFFER_SIZE);
+  if (!data)
+    return E_OUTOFMEMORY;
+
   hr = StorageBaseImpl_ReadDirEntry(src, src_entry, &srcdata);
 
   if (SUCCEEDED(hr))
@@ -4341,7 +4349,7 @@ static HRESULT StorageBaseImpl_CopyStream(
     bytes_copied.QuadPart = 0;
     while (bytes_copied.QuadPart < srcdata.size.QuadPart && SUCCEEDED(hr))
     {
-      bytestocopy = min(4096, srcdata.size.QuadPart - bytes_copied.QuadPart);
+      bytestocopy = min(COPY_STREAM_BUFFER_SIZE, srcdata.size.QuadPart - bytes_copied.QuadPart);
 
       hr = StorageBaseImpl_StreamReadAt(src, src_entry, bytes_copied, bytestocopy,
         data, &bytesread);
@@ -4358,6 +4366,7 @@ static HRESULT StorageBaseImpl_CopyStream(
     }
   }
 
+  HeapFree(GetProcessHeap(), 0, data);
   return hr;
 }
 
@@ -5973,12 +5982,15 @@ HRESULT BlockChainStream_UpdateIndexCache(BlockChainStream* This)
   return S_OK;
 }
 
-/* Locate the nth block in this stream. */
-ULONG BlockChainStream_GetSectorOfOffset(BlockChainStream *This, ULONG offset)
+/* Locate the nth block in this stream, and count the blocks starting there
+ * that are stored in consecutive sectors. */
+static ULONG BlockChainStream_GetSectorRun(BlockChainStream *This, ULONG offset, ULONG *run_length)
 {
   ULONG min_offset = 0, max_offset = This->numBlocks-1;
   ULONG min_run = 0, max_run = This->indexCacheLen-1;
 
+  *run_length = 0;
+
   if (offset >= This->numBlocks)
     return BLOCK_END_OF_CHAIN;
 
@@ -6000,9 +6012,41 @@ ULONG BlockChainStream_GetSectorOfOffset(BlockChainStream *This, ULONG offset)
       min_run = max_run = run_to_check;
   }
 
+  *run_length = This->indexCache[min_run].lastOffset - offset + 1;
   return This->indexCache[min_run].firstSector + offset - This->indexCache[min_run].firstOffset;
 }
 
+/* Locate the nth block in this stream. */
+ULONG BlockChainStream_GetSectorOfOffset(BlockChainStream *This, ULONG offset)
+{
+  ULONG run_length;
+
+  return BlockChainStream_GetSectorRun(This, offset, &run_length);
+}
+
+/*
+ * Count how many of the next blocks, up to count, can be transferred with a
+ * single call because they are in consecutive sectors and not in the cache.
+ */
+static ULONG BlockChainStream_GetDirectRun(BlockChainStream *This,
+    ULONG index, ULONG count, ULONG *sector)
+{
+  ULONG run_length;
+  int i;
+
+  *sector = BlockChainStream_GetSectorRun(This, index, &run_length);
+  if (*sector == BLOCK_END_OF_CHAIN)
+    return 0;
+
+  count = min(count, run_length);
+
+  for (i=0; i<2; i++)
+    if (This->cachedBlocks[i].index >= index && This->cachedBlocks[i].index - index < count)
+      count = This->cachedBlocks[i].index - index;
+
+  return count;
+}
+
 HRESULT BlockChainStream_GetBlockAtOffset(BlockChainStream *This,
     ULONG index, BlockChainBlock **block, ULONG *sector, BOOL create)
 {
@@ -6197,6 +6241,40 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
   {
     ULARGE_INTEGER ulOffset;
     DWORD bytesReadAt;
+    ULONG directBlocks;
+
+    /*
+     * Read whole blocks in consecutive sectors with a single call. The last
+     * block is left to the cache below.
+     */
+    if (offsetInBlock == 0 && size > This->parentStorage->bigBlockSize)
+    {
+      directBlocks = BlockChainStream_GetDirectRun(This, blockNoInSequence,
+          (size - 1) / This->parentStorage->bigBlockSize, &blockIndex);
+
+      if (directBlocks)
+      {
+        bytesToReadInBuffer = directBlocks * This->parentStorage->bigBlockSize;
+
+        ulOffset.u.HighPart = 0;
+        ulOffset.u.LowPart = StorageImpl_GetBigBlockOffset(This->parentStorage, blockIndex);
+
+        StorageImpl_ReadAt(This->parentStorage,
+             ulOffset,
+             bufferWalker,
+             bytesToReadInBuffer,
+             &bytesReadAt);
+
+        blockNoInSequence += directBlocks;
+        bufferWalker += bytesReadAt;
+        size         -= bytesReadAt;
+        *bytesRead   += bytesReadAt;
+
+        if (bytesToReadInBuffer != bytesReadAt)
+          break;
+        continue;
+      }
+    }
 
     /*
      * Calculate how many bytes we can copy from this big block.
@@ -6277,6 +6355,40 @@ HRESULT BlockChainStream_WriteAt(BlockChainStream* This,
   {
     ULARGE_INTEGER ulOffset;
     DWORD bytesWrittenAt;
+    ULONG directBlocks;
+
+    /*
+     * Write whole blocks in consecutive sectors with a single call. The last
+     * block is left to the cache below.
+     */
+    if (offsetInBlock == 0 && size > This->parentStorage->bigBlockSize)
+    {
+      directBlocks = BlockChainStream_GetDirectRun(This, blockNoInSequence,
+          (size - 1) / This->parentStorage->bigBlockSize, &blockIndex);
+
+      if (directBlocks)
+      {
+        bytesToWrite = directBlocks * This->parentStorage->bigBlockSize;
+
+        ulOffset.u.HighPart = 0;
+        ulOffset.u.LowPart = StorageImpl_GetBigBlockOffset(This->parentStorage, blockIndex);
+
+        StorageImpl_WriteAt(This->parentStorage,
+             ulOffset,
+             bufferWalker,
+             bytesToWrite,
+             &bytesWrittenAt);
+
+        blockNoInSequence += directBlocks;
+        bufferWalker  += bytesWrittenAt;
+        size          -= bytesWrittenAt;
+        *bytesWritten += bytesWrittenAt;
+
+        if (bytesWrittenAt != bytesToWrite)
+          break;
+        continue;
+      }
+    }
 
     /*
      * Calculate how many bytes we can copy to this big block.
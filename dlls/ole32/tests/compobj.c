@@ -463,6 +463,59 @@ static void test_CoGetClassObject(void)
     CoUninitialize();
 }
 
+static void test_CoGetClassObject_registry_changes(void)
+{
+    static const char clsid_key[] = "CLSID\\{12345678-1234-1234-1234-56789ABCDEF0}";
+    static const char inproc_key[] = "CLSID\\{12345678-1234-1234-1234-56789ABCDEF0}\\InprocServer32";
+    static const char ole32_path[] = "\"ole32.dll\"";
+    IUnknown *pUnk;
+    HRESULT hr;
+    HKEY hkey;
+    LONG res;
+
+    CoInitialize(NULL);
+
+    pUnk = (IUnknown *)0xdeadbeef;
+    hr = CoGetClassObject(&CLSID_non_existent, CLSCTX_INPROC_SERVER, NULL, &IID_IUnknown, (void **)&pUnk);
+    ok(hr == REGDB_E_CLASSNOTREG, "CoGetClassObject should have returned REGDB_E_CLASSNOTREG instead of 0x%08x\n", hr);
+
+    res = RegCreateKeyEx(HKEY_CLASSES_ROOT, clsid_key, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &hkey, NULL);
+    if (res == ERROR_ACCESS_DENIED)
+    {
+        skip("Not authorized to modify the Classes key\n");
+        CoUninitialize();
+        return;
+    }
+    ok(!res, "RegCreateKeyEx returned %d\n", res);
+    RegCloseKey(hkey);
+
+    /* the class is now registered, but not as an in-process server */
+    hr = CoGetClassObject(&CLSID_non_existent, CLSCTX_INPROC_SERVER, NULL, &IID_IUnknown, (void **)&pUnk);
+    ok(hr == REGDB_E_CLASSNOTREG, "CoGetClassObject should have returned REGDB_E_CLASSNOTREG instead of 0x%08x\n", hr);
+
+    res = RegCreateKeyEx(HKEY_CLASSES_ROOT, inproc_key, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &hkey, NULL);
+    ok(!res, "RegCreateKeyEx returned %d\n", res);
+    res = RegSetValueEx(hkey, NULL, 0, REG_SZ, (const BYTE *)ole32_path, sizeof(ole32_path));
+    ok(!res, "RegSetValueEx returned %d\n", res);
+    res = RegSetValueEx(hkey, "ThreadingModel", 0, REG_SZ, (const BYTE *)"Both", sizeof("Both"));
+    ok(!res, "RegSetValueEx returned %d\n", res);
+    RegCloseKey(hkey);
+
+    /* ole32 doesn't implement the class, but the registration must be seen */
+    hr = CoGetClassObject(&CLSID_non_existent, CLSCTX_INPROC_SERVER, NULL, &IID_IUnknown, (void **)&pUnk);
+    ok(hr == CLASS_E_CLASSNOTAVAILABLE, "CoGetClassObject should have returned CLASS_E_CLASSNOTAVAILABLE instead of 0x%08x\n", hr);
+
+    res = RegDeleteKey(HKEY_CLASSES_ROOT, inproc_key);
+    ok(!res, "RegDeleteKey returned %d\n", res);
+    res = RegDeleteKey(HKEY_CLASSES_ROOT, clsid_key);
+    ok(!res, "RegDeleteKey returned %d\n", res);
+
+    hr = CoGetClassObject(&CLSID_non_existent, CLSCTX_INPROC_SERVER, NULL, &IID_IUnknown, (void **)&pUnk);
+    ok(hr == REGDB_E_CLASSNOTREG, "CoGetClassObject should have returned REGDB_E_CLASSNOTREG instead of 0x%08x\n", hr);
+
+    CoUninitialize();
+}
+
 static ATOM register_dummy_class(void)
 {
     WNDCLASS wc =
@@ -1590,6 +1643,7 @@ START_TEST(compobj)
     test_CoCreateInstance();
     test_ole_menu();
     test_CoGetClassObject();
+    test_CoGetClassObject_registry_changes();
     test_CoRegisterMessageFilter();
     test_CoRegisterPSClsid();
     test_CoGetPSClsid();
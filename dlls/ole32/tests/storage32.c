@@ -3099,6 +3099,84 @@ if (hr == S_OK) {
     DeleteFileW(fileW);
 }
 
+static void test_large_streams(void)
+{
+    static const DWORD mode = STGM_CREATE | STGM_READWRITE | STGM_SHARE_EXCLUSIVE;
+    IStorage *stg;
+    IStream *stm[2];
+    LARGE_INTEGER pos;
+    BYTE *data, *buffer;
+    ULONG count, i, j;
+    HRESULT hr;
+    BOOL r;
+
+    data = HeapAlloc(GetProcessHeap(), 0, 0x40000);
+    buffer = HeapAlloc(GetProcessHeap(), 0, 0x40000);
+    for (i = 0; i < 0x40000; i++)
+        data[i] = i * 7 + (i >> 9);
+
+    hr = StgCreateDocfile(filename, mode | STGM_TRANSACTED, 0, &stg);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    hr = IStorage_CreateStream(stg, strmA_name, mode & ~STGM_CREATE, 0, 0, &stm[0]);
+    ok(hr == S_OK, "got %08x\n", hr);
+    hr = IStorage_CreateStream(stg, strmB_name, mode & ~STGM_CREATE, 0, 0, &stm[1]);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    /* interleave the writes so that the block chains are fragmented */
+    for (i = 0; i < 0x40000; i += 0x3000)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            hr = IStream_Write(stm[j], data + i, min(0x3000, 0x40000 - i), &count);
+            ok(hr == S_OK, "got %08x\n", hr);
+        }
+    }
+
+    hr = IStorage_Commit(stg, STGC_DEFAULT);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    /* overwrite a range of the second stream, not starting on a block boundary */
+    pos.QuadPart = 0x1234;
+    hr = IStream_Seek(stm[1], pos, STREAM_SEEK_SET, NULL);
+    ok(hr == S_OK, "got %08x\n", hr);
+    memset(buffer, 0x55, 0x10000);
+    hr = IStream_Write(stm[1], buffer, 0x10000, &count);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(count == 0x10000, "got %u\n", count);
+    memset(data + 0x1234, 0x55, 0x10000);
+
+    for (j = 0; j < 2; j++)
+        IStream_Release(stm[j]);
+
+    hr = IStorage_Commit(stg, STGC_DEFAULT);
+    ok(hr == S_OK, "got %08x\n", hr);
+    IStorage_Release(stg);
+
+    hr = StgOpenStorage(filename, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &stg);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    hr = IStorage_OpenStream(stg, strmB_name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &stm[1]);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    pos.QuadPart = 100;
+    hr = IStream_Seek(stm[1], pos, STREAM_SEEK_SET, NULL);
+    ok(hr == S_OK, "got %08x\n", hr);
+    hr = IStream_Read(stm[1], buffer, 0x40000, &count);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(count == 0x40000 - 100, "got %u\n", count);
+    ok(!memcmp(buffer, data + 100, 0x40000 - 100), "data differs\n");
+
+    IStream_Release(stm[1]);
+    IStorage_Release(stg);
+
+    r = DeleteFileA(filenameA);
+    ok(r, "file should exist\n");
+
+    HeapFree(GetProcessHeap(), 0, buffer);
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
 START_TEST(storage32)
 {
     CHAR temp[MAX_PATH];
@@ -3144,4 +3222,5 @@ START_TEST(storage32)
     test_hglobal_storage_creation();
     test_convert();
     test_direct_swmr();
+    test_large_streams();
 }
@@ -1214,7 +1214,7 @@ static void test_typelibmarshal(void)
     ITypeInfo *pTypeInfo;
     MYSTRUCT mystruct;
     MYSTRUCT mystructArray[5];
-    UINT uval;
+    UINT uval, i;
 
     ok(pKEW != NULL, "Widget creation failed\n");
 
@@ -1283,6 +1283,23 @@ static void test_typelibmarshal(void)
     ok(!lstrcmpW(bstr, szCat), "IWidget_get_Name should have returned string \"Cat\" instead of %s\n", wine_dbgstr_w(bstr));
     SysFreeString(bstr);
 
+    /* call Map (direct), buffers are presized after earlier calls of the
+     * same method so check that both bigger and smaller ones still work */
+    for (uval = 0; uval < 3; uval++)
+    {
+        static const UINT lens[] = { 4, 1000, 10 };
+        BSTR value = (void *)0xdeadbeef;
+
+        bstr = SysAllocStringLen(NULL, lens[uval]);
+        for (i = 0; i < lens[uval]; i++) bstr[i] = 'a' + (i + uval) % 26;
+        hr = IWidget_Map(pWidget, bstr, &value);
+        ok_ole_success(hr, IWidget_Map);
+        ok(SysStringLen(value) == lens[uval], "got length %u\n", SysStringLen(value));
+        ok(!lstrcmpW(value, bstr), "got %s\n", wine_dbgstr_w(value));
+        SysFreeString(value);
+        SysFreeString(bstr);
+    }
+
     /* call DoSomething */
     VariantInit(&vararg[0]);
     VariantInit(&vararg[1]);
@@ -3456,6 +3456,79 @@ static void test_TypeInfo2_GetContainingTypeLib(void)
     ICreateTypeLib2_Release(ctl2);
 }
 
+static void test_GetTypeInfoOfGuid(void)
+{
+    static const GUID bogus_guid = {0xdeadbeef,0x1234,0x5678,{0x9a,0xbc,0xde,0xf0,0x12,0x34,0x56,0x78}};
+    static const WCHAR test[] = {'t','e','s','t','.','t','l','b',0};
+    static OLECHAR testTI[] = {'t','e','s','t','T','y','p','e','I','n','f','o',0};
+    ICreateTypeLib2 *ctl2;
+    ICreateTypeInfo *cti;
+    ITypeInfo *ti, *ti2;
+    ITypeLib *tl;
+    TYPEATTR *attr;
+    UINT i, count;
+    HRESULT hr;
+
+    hr = LoadTypeLib(wszStdOle2, &tl);
+    ok_ole_success(hr, LoadTypeLib);
+
+    count = ITypeLib_GetTypeInfoCount(tl);
+    for (i = 0; i < count; i++)
+    {
+        hr = ITypeLib_GetTypeInfo(tl, i, &ti);
+        ok_ole_success(hr, ITypeLib_GetTypeInfo);
+
+        hr = ITypeInfo_GetTypeAttr(ti, &attr);
+        ok_ole_success(hr, ITypeInfo_GetTypeAttr);
+
+        hr = ITypeLib_GetTypeInfoOfGuid(tl, &attr->guid, &ti2);
+        ok_ole_success(hr, ITypeLib_GetTypeInfoOfGuid);
+        ok(ti2 == ti, "%u: got %p, expected %p\n", i, ti2, ti);
+        ITypeInfo_Release(ti2);
+
+        ITypeInfo_ReleaseTypeAttr(ti, attr);
+        ITypeInfo_Release(ti);
+    }
+
+    ti = (void *)0xdeadbeef;
+    hr = ITypeLib_GetTypeInfoOfGuid(tl, &bogus_guid, &ti);
+    ok(hr == TYPE_E_ELEMENTNOTFOUND, "got 0x%08x\n", hr);
+
+    ITypeLib_Release(tl);
+
+    /* type infos added or changed after a lookup are found too */
+    hr = CreateTypeLib2(SYS_WIN32, test, &ctl2);
+    ok_ole_success(hr, CreateTypeLib2);
+
+    hr = ICreateTypeLib2_QueryInterface(ctl2, &IID_ITypeLib, (void**)&tl);
+    ok_ole_success(hr, ICreateTypeLib2_QueryInterface);
+
+    hr = ITypeLib_GetTypeInfoOfGuid(tl, &bogus_guid, &ti);
+    ok(hr == TYPE_E_ELEMENTNOTFOUND, "got 0x%08x\n", hr);
+
+    hr = ICreateTypeLib2_CreateTypeInfo(ctl2, testTI, TKIND_INTERFACE, &cti);
+    ok_ole_success(hr, ICreateTypeLib2_CreateTypeInfo);
+
+    hr = ITypeLib_GetTypeInfoOfGuid(tl, &bogus_guid, &ti);
+    ok(hr == TYPE_E_ELEMENTNOTFOUND, "got 0x%08x\n", hr);
+
+    hr = ICreateTypeInfo_SetGuid(cti, &bogus_guid);
+    ok_ole_success(hr, ICreateTypeInfo_SetGuid);
+
+    hr = ITypeLib_GetTypeInfoOfGuid(tl, &bogus_guid, &ti);
+    ok_ole_success(hr, ITypeLib_GetTypeInfoOfGuid);
+
+    hr = ICreateTypeInfo_QueryInterface(cti, &IID_ITypeInfo, (void**)&ti2);
+    ok_ole_success(hr, ICreateTypeInfo_QueryInterface);
+    ok(ti == ti2, "got %p, expected %p\n", ti, ti2);
+
+    ITypeInfo_Release(ti2);
+    ITypeInfo_Release(ti);
+    ICreateTypeInfo_Release(cti);
+    ITypeLib_Release(tl);
+    ICreateTypeLib2_Release(ctl2);
+}
+
 START_TEST(typelib)
 {
     const char *filename;
@@ -3488,4 +3561,5 @@ START_TEST(typelib)
     test_create_typelibs();
     test_LoadTypeLib();
     test_TypeInfo2_GetContainingTypeLib();
+    test_GetTypeInfoOfGuid();
 }
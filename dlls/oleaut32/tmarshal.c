@@ -101,7 +101,7 @@ xbuf_add(marshal_state *buf, const BYTE *stuff, DWORD size)
 
     if(buf->size - buf->curoff < size)
     {
-        hr = xbuf_resize(buf, buf->size + size + 100);
+        hr = xbuf_resize(buf, max(buf->size * 2, buf->curoff + size + 100));
         if(FAILED(hr)) return hr;
     }
     memcpy(buf->base+buf->curoff,stuff,size);
@@ -428,6 +428,16 @@ typedef struct _TMAsmProxy {
 } TMAsmProxy;
 #endif
 
+/* marshalling information of a method, looked up the first time it is used */
+typedef struct _TMMethod {
+    ITypeInfo          *tinfo;      /* type info actually declaring the method */
+    const FUNCDESC     *fdesc;
+    int                *argsizes;   /* stack size of each parameter in DWORDs */
+    int                 nrofargs;   /* stack size of all parameters in DWORDs */
+    BOOL                dispatch;   /* method is part of IDispatch itself */
+    DWORD               bufsize;    /* largest buffer marshalled so far, to presize the next one */
+} TMMethod;
+
 typedef struct _TMProxyImpl {
     LPVOID                             *lpvtbl;
     IRpcProxyBuffer                     IRpcProxyBuffer_iface;
@@ -441,8 +451,25 @@ typedef struct _TMProxyImpl {
     IUnknown				*outerunknown;
     IDispatch				*dispatch;
     IRpcProxyBuffer			*dispatch_proxy;
+    TMMethod				*methods;
+    unsigned int			nrofmethods;
 } TMProxyImpl;
 
+static void free_methods(TMMethod *methods, unsigned int count)
+{
+    unsigned int i;
+
+    if (!methods) return;
+
+    for (i = 0; i < count; i++)
+    {
+        if (!methods[i].tinfo) continue;
+        HeapFree(GetProcessHeap(), 0, methods[i].argsizes);
+        ITypeInfo_Release(methods[i].tinfo);
+    }
+    HeapFree(GetProcessHeap(), 0, methods);
+}
+
 static inline TMProxyImpl *impl_from_IRpcProxyBuffer( IRpcProxyBuffer *iface )
 {
     return CONTAINING_RECORD(iface, TMProxyImpl, IRpcProxyBuffer_iface);
@@ -488,6 +515,7 @@ TMProxyImpl_Release(LPRPCPROXYBUFFER iface)
         if (This->chanbuf) IRpcChannelBuffer_Release(This->chanbuf);
         VirtualFree(This->asmstubs, 0, MEM_RELEASE);
         HeapFree(GetProcessHeap(), 0, This->lpvtbl);
+        free_methods(This->methods, This->nrofmethods);
         ITypeInfo_Release(This->tinfo);
         CoTaskMemFree(This);
     }
@@ -1330,6 +1358,51 @@ static inline BOOL is_out_elem(const ELEMDESC *elem)
     return (elem->u.paramdesc.wParamFlags & PARAMFLAG_FOUT || !elem->u.paramdesc.wParamFlags);
 }
 
+/* Returns the cached marshalling information of a method, looking it up in
+ * the type info on first use. Must be called with the owner's lock held. */
+static HRESULT get_method(ITypeInfo *tinfo, TMMethod *methods, unsigned int count,
+                          unsigned int iMethod, TMMethod **ret)
+{
+    TMMethod *method;
+    ITypeInfo *tactual;
+    const FUNCDESC *fdesc;
+    BSTR iname;
+    HRESULT hr;
+    int i;
+
+    if (iMethod >= count) return E_INVALIDARG;
+
+    method = &methods[iMethod];
+    if (!method->tinfo)
+    {
+        hr = get_funcdesc(tinfo, iMethod, &tactual, &fdesc, &iname, NULL, NULL);
+        if (hr) return hr;
+
+        method->argsizes = HeapAlloc(GetProcessHeap(), 0, max(fdesc->cParams, 1) * sizeof(int));
+        if (!method->argsizes)
+        {
+            SysFreeString(iname);
+            ITypeInfo_Release(tactual);
+            return E_OUTOFMEMORY;
+        }
+
+        method->nrofargs = 0;
+        for (i = 0; i < fdesc->cParams; i++)
+        {
+            method->argsizes[i] = _argsize(&fdesc->lprgelemdescParam[i].tdesc, tactual);
+            method->nrofargs += method->argsizes[i];
+        }
+        method->dispatch = iname && !lstrcmpW(iname, IDispatchW);
+        method->bufsize = 0;
+        method->fdesc = fdesc;
+        method->tinfo = tactual;
+        SysFreeString(iname);
+    }
+
+    *ret = method;
+    return S_OK;
+}
+
 static DWORD WINAPI xCall(int method, void **args)
 {
     TMProxyImpl *tpinfo = args[0];
@@ -1346,10 +1419,11 @@ static DWORD WINAPI xCall(int method, void **args)
     DWORD		remoteresult = 0;
     ITypeInfo 		*tinfo;
     IRpcChannelBuffer *chanbuf;
+    TMMethod		*minfo;
 
     EnterCriticalSection(&tpinfo->crit);
 
-    hres = get_funcdesc(tpinfo->tinfo,method,&tinfo,&fdesc,&iname,&fname,NULL);
+    hres = get_method(tpinfo->tinfo,tpinfo->methods,tpinfo->nrofmethods,method,&minfo);
     if (hres) {
         ERR("Did not find typeinfo/funcdesc entry for method %d!\n",method);
         LeaveCriticalSection(&tpinfo->crit);
@@ -1359,7 +1433,6 @@ static DWORD WINAPI xCall(int method, void **args)
     if (!tpinfo->chanbuf)
     {
         WARN("Tried to use disconnected proxy\n");
-        ITypeInfo_Release(tinfo);
         LeaveCriticalSection(&tpinfo->crit);
         return RPC_E_DISCONNECTED;
     }
@@ -1368,8 +1441,15 @@ static DWORD WINAPI xCall(int method, void **args)
 
     LeaveCriticalSection(&tpinfo->crit);
 
+    tinfo = minfo->tinfo;
+    fdesc = minfo->fdesc;
+
+    memset(names,0,sizeof(names));
+    nrofnames = 0;
     if (TRACE_ON(olerelay)) {
-       TRACE_(olerelay)("->");
+	ITypeInfo_GetDocumentation(tinfo,-1,&iname,NULL,NULL,NULL);
+	ITypeInfo_GetDocumentation(tinfo,fdesc->memid,&fname,NULL,NULL,NULL);
+	TRACE_(olerelay)("->");
 	if (iname)
 	    TRACE_(olerelay)("%s:",relaystr(iname));
 	if (fname)
@@ -1377,21 +1457,18 @@ static DWORD WINAPI xCall(int method, void **args)
 	else
 	    TRACE_(olerelay)("%d",method);
 	TRACE_(olerelay)("(");
-    }
+	SysFreeString(iname);
+	SysFreeString(fname);
 
-    SysFreeString(iname);
-    SysFreeString(fname);
+	if (ITypeInfo_GetNames(tinfo,fdesc->memid,names,sizeof(names)/sizeof(names[0]),&nrofnames))
+	    nrofnames = 0;
+    }
 
+    /* normal typelib driven serializing, into a buffer sized after the
+     * previous calls of this method */
     memset(&buf,0,sizeof(buf));
-
-    /* normal typelib driven serializing */
-
-    /* Need them for hack below */
-    memset(names,0,sizeof(names));
-    if (ITypeInfo_GetNames(tinfo,fdesc->memid,names,sizeof(names)/sizeof(names[0]),&nrofnames))
-	nrofnames = 0;
-    if (nrofnames > sizeof(names)/sizeof(names[0]))
-	ERR("Need more names!\n");
+    if (minfo->bufsize)
+	xbuf_resize(&buf, minfo->bufsize);
 
     xargs = (DWORD *)(args + 1);
     for (i=0;i<fdesc->cParams;i++) {
@@ -1406,7 +1483,7 @@ static DWORD WINAPI xCall(int method, void **args)
         {
             if (elem->tdesc.vt != VT_PTR)
             {
-                xargs+=_argsize(&elem->tdesc, tinfo);
+                xargs+=minfo->argsizes[i];
                 TRACE_(olerelay)("[out]");
                 continue;
             }
@@ -1430,9 +1507,11 @@ static DWORD WINAPI xCall(int method, void **args)
 	    ERR("Failed to serialize param, hres %x\n",hres);
 	    break;
 	}
-	xargs+=_argsize(&elem->tdesc, tinfo);
+	xargs+=minfo->argsizes[i];
     }
     TRACE_(olerelay)(")");
+    if (buf.curoff > minfo->bufsize)
+        minfo->bufsize = buf.curoff;
 
     memset(&msg,0,sizeof(msg));
     msg.cbBuffer = buf.curoff;
@@ -1470,7 +1549,7 @@ static DWORD WINAPI xCall(int method, void **args)
 
 	/* No need to marshal other data than FOUT and any VT_PTR */
 	if (!is_out_elem(elem) && (elem->tdesc.vt != VT_PTR)) {
-	    xargs += _argsize(&elem->tdesc, tinfo);
+	    xargs += minfo->argsizes[i];
 	    TRACE_(olerelay)("[in]");
 	    continue;
 	}
@@ -1488,7 +1567,7 @@ static DWORD WINAPI xCall(int method, void **args)
 	    status = hres;
 	    break;
 	}
-	xargs += _argsize(&elem->tdesc, tinfo);
+	xargs += minfo->argsizes[i];
     }
 
     hres = xbuf_get(&buf, (LPBYTE)&remoteresult, sizeof(DWORD));
@@ -1504,7 +1583,6 @@ exit:
         SysFreeString(names[i]);
     HeapFree(GetProcessHeap(),0,buf.base);
     IRpcChannelBuffer_Release(chanbuf);
-    ITypeInfo_Release(tinfo);
     TRACE("-- 0x%08x\n", hres);
     return hres;
 }
@@ -1717,26 +1795,19 @@ static inline HRESULT get_facbuf_for_iid(REFIID riid, IPSFactoryBuffer **facbuf)
 
 static HRESULT init_proxy_entry_point(TMProxyImpl *proxy, unsigned int num)
 {
-    int j;
-    /* nrofargs including This */
-    int nrofargs = 1;
-    ITypeInfo *tinfo2;
     TMAsmProxy	*xasm = proxy->asmstubs + num;
     HRESULT hres;
-    const FUNCDESC *fdesc;
+    TMMethod *minfo;
 
-    hres = get_funcdesc(proxy->tinfo, num, &tinfo2, &fdesc, NULL, NULL, NULL);
+    /* look the method up now so that calls don't have to walk the type info */
+    hres = get_method(proxy->tinfo, proxy->methods, proxy->nrofmethods, num, &minfo);
     if (hres) {
         ERR("GetFuncDesc %x should not fail here.\n",hres);
         return hres;
     }
-    ITypeInfo_Release(tinfo2);
-    /* some args take more than 4 byte on the stack */
-    for (j=0;j<fdesc->cParams;j++)
-        nrofargs += _argsize(&fdesc->lprgelemdescParam[j].tdesc, proxy->tinfo);
 
 #ifdef __i386__
-    if (fdesc->callconv != CC_STDCALL) {
+    if (minfo->fdesc->callconv != CC_STDCALL) {
         ERR("calling convention is not stdcall????\n");
         return E_FAIL;
     }
@@ -1753,9 +1824,10 @@ static HRESULT init_proxy_entry_point(TMProxyImpl *proxy, unsigned int num)
     xasm->lcall         = 0xe8;
     xasm->xcall         = (char *)xCall - (char *)&xasm->lret;
     xasm->lret          = 0xc2;
-    xasm->bytestopop    = nrofargs * 4;
+    /* some args take more than 4 byte on the stack, plus This */
+    xasm->bytestopop    = (1 + minfo->nrofargs) * 4;
     xasm->nop           = 0x9090;
-    proxy->lpvtbl[fdesc->oVft / sizeof(void *)] = xasm;
+    proxy->lpvtbl[minfo->fdesc->oVft / sizeof(void *)] = xasm;
 #else
     FIXME("not implemented on non i386\n");
     return E_FAIL;
@@ -1797,9 +1869,16 @@ PSFacBuf_CreateProxy(
     proxy->dispatch = NULL;
     proxy->dispatch_proxy = NULL;
     proxy->outerunknown = pUnkOuter;
+    proxy->nrofmethods = nroffuncs;
+    proxy->methods = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, nroffuncs * sizeof(TMMethod));
+    if (!proxy->methods) {
+        CoTaskMemFree(proxy);
+        return E_OUTOFMEMORY;
+    }
     proxy->asmstubs = VirtualAlloc(NULL, sizeof(TMAsmProxy) * nroffuncs, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
     if (!proxy->asmstubs) {
         ERR("Could not commit pages for proxy thunks\n");
+        HeapFree(GetProcessHeap(), 0, proxy->methods);
         CoTaskMemFree(proxy);
         return E_OUTOFMEMORY;
     }
@@ -1896,6 +1975,9 @@ typedef struct _TMStubImpl {
     IID				iid;
     IRpcStubBuffer		*dispatch_stub;
     BOOL			dispatch_derivative;
+    CRITICAL_SECTION		crit;
+    TMMethod			*methods;
+    unsigned int		nrofmethods;
 } TMStubImpl;
 
 static inline TMStubImpl *impl_from_IRpcStubBuffer(IRpcStubBuffer *iface)
@@ -1937,6 +2019,9 @@ TMStubImpl_Release(LPRPCSTUBBUFFER iface)
     if (!refCount)
     {
         IRpcStubBuffer_Disconnect(iface);
+        free_methods(This->methods, This->nrofmethods);
+        This->crit.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&This->crit);
         ITypeInfo_Release(This->tinfo);
         if (This->dispatch_stub)
             IRpcStubBuffer_Release(This->dispatch_stub);
@@ -1991,8 +2076,8 @@ TMStubImpl_Invoke(
     marshal_state	buf;
     UINT	nrofnames = 0;
     BSTR	names[10];
-    BSTR	iname = NULL;
     ITypeInfo 	*tinfo = NULL;
+    TMMethod	*minfo;
 
     TRACE("...\n");
 
@@ -2019,39 +2104,33 @@ TMStubImpl_Invoke(
         return IRpcStubBuffer_Invoke(This->dispatch_stub, xmsg, rpcchanbuf);
     }
 
-    memset(&buf,0,sizeof(buf));
-    buf.size	= xmsg->cbBuffer;
-    buf.base	= HeapAlloc(GetProcessHeap(), 0, xmsg->cbBuffer);
-    memcpy(buf.base, xmsg->Buffer, xmsg->cbBuffer);
-    buf.curoff	= 0;
-
-    hres = get_funcdesc(This->tinfo,xmsg->iMethod,&tinfo,&fdesc,&iname,NULL,NULL);
+    EnterCriticalSection(&This->crit);
+    hres = get_method(This->tinfo,This->methods,This->nrofmethods,xmsg->iMethod,&minfo);
+    LeaveCriticalSection(&This->crit);
     if (hres) {
 	ERR("GetFuncDesc on method %d failed with %x\n",xmsg->iMethod,hres);
 	return hres;
     }
 
-    if (iname && !lstrcmpW(iname, IDispatchW))
+    if (minfo->dispatch)
     {
         ERR("IDispatch cannot be marshaled by the typelib marshaler\n");
-        hres = E_UNEXPECTED;
-        SysFreeString (iname);
-        goto exit;
+        return E_UNEXPECTED;
     }
 
-    SysFreeString (iname);
+    tinfo = minfo->tinfo;
+    fdesc = minfo->fdesc;
+
+    memset(&buf,0,sizeof(buf));
+    buf.size	= xmsg->cbBuffer;
+    buf.base	= HeapAlloc(GetProcessHeap(), 0, xmsg->cbBuffer);
+    memcpy(buf.base, xmsg->Buffer, xmsg->cbBuffer);
+    buf.curoff	= 0;
 
-    /* Need them for hack below */
     memset(names,0,sizeof(names));
-    ITypeInfo_GetNames(tinfo,fdesc->memid,names,sizeof(names)/sizeof(names[0]),&nrofnames);
-    if (nrofnames > sizeof(names)/sizeof(names[0])) {
-	ERR("Need more names!\n");
-    }
 
     /*dump_FUNCDESC(fdesc);*/
-    nrofargs = 0;
-    for (i=0;i<fdesc->cParams;i++)
-	nrofargs += _argsize(&fdesc->lprgelemdescParam[i].tdesc, tinfo);
+    nrofargs = minfo->nrofargs;
     args = HeapAlloc(GetProcessHeap(),HEAP_ZERO_MEMORY,(nrofargs+1)*sizeof(DWORD));
     if (!args)
     {
@@ -2073,8 +2152,10 @@ TMStubImpl_Invoke(
 	   xargs,
 	   &buf
 	);
-	xargs += _argsize(&elem->tdesc, tinfo);
+	xargs += minfo->argsizes[i];
 	if (hres) {
+	    if (!nrofnames)
+		ITypeInfo_GetNames(tinfo,fdesc->memid,names,sizeof(names)/sizeof(names[0]),&nrofnames);
 	    ERR("Failed to deserialize param %s, hres %x\n",relaystr(names[i+1]),hres);
 	    break;
 	}
@@ -2105,7 +2186,9 @@ TMStubImpl_Invoke(
     if (hres != S_OK)
         goto exit;
 
+    /* presize the reply after the previous calls of this method */
     buf.curoff = 0;
+    xbuf_resize(&buf, minfo->bufsize);
 
     xargs = args+1;
     for (i=0;i<fdesc->cParams;i++) {
@@ -2119,7 +2202,7 @@ TMStubImpl_Invoke(
 	   xargs,
 	   &buf
 	);
-	xargs += _argsize(&elem->tdesc, tinfo);
+	xargs += minfo->argsizes[i];
 	if (hres) {
 	    ERR("Failed to stuballoc param, hres %x\n",hres);
 	    break;
@@ -2131,6 +2214,9 @@ TMStubImpl_Invoke(
     if (hres != S_OK)
         goto exit;
 
+    if (buf.curoff > minfo->bufsize)
+        minfo->bufsize = buf.curoff;
+
     xmsg->cbBuffer	= buf.curoff;
     hres = IRpcChannelBuffer_GetBuffer(rpcchanbuf, xmsg, &This->iid);
     if (hres != S_OK)
@@ -2143,7 +2229,6 @@ exit:
     for (i = 0; i < nrofnames; i++)
         SysFreeString(names[i]);
 
-    ITypeInfo_Release(tinfo);
     HeapFree(GetProcessHeap(), 0, args);
 
     HeapFree(GetProcessHeap(), 0, buf.base);
@@ -2202,6 +2287,7 @@ PSFacBuf_CreateStub(
     ITypeInfo	*tinfo;
     TMStubImpl	*stub;
     TYPEATTR *typeattr;
+    unsigned int nroffuncs;
 
     TRACE("(%s,%p,%p)\n",debugstr_guid(riid),pUnkServer,ppStub);
 
@@ -2211,9 +2297,25 @@ PSFacBuf_CreateStub(
 	return hres;
     }
 
+    hres = num_of_funcs(tinfo, &nroffuncs, NULL);
+    if (FAILED(hres)) {
+        ERR("Cannot get number of functions for typeinfo %s\n",debugstr_guid(riid));
+        ITypeInfo_Release(tinfo);
+        return hres;
+    }
+
     stub = CoTaskMemAlloc(sizeof(TMStubImpl));
     if (!stub)
 	return E_OUTOFMEMORY;
+    stub->methods = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, nroffuncs * sizeof(TMMethod));
+    if (!stub->methods)
+    {
+        CoTaskMemFree(stub);
+        return E_OUTOFMEMORY;
+    }
+    stub->nrofmethods = nroffuncs;
+    InitializeCriticalSection(&stub->crit);
+    stub->crit.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": TMStubImpl.crit");
     stub->IRpcStubBuffer_iface.lpVtbl = &tmstubvtbl;
     stub->ref		= 1;
     stub->tinfo		= tinfo;
@@ -1034,6 +1034,16 @@ typedef struct tagITypeLibImpl
     struct list ref_list;       /* list of ref types in this typelib */
     HREFTYPE dispatch_href;     /* reference to IDispatch, -1 if unused */
 
+    /* MSFT typelibs keep their image mapped, function and variable
+     * descriptions are only read when a type info is first used */
+    IUnknown *pFile;
+    void *mapping;
+    DWORD mapping_length;
+    MSFT_SegDir *pTblDir;
+
+    /* hash of the type infos by guid, built on the first GetTypeInfoOfGuid */
+    struct tagITypeInfoImpl **guid_hash;
+    UINT guid_hash_size;
 
     /* typelibs are cached, keyed by path and index, so store the linked list info within them */
     struct list entry;
@@ -1066,7 +1076,7 @@ static inline ITypeLibImpl *impl_from_ICreateTypeLib2( ICreateTypeLib2 *iface )
 }
 
 /* ITypeLib methods */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength);
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *pFile);
 static ITypeLib2* ITypeLib2_Constructor_SLTG(LPVOID pLib, DWORD dwTLBLength);
 
 /*======================= ITypeInfo implementation =======================*/
@@ -1175,6 +1185,10 @@ typedef struct tagITypeInfoImpl
     DWORD dwHelpContext;
     DWORD dwHelpStringContext;
 
+    /* functions and variables not read from the MSFT image yet */
+    BOOL members_pending;
+    int members_offset;
+
     /* functions  */
     TLBFuncDesc *funcdescs;
 
@@ -1546,9 +1560,14 @@ static void dump_TypeInfo(const ITypeInfoImpl * pty)
     TRACE("wTypeFlags: 0x%04x\n", pty->wTypeFlags);
     TRACE("parent tlb:%p index in TLB:%u\n",pty->pTypeLib, pty->index);
     if (pty->typekind == TKIND_MODULE) TRACE("dllname:%s\n", debugstr_w(TLB_get_bstr(pty->DllName)));
-    if (TRACE_ON(ole))
-        dump_TLBFuncDesc(pty->funcdescs, pty->cFuncs);
-    dump_TLBVarDesc(pty->vardescs, pty->cVars);
+    if (pty->members_pending)
+        TRACE("members not loaded yet\n");
+    else
+    {
+        if (TRACE_ON(ole))
+            dump_TLBFuncDesc(pty->funcdescs, pty->cFuncs);
+        dump_TLBVarDesc(pty->vardescs, pty->cVars);
+    }
     dump_TLBImplType(pty->impltypes, pty->cImplTypes);
 }
 
@@ -2563,16 +2582,12 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
 /* note: InfoType's Help file and HelpStringDll come from the containing
  * library. Further HelpString and Docstring appear to be the same thing :(
  */
-    /* functions */
-    if(ptiRet->cFuncs >0 )
-        MSFT_DoFuncs(pcx, ptiRet, ptiRet->cFuncs,
-		    ptiRet->cVars,
-		    tiBase.memoffset, &ptiRet->funcdescs);
-    /* variables */
-    if(ptiRet->cVars >0 )
-        MSFT_DoVars(pcx, ptiRet, ptiRet->cFuncs,
-		   ptiRet->cVars,
-		   tiBase.memoffset, &ptiRet->vardescs);
+    /* functions and variables are read on first use by MSFT_LoadMembers */
+    if(ptiRet->cFuncs > 0 || ptiRet->cVars > 0)
+    {
+        ptiRet->members_offset = tiBase.memoffset;
+        ptiRet->members_pending = TRUE;
+    }
     if(ptiRet->cImplTypes >0 ) {
         switch(ptiRet->typekind)
         {
@@ -2611,6 +2626,57 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
     return ptiRet;
 }
 
+static CRITICAL_SECTION lazy_section;
+static CRITICAL_SECTION_DEBUG lazy_section_debug =
+{
+    0, 0, &lazy_section,
+    { &lazy_section_debug.ProcessLocksList, &lazy_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": typelib lazy loading") }
+};
+static CRITICAL_SECTION lazy_section = { &lazy_section_debug, -1, 0, 0, 0, 0 };
+
+/* read the function and variable descriptions of a type info from the
+ * image its typelib keeps mapped */
+static void MSFT_LoadMembers(ITypeInfoImpl *pTI)
+{
+    ITypeLibImpl *pLibInfo = pTI->pTypeLib;
+    TLBContext cx;
+
+    if(!pTI->members_pending)
+        return;
+
+    EnterCriticalSection(&lazy_section);
+
+    if(pTI->members_pending)
+    {
+        TRACE_(typelib)("loading members of %s\n", debugstr_w(TLB_get_bstr(pTI->Name)));
+
+        cx.pos = 0;
+        cx.oStart = 0;
+        cx.mapping = pLibInfo->mapping;
+        cx.pLibInfo = pLibInfo;
+        cx.length = pLibInfo->mapping_length;
+        cx.pTblDir = pLibInfo->pTblDir;
+
+        if(pTI->cFuncs > 0)
+            MSFT_DoFuncs(&cx, pTI, pTI->cFuncs, pTI->cVars,
+                         pTI->members_offset, &pTI->funcdescs);
+        if(pTI->cVars > 0)
+            MSFT_DoVars(&cx, pTI, pTI->cFuncs, pTI->cVars,
+                        pTI->members_offset, &pTI->vardescs);
+
+        InterlockedExchange((LONG *)&pTI->members_pending, FALSE);
+    }
+
+    LeaveCriticalSection(&lazy_section);
+}
+
+static inline void TLB_free_guid_hash(ITypeLibImpl *This)
+{
+    heap_free(This->guid_hash);
+    This->guid_hash = NULL;
+}
+
 static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
 {
     char *string;
@@ -3227,7 +3293,7 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
         {
             DWORD dwSignature = FromLEDWord(*((DWORD*) pBase));
             if (dwSignature == MSFT_SIGNATURE)
-                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength);
+                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength, pFile);
             else if (dwSignature == SLTG_SIGNATURE)
                 *ppTypeLib = ITypeLib2_Constructor_SLTG(pBase, dwTLBLength);
             else
@@ -3298,7 +3364,7 @@ static ITypeLibImpl* TypeLibImpl_Constructor(void)
  *
  * loading an MSFT typelib from an in-memory image
  */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *pFile)
 {
     TLBContext cx;
     LONG lPSegDir;
@@ -3346,6 +3412,15 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
 	return NULL;
     }
 
+    /* keep the image around for MSFT_LoadMembers */
+    pTypeLibImpl->pTblDir = heap_alloc(sizeof(tlbSegDir));
+    *pTypeLibImpl->pTblDir = tlbSegDir;
+    cx.pTblDir = pTypeLibImpl->pTblDir;
+    pTypeLibImpl->mapping = pLib;
+    pTypeLibImpl->mapping_length = dwTLBLength;
+    pTypeLibImpl->pFile = pFile;
+    IUnknown_AddRef(pFile);
+
     MSFT_ReadAllNames(&cx);
     MSFT_ReadAllStrings(&cx);
     MSFT_ReadAllGuids(&cx);
@@ -4628,6 +4703,10 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
       for (i = 0; i < This->TypeInfoCount; ++i)
           ITypeInfoImpl_Destroy(This->typeinfos[i]);
       heap_free(This->typeinfos);
+      TLB_free_guid_hash(This);
+      heap_free(This->pTblDir);
+      if (This->pFile)
+          IUnknown_Release(This->pFile);
       heap_free(This);
       return 0;
     }
@@ -4696,6 +4775,45 @@ static HRESULT WINAPI ITypeLib2_fnGetTypeInfoType(
     return S_OK;
 }
 
+static inline UINT TLB_guid_hash(const GUID *guid, UINT size)
+{
+    const DWORD *data = (const DWORD *)guid;
+    return (data[0] ^ data[1] ^ data[2] ^ data[3]) & (size - 1);
+}
+
+/* open addressed table of the type infos keyed by guid, the first type info
+ * using a guid is the one that is found */
+static void TLB_build_guid_hash(ITypeLibImpl *This)
+{
+    ITypeInfoImpl **hash;
+    UINT size = 16, i, j;
+
+    EnterCriticalSection(&lazy_section);
+
+    if(!This->guid_hash)
+    {
+        while(size < This->TypeInfoCount * 2)
+            size <<= 1;
+        hash = heap_alloc_zero(size * sizeof(*hash));
+
+        for(i = 0; i < This->TypeInfoCount; ++i)
+        {
+            const GUID *guid = TLB_get_guid_null(This->typeinfos[i]->guid);
+
+            for(j = TLB_guid_hash(guid, size); hash[j]; j = (j + 1) & (size - 1))
+                if(IsEqualIID(TLB_get_guid_null(hash[j]->guid), guid))
+                    break;
+            if(!hash[j])
+                hash[j] = This->typeinfos[i];
+        }
+
+        This->guid_hash_size = size;
+        This->guid_hash = hash;
+    }
+
+    LeaveCriticalSection(&lazy_section);
+}
+
 /* ITypeLib::GetTypeInfoOfGuid
  *
  * Retrieves the type description that corresponds to the specified GUID.
@@ -4707,13 +4825,18 @@ static HRESULT WINAPI ITypeLib2_fnGetTypeInfoOfGuid(
     ITypeInfo **ppTInfo)
 {
     ITypeLibImpl *This = impl_from_ITypeLib2(iface);
-    int i;
+    ITypeInfoImpl *info;
+    UINT i;
 
     TRACE("%p %s %p\n", This, debugstr_guid(guid), ppTInfo);
 
-    for(i = 0; i < This->TypeInfoCount; ++i){
-        if(IsEqualIID(TLB_get_guid_null(This->typeinfos[i]->guid), guid)){
-            *ppTInfo = (ITypeInfo *)&This->typeinfos[i]->ITypeInfo2_iface;
+    if(!This->guid_hash)
+        TLB_build_guid_hash(This);
+
+    for(i = TLB_guid_hash(guid, This->guid_hash_size); (info = This->guid_hash[i]);
+            i = (i + 1) & (This->guid_hash_size - 1)){
+        if(IsEqualIID(TLB_get_guid_null(info->guid), guid)){
+            *ppTInfo = (ITypeInfo *)&info->ITypeInfo2_iface;
             ITypeInfo_AddRef(*ppTInfo);
             return S_OK;
         }
@@ -4883,6 +5006,7 @@ static HRESULT WINAPI ITypeLib2_fnIsName(
     for(tic = 0; tic < This->TypeInfoCount; ++tic){
         ITypeInfoImpl *pTInfo = This->typeinfos[tic];
         if(!TLB_str_memcmp(szNameBuf, pTInfo->Name, nNameBufLen)) goto ITypeLib2_fnIsName_exit;
+        MSFT_LoadMembers(pTInfo);
         for(fdc = 0; fdc < pTInfo->cFuncs; ++fdc) {
             TLBFuncDesc *pFInfo = &pTInfo->funcdescs[fdc];
             int pc;
@@ -4938,6 +5062,7 @@ static HRESULT WINAPI ITypeLib2_fnFindName(
         UINT fdc;
 
         if(!TLB_str_memcmp(name, pTInfo->Name, len)) goto ITypeLib2_fnFindName_exit;
+        MSFT_LoadMembers(pTInfo);
         for(fdc = 0; fdc < pTInfo->cFuncs; ++fdc) {
             TLBFuncDesc *func = &pTInfo->funcdescs[fdc];
             int pc;
@@ -5423,6 +5548,10 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TRACE("destroying ITypeInfo(%p)\n",This);
 
+    /* members that were never used have not been read either */
+    if (This->members_pending)
+        This->cFuncs = This->cVars = 0;
+
     for (i = 0; i < This->cFuncs; ++i)
     {
         int j;
@@ -5720,6 +5849,7 @@ HRESULT ITypeInfoImpl_GetInternalFuncDesc( ITypeInfo *iface, UINT index, const F
     if (index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    MSFT_LoadMembers(This);
     *ppFuncDesc = &This->funcdescs[index].funcdesc;
     return S_OK;
 }
@@ -5909,13 +6039,16 @@ static HRESULT WINAPI ITypeInfo_fnGetVarDesc( ITypeInfo2 *iface, UINT index,
         LPVARDESC  *ppVarDesc)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    const TLBVarDesc *pVDesc = &This->vardescs[index];
+    const TLBVarDesc *pVDesc;
 
     TRACE("(%p) index %d\n", This, index);
 
     if(index >= This->cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    MSFT_LoadMembers(This);
+    pVDesc = &This->vardescs[index];
+
     if (This->needs_layout)
         ICreateTypeInfo2_LayOut(&This->ICreateTypeInfo2_iface);
 
@@ -5942,6 +6075,7 @@ static HRESULT WINAPI ITypeInfo_fnGetNames( ITypeInfo2 *iface, MEMBERID memid,
 
     *pcNames = 0;
 
+    MSFT_LoadMembers(This);
     pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
     if(pFDesc)
     {
@@ -6101,6 +6235,7 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
+    MSFT_LoadMembers(This);
     for (fdc = 0; fdc < This->cFuncs; ++fdc) {
         int j;
         const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
@@ -6719,6 +6854,7 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
 
     /* we do this instead of using GetFuncDesc since it will return a fake
      * FUNCDESC for dispinterfaces and we want the real function description */
+    MSFT_LoadMembers(This);
     for (fdc = 0; fdc < This->cFuncs; ++fdc){
         pFuncInfo = &This->funcdescs[fdc];
         if ((memid == pFuncInfo->funcdesc.memid) &&
@@ -7235,6 +7371,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDocumentation( ITypeInfo2 *iface,
             *pBstrHelpFile=SysAllocString(TLB_get_bstr(This->pTypeLib->HelpFile));
         return S_OK;
     }else {/* for a member */
+        MSFT_LoadMembers(This);
         pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
         if(pFDesc){
             if(pBstrName)
@@ -7301,6 +7438,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDllEntry( ITypeInfo2 *iface, MEMBERID memid
     if (This->typekind != TKIND_MODULE)
         return TYPE_E_BADMODULEKIND;
 
+    MSFT_LoadMembers(This);
     pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
     if(pFDesc){
 	    dump_TypeInfo(This);
@@ -7387,6 +7525,8 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
         */
         pTypeInfoImpl = ITypeInfoImpl_Constructor();
 
+        /* the copy shares the members, so they must be loaded before */
+        MSFT_LoadMembers(This);
         *pTypeInfoImpl = *This;
         pTypeInfoImpl->ref = 0;
 
@@ -7729,6 +7869,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncIndexOfMemId( ITypeInfo2 * iface,
     UINT fdc;
     HRESULT result;
 
+    MSFT_LoadMembers(This);
     for (fdc = 0; fdc < This->cFuncs; ++fdc){
         const TLBFuncDesc *pFuncInfo = &This->funcdescs[fdc];
         if(memid == pFuncInfo->funcdesc.memid && (invKind & pFuncInfo->funcdesc.invkind))
@@ -7759,6 +7900,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetVarIndexOfMemId( ITypeInfo2 * iface,
 
     TRACE("%p %d %p\n", iface, memid, pVarIndex);
 
+    MSFT_LoadMembers(This);
     pVarInfo = TLB_get_vardesc_by_memberid(This->vardescs, This->cVars, memid);
     if(!pVarInfo)
         return TYPE_E_ELEMENTNOTFOUND;
@@ -7807,13 +7949,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBFuncDesc *pFDesc = &This->funcdescs[index];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %s %p\n", This, index, debugstr_guid(guid), pVarVal);
 
     if(index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    MSFT_LoadMembers(This);
+    pFDesc = &This->funcdescs[index];
+
     pCData = TLB_get_custdata_by_guid(&pFDesc->custdata_list, guid);
     if(!pCData)
         return TYPE_E_ELEMENTNOTFOUND;
@@ -7837,7 +7982,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetParamCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBFuncDesc *pFDesc = &This->funcdescs[indexFunc];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %u %s %p\n", This, indexFunc, indexParam,
             debugstr_guid(guid), pVarVal);
@@ -7845,6 +7990,9 @@ static HRESULT WINAPI ITypeInfo2_fnGetParamCustData(
     if(indexFunc >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    MSFT_LoadMembers(This);
+    pFDesc = &This->funcdescs[indexFunc];
+
     if(indexParam >= pFDesc->funcdesc.cParams)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -7870,13 +8018,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetVarCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBVarDesc *pVDesc = &This->vardescs[index];
+    TLBVarDesc *pVDesc;
 
     TRACE("%p %s %p\n", This, debugstr_guid(guid), pVarVal);
 
     if(index >= This->cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    MSFT_LoadMembers(This);
+    pVDesc = &This->vardescs[index];
+
     pCData = TLB_get_custdata_by_guid(&pVDesc->custdata_list, guid);
     if(!pCData)
         return TYPE_E_ELEMENTNOTFOUND;
@@ -7952,6 +8103,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetDocumentation2(
                 SysAllocString(TLB_get_bstr(This->pTypeLib->HelpStringDll));/* FIXME */
         return S_OK;
     }else {/* for a member */
+        MSFT_LoadMembers(This);
         pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
         if(pFDesc){
             if(pbstrHelpString)
@@ -8005,13 +8157,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllFuncCustData(
 	CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBFuncDesc *pFDesc = &This->funcdescs[index];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %p\n", This, index, pCustData);
 
     if(index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    MSFT_LoadMembers(This);
+    pFDesc = &This->funcdescs[index];
+
     return TLB_copy_all_custdata(&pFDesc->custdata_list, pCustData);
 }
 
@@ -8024,13 +8179,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllParamCustData( ITypeInfo2 * iface,
     UINT indexFunc, UINT indexParam, CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBFuncDesc *pFDesc = &This->funcdescs[indexFunc];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %u %p\n", This, indexFunc, indexParam, pCustData);
 
     if(indexFunc >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    MSFT_LoadMembers(This);
+    pFDesc = &This->funcdescs[indexFunc];
+
     if(indexParam >= pFDesc->funcdesc.cParams)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -8046,13 +8204,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllVarCustData( ITypeInfo2 * iface,
     UINT index, CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBVarDesc * pVDesc = &This->vardescs[index];
+    TLBVarDesc * pVDesc;
 
     TRACE("%p %u %p\n", This, index, pCustData);
 
     if(index >= This->cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    MSFT_LoadMembers(This);
+    pVDesc = &This->vardescs[index];
+
     return TLB_copy_all_custdata(&pVDesc->custdata_list, pCustData);
 }
 
@@ -8286,6 +8447,7 @@ static HRESULT WINAPI ITypeComp_fnBind(
     pBindPtr->lpfuncdesc = NULL;
     *ppTInfo = NULL;
 
+    MSFT_LoadMembers(This);
     for(fdc = 0; fdc < This->cFuncs; ++fdc){
         pFDesc = &This->funcdescs[fdc];
         if (!strcmpiW(TLB_get_bstr(pFDesc->Name), szName)) {
@@ -8453,6 +8615,8 @@ static HRESULT WINAPI ICreateTypeLib2_fnCreateTypeInfo(ICreateTypeLib2 *iface,
     else
         This->typeinfos = heap_alloc_zero(sizeof(ITypeInfoImpl*));
 
+    TLB_free_guid_hash(This);
+
     info = This->typeinfos[This->TypeInfoCount] = ITypeInfoImpl_Constructor();
 
     info->pTypeLib = This;
@@ -9053,6 +9217,8 @@ static DWORD WMSFT_compile_typeinfo_aux(ITypeInfoImpl *info,
     MEMBERID *memid;
     DWORD *name, *offsets, offs;
 
+    MSFT_LoadMembers(info);
+
     for(i = 0; i < info->cFuncs; ++i){
         TLBFuncDesc *desc = &info->funcdescs[i];
 
@@ -9949,6 +10115,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetGuid(ICreateTypeInfo2 *iface,
     TRACE("%p %s\n", This, debugstr_guid(guid));
 
     This->guid = TLB_append_guid(&This->pTypeLib->guid_list, guid);
+    TLB_free_guid_hash(This->pTypeLib);
 
     return S_OK;
 }
@@ -10155,6 +10322,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddFuncDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %p\n", This, index, funcDesc);
 
+    MSFT_LoadMembers(This);
+
     if (!funcDesc || funcDesc->oVft & 3)
         return E_INVALIDARG;
 
@@ -10397,6 +10566,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddVarDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %p\n", This, index, varDesc);
 
+    MSFT_LoadMembers(This);
+
     if (This->vardescs){
         UINT i;
 
@@ -10440,11 +10611,14 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncAndParamNames(ICreateTypeInfo2 *
         UINT index, LPOLESTR *names, UINT numNames)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBFuncDesc *func_desc = &This->funcdescs[index];
+    TLBFuncDesc *func_desc;
     int i;
 
     TRACE("%p %u %p %u\n", This, index, names, numNames);
 
+    MSFT_LoadMembers(This);
+    func_desc = &This->funcdescs[index];
+
     if (!names)
         return E_INVALIDARG;
 
@@ -10515,10 +10689,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarDocString(ICreateTypeInfo2 *iface
         UINT index, LPOLESTR docString)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBVarDesc *var_desc = &This->vardescs[index];
+    TLBVarDesc *var_desc;
 
     TRACE("%p %u %s\n", This, index, wine_dbgstr_w(docString));
 
+    MSFT_LoadMembers(This);
+    var_desc = &This->vardescs[index];
+
     if(!docString)
         return E_INVALIDARG;
 
@@ -10534,10 +10711,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncHelpContext(ICreateTypeInfo2 *if
         UINT index, DWORD helpContext)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBFuncDesc *func_desc = &This->funcdescs[index];
+    TLBFuncDesc *func_desc;
 
     TRACE("%p %u %d\n", This, index, helpContext);
 
+    MSFT_LoadMembers(This);
+    func_desc = &This->funcdescs[index];
+
     if(index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -10550,10 +10730,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarHelpContext(ICreateTypeInfo2 *ifa
         UINT index, DWORD helpContext)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBVarDesc *var_desc = &This->vardescs[index];
+    TLBVarDesc *var_desc;
 
     TRACE("%p %u %d\n", This, index, helpContext);
 
+    MSFT_LoadMembers(This);
+    var_desc = &This->vardescs[index];
+
     if(index >= This->cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -10596,6 +10779,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnLayOut(ICreateTypeInfo2 *iface)
 
     TRACE("%p\n", This);
 
+    MSFT_LoadMembers(This);
+
     This->needs_layout = FALSE;
 
     hres = ICreateTypeInfo2_QueryInterface(iface, &IID_ITypeInfo, (LPVOID*)&tinfo);
@@ -474,6 +474,338 @@ void client_do_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat, enum s
     }
 }
 
+/* Client marshalling plans
+ *
+ * The sizing and marshalling passes of the client are the hot part of
+ * every stubless call. For base types and flat structures, the work done
+ * by the generic routines only depends on the format string, so we
+ * compile the parameter list once into an array of copy operations and
+ * keep the generic routines for everything else. */
+
+#define PLAN_OP_IN          0x01  /* [in] parameter */
+#define PLAN_OP_CHECK_NULL  0x02  /* simple ref pointer that must not be NULL */
+#define PLAN_OP_DEREF       0x04  /* stack slot holds a pointer to the data */
+#define PLAN_OP_STRUCT      0x08  /* flat structure, sets the buffer mark */
+
+struct client_plan_op
+{
+    unsigned short param;         /* index into the parameter descriptions */
+    unsigned short stack_offset;
+    unsigned short size;          /* wire size of a flat copy, 0 for generic parameters */
+    unsigned char  align;         /* wire alignment of a flat copy */
+    unsigned char  flags;
+};
+
+struct client_plan
+{
+    struct client_plan    *next;        /* in the list of replaced plans */
+    const MIDL_STUB_DESC  *stub_desc;
+    PFORMAT_STRING         proc_format; /* start of the procedure in the format string */
+    const NDR_PARAM_OIF   *params;      /* copy of the parameter descriptions */
+    unsigned short         number_of_params;
+    unsigned short         count;
+    ULONG                  fixed_size;  /* buffer size when all [in] parameters are flat copies */
+    struct client_plan_op  ops[1];
+};
+
+#define CLIENT_PLAN_CACHE_SIZE 256
+#define CLIENT_PLAN_PROBES     4
+
+static struct client_plan *client_plans[CLIENT_PLAN_CACHE_SIZE];
+/* plans replaced in the cache may still be in use by other threads */
+static struct client_plan *replaced_client_plans;
+
+static unsigned int client_plan_hash( PFORMAT_STRING proc_format )
+{
+    ULONG_PTR val = (ULONG_PTR)proc_format;
+    return (val ^ (val >> 8) ^ (val >> 16)) % CLIENT_PLAN_CACHE_SIZE;
+}
+
+void release_client_plans(void)
+{
+    struct client_plan *plan, *next;
+    unsigned int i;
+
+    for (i = 0; i < CLIENT_PLAN_CACHE_SIZE; i++)
+    {
+        HeapFree( GetProcessHeap(), 0, client_plans[i] );
+        client_plans[i] = NULL;
+    }
+    for (plan = replaced_client_plans; plan; plan = next)
+    {
+        next = plan->next;
+        HeapFree( GetProcessHeap(), 0, plan );
+    }
+    replaced_client_plans = NULL;
+}
+
+/* returns the wire size of a base type that can be copied as is, 0 otherwise */
+static unsigned int plan_base_type_size( unsigned char fc )
+{
+    switch (fc)
+    {
+    case RPC_FC_BYTE:
+    case RPC_FC_CHAR:
+    case RPC_FC_SMALL:
+    case RPC_FC_USMALL:
+        return sizeof(UCHAR);
+    case RPC_FC_WCHAR:
+    case RPC_FC_SHORT:
+    case RPC_FC_USHORT:
+        return sizeof(USHORT);
+    case RPC_FC_LONG:
+    case RPC_FC_ULONG:
+    case RPC_FC_ERROR_STATUS_T:
+    case RPC_FC_ENUM32:
+        return sizeof(ULONG);
+    case RPC_FC_DOUBLE:
+    case RPC_FC_HYPER:
+        return sizeof(ULONGLONG);
+    default:
+        /* floats may need conversion from the varargs stack, enum16 needs a
+         * range check and int3264 a size conversion */
+        return 0;
+    }
+}
+
+static struct client_plan *build_client_plan( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING proc_format,
+                                              PFORMAT_STRING pFormat, unsigned short number_of_params )
+{
+    const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)pFormat;
+    struct client_plan *plan;
+    unsigned int i, size, align;
+    ULONG length = 0;
+    BOOL fixed = TRUE;
+
+    plan = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET( struct client_plan, ops[number_of_params] ) +
+                      number_of_params * sizeof(*params) );
+    if (!plan) return NULL;
+
+    plan->next = NULL;
+    plan->stub_desc = pStubMsg->StubDesc;
+    plan->proc_format = proc_format;
+    plan->params = (const NDR_PARAM_OIF *)&plan->ops[number_of_params];
+    memcpy( (NDR_PARAM_OIF *)plan->params, params, number_of_params * sizeof(*params) );
+    plan->number_of_params = number_of_params;
+    plan->count = 0;
+
+    for (i = 0; i < number_of_params; i++)
+    {
+        struct client_plan_op *op = &plan->ops[plan->count];
+
+        if (!params[i].attr.IsIn && !params[i].attr.IsSimpleRef) continue;
+
+        op->param = i;
+        op->stack_offset = params[i].stack_offset;
+        op->flags = 0;
+        op->size = 0;
+        op->align = 1;
+        if (params[i].attr.IsIn) op->flags |= PLAN_OP_IN;
+        if (params[i].attr.IsSimpleRef) op->flags |= PLAN_OP_CHECK_NULL;
+
+        if (params[i].attr.IsBasetype)
+        {
+            if ((size = plan_base_type_size( params[i].u.type_format_char )))
+            {
+                op->size = op->align = size;
+                if (params[i].attr.IsSimpleRef) op->flags |= PLAN_OP_DEREF;
+            }
+        }
+        else
+        {
+            PFORMAT_STRING type = &pStubMsg->StubDesc->pFormatTypes[params[i].u.type_offset];
+
+            if (type[0] == RPC_FC_STRUCT)
+            {
+                op->size = *(const WORD *)&type[2];
+                op->align = type[1] + 1;
+                op->flags |= PLAN_OP_STRUCT;
+                if (!params[i].attr.IsByValue) op->flags |= PLAN_OP_DEREF;
+            }
+        }
+
+        if (op->flags & PLAN_OP_IN)
+        {
+            if (op->size)
+            {
+                align = op->align;
+                length = ((length + align - 1) & ~(align - 1)) + op->size;
+            }
+            else fixed = FALSE;
+        }
+        plan->count++;
+    }
+
+    plan->fixed_size = fixed ? length : 0;
+    TRACE( "format %p: %u ops, fixed size %u\n", proc_format, plan->count, plan->fixed_size );
+    return plan;
+}
+
+static BOOL client_plan_matches( const struct client_plan *plan, PMIDL_STUB_MESSAGE pStubMsg,
+                                 PFORMAT_STRING pFormat, unsigned short number_of_params )
+{
+    const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)pFormat;
+    PFORMAT_STRING type;
+    unsigned int i;
+
+    if (plan->number_of_params != number_of_params ||
+        memcmp( plan->params, params, number_of_params * sizeof(*params) ))
+        return FALSE;
+
+    for (i = 0; i < plan->count; i++)
+    {
+        const struct client_plan_op *op = &plan->ops[i];
+
+        if (!(op->flags & PLAN_OP_STRUCT)) continue;
+        type = &pStubMsg->StubDesc->pFormatTypes[params[op->param].u.type_offset];
+        if (type[0] != RPC_FC_STRUCT || op->align != type[1] + 1 || op->size != *(const WORD *)&type[2])
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* a plan that was replaced in the cache is kept until rpcrt4 is unloaded */
+static void replace_client_plan( struct client_plan *plan )
+{
+    struct client_plan *next;
+
+    do
+    {
+        next = replaced_client_plans;
+        plan->next = next;
+    } while (InterlockedCompareExchangePointer( (void **)&replaced_client_plans, plan, next ) != next);
+}
+
+/* plans are keyed on the procedure format string, ie. the format string plus
+ * the procedure offset, and on the stub descriptor. A module loaded at the
+ * address of an unloaded one can reuse both addresses, so the parameter
+ * descriptions are compared as well before a plan is used. */
+static const struct client_plan *get_client_plan( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING proc_format,
+                                                  PFORMAT_STRING pFormat, unsigned short number_of_params )
+{
+    unsigned int i, hash = client_plan_hash( proc_format );
+    struct client_plan *plan, *old, *stale = NULL;
+    struct client_plan **slot = NULL;
+
+    for (i = 0; i < CLIENT_PLAN_PROBES; i++)
+    {
+        plan = client_plans[(hash + i) % CLIENT_PLAN_CACHE_SIZE];
+        if (!plan) break;
+        if (plan->proc_format == proc_format && plan->stub_desc == pStubMsg->StubDesc)
+        {
+            if (client_plan_matches( plan, pStubMsg, pFormat, number_of_params )) return plan;
+            slot = &client_plans[(hash + i) % CLIENT_PLAN_CACHE_SIZE];
+            stale = plan;
+            break;
+        }
+    }
+
+    if (!(plan = build_client_plan( pStubMsg, proc_format, pFormat, number_of_params ))) return NULL;
+
+    if (stale)
+    {
+        TRACE( "replacing stale plan for format %p\n", proc_format );
+        if (InterlockedCompareExchangePointer( (void **)slot, plan, stale ) == stale)
+        {
+            replace_client_plan( stale );
+            return plan;
+        }
+        HeapFree( GetProcessHeap(), 0, plan );
+        return NULL;
+    }
+
+    for (i = 0; i < CLIENT_PLAN_PROBES; i++)
+    {
+        old = InterlockedCompareExchangePointer( (void **)&client_plans[(hash + i) % CLIENT_PLAN_CACHE_SIZE],
+                                                 plan, NULL );
+        if (!old) return plan;
+        if (old->proc_format == proc_format && old->stub_desc == pStubMsg->StubDesc &&
+            client_plan_matches( old, pStubMsg, pFormat, number_of_params ))
+        {
+            /* another thread got there first */
+            HeapFree( GetProcessHeap(), 0, plan );
+            return old;
+        }
+    }
+    /* the cache is full for this slot, use the generic path rather than
+     * leaking a plan on every call */
+    WARN( "no room to cache plan for format %p\n", proc_format );
+    HeapFree( GetProcessHeap(), 0, plan );
+    return NULL;
+}
+
+static void client_plan_do_args( PMIDL_STUB_MESSAGE pStubMsg, const struct client_plan *plan,
+                                 PFORMAT_STRING pFormat, enum stubless_phase phase,
+                                 void **fpu_args, unsigned short number_of_params, unsigned char *pRetVal )
+{
+    const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)pFormat;
+    unsigned char *end;
+    unsigned int i;
+
+    if (!plan || (phase != STUBLESS_CALCSIZE && phase != STUBLESS_MARSHAL))
+    {
+        client_do_args( pStubMsg, pFormat, phase, fpu_args, number_of_params, pRetVal );
+        return;
+    }
+
+    if (phase == STUBLESS_CALCSIZE)
+    {
+        for (i = 0; i < plan->count; i++)
+        {
+            const struct client_plan_op *op = &plan->ops[i];
+            unsigned char *pArg = pStubMsg->StackTop + op->stack_offset;
+
+            if ((op->flags & PLAN_OP_CHECK_NULL) && !*(unsigned char **)pArg)
+                RpcRaiseException( RPC_X_NULL_REF_POINTER );
+            if (plan->fixed_size || !(op->flags & PLAN_OP_IN)) continue;
+            if (!op->size)
+                client_do_args( pStubMsg, (PFORMAT_STRING)&params[op->param], phase, fpu_args, 1, pRetVal );
+            else
+            {
+                pStubMsg->BufferLength = (pStubMsg->BufferLength + op->align - 1) & ~(op->align - 1);
+                if (pStubMsg->BufferLength + op->size < pStubMsg->BufferLength)
+                    RpcRaiseException( RPC_X_BAD_STUB_DATA );
+                pStubMsg->BufferLength += op->size;
+            }
+        }
+        if (plan->fixed_size)
+        {
+            /* everything is flat, the size only depends on the starting length */
+            if (!pStubMsg->BufferLength) pStubMsg->BufferLength = plan->fixed_size;
+            else client_do_args( pStubMsg, pFormat, phase, fpu_args, number_of_params, pRetVal );
+        }
+        return;
+    }
+
+    end = (unsigned char *)pStubMsg->RpcMsg->Buffer + pStubMsg->BufferLength;
+    for (i = 0; i < plan->count; i++)
+    {
+        const struct client_plan_op *op = &plan->ops[i];
+        unsigned char *pArg = pStubMsg->StackTop + op->stack_offset;
+        ULONG_PTR mask = op->align - 1;
+
+        if (!(op->flags & PLAN_OP_IN)) continue;
+        if (!op->size)
+        {
+            client_do_args( pStubMsg, (PFORMAT_STRING)&params[op->param], phase, fpu_args, 1, pRetVal );
+            continue;
+        }
+        if (op->flags & PLAN_OP_DEREF) pArg = *(unsigned char **)pArg;
+
+        memset( pStubMsg->Buffer, 0, (op->align - (ULONG_PTR)pStubMsg->Buffer) & mask );
+        pStubMsg->Buffer = (unsigned char *)(((ULONG_PTR)pStubMsg->Buffer + mask) & ~mask);
+        if (op->flags & PLAN_OP_STRUCT) pStubMsg->BufferMark = pStubMsg->Buffer;
+        if (pStubMsg->Buffer + op->size > end)
+        {
+            ERR( "buffer overflow - Buffer = %p, BufferEnd = %p, size = %u\n",
+                 pStubMsg->Buffer, end, op->size );
+            RpcRaiseException( RPC_X_BAD_STUB_DATA );
+        }
+        memcpy( pStubMsg->Buffer, pArg, op->size );
+        pStubMsg->Buffer += op->size;
+    }
+}
+
 static unsigned int type_stack_size(unsigned char fc)
 {
     switch (fc)
@@ -619,6 +951,8 @@ LONG_PTR CDECL ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORMAT_STRING pForma
     PFORMAT_STRING pHandleFormat;
     /* correlation cache */
     ULONG_PTR NdrCorrCache[256];
+    /* compiled sizing and marshalling operations */
+    const struct client_plan *plan = NULL;
 
     TRACE("pStubDesc %p, pFormat %p, ...\n", pStubDesc, pFormat);
 
@@ -697,6 +1031,7 @@ LONG_PTR CDECL ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORMAT_STRING pForma
             }
 #endif
         }
+        plan = get_client_plan(&stubMsg, (PFORMAT_STRING)pProcHeader, pFormat, number_of_params);
     }
     else
     {
@@ -753,8 +1088,8 @@ LONG_PTR CDECL ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORMAT_STRING pForma
         {
             /* 2. CALCSIZE */
             TRACE( "CALCSIZE\n" );
-            client_do_args(&stubMsg, pFormat, STUBLESS_CALCSIZE, fpu_stack,
-                           number_of_params, (unsigned char *)&RetVal);
+            client_plan_do_args(&stubMsg, plan, pFormat, STUBLESS_CALCSIZE, fpu_stack,
+                                number_of_params, (unsigned char *)&RetVal);
 
             /* 3. GETBUFFER */
             TRACE( "GETBUFFER\n" );
@@ -784,8 +1119,8 @@ LONG_PTR CDECL ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORMAT_STRING pForma
 
             /* 4. MARSHAL */
             TRACE( "MARSHAL\n" );
-            client_do_args(&stubMsg, pFormat, STUBLESS_MARSHAL, fpu_stack,
-                           number_of_params, (unsigned char *)&RetVal);
+            client_plan_do_args(&stubMsg, plan, pFormat, STUBLESS_MARSHAL, fpu_stack,
+                                number_of_params, (unsigned char *)&RetVal);
 
             /* 5. SENDRECEIVE */
             TRACE( "SENDRECEIVE\n" );
@@ -867,8 +1202,8 @@ LONG_PTR CDECL ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORMAT_STRING pForma
     {
         /* 2. CALCSIZE */
         TRACE( "CALCSIZE\n" );
-        client_do_args(&stubMsg, pFormat, STUBLESS_CALCSIZE, fpu_stack,
-                       number_of_params, (unsigned char *)&RetVal);
+        client_plan_do_args(&stubMsg, plan, pFormat, STUBLESS_CALCSIZE, fpu_stack,
+                            number_of_params, (unsigned char *)&RetVal);
 
         /* 3. GETBUFFER */
         TRACE( "GETBUFFER\n" );
@@ -889,8 +1224,8 @@ LONG_PTR CDECL ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORMAT_STRING pForma
 
         /* 4. MARSHAL */
         TRACE( "MARSHAL\n" );
-        client_do_args(&stubMsg, pFormat, STUBLESS_MARSHAL, fpu_stack,
-                       number_of_params, (unsigned char *)&RetVal);
+        client_plan_do_args(&stubMsg, plan, pFormat, STUBLESS_MARSHAL, fpu_stack,
+                            number_of_params, (unsigned char *)&RetVal);
 
         /* 5. SENDRECEIVE */
         TRACE( "SENDRECEIVE\n" );
@@ -235,13 +235,14 @@ static RPC_STATUS RpcAssoc_BindConnection(const RpcAssoc *assoc, RpcConnection *
     RPC_STATUS status;
     unsigned char *auth_data = NULL;
     ULONG auth_length;
+    unsigned short features = conn->ops->bind_features;
 
     TRACE("sending bind request to server\n");
 
     hdr = RPCRT4_BuildBindHeader(NDR_LOCAL_DATA_REPRESENTATION,
                                  RPC_MAX_PACKET_SIZE, RPC_MAX_PACKET_SIZE,
                                  assoc->assoc_group_id,
-                                 InterfaceId, TransferSyntax);
+                                 InterfaceId, TransferSyntax, features);
 
     status = RPCRT4_Send(conn, hdr, NULL, 0);
     RPCRT4_FreeHeader(hdr);
@@ -267,14 +268,23 @@ static RPC_STATUS RpcAssoc_BindConnection(const RpcAssoc *assoc, RpcConnection *
             ROUND_UP(FIELD_OFFSET(RpcAddressString, string[server_address->length]), 4);
             RpcResultList *results = (RpcResultList*)((ULONG_PTR)server_address +
                 ROUND_UP(FIELD_OFFSET(RpcAddressString, string[server_address->length]), 4));
-            if ((results->num_results == 1) &&
+            if ((results->num_results == 1 || (features && results->num_results == 2)) &&
                 (remaining >= FIELD_OFFSET(RpcResultList, results[results->num_results])))
             {
+                /* servers that don't know about feature negotiation reject its context */
+                if (results->num_results == 2 && results->results[1].result == RESULT_NEGOTIATE_ACK)
+                    features &= results->results[1].reason;
+                else
+                    features = 0;
+
                 switch (results->results[0].result)
                 {
                 case RESULT_ACCEPT:
+                    /* the server expects the transport to switch right after the ack */
+                    if (features)
+                        status = rpcrt4_conn_set_bind_features(conn, features);
                     /* respond to authorization request */
-                    if (auth_length > sizeof(RpcAuthVerifier))
+                    if (status == RPC_S_OK && auth_length > sizeof(RpcAuthVerifier))
                         status = RPCRT4_ClientConnectionAuth(conn,
                                                              auth_data + sizeof(RpcAuthVerifier),
                                                              auth_length);
@@ -113,6 +113,8 @@ struct connection_ops {
   RPC_STATUS (*impersonate_client)(RpcConnection *conn);
   RPC_STATUS (*revert_to_self)(RpcConnection *conn);
   RPC_STATUS (*inquire_auth_client)(RpcConnection *, RPC_AUTHZ_HANDLE *, RPC_WSTR *, ULONG *, ULONG *, ULONG *, ULONG);
+  unsigned short bind_features; /* bind time features the transport supports */
+  RPC_STATUS (*set_bind_features)(RpcConnection *conn, unsigned short features);
 };
 
 /* don't know what MS's structure looks like */
@@ -233,6 +235,12 @@ static inline RPC_STATUS rpcrt4_conn_revert_to_self(
     return conn->ops->revert_to_self(conn);
 }
 
+static inline RPC_STATUS rpcrt4_conn_set_bind_features(
+    RpcConnection *conn, unsigned short features)
+{
+    return conn->ops->set_bind_features(conn, features);
+}
+
 static inline RPC_STATUS rpcrt4_conn_inquire_auth_client(
     RpcConnection *conn, RPC_AUTHZ_HANDLE *privs, RPC_WSTR *server_princ_name,
     ULONG *authn_level, ULONG *authn_svc, ULONG *authz_svc, ULONG flags)
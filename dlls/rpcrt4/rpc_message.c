@@ -182,36 +182,65 @@ RpcPktHdr *RPCRT4_BuildFaultHeader(ULONG DataRepresentation, RPC_STATUS Status)
   return header;
 }
 
+/* bind time feature negotiation uses 6cb71c2c-9812-4540-xxxx-xxxxxxxxxxxx as
+ * transfer syntax, with the requested features in the last eight bytes */
+static const GUID btfn_guid = {0x6cb71c2c,0x9812,0x4540,{0}};
+
 RpcPktHdr *RPCRT4_BuildBindHeader(ULONG DataRepresentation,
                                   unsigned short MaxTransmissionSize,
                                   unsigned short MaxReceiveSize,
                                   ULONG  AssocGroupId,
                                   const RPC_SYNTAX_IDENTIFIER *AbstractId,
-                                  const RPC_SYNTAX_IDENTIFIER *TransferId)
+                                  const RPC_SYNTAX_IDENTIFIER *TransferId,
+                                  unsigned short Features)
 {
   RpcPktHdr *header;
   RpcContextElement *ctxt_elem;
+  unsigned int num_elements = Features ? 2 : 1;
+  ULONG size = sizeof(header->bind) + num_elements * FIELD_OFFSET(RpcContextElement, transfer_syntaxes[1]);
 
-  header = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
-                     sizeof(header->bind) + FIELD_OFFSET(RpcContextElement, transfer_syntaxes[1]));
+  header = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, size);
   if (header == NULL) {
     return NULL;
   }
   ctxt_elem = (RpcContextElement *)(&header->bind + 1);
 
   RPCRT4_BuildCommonHeader(header, PKT_BIND, DataRepresentation);
-  header->common.frag_len = sizeof(header->bind) + FIELD_OFFSET(RpcContextElement, transfer_syntaxes[1]);
+  header->common.frag_len = size;
   header->bind.max_tsize = MaxTransmissionSize;
   header->bind.max_rsize = MaxReceiveSize;
   header->bind.assoc_gid = AssocGroupId;
-  header->bind.num_elements = 1;
+  header->bind.num_elements = num_elements;
   ctxt_elem->num_syntaxes = 1;
   ctxt_elem->abstract_syntax = *AbstractId;
   ctxt_elem->transfer_syntaxes[0] = *TransferId;
 
+  if (Features)
+  {
+    ctxt_elem = (RpcContextElement *)&ctxt_elem->transfer_syntaxes[1];
+    ctxt_elem->context_id = 1;
+    ctxt_elem->num_syntaxes = 1;
+    ctxt_elem->abstract_syntax = *AbstractId;
+    ctxt_elem->transfer_syntaxes[0].SyntaxGUID = btfn_guid;
+    ctxt_elem->transfer_syntaxes[0].SyntaxGUID.Data4[0] = Features & 0xff;
+    ctxt_elem->transfer_syntaxes[0].SyntaxGUID.Data4[1] = Features >> 8;
+    ctxt_elem->transfer_syntaxes[0].SyntaxVersion.MajorVersion = 1;
+  }
+
   return header;
 }
 
+BOOL RPCRT4_IsBindTimeFeatureNegotiation(const RPC_SYNTAX_IDENTIFIER *TransferId,
+                                         unsigned short *Features)
+{
+  const GUID *guid = &TransferId->SyntaxGUID;
+
+  if (memcmp(guid, &btfn_guid, FIELD_OFFSET(GUID, Data4)))
+    return FALSE;
+  *Features = guid->Data4[0] | (guid->Data4[1] << 8);
+  return TRUE;
+}
+
 static RpcPktHdr *RPCRT4_BuildAuthHeader(ULONG DataRepresentation)
 {
   RpcPktHdr *header;
@@ -215,6 +215,7 @@ static RPC_STATUS process_bind_packet_no_send(
   RpcContextElement *ctxt_elem;
   unsigned int i;
   RpcResult *results;
+  unsigned short features = 0;
 
   /* validate data */
   for (i = 0, ctxt_elem = msg->Buffer;
@@ -251,6 +252,17 @@ static RPC_STATUS process_bind_packet_no_send(
       RpcServerInterface* sif = NULL;
       unsigned int j;
 
+      if (ctxt_elem->num_syntaxes &&
+          RPCRT4_IsBindTimeFeatureNegotiation(&ctxt_elem->transfer_syntaxes[0], &features))
+      {
+          features &= conn->ops->bind_features;
+          TRACE("bind time features %04x on connection %p\n", features, conn);
+          results[i].result = RESULT_NEGOTIATE_ACK;
+          results[i].reason = features;
+          memset(&results[i].transfer_syntax, 0, sizeof(results[i].transfer_syntax));
+          continue;
+      }
+
       for (j = 0; !sif && j < ctxt_elem->num_syntaxes; j++)
       {
           sif = RPCRT4_find_interface(NULL, &ctxt_elem->abstract_syntax,
@@ -332,7 +344,11 @@ static RPC_STATUS process_bind_packet_no_send(
   HeapFree(GetProcessHeap(), 0, results);
 
   if (*ack_response)
+  {
       conn->MaxTransmissionSize = hdr->max_tsize;
+      if (features)
+          status = rpcrt4_conn_set_bind_features(conn, features);
+  }
   else
       status = RPC_S_OUT_OF_RESOURCES;
 
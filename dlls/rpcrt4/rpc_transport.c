@@ -113,6 +113,16 @@ typedef struct _RpcConnection_np
   HANDLE pipe;
   HANDLE listen_thread;
   BOOL listening;
+  /* ncalrpc shared memory channel, see below */
+  struct lrpc_shm *shm;
+  HANDLE shm_mapping;
+  HANDLE shm_events[4];
+  HANDLE shm_peer;
+  HANDLE shm_cancel_event;
+  BOOL shm_requested;
+  BOOL shm_reading;
+  LONG shm_call;
+  LONG shm_cancel_call;
 } RpcConnection_np;
 
 static RpcConnection *rpcrt4_conn_np_alloc(void)
@@ -474,6 +484,369 @@ static int rpcrt4_conn_np_wait_for_incoming_data(RpcConnection *Connection)
     return -1;
 }
 
+/* ncalrpc shared memory channel
+ *
+ * Both sides ask for it at bind time with a private bind time feature flag,
+ * so peers that don't know about it just keep using the pipe. Right after the
+ * bind ack, the client sends its process id and the server answers with an
+ * unnamed section holding one ring buffer per direction and the events used
+ * to wait on them, duplicated into the client. From then on all PDUs go
+ * through the rings and the pipe is only kept for impersonation. A side that
+ * finds its ring empty, or full, flags itself as waiting and sleeps on an
+ * event, and the other side only signals the event when that flag is set.
+ * The receiving side is usually asleep by the time a request or a reply is
+ * sent, so a call still costs a SetEvent and a wait in each direction; what
+ * it saves are the pipe reads and writes. */
+
+#define LRPC_SHM_MAGIC      0x4d48534c  /* "LSHM" */
+#define LRPC_SHM_RING_SIZE  0x40000
+#define LRPC_SHM_RING_MASK  (LRPC_SHM_RING_SIZE - 1)
+#define LRPC_SHM_EVENTS     4
+#define LRPC_SHM_DATA_EVENT(ring)   ((ring) * 2)
+#define LRPC_SHM_SPACE_EVENT(ring)  ((ring) * 2 + 1)
+
+struct lrpc_shm_ring
+{
+    LONG head;           /* total bytes written */
+    LONG tail;           /* total bytes read */
+    LONG reader_waiting;
+    LONG writer_waiting;
+    LONG closed;
+    LONG pad[11];        /* keep the data on its own cache lines */
+    unsigned char data[LRPC_SHM_RING_SIZE];
+};
+
+struct lrpc_shm
+{
+    struct lrpc_shm_ring ring[2];  /* client to server, server to client */
+};
+
+struct lrpc_shm_request
+{
+    DWORD magic;
+    DWORD pid;
+};
+
+struct lrpc_shm_reply
+{
+    DWORD magic;
+    DWORD status;
+    DWORD pid;
+    ULONG handles[1 + LRPC_SHM_EVENTS];  /* section and events, in the client */
+};
+
+/* waits for the peer to move *addr away from val, returns FALSE if the call
+ * can't go on */
+static BOOL lrpc_shm_wait(RpcConnection_np *npc, LONG *addr, LONG val,
+                          LONG *waiting, HANDLE event)
+{
+    HANDLE handles[3];
+    DWORD res;
+
+    InterlockedExchange(waiting, 1);
+    if (*(volatile LONG *)addr != val)
+        return TRUE;
+
+    handles[0] = event;
+    handles[1] = npc->shm_cancel_event;
+    handles[2] = npc->shm_peer;
+    for (;;)
+    {
+        res = WaitForMultipleObjects(3, handles, FALSE, INFINITE);
+        /* a cancel only applies to the call it was issued for */
+        if (res != WAIT_OBJECT_0 + 1 ||
+            *(volatile LONG *)&npc->shm_cancel_call == npc->shm_call)
+            break;
+    }
+    switch (res)
+    {
+    case WAIT_OBJECT_0:
+        return TRUE;
+    case WAIT_OBJECT_0 + 1:
+        TRACE("call cancelled\n");
+        return FALSE;
+    case WAIT_OBJECT_0 + 2:
+        WARN("peer process went away\n");
+        return FALSE;
+    default:
+        ERR("wait failed with error %u\n", GetLastError());
+        return FALSE;
+    }
+}
+
+static int lrpc_shm_read(RpcConnection_np *npc, void *buffer, unsigned int count)
+{
+    unsigned int index = npc->common.server ? 0 : 1;
+    struct lrpc_shm_ring *ring = &npc->shm->ring[index];
+    unsigned char *buf = buffer;
+    unsigned int bytes_left = count;
+
+    while (bytes_left)
+    {
+        LONG head = *(volatile LONG *)&ring->head, tail = ring->tail;
+        unsigned int avail = head - tail, pos = tail & LRPC_SHM_RING_MASK, len;
+
+        if (!avail)
+        {
+            if (ring->closed ||
+                !lrpc_shm_wait(npc, &ring->head, head, &ring->reader_waiting,
+                               npc->shm_events[LRPC_SHM_DATA_EVENT(index)]))
+                return -1;
+            continue;
+        }
+        __sync_synchronize();  /* don't read the data before the head */
+        len = min(bytes_left, min(avail, LRPC_SHM_RING_SIZE - pos));
+        memcpy(buf, ring->data + pos, len);
+        /* full barrier, frees the space before checking for a sleeping writer */
+        InterlockedExchangeAdd(&ring->tail, len);
+        if (ring->writer_waiting)
+        {
+            ring->writer_waiting = 0;
+            SetEvent(npc->shm_events[LRPC_SHM_SPACE_EVENT(index)]);
+        }
+        buf += len;
+        bytes_left -= len;
+    }
+    return count;
+}
+
+static int lrpc_shm_write(RpcConnection_np *npc, const void *buffer, unsigned int count)
+{
+    unsigned int index = npc->common.server ? 1 : 0;
+    struct lrpc_shm_ring *ring = &npc->shm->ring[index];
+    const unsigned char *buf = buffer;
+    unsigned int bytes_left = count;
+
+    while (bytes_left)
+    {
+        LONG head = ring->head, tail = *(volatile LONG *)&ring->tail;
+        unsigned int space = LRPC_SHM_RING_SIZE - (head - tail), pos = head & LRPC_SHM_RING_MASK, len;
+
+        if (ring->closed) return -1;
+        if (!space)
+        {
+            if (!lrpc_shm_wait(npc, &ring->tail, tail, &ring->writer_waiting,
+                               npc->shm_events[LRPC_SHM_SPACE_EVENT(index)]))
+                return -1;
+            continue;
+        }
+        len = min(bytes_left, min(space, LRPC_SHM_RING_SIZE - pos));
+        memcpy(ring->data + pos, buf, len);
+        /* full barrier, publishes the data before checking for a sleeping reader */
+        InterlockedExchangeAdd(&ring->head, len);
+        if (ring->reader_waiting)
+        {
+            ring->reader_waiting = 0;
+            SetEvent(npc->shm_events[LRPC_SHM_DATA_EVENT(index)]);
+        }
+        buf += len;
+        bytes_left -= len;
+    }
+    return count;
+}
+
+static void lrpc_shm_free(RpcConnection_np *npc)
+{
+    unsigned int i;
+
+    if (npc->shm)
+    {
+        InterlockedExchange(&npc->shm->ring[0].closed, 1);
+        InterlockedExchange(&npc->shm->ring[1].closed, 1);
+        UnmapViewOfFile(npc->shm);
+        npc->shm = NULL;
+    }
+    if (npc->shm_mapping)
+    {
+        CloseHandle(npc->shm_mapping);
+        npc->shm_mapping = 0;
+    }
+    for (i = 0; i < LRPC_SHM_EVENTS; i++)
+    {
+        if (!npc->shm_events[i]) continue;
+        /* wake up the peer so that it notices the channel is closed */
+        SetEvent(npc->shm_events[i]);
+        CloseHandle(npc->shm_events[i]);
+        npc->shm_events[i] = 0;
+    }
+    if (npc->shm_peer)
+    {
+        CloseHandle(npc->shm_peer);
+        npc->shm_peer = 0;
+    }
+    if (npc->shm_cancel_event)
+    {
+        CloseHandle(npc->shm_cancel_event);
+        npc->shm_cancel_event = 0;
+    }
+}
+
+/* creates the channel and duplicates its handles into the client process */
+static RPC_STATUS lrpc_shm_create(RpcConnection_np *npc, DWORD pid, ULONG *handles)
+{
+    HANDLE local[1 + LRPC_SHM_EVENTS], remote;
+    unsigned int i;
+
+    npc->shm_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                          0, sizeof(struct lrpc_shm), NULL);
+    if (!npc->shm_mapping ||
+        !(npc->shm = MapViewOfFile(npc->shm_mapping, FILE_MAP_WRITE, 0, 0, 0)) ||
+        !(npc->shm_cancel_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        return RPC_S_OUT_OF_RESOURCES;
+    for (i = 0; i < LRPC_SHM_EVENTS; i++)
+        if (!(npc->shm_events[i] = CreateEventW(NULL, FALSE, FALSE, NULL)))
+            return RPC_S_OUT_OF_RESOURCES;
+
+    if (!(npc->shm_peer = OpenProcess(PROCESS_DUP_HANDLE | SYNCHRONIZE, FALSE, pid)))
+    {
+        WARN("couldn't open client process %04x, error %u\n", pid, GetLastError());
+        return RPC_S_ACCESS_DENIED;
+    }
+
+    local[0] = npc->shm_mapping;
+    memcpy(local + 1, npc->shm_events, sizeof(npc->shm_events));
+    for (i = 0; i < 1 + LRPC_SHM_EVENTS; i++)
+    {
+        if (!DuplicateHandle(GetCurrentProcess(), local[i], npc->shm_peer, &remote,
+                             0, FALSE, DUPLICATE_SAME_ACCESS))
+        {
+            while (i--)
+                DuplicateHandle(npc->shm_peer, ULongToHandle(handles[i]), NULL, NULL,
+                                0, FALSE, DUPLICATE_CLOSE_SOURCE);
+            return RPC_S_OUT_OF_RESOURCES;
+        }
+        handles[i] = HandleToULong(remote);
+    }
+    return RPC_S_OK;
+}
+
+/* answers the request that follows a bind ack enabling the channel */
+static int rpcrt4_ncalrpc_shm_accept(RpcConnection_np *npc)
+{
+    struct lrpc_shm_request request;
+    struct lrpc_shm_reply reply;
+
+    npc->shm_requested = FALSE;
+    if (rpcrt4_conn_np_read(&npc->common, &request, sizeof(request)) == -1)
+        return -1;
+    if (request.magic != LRPC_SHM_MAGIC)
+    {
+        ERR("bad shared memory channel request\n");
+        return -1;
+    }
+
+    memset(&reply, 0, sizeof(reply));
+    reply.magic = LRPC_SHM_MAGIC;
+    reply.pid = GetCurrentProcessId();
+    reply.status = lrpc_shm_create(npc, request.pid, reply.handles);
+    if (reply.status != RPC_S_OK) lrpc_shm_free(npc);
+
+    if (rpcrt4_conn_np_write(&npc->common, &reply, sizeof(reply)) == -1)
+    {
+        lrpc_shm_free(npc);
+        return -1;
+    }
+    TRACE("shared memory channel status %u\n", reply.status);
+    return 0;
+}
+
+static RPC_STATUS rpcrt4_ncalrpc_shm_connect(RpcConnection_np *npc)
+{
+    struct lrpc_shm_request request;
+    struct lrpc_shm_reply reply;
+    unsigned int i;
+
+    request.magic = LRPC_SHM_MAGIC;
+    request.pid = GetCurrentProcessId();
+    if (rpcrt4_conn_np_write(&npc->common, &request, sizeof(request)) == -1 ||
+        rpcrt4_conn_np_read(&npc->common, &reply, sizeof(reply)) == -1 ||
+        reply.magic != LRPC_SHM_MAGIC)
+        return RPC_S_PROTOCOL_ERROR;
+    if (reply.status != RPC_S_OK)
+    {
+        WARN("not using shared memory channel, status %u\n", reply.status);
+        return RPC_S_OK;
+    }
+
+    npc->shm_mapping = ULongToHandle(reply.handles[0]);
+    for (i = 0; i < LRPC_SHM_EVENTS; i++)
+        npc->shm_events[i] = ULongToHandle(reply.handles[i + 1]);
+    if (!(npc->shm = MapViewOfFile(npc->shm_mapping, FILE_MAP_WRITE, 0, 0, 0)) ||
+        !(npc->shm_peer = OpenProcess(SYNCHRONIZE, FALSE, reply.pid)) ||
+        !(npc->shm_cancel_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+    {
+        /* the server has already switched, so the connection is lost */
+        WARN("couldn't set up shared memory channel, error %u\n", GetLastError());
+        lrpc_shm_free(npc);
+        return RPC_S_OUT_OF_RESOURCES;
+    }
+    npc->shm_reading = TRUE;
+    TRACE("using shared memory channel\n");
+    return RPC_S_OK;
+}
+
+static RPC_STATUS rpcrt4_ncalrpc_set_bind_features(RpcConnection *Connection, unsigned short features)
+{
+    RpcConnection_np *npc = (RpcConnection_np *) Connection;
+
+    if (!(features & BTFN_WINE_SHARED_MEMORY))
+        return RPC_S_OK;
+
+    /* the client sends its request as soon as it gets the bind ack */
+    if (Connection->server)
+    {
+        npc->shm_requested = TRUE;
+        return RPC_S_OK;
+    }
+    return rpcrt4_ncalrpc_shm_connect(npc);
+}
+
+static int rpcrt4_ncalrpc_read(RpcConnection *Connection, void *buffer, unsigned int count)
+{
+    RpcConnection_np *npc = (RpcConnection_np *) Connection;
+
+    if (npc->shm_requested && rpcrt4_ncalrpc_shm_accept(npc) == -1)
+        return -1;
+    if (npc->shm)
+    {
+        npc->shm_reading = TRUE;
+        return lrpc_shm_read(npc, buffer, count);
+    }
+    return rpcrt4_conn_np_read(Connection, buffer, count);
+}
+
+static int rpcrt4_ncalrpc_write(RpcConnection *Connection, const void *buffer, unsigned int count)
+{
+    RpcConnection_np *npc = (RpcConnection_np *) Connection;
+
+    if (npc->shm)
+    {
+        /* a client write after a read starts a new call */
+        if (!Connection->server && npc->shm_reading)
+        {
+            npc->shm_reading = FALSE;
+            InterlockedIncrement(&npc->shm_call);
+        }
+        return lrpc_shm_write(npc, buffer, count);
+    }
+    return rpcrt4_conn_np_write(Connection, buffer, count);
+}
+
+static int rpcrt4_ncalrpc_close(RpcConnection *Connection)
+{
+    lrpc_shm_free((RpcConnection_np *) Connection);
+    return rpcrt4_conn_np_close(Connection);
+}
+
+static void rpcrt4_ncalrpc_cancel_call(RpcConnection *Connection)
+{
+    RpcConnection_np *npc = (RpcConnection_np *) Connection;
+
+    if (!npc->shm_cancel_event) return;
+    InterlockedExchange(&npc->shm_cancel_call, npc->shm_call);
+    SetEvent(npc->shm_cancel_event);
+}
+
 static size_t rpcrt4_ncacn_np_get_top_of_tower(unsigned char *tower_data,
                                                const char *networkaddr,
                                                const char *endpoint)
@@ -2763,16 +3136,18 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_impersonate_client,
     rpcrt4_conn_np_revert_to_self,
     RPCRT4_default_inquire_auth_client,
+    0,
+    NULL,
   },
   { "ncalrpc",
     { EPM_PROTOCOL_NCALRPC, EPM_PROTOCOL_PIPE },
     rpcrt4_conn_np_alloc,
     rpcrt4_ncalrpc_open,
     rpcrt4_ncalrpc_handoff,
-    rpcrt4_conn_np_read,
-    rpcrt4_conn_np_write,
-    rpcrt4_conn_np_close,
-    rpcrt4_conn_np_cancel_call,
+    rpcrt4_ncalrpc_read,
+    rpcrt4_ncalrpc_write,
+    rpcrt4_ncalrpc_close,
+    rpcrt4_ncalrpc_cancel_call,
     rpcrt4_conn_np_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
     rpcrt4_ncalrpc_parse_top_of_tower,
@@ -2783,6 +3158,8 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_impersonate_client,
     rpcrt4_conn_np_revert_to_self,
     rpcrt4_ncalrpc_inquire_auth_client,
+    BTFN_WINE_SHARED_MEMORY,
+    rpcrt4_ncalrpc_set_bind_features,
   },
   { "ncacn_ip_tcp",
     { EPM_PROTOCOL_NCACN, EPM_PROTOCOL_TCP },
@@ -2803,6 +3180,8 @@ static const struct connection_ops conn_protseq_list[] = {
     RPCRT4_default_impersonate_client,
     RPCRT4_default_revert_to_self,
     RPCRT4_default_inquire_auth_client,
+    0,
+    NULL,
   },
   { "ncacn_http",
     { EPM_PROTOCOL_NCACN, EPM_PROTOCOL_HTTP },
@@ -2823,6 +3202,8 @@ static const struct connection_ops conn_protseq_list[] = {
     RPCRT4_default_impersonate_client,
     RPCRT4_default_revert_to_self,
     RPCRT4_default_inquire_auth_client,
+    0,
+    NULL,
   },
 };
 
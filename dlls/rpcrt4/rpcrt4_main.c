@@ -55,6 +55,7 @@
 
 #include "rpc_binding.h"
 #include "rpc_server.h"
+#include "ndr_stubless.h"
 
 #include "wine/debug.h"
 
@@ -141,6 +142,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
         if (lpvReserved) break; /* do nothing if process is shutting down */
         RPCRT4_destroy_all_protseqs();
         RPCRT4_ServerFreeAllRegisteredAuthInfo();
+        release_client_plans();
         DeleteCriticalSection(&uuid_cs);
         DeleteCriticalSection(&threaddata_cs);
         break;
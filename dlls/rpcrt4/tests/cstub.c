@@ -1097,6 +1097,299 @@ static void test_delegating_Invoke(IPSFactoryBuffer *ppsf)
     HeapFree(GetProcessHeap(), 0, msg.Buffer);
     IRpcStubBuffer_Release(pstub);
 }
+/* HRESULT fn(IUnknown *This, char a, hyper b, short c, long l, vector *v), with
+ * v a [in] ref pointer to a simple structure of three longs */
+#define STACK_SLOT sizeof(void *)
+#define PLAN_STACK_SIZE (6 * STACK_SLOT + 8)
+
+static const unsigned char plan_type_format[] =
+{
+/* 0 */
+    0x11, 0x0,          /* FC_RP */
+    NdrFcShort(0x2),    /* Offset= 2 (4) */
+/* 4 */
+    0x15,               /* FC_STRUCT */
+    0x3,                /* 3 */
+    NdrFcShort(0xc),    /* 12 */
+    0x8,                /* FC_LONG */
+    0x8,                /* FC_LONG */
+    0x8,                /* FC_LONG */
+    0x5c,               /* FC_PAD */
+    0x5b,               /* FC_END */
+    0x0
+};
+
+/* -Oicf format, marshalled with the cached client plan */
+static const unsigned char plan_proc_format_oif[] =
+{
+    0x33,               /* FC_AUTO_HANDLE */
+    0x6c,               /* Old Flags:  object, Oi2 */
+    NdrFcLong(0x0),     /* 0 */
+    NdrFcShort(0x3),    /* 3 */
+    NdrFcShort(PLAN_STACK_SIZE),
+    NdrFcShort(0x24),   /* client buffer = 36 */
+    NdrFcShort(0x8),    /* server buffer = 8 */
+    0x4,                /* Oi2 Flags:  has return, */
+    0x6,                /* 6 params */
+    /* a */
+    NdrFcShort(0x48),   /* Flags:  in, base type, */
+    NdrFcShort(STACK_SLOT),
+    0x2, 0x0,           /* FC_CHAR */
+    /* b */
+    NdrFcShort(0x48),   /* Flags:  in, base type, */
+    NdrFcShort(2 * STACK_SLOT),
+    0xb, 0x0,           /* FC_HYPER */
+    /* c */
+    NdrFcShort(0x48),   /* Flags:  in, base type, */
+    NdrFcShort(2 * STACK_SLOT + 8),
+    0x6, 0x0,           /* FC_SHORT */
+    /* l */
+    NdrFcShort(0x48),   /* Flags:  in, base type, */
+    NdrFcShort(3 * STACK_SLOT + 8),
+    0x8, 0x0,           /* FC_LONG */
+    /* v */
+    NdrFcShort(0x10a),  /* Flags:  must free, in, simple ref, */
+    NdrFcShort(4 * STACK_SLOT + 8),
+    NdrFcShort(0x4),    /* Type Offset=4 */
+    /* return value */
+    NdrFcShort(0x70),   /* Flags:  out, return, base type, */
+    NdrFcShort(5 * STACK_SLOT + 8),
+    0x8, 0x0,           /* FC_LONG */
+    0x0
+};
+
+#ifdef __i386__
+/* -Oi format of the same procedure, marshalled by the generic routines */
+static const unsigned char plan_proc_format_oi[] =
+{
+    0x33,               /* FC_AUTO_HANDLE */
+    0x4c,               /* Old Flags:  object, */
+    NdrFcLong(0x0),     /* 0 */
+    NdrFcShort(0x3),    /* 3 */
+    NdrFcShort(PLAN_STACK_SIZE),
+    0x4e, 0x2,          /* FC_IN_PARAM_BASETYPE FC_CHAR */
+    0x4e, 0xb,          /* FC_IN_PARAM_BASETYPE FC_HYPER */
+    0x4e, 0x6,          /* FC_IN_PARAM_BASETYPE FC_SHORT */
+    0x4e, 0x8,          /* FC_IN_PARAM_BASETYPE FC_LONG */
+    0x4d, 0x1,          /* FC_IN_PARAM, stack size = 1 */
+    NdrFcShort(0x0),    /* Type Offset=0 */
+    0x53, 0x8,          /* FC_RETURN_PARAM_BASETYPE FC_LONG */
+    0x0
+};
+#endif
+
+static const MIDL_STUB_DESC plan_stub_desc_oif =
+    {
+    NULL,
+    NdrOleAllocate,
+    NdrOleFree,
+    { 0 },
+    0,
+    0,
+    0,
+    0,
+    plan_type_format,
+    1, /* -error bounds_check flag */
+    0x50002, /* Ndr library version */
+    0,
+    0x600016e, /* MIDL Version 6.0.366 */
+    0,
+    NULL,
+    0,  /* notify & notify_flag routine table */
+    1,  /* Flags */
+    0,  /* Reserved3 */
+    0,  /* Reserved4 */
+    0   /* Reserved5 */
+    };
+
+#ifdef __i386__
+static const MIDL_STUB_DESC plan_stub_desc_oi =
+    {
+    NULL,
+    NdrOleAllocate,
+    NdrOleFree,
+    { 0 },
+    0,
+    0,
+    0,
+    0,
+    plan_type_format,
+    1, /* -error bounds_check flag */
+    0x10001, /* Ndr library version */
+    0,
+    0x50100a4, /* MIDL Version 5.1.164 */
+    0,
+    NULL,
+    0,  /* notify & notify_flag routine table */
+    1,  /* Flags */
+    0,  /* Reserved3 */
+    0,  /* Reserved4 */
+    0   /* Reserved5 */
+    };
+#endif
+
+/* writable copies, changed in place to look like a module reloaded at the same address */
+static unsigned char plan_reload_type_format[sizeof(plan_type_format)];
+static unsigned char plan_reload_proc_format[sizeof(plan_proc_format_oif)];
+static MIDL_STUB_DESC plan_reload_stub_desc;
+
+static unsigned char plan_buffer[64];
+static ULONG plan_buffer_len;
+
+static HRESULT WINAPI plan_chan_query_interface(IRpcChannelBuffer *pchan, REFIID iid, void **ppv)
+{
+    ok(0, "call to QueryInterface not expected\n");
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI plan_chan_add_ref(IRpcChannelBuffer *pchan)
+{
+    return 2;
+}
+
+static ULONG WINAPI plan_chan_release(IRpcChannelBuffer *pchan)
+{
+    return 1;
+}
+
+static HRESULT WINAPI plan_chan_get_buffer(IRpcChannelBuffer *pchan, RPCOLEMESSAGE *msg, REFIID iid)
+{
+    msg->Buffer = HeapAlloc(GetProcessHeap(), 0, msg->cbBuffer);
+    return S_OK;
+}
+
+static HRESULT WINAPI plan_chan_send_receive(IRpcChannelBuffer *pchan, RPCOLEMESSAGE *msg, ULONG *status)
+{
+    ok(msg->cbBuffer <= sizeof(plan_buffer), "buffer too large %u\n", msg->cbBuffer);
+    plan_buffer_len = min(msg->cbBuffer, sizeof(plan_buffer));
+    memcpy(plan_buffer, msg->Buffer, plan_buffer_len);
+
+    /* reply with S_OK */
+    HeapFree(GetProcessHeap(), 0, msg->Buffer);
+    msg->Buffer = HeapAlloc(GetProcessHeap(), 0, sizeof(HRESULT));
+    *(HRESULT *)msg->Buffer = S_OK;
+    msg->cbBuffer = sizeof(HRESULT);
+    *status = 0;
+    return S_OK;
+}
+
+static HRESULT WINAPI plan_chan_free_buffer(IRpcChannelBuffer *pchan, RPCOLEMESSAGE *msg)
+{
+    HeapFree(GetProcessHeap(), 0, msg->Buffer);
+    return S_OK;
+}
+
+static HRESULT WINAPI plan_chan_get_dest_ctx(IRpcChannelBuffer *pchan, DWORD *pdwDestContext, void **ppvDestContext)
+{
+    *pdwDestContext = MSHCTX_LOCAL;
+    *ppvDestContext = NULL;
+    return S_OK;
+}
+
+static HRESULT WINAPI plan_chan_is_connected(IRpcChannelBuffer *pchan)
+{
+    return S_OK;
+}
+
+static IRpcChannelBufferVtbl plan_rpc_chan_vtbl =
+{
+    plan_chan_query_interface,
+    plan_chan_add_ref,
+    plan_chan_release,
+    plan_chan_get_buffer,
+    plan_chan_send_receive,
+    plan_chan_free_buffer,
+    plan_chan_get_dest_ctx,
+    plan_chan_is_connected
+};
+
+static void test_client_call_marshal(IPSFactoryBuffer *ppsf)
+{
+    static const unsigned char expected[] =
+    {
+        0x12, 0, 0, 0, 0, 0, 0, 0,                      /* char, aligned to 8 */
+        0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01, /* hyper */
+        0x56, 0x34, 0, 0,                               /* short, aligned to 4 */
+        0xde, 0xbc, 0x9a, 0x78,                         /* long */
+        1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0              /* structure */
+    };
+    static const unsigned char expected_reload[] =
+    {
+        0x12, 0, 0, 0, 0, 0, 0, 0,                      /* char, aligned to 8 */
+        0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01, /* hyper */
+        0x56, 0x34, 0, 0,                               /* short, aligned to 4 */
+        0xde, 0xbc, 0x9a, 0x78,                         /* long */
+        1, 0, 0, 0, 2, 0, 0, 0                          /* structure of two longs */
+    };
+    IRpcChannelBufferVtbl *pchan_vtbl = &plan_rpc_chan_vtbl;
+    IRpcChannelBuffer *pchan = (IRpcChannelBuffer *)&pchan_vtbl;
+    IRpcProxyBuffer *proxy = NULL;
+    IUnknown *iface = NULL;
+    CLIENT_CALL_RETURN ret;
+    int v[3] = { 1, 2, 3 };
+    HRESULT r;
+    int i;
+
+    r = IPSFactoryBuffer_CreateProxy(ppsf, NULL, &IID_if1, &proxy, (void **)&iface);
+    ok(r == S_OK, "IPSFactoryBuffer_CreateProxy failed %x\n", r);
+    r = IRpcProxyBuffer_Connect(proxy, pchan);
+    ok(r == S_OK, "IRpcProxyBuffer_Connect failed %x\n", r);
+
+    /* the second call uses the cached plan */
+    for (i = 0; i < 2; i++)
+    {
+        memset(plan_buffer, 0xcc, sizeof(plan_buffer));
+        plan_buffer_len = 0;
+        ret = NdrClientCall2((PMIDL_STUB_DESC)&plan_stub_desc_oif, plan_proc_format_oif, iface,
+                             0x12, (ULONGLONG)0x0123456789abcdef, 0x3456, 0x789abcde, v);
+        ok(ret.Simple == S_OK, "%d: got %08x\n", i, (HRESULT)ret.Simple);
+        ok(plan_buffer_len == sizeof(expected), "%d: got length %u\n", i, plan_buffer_len);
+        ok(!memcmp(plan_buffer, expected, sizeof(expected)), "%d: wrong buffer contents\n", i);
+    }
+
+    /* a different procedure at the address of a cached one must not use its plan */
+    memcpy(plan_reload_type_format, plan_type_format, sizeof(plan_type_format));
+    memcpy(plan_reload_proc_format, plan_proc_format_oif, sizeof(plan_proc_format_oif));
+    plan_reload_stub_desc = plan_stub_desc_oif;
+    plan_reload_stub_desc.pFormatTypes = plan_reload_type_format;
+
+    memset(plan_buffer, 0xcc, sizeof(plan_buffer));
+    plan_buffer_len = 0;
+    ret = NdrClientCall2(&plan_reload_stub_desc, plan_reload_proc_format, iface,
+                         0x12, (ULONGLONG)0x0123456789abcdef, 0x3456, 0x789abcde, v);
+    ok(ret.Simple == S_OK, "got %08x\n", (HRESULT)ret.Simple);
+    ok(plan_buffer_len == sizeof(expected), "got length %u\n", plan_buffer_len);
+    ok(!memcmp(plan_buffer, expected, sizeof(expected)), "wrong buffer contents\n");
+
+    plan_reload_proc_format[10] = 0x20;    /* client buffer = 32 */
+    plan_reload_type_format[6] = 0x8;      /* structure size = 8 */
+    plan_reload_type_format[10] = 0x5c;    /* FC_PAD */
+    plan_reload_type_format[11] = 0x5b;    /* FC_END */
+
+    memset(plan_buffer, 0xcc, sizeof(plan_buffer));
+    plan_buffer_len = 0;
+    ret = NdrClientCall2(&plan_reload_stub_desc, plan_reload_proc_format, iface,
+                         0x12, (ULONGLONG)0x0123456789abcdef, 0x3456, 0x789abcde, v);
+    ok(ret.Simple == S_OK, "got %08x\n", (HRESULT)ret.Simple);
+    ok(plan_buffer_len == sizeof(expected_reload), "got length %u\n", plan_buffer_len);
+    ok(!memcmp(plan_buffer, expected_reload, sizeof(expected_reload)), "wrong buffer contents\n");
+
+#ifdef __i386__
+    /* same arguments through the -Oi interpreter */
+    memset(plan_buffer, 0xcc, sizeof(plan_buffer));
+    plan_buffer_len = 0;
+    ret = NdrClientCall((PMIDL_STUB_DESC)&plan_stub_desc_oi, plan_proc_format_oi, iface,
+                        0x12, (ULONGLONG)0x0123456789abcdef, 0x3456, 0x789abcde, v);
+    ok(ret.Simple == S_OK, "got %08x\n", (HRESULT)ret.Simple);
+    ok(plan_buffer_len == sizeof(expected), "got length %u\n", plan_buffer_len);
+    ok(!memcmp(plan_buffer, expected, sizeof(expected)), "wrong buffer contents\n");
+#endif
+
+    IRpcProxyBuffer_Disconnect(proxy);
+    IUnknown_Release(iface);
+    IRpcProxyBuffer_Release(proxy);
+}
+
 static const CInterfaceProxyVtbl *cstub_ProxyVtblList2[] =
 {
     NULL
@@ -1175,6 +1468,7 @@ START_TEST( cstub )
     test_Disconnect(ppsf);
     test_Release(ppsf);
     test_delegating_Invoke(ppsf);
+    test_client_call_marshal(ppsf);
     test_NdrDllRegisterProxy();
 
     OleUninitialize();
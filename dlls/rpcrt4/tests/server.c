@@ -138,6 +138,11 @@ int __cdecl s_sum_char_hyper(signed char x, hyper y)
     return x + y;
 }
 
+hyper __cdecl s_sum_mixed(signed char a, hyper b, short c, vector_t *v, double d)
+{
+    return a + b + c + v->x + v->y + v->z + d;
+}
+
 void __cdecl s_square_out(int x, int *y)
 {
   *y = s_square(x);
@@ -756,6 +761,11 @@ void __cdecl s_full_pointer_null_test(int *a, int *b)
     ok(b == NULL, "Expected b to be NULL instead of %p\n", b);
 }
 
+void __cdecl s_sleep_ms(int ms)
+{
+  Sleep(ms);
+}
+
 void __cdecl s_stop(void)
 {
   ok(RPC_S_OK == RpcMgmtStopServerListening(NULL), "RpcMgmtStopServerListening\n");
@@ -837,6 +847,15 @@ basic_tests(void)
   x = sum_char_hyper( 12, ((hyper)0x42424242 << 32) | 0x33334444 );
   ok(x == 0x33334450, "RPC char_hyper got 0x%x\n", x);
 
+  /* the client marshalling plan is reused after the first call */
+  for (i1 = 0; i1 < 3; i1++)
+  {
+    vector_t vm = {i1, -3, 100};
+    y = sum_mixed( -2, ((hyper)1 << 40) + 1000 * i1, 300, &vm, 0.5 + i1 );
+    ok(y == ((hyper)1 << 40) + 395 + 1002 * i1, "RPC sum_mixed %d got %x%08x\n",
+       i1, (DWORD)(y >> 32), (DWORD)y);
+  }
+
   x = 0;
   square_out(11, &x);
   ok(x == 121, "RPC square_out\n");
@@ -1447,6 +1466,56 @@ void __cdecl s_authinfo_test(unsigned int protseq, int secure)
     }
 }
 
+static DWORD WINAPI cancel_thread(void *arg)
+{
+  Sleep(100);
+  ok(RpcCancelThread(arg) == RPC_S_OK, "RpcCancelThread failed\n");
+  return 0;
+}
+
+static void
+ncalrpc_tests(void)
+{
+  HANDLE thread, self;
+  RPC_STATUS status;
+  char *str;
+
+  ok(sum(1, 2) == 3, "RPC sum\n");
+
+  /* a cancel must not affect the following calls */
+  ok(DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &self,
+                     0, FALSE, DUPLICATE_SAME_ACCESS), "DuplicateHandle\n");
+  thread = CreateThread(NULL, 0, cancel_thread, self, 0, NULL);
+  ok(thread != NULL, "CreateThread failed with error %d\n", GetLastError());
+  status = RPC_S_OK;
+  RpcTryExcept
+  {
+    sleep_ms(500);
+  }
+  RpcExcept(TRUE)
+  {
+    status = RpcExceptionCode();
+  }
+  RpcEndExcept
+  ok(status == RPC_S_OK || status == RPC_S_CALL_CANCELLED || status == RPC_S_CALL_FAILED,
+     "got %d\n", status);
+  ok(WaitForSingleObject(thread, 5000) == WAIT_OBJECT_0, "WaitForSingleObject\n");
+  CloseHandle(thread);
+  CloseHandle(self);
+
+  ok(sum(3, 4) == 7, "RPC sum\n");
+  ok(sum(5, 6) == 11, "RPC sum\n");
+
+  /* more data than fits in the shared memory ring */
+  str = HeapAlloc(GetProcessHeap(), 0, 0x100001);
+  memset(str, 'a', 0x100000);
+  str[0x100000] = 0;
+  ok(str_length(str) == 0x100000, "RPC str_length\n");
+  HeapFree(GetProcessHeap(), 0, str);
+
+  ok(sum(7, 8) == 15, "RPC sum\n");
+}
+
 static void
 run_tests(void)
 {
@@ -1519,6 +1588,7 @@ client(const char *test)
 
     run_tests(); /* can cause RPC_X_BAD_STUB_DATA exception */
     authinfo_test(RPC_PROTSEQ_LRPC, 0);
+    ncalrpc_tests();
 
     ok(RPC_S_OK == RpcStringFree(&binding), "RpcStringFree\n");
     ok(RPC_S_OK == RpcBindingFree(&IServer_IfHandle), "RpcBindingFree\n");
@@ -934,6 +934,135 @@ static ulong32 setup_mix(ulong32 temp)
           (Te4_0[byte(temp, 3)]);
 }
 
+int aes_ni_enabled = 0;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+
+/* AES-NI versions of the block functions, selected at runtime through
+ * aes_ni_enabled. They use the same key schedule as the table based code,
+ * stored in memory byte order by aes_setup. The compiler has to know about
+ * the SSE registers for the clobber lists, so this is left out of plain
+ * i386 builds. */
+#define HAVE_AES_NI
+
+static void aes_ni_encrypt(const unsigned char *pt, unsigned char *ct, const unsigned char *rk, int Nr)
+{
+    int r = Nr - 1;
+
+    __asm__ __volatile__(
+        "movdqu (%[in]), %%xmm0\n\t"
+        "movdqu (%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n"
+        "1:\tadd $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm1\n\t"
+        "aesenc %%xmm1, %%xmm0\n\t"
+        "dec %[r]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm1\n\t"
+        "aesenclast %%xmm1, %%xmm0\n\t"
+        "movdqu %%xmm0, (%[out])\n\t"
+        : [rk] "+r" (rk), [r] "+r" (r)
+        : [in] "r" (pt), [out] "r" (ct)
+        : "xmm0", "xmm1", "memory", "cc");
+}
+
+static void aes_ni_decrypt(const unsigned char *ct, unsigned char *pt, const unsigned char *rk, int Nr)
+{
+    int r = Nr - 1;
+
+    __asm__ __volatile__(
+        "movdqu (%[in]), %%xmm0\n\t"
+        "movdqu (%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n"
+        "1:\tadd $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm1\n\t"
+        "aesdec %%xmm1, %%xmm0\n\t"
+        "dec %[r]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm1\n\t"
+        "aesdeclast %%xmm1, %%xmm0\n\t"
+        "movdqu %%xmm0, (%[out])\n\t"
+        : [rk] "+r" (rk), [r] "+r" (r)
+        : [in] "r" (ct), [out] "r" (pt)
+        : "xmm0", "xmm1", "memory", "cc");
+}
+
+static void aes_ni_cbc_encrypt(const unsigned char *pt, unsigned char *ct, unsigned char *iv,
+                               const unsigned char *rk, int Nr)
+{
+    int r = Nr - 1;
+
+    __asm__ __volatile__(
+        "movdqu %[iv], %%xmm0\n\t"
+        "movdqu (%[in]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n\t"
+        "movdqu (%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n"
+        "1:\tadd $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm1\n\t"
+        "aesenc %%xmm1, %%xmm0\n\t"
+        "dec %[r]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm1\n\t"
+        "aesenclast %%xmm1, %%xmm0\n\t"
+        "movdqu %%xmm0, (%[out])\n\t"
+        "movdqu %%xmm0, %[iv]\n\t"
+        : [rk] "+r" (rk), [r] "+r" (r), [iv] "+m" (*(unsigned char (*)[16])iv)
+        : [in] "r" (pt), [out] "r" (ct)
+        : "xmm0", "xmm1", "memory", "cc");
+}
+
+/* CBC decryption has no dependency between blocks, so four of them are
+ * kept in flight to hide the latency of aesdec. */
+static void aes_ni_cbc_decrypt4(const unsigned char *ct, unsigned char *pt, unsigned char *iv,
+                                const unsigned char *rk, int Nr)
+{
+    int r = Nr - 1;
+
+    __asm__ __volatile__(
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "movdqu   (%[in]), %%xmm0\n\t"
+        "movdqu 16(%[in]), %%xmm1\n\t"
+        "movdqu 32(%[in]), %%xmm2\n\t"
+        "movdqu 48(%[in]), %%xmm3\n\t"
+        "pxor %%xmm4, %%xmm0\n\t"
+        "pxor %%xmm4, %%xmm1\n\t"
+        "pxor %%xmm4, %%xmm2\n\t"
+        "pxor %%xmm4, %%xmm3\n"
+        "1:\tadd $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "aesdec %%xmm4, %%xmm0\n\t"
+        "aesdec %%xmm4, %%xmm1\n\t"
+        "aesdec %%xmm4, %%xmm2\n\t"
+        "aesdec %%xmm4, %%xmm3\n\t"
+        "dec %[r]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm4\n\t"
+        "aesdeclast %%xmm4, %%xmm0\n\t"
+        "aesdeclast %%xmm4, %%xmm1\n\t"
+        "aesdeclast %%xmm4, %%xmm2\n\t"
+        "aesdeclast %%xmm4, %%xmm3\n\t"
+        "movdqu %[iv], %%xmm5\n\t"
+        "pxor %%xmm5, %%xmm0\n\t"
+        "movdqu   (%[in]), %%xmm5\n\t"
+        "pxor %%xmm5, %%xmm1\n\t"
+        "movdqu 16(%[in]), %%xmm5\n\t"
+        "pxor %%xmm5, %%xmm2\n\t"
+        "movdqu 32(%[in]), %%xmm5\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        "movdqu 48(%[in]), %%xmm5\n\t"
+        "movdqu %%xmm5, %[iv]\n\t"
+        "movdqu %%xmm0,   (%[out])\n\t"
+        "movdqu %%xmm1, 16(%[out])\n\t"
+        "movdqu %%xmm2, 32(%[out])\n\t"
+        "movdqu %%xmm3, 48(%[out])\n\t"
+        : [rk] "+r" (rk), [r] "+r" (r), [iv] "+m" (*(unsigned char (*)[16])iv)
+        : [in] "r" (ct), [out] "r" (pt)
+        : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "memory", "cc");
+}
+
+#endif
+
 int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
 {
     int i, j;
@@ -1058,6 +1187,13 @@ int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
     *rk++ = *rrk++;
     *rk   = *rrk;
 
+#ifdef HAVE_AES_NI
+    for (i = 0; i < j; i++) {
+        STORE32H(skey->eK[i], skey->ni_eK + 4 * i);
+        STORE32H(skey->dK[i], skey->ni_dK + 4 * i);
+    }
+#endif
+
     return CRYPT_OK;
 }
 
@@ -1066,6 +1202,13 @@ void aes_ecb_encrypt(const unsigned char *pt, unsigned char *ct, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#ifdef HAVE_AES_NI
+    if (aes_ni_enabled) {
+        aes_ni_encrypt(pt, ct, skey->ni_eK, skey->Nr);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->eK;
 
@@ -1167,6 +1310,13 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#ifdef HAVE_AES_NI
+    if (aes_ni_enabled) {
+        aes_ni_decrypt(ct, pt, skey->ni_dK, skey->Nr);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->dK;
 
@@ -1264,3 +1414,46 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
         rk[3];
     STORE32H(s3, pt+12);
 }
+
+void aes_cbc_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks,
+                     unsigned char *iv, aes_key *skey)
+{
+    unsigned char buf[16];
+    int i;
+
+#ifdef HAVE_AES_NI
+    if (aes_ni_enabled) {
+        for (; blocks; blocks--, pt += 16, ct += 16)
+            aes_ni_cbc_encrypt(pt, ct, iv, skey->ni_eK, skey->Nr);
+        return;
+    }
+#endif
+
+    for (; blocks; blocks--, pt += 16, ct += 16) {
+        for (i = 0; i < 16; i++) buf[i] = pt[i] ^ iv[i];
+        aes_ecb_encrypt(buf, ct, skey);
+        memcpy(iv, ct, 16);
+    }
+}
+
+void aes_cbc_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks,
+                     unsigned char *iv, aes_key *skey)
+{
+    unsigned char buf[16];
+    int i;
+
+#ifdef HAVE_AES_NI
+    if (aes_ni_enabled) {
+        for (; blocks >= 4; blocks -= 4, ct += 64, pt += 64)
+            aes_ni_cbc_decrypt4(ct, pt, iv, skey->ni_dK, skey->Nr);
+    }
+#endif
+
+    /* ct and pt may overlap, so save the chaining block before decrypting */
+    for (; blocks; blocks--, ct += 16, pt += 16) {
+        memcpy(buf, ct, 16);
+        aes_ecb_decrypt(ct, pt, skey);
+        for (i = 0; i < 16; i++) pt[i] ^= iv[i];
+        memcpy(iv, buf, 16);
+    }
+}
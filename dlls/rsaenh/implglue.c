@@ -27,6 +27,7 @@
 #include "wine/library.h"
 
 #include "windef.h"
+#include "winbase.h"
 #include "wincrypt.h"
 
 #include "implglue.h"
@@ -375,6 +376,42 @@ BOOL encrypt_block_impl(ALG_ID aiAlgid, DWORD dwKeySpec, KEY_CONTEXT *pKeyContex
     return TRUE;
 }
 
+BOOL encrypt_cbc_impl(ALG_ID aiAlgid, KEY_CONTEXT *pKeyContext, BYTE *pbData, DWORD dwLen,
+                      DWORD dwBlockLen, BYTE *pbChainVector, DWORD enc)
+{
+    BYTE in[16], out[16];
+    DWORD i, j;
+
+    switch (aiAlgid) {
+        case CALG_AES:
+        case CALG_AES_128:
+        case CALG_AES_192:
+        case CALG_AES_256:
+            if (enc) {
+                aes_cbc_encrypt(pbData, pbData, (dwLen + 15) / 16, pbChainVector, &pKeyContext->aes);
+            } else {
+                aes_cbc_decrypt(pbData, pbData, (dwLen + 15) / 16, pbChainVector, &pKeyContext->aes);
+            }
+            return TRUE;
+    }
+
+    for (i = 0; i < dwLen; i += dwBlockLen, pbData += dwBlockLen) {
+        if (enc) {
+            for (j = 0; j < dwBlockLen; j++) in[j] = pbData[j] ^ pbChainVector[j];
+            if (!encrypt_block_impl(aiAlgid, 0, pKeyContext, in, out, enc)) return FALSE;
+            memcpy(pbChainVector, out, dwBlockLen);
+        } else {
+            memcpy(in, pbData, dwBlockLen);
+            if (!encrypt_block_impl(aiAlgid, 0, pKeyContext, in, out, enc)) return FALSE;
+            for (j = 0; j < dwBlockLen; j++) out[j] ^= pbChainVector[j];
+            memcpy(pbChainVector, in, dwBlockLen);
+        }
+        memcpy(pbData, out, dwBlockLen);
+    }
+
+    return TRUE;
+}
+
 BOOL encrypt_stream_impl(ALG_ID aiAlgid, KEY_CONTEXT *pKeyContext, BYTE *stream, DWORD dwLen)
 {
     switch (aiAlgid) {
@@ -395,6 +432,50 @@ BOOL gen_rand_impl(BYTE *pbBuffer, DWORD dwLen)
     return SystemFunction036(pbBuffer, dwLen);
 }
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+static inline void do_cpuid(unsigned int ax, unsigned int cx, unsigned int *p)
+{
+#ifdef __i386__
+    __asm__("pushl %%ebx\n\t"
+            "cpuid\n\t"
+            "movl %%ebx, %%esi\n\t"
+            "popl %%ebx"
+            : "=a" (p[0]), "=S" (p[1]), "=c" (p[2]), "=d" (p[3])
+            :  "0" (ax), "2" (cx));
+#else
+    __asm__("push %%rbx\n\t"
+            "cpuid\n\t"
+            "movq %%rbx, %%rsi\n\t"
+            "pop %%rbx"
+            : "=a" (p[0]), "=S" (p[1]), "=c" (p[2]), "=d" (p[3])
+            :  "0" (ax), "2" (cx));
+#endif
+}
+#endif
+
+/* Enable the AES-NI and SHA-NI code paths when the CPU supports them */
+void init_cpu_features_impl(void)
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    unsigned int regs[4], max_level;
+
+    /* this also guarantees that cpuid is available */
+    if (!IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE)) return;
+
+    do_cpuid(0, 0, regs);
+    max_level = regs[0];
+    do_cpuid(1, 0, regs);
+    aes_ni_enabled = (regs[2] >> 25) & 1;
+
+    /* SHA-NI code also needs SSSE3 and SSE4.1 */
+    if (max_level >= 7 && (regs[2] & (1 << 9)) && (regs[2] & (1 << 19)))
+    {
+        do_cpuid(7, 0, regs);
+        sha256_ni_enabled = (regs[1] >> 29) & 1;
+    }
+#endif
+}
+
 BOOL export_public_key_impl(BYTE *pbDest, const KEY_CONTEXT *pKeyContext, DWORD dwKeyLen,DWORD *pdwPubExp)
 {
     mp_to_unsigned_bin(&pKeyContext->rsa.N, pbDest);
@@ -366,6 +366,7 @@ BOOL WINAPI DllMain(HINSTANCE hInstance, DWORD fdwReason, PVOID reserved)
             instance = hInstance;
             DisableThreadLibraryCalls(hInstance);
             init_handle_table(&handle_table);
+            init_cpu_features_impl();
             break;
 
         case DLL_PROCESS_DETACH:
@@ -2206,36 +2207,36 @@ BOOL WINAPI RSAENH_CPEncrypt(HCRYPTPROV hProv, HCRYPTKEY hKey, HCRYPTHASH hHash,
         for (i=*pdwDataLen; i<dwEncryptedLen; i++) pbData[i] = dwEncryptedLen - *pdwDataLen;
         *pdwDataLen = dwEncryptedLen;
 
-        for (i=0, in=pbData; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
-            switch (pCryptKey->dwMode) {
-                case CRYPT_MODE_ECB:
-                    encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
-                                       RSAENH_ENCRYPT);
-                    break;
-                
-                case CRYPT_MODE_CBC:
-                    for (j=0; j<pCryptKey->dwBlockLen; j++) in[j] ^= pCryptKey->abChainVector[j];
-                    encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
-                                       RSAENH_ENCRYPT);
-                    memcpy(pCryptKey->abChainVector, out, pCryptKey->dwBlockLen);
-                    break;
+        /* CBC is done on the whole buffer at once so that the cipher can
+         * use its bulk code path */
+        if (pCryptKey->dwMode == CRYPT_MODE_CBC) {
+            encrypt_cbc_impl(pCryptKey->aiAlgid, &pCryptKey->context, pbData, *pdwDataLen,
+                             pCryptKey->dwBlockLen, pCryptKey->abChainVector, RSAENH_ENCRYPT);
+        } else {
+            for (i=0, in=pbData; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
+                switch (pCryptKey->dwMode) {
+                    case CRYPT_MODE_ECB:
+                        encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
+                                           RSAENH_ENCRYPT);
+                        break;
 
-                case CRYPT_MODE_CFB:
-                    for (j=0; j<pCryptKey->dwBlockLen; j++) {
-                        encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, 
-                                           pCryptKey->abChainVector, o, RSAENH_ENCRYPT);
-                        out[j] = in[j] ^ o[0];
-                        for (k=0; k<pCryptKey->dwBlockLen-1; k++) 
-                            pCryptKey->abChainVector[k] = pCryptKey->abChainVector[k+1];
-                        pCryptKey->abChainVector[k] = out[j];
-                    }
-                    break;
+                    case CRYPT_MODE_CFB:
+                        for (j=0; j<pCryptKey->dwBlockLen; j++) {
+                            encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, 
+                                               pCryptKey->abChainVector, o, RSAENH_ENCRYPT);
+                            out[j] = in[j] ^ o[0];
+                            for (k=0; k<pCryptKey->dwBlockLen-1; k++) 
+                                pCryptKey->abChainVector[k] = pCryptKey->abChainVector[k+1];
+                            pCryptKey->abChainVector[k] = out[j];
+                        }
+                        break;
                     
-                default:
-                    SetLastError(NTE_BAD_ALGID);
-                    return FALSE;
+                    default:
+                        SetLastError(NTE_BAD_ALGID);
+                        return FALSE;
+                }
+                memcpy(in, out, pCryptKey->dwBlockLen); 
             }
-            memcpy(in, out, pCryptKey->dwBlockLen); 
         }
     } else if (GET_ALG_TYPE(pCryptKey->aiAlgid) == ALG_TYPE_STREAM) {
         if (pbData == NULL) {
@@ -2335,36 +2336,34 @@ BOOL WINAPI RSAENH_CPDecrypt(HCRYPTPROV hProv, HCRYPTKEY hKey, HCRYPTHASH hHash,
     dwMax=*pdwDataLen;
 
     if (GET_ALG_TYPE(pCryptKey->aiAlgid) == ALG_TYPE_BLOCK) {
-        for (i=0, in=pbData; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
-            switch (pCryptKey->dwMode) {
-                case CRYPT_MODE_ECB:
-                    encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
-                                       RSAENH_DECRYPT);
-                    break;
-                
-                case CRYPT_MODE_CBC:
-                    encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
-                                       RSAENH_DECRYPT);
-                    for (j=0; j<pCryptKey->dwBlockLen; j++) out[j] ^= pCryptKey->abChainVector[j];
-                    memcpy(pCryptKey->abChainVector, in, pCryptKey->dwBlockLen);
-                    break;
+        if (pCryptKey->dwMode == CRYPT_MODE_CBC) {
+            encrypt_cbc_impl(pCryptKey->aiAlgid, &pCryptKey->context, pbData, *pdwDataLen,
+                             pCryptKey->dwBlockLen, pCryptKey->abChainVector, RSAENH_DECRYPT);
+        } else {
+            for (i=0, in=pbData; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
+                switch (pCryptKey->dwMode) {
+                    case CRYPT_MODE_ECB:
+                        encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
+                                           RSAENH_DECRYPT);
+                        break;
 
-                case CRYPT_MODE_CFB:
-                    for (j=0; j<pCryptKey->dwBlockLen; j++) {
-                        encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, 
-                                           pCryptKey->abChainVector, o, RSAENH_ENCRYPT);
-                        out[j] = in[j] ^ o[0];
-                        for (k=0; k<pCryptKey->dwBlockLen-1; k++) 
-                            pCryptKey->abChainVector[k] = pCryptKey->abChainVector[k+1];
-                        pCryptKey->abChainVector[k] = in[j];
-                    }
-                    break;
+                    case CRYPT_MODE_CFB:
+                        for (j=0; j<pCryptKey->dwBlockLen; j++) {
+                            encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, 
+                                               pCryptKey->abChainVector, o, RSAENH_ENCRYPT);
+                            out[j] = in[j] ^ o[0];
+                            for (k=0; k<pCryptKey->dwBlockLen-1; k++) 
+                                pCryptKey->abChainVector[k] = pCryptKey->abChainVector[k+1];
+                            pCryptKey->abChainVector[k] = in[j];
+                        }
+                        break;
                     
-                default:
-                    SetLastError(NTE_BAD_ALGID);
-                    return FALSE;
+                    default:
+                        SetLastError(NTE_BAD_ALGID);
+                        return FALSE;
+                }
+                memcpy(in, out, pCryptKey->dwBlockLen);
             }
-            memcpy(in, out, pCryptKey->dwBlockLen);
         }
         if (Final) {
             if (pbData[*pdwDataLen-1] &&
@@ -55,6 +55,7 @@
  *   #define SHA2_UNROLL_TRANSFORM
  *
  */
+#define SHA2_UNROLL_TRANSFORM
 
 /*** SHA-256/384/512 Various Length Definitions ***********************/
 /* NOTE: Most of these are in sha2.h */
@@ -456,6 +457,109 @@ void SHA256_Transform(SHA256_CTX* context, const sha2_word32* data) {
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+int sha256_ni_enabled = 0;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+
+/*
+ * SHA-256 using the Intel SHA extensions, selected at runtime through
+ * sha256_ni_enabled (which also requires SSSE3 and SSE4.1).  The state is
+ * kept as ABEF/CDGH in xmm1/xmm2, the message schedule in xmm3-xmm6, and
+ * each SHA256_NI_ROUNDS does four rounds.  Only xmm0-xmm7 are used so this
+ * also works on i386.
+ */
+#define HAVE_SHA_NI
+
+static const sha2_byte sha256_ni_shuffle[16] = {
+	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+};
+
+#define SHA256_NI_ROUNDS(msg,k) \
+	"movdqu " #k "*16(%[k]), %%xmm0\n\t" \
+	"paddd %%xmm" #msg ", %%xmm0\n\t" \
+	"sha256rnds2 %%xmm0, %%xmm1, %%xmm2\n\t" \
+	"pshufd $0x0e, %%xmm0, %%xmm0\n\t" \
+	"sha256rnds2 %%xmm0, %%xmm2, %%xmm1\n\t"
+
+#define SHA256_NI_MSG1(prev,cur) \
+	"sha256msg1 %%xmm" #cur ", %%xmm" #prev "\n\t"
+
+#define SHA256_NI_MSG2(prev,cur,next) \
+	"movdqa %%xmm" #cur ", %%xmm7\n\t" \
+	"palignr $4, %%xmm" #prev ", %%xmm7\n\t" \
+	"paddd %%xmm7, %%xmm" #next "\n\t" \
+	"sha256msg2 %%xmm" #cur ", %%xmm" #next "\n\t"
+
+#define SHA256_NI_LOAD(msg,n) \
+	"movdqu " #n "*16(%[data]), %%xmm" #msg "\n\t" \
+	"pshufb %%xmm7, %%xmm" #msg "\n\t"
+
+static void SHA256_Transform_ni(sha2_word32* state, const sha2_byte* data, size_t blocks) {
+	sha2_byte	abef[16], cdgh[16];
+
+	__asm__ __volatile__(
+		"movdqu (%[state]), %%xmm7\n\t"
+		"movdqu 16(%[state]), %%xmm2\n\t"
+		"pshufd $0xb1, %%xmm7, %%xmm7\n\t"
+		"pshufd $0x1b, %%xmm2, %%xmm2\n\t"
+		"movdqa %%xmm7, %%xmm1\n\t"
+		"palignr $8, %%xmm2, %%xmm1\n\t"
+		"pblendw $0xf0, %%xmm7, %%xmm2\n"
+		"1:\tmovdqu %%xmm1, %[abef]\n\t"
+		"movdqu %%xmm2, %[cdgh]\n\t"
+		"movdqu %[shuffle], %%xmm7\n\t"
+		SHA256_NI_LOAD(3,0)
+		SHA256_NI_LOAD(4,1)
+		SHA256_NI_LOAD(5,2)
+		SHA256_NI_LOAD(6,3)
+		SHA256_NI_ROUNDS(3,0)
+		SHA256_NI_ROUNDS(4,1)  SHA256_NI_MSG1(3,4)
+		SHA256_NI_ROUNDS(5,2)  SHA256_NI_MSG1(4,5)
+		SHA256_NI_ROUNDS(6,3)  SHA256_NI_MSG2(5,6,3) SHA256_NI_MSG1(5,6)
+		SHA256_NI_ROUNDS(3,4)  SHA256_NI_MSG2(6,3,4) SHA256_NI_MSG1(6,3)
+		SHA256_NI_ROUNDS(4,5)  SHA256_NI_MSG2(3,4,5) SHA256_NI_MSG1(3,4)
+		SHA256_NI_ROUNDS(5,6)  SHA256_NI_MSG2(4,5,6) SHA256_NI_MSG1(4,5)
+		SHA256_NI_ROUNDS(6,7)  SHA256_NI_MSG2(5,6,3) SHA256_NI_MSG1(5,6)
+		SHA256_NI_ROUNDS(3,8)  SHA256_NI_MSG2(6,3,4) SHA256_NI_MSG1(6,3)
+		SHA256_NI_ROUNDS(4,9)  SHA256_NI_MSG2(3,4,5) SHA256_NI_MSG1(3,4)
+		SHA256_NI_ROUNDS(5,10) SHA256_NI_MSG2(4,5,6) SHA256_NI_MSG1(4,5)
+		SHA256_NI_ROUNDS(6,11) SHA256_NI_MSG2(5,6,3) SHA256_NI_MSG1(5,6)
+		SHA256_NI_ROUNDS(3,12) SHA256_NI_MSG2(6,3,4) SHA256_NI_MSG1(6,3)
+		SHA256_NI_ROUNDS(4,13) SHA256_NI_MSG2(3,4,5)
+		SHA256_NI_ROUNDS(5,14) SHA256_NI_MSG2(4,5,6)
+		SHA256_NI_ROUNDS(6,15)
+		"movdqu %[abef], %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm1\n\t"
+		"movdqu %[cdgh], %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm2\n\t"
+		"add $64, %[data]\n\t"
+		"dec %[blocks]\n\t"
+		"jnz 1b\n\t"
+		"pshufd $0x1b, %%xmm1, %%xmm7\n\t"
+		"pshufd $0xb1, %%xmm2, %%xmm2\n\t"
+		"movdqa %%xmm7, %%xmm1\n\t"
+		"pblendw $0xf0, %%xmm2, %%xmm1\n\t"
+		"palignr $8, %%xmm7, %%xmm2\n\t"
+		"movdqu %%xmm1, (%[state])\n\t"
+		"movdqu %%xmm2, 16(%[state])\n\t"
+		: [data] "+r" (data), [blocks] "+r" (blocks), [abef] "=m" (abef), [cdgh] "=m" (cdgh)
+		: [state] "r" (state), [k] "r" (K256), [shuffle] "m" (sha256_ni_shuffle)
+		: "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", "memory", "cc");
+}
+
+#endif
+
+static void SHA256_Transform_blocks(SHA256_CTX* context, const sha2_byte* data, size_t blocks) {
+#ifdef HAVE_SHA_NI
+	if (sha256_ni_enabled) {
+		SHA256_Transform_ni(context->state, data, blocks);
+		return;
+	}
+#endif
+	for (; blocks; blocks--, data += SHA256_BLOCK_LENGTH)
+		SHA256_Transform(context, (const sha2_word32*)data);
+}
+
 void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len) {
 	unsigned int	freespace, usedspace;
 
@@ -478,7 +582,7 @@ void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len) {
 			context->bitcount += freespace << 3;
 			len -= freespace;
 			data += freespace;
-			SHA256_Transform(context, (sha2_word32*)context->buffer);
+			SHA256_Transform_blocks(context, context->buffer, 1);
 		} else {
 			/* The buffer is not yet full */
 			MEMCPY_BCOPY(&context->buffer[usedspace], data, len);
@@ -488,12 +592,14 @@ void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len) {
 			return;
 		}
 	}
-	while (len >= SHA256_BLOCK_LENGTH) {
+	if (len >= SHA256_BLOCK_LENGTH) {
 		/* Process as many complete blocks as we can */
-		SHA256_Transform(context, (const sha2_word32*)data);
-		context->bitcount += SHA256_BLOCK_LENGTH << 3;
-		len -= SHA256_BLOCK_LENGTH;
-		data += SHA256_BLOCK_LENGTH;
+		size_t	blocks = len / SHA256_BLOCK_LENGTH;
+
+		SHA256_Transform_blocks(context, data, blocks);
+		context->bitcount += (sha2_word64)(blocks * SHA256_BLOCK_LENGTH) << 3;
+		len -= blocks * SHA256_BLOCK_LENGTH;
+		data += blocks * SHA256_BLOCK_LENGTH;
 	}
 	if (len > 0) {
 		/* There's left-overs, so save 'em */
@@ -530,7 +636,7 @@ void SHA256_Final(sha2_byte digest[], SHA256_CTX* context) {
 					MEMSET_BZERO(&context->buffer[usedspace], SHA256_BLOCK_LENGTH - usedspace);
 				}
 				/* Do second-to-last transform: */
-				SHA256_Transform(context, (sha2_word32*)context->buffer);
+				SHA256_Transform_blocks(context, context->buffer, 1);
 
 				/* And set-up for the last transform: */
 				MEMSET_BZERO(context->buffer, SHA256_SHORT_BLOCK_LENGTH);
@@ -546,7 +652,7 @@ void SHA256_Final(sha2_byte digest[], SHA256_CTX* context) {
 		*(sha2_word64*)&context->buffer[SHA256_SHORT_BLOCK_LENGTH] = context->bitcount;
 
 		/* Final transform: */
-		SHA256_Transform(context, (sha2_word32*)context->buffer);
+		SHA256_Transform_blocks(context, context->buffer, 1);
 
 #ifndef WORDS_BIGENDIAN
 		{
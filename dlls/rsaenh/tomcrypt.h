@@ -131,6 +131,7 @@ typedef struct tag_des3_key {
 
 typedef struct tag_aes_key {
    ulong32 eK[64], dK[64];
+   unsigned char ni_eK[240], ni_dK[240]; /* round keys in memory order for AES-NI */
    int Nr;
 } aes_key;
 
@@ -149,6 +150,11 @@ void des3_ecb_decrypt(const unsigned char *ct, unsigned char *pt, const des3_key
 int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey);
 void aes_ecb_encrypt(const unsigned char *pt, unsigned char *ct, aes_key *skey);
 void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey);
+void aes_cbc_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks,
+                     unsigned char *iv, aes_key *skey);
+void aes_cbc_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks,
+                     unsigned char *iv, aes_key *skey);
+extern int aes_ni_enabled;
 
 typedef struct tag_md2_state {
     unsigned char chksum[16], X[48], buf[16];
@@ -20,91 +20,1182 @@
  */
 
 #include "config.h"
+#include "wine/port.h"
 
 #include <stdarg.h>
 
 #include "windef.h"
 #include "winbase.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(vcomp);
 
-int CDECL omp_get_dynamic(void)
+typedef CRITICAL_SECTION *omp_lock_t;
+typedef CRITICAL_SECTION *omp_nest_lock_t;
+
+#define VCOMP_DYNAMIC_FLAGS_STATIC      0x01
+#define VCOMP_DYNAMIC_FLAGS_CHUNKED     0x02
+#define VCOMP_DYNAMIC_FLAGS_GUIDED      0x03
+#define VCOMP_DYNAMIC_FLAGS_INCREMENT   0x40
+
+#define VCOMP_REDUCTION_FLAGS_ADD       0x100
+#define VCOMP_REDUCTION_FLAGS_MUL       0x200
+#define VCOMP_REDUCTION_FLAGS_AND       0x300
+#define VCOMP_REDUCTION_FLAGS_OR        0x400
+#define VCOMP_REDUCTION_FLAGS_XOR       0x500
+#define VCOMP_REDUCTION_FLAGS_BOOL_AND  0x600
+#define VCOMP_REDUCTION_FLAGS_BOOL_OR   0x700
+#define VCOMP_REDUCTION_FLAGS_MASK      0xf00
+
+/* number of polls before a thread waiting for the rest of its team goes to sleep */
+#define VCOMP_SPIN_COUNT                4000
+
+/* idle worker threads exit after this many milliseconds */
+#define VCOMP_IDLE_TIMEOUT              5000
+
+static HMODULE vcomp_module;
+static DWORD   vcomp_context_tls = TLS_OUT_OF_INDEXES;
+static int     vcomp_max_threads;
+static int     vcomp_num_procs;
+static BOOL    vcomp_nested_fork = FALSE;
+static int     vcomp_spin_count;
+
+/* idle threads of the pool, protected by vcomp_section */
+static struct list vcomp_idle_threads = LIST_INIT(vcomp_idle_threads);
+
+static CRITICAL_SECTION vcomp_section;
+static CRITICAL_SECTION_DEBUG critsect_debug =
 {
-    TRACE("stub\n");
-    return 0;
+    0, 0, &vcomp_section,
+    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": vcomp_section") }
+};
+static CRITICAL_SECTION vcomp_section = { &critsect_debug, -1, 0, 0, 0, 0 };
+
+struct vcomp_thread_data
+{
+    struct vcomp_team_data  *team;
+    struct vcomp_task_data  *task;
+    int                     thread_num;
+    BOOL                    parallel;
+    int                     fork_threads;
+
+    /* pool threads */
+    BOOL                    worker;
+    HANDLE                  wake_event;
+    struct list             entry;
+
+    /* events of the teams forked by this thread */
+    HANDLE                  finished_event;
+    HANDLE                  barrier_events[2];
+
+    /* single */
+    unsigned int            single;
+
+    /* section */
+    unsigned int            section;
+
+    /* dynamic */
+    unsigned int            dynamic;
+    unsigned int            dynamic_type;
+    unsigned int            dynamic_begin;
+    unsigned int            dynamic_end;
+};
+
+struct vcomp_team_data
+{
+    int                     num_threads;
+    LONG                    running_threads;
+    HANDLE                  finished_event;
+
+    /* callback arguments */
+    int                     nargs;
+    void                    *wrapper;
+    __ms_va_list            valist;
+
+    /* barrier */
+    LONG volatile           barrier;
+    LONG                    barrier_count;
+    LONG                    barrier_sleepers[2];
+    BOOL                    barrier_signaled[2];
+    HANDLE                  barrier_events[2];
+};
+
+struct vcomp_task_data
+{
+    /* single */
+    unsigned int            single;
+
+    /* section */
+    unsigned int            section;
+    int                     num_sections;
+    int                     section_index;
+
+    /* dynamic */
+    unsigned int            dynamic;
+    unsigned int            dynamic_first;
+    unsigned int            dynamic_last;
+    unsigned int            dynamic_iterations;
+    int                     dynamic_step;
+    unsigned int            dynamic_chunksize;
+};
+
+#if defined(__i386__)
+
+extern void CDECL _vcomp_fork_call_wrapper(void *wrapper, int nargs, __ms_va_list args);
+__ASM_GLOBAL_FUNC( _vcomp_fork_call_wrapper,
+                   "pushl %ebp\n\t"
+                   __ASM_CFI(".cfi_adjust_cfa_offset 4\n\t")
+                   __ASM_CFI(".cfi_rel_offset %ebp,0\n\t")
+                   "movl %esp,%ebp\n\t"
+                   __ASM_CFI(".cfi_def_cfa_register %ebp\n\t")
+                   "pushl %esi\n\t"
+                   __ASM_CFI(".cfi_rel_offset %esi,-4\n\t")
+                   "pushl %edi\n\t"
+                   __ASM_CFI(".cfi_rel_offset %edi,-8\n\t")
+                   "movl 12(%ebp),%edx\n\t"
+                   "movl %esp,%edi\n\t"
+                   "shll $2,%edx\n\t"
+                   "jz 1f\n\t"
+                   "subl %edx,%edi\n\t"
+                   "andl $~15,%edi\n\t"
+                   "movl %edi,%esp\n\t"
+                   "movl 12(%ebp),%ecx\n\t"
+                   "movl 16(%ebp),%esi\n\t"
+                   "cld\n\t"
+                   "rep; movsl\n"
+                   "1:\tcall *8(%ebp)\n\t"
+                   "leal -8(%ebp),%esp\n\t"
+                   "popl %edi\n\t"
+                   __ASM_CFI(".cfi_same_value %edi\n\t")
+                   "popl %esi\n\t"
+                   __ASM_CFI(".cfi_same_value %esi\n\t")
+                   "popl %ebp\n\t"
+                   __ASM_CFI(".cfi_def_cfa %esp,4\n\t")
+                   __ASM_CFI(".cfi_same_value %ebp\n\t")
+                   "ret" )
+
+#elif defined(__x86_64__)
+
+extern void CDECL _vcomp_fork_call_wrapper(void *wrapper, int nargs, __ms_va_list args);
+__ASM_GLOBAL_FUNC( _vcomp_fork_call_wrapper,
+                   "pushq %rbp\n\t"
+                   __ASM_CFI(".cfi_adjust_cfa_offset 8\n\t")
+                   __ASM_CFI(".cfi_rel_offset %rbp,0\n\t")
+                   "movq %rsp,%rbp\n\t"
+                   __ASM_CFI(".cfi_def_cfa_register %rbp\n\t")
+                   "pushq %rsi\n\t"
+                   __ASM_CFI(".cfi_rel_offset %rsi,-8\n\t")
+                   "pushq %rdi\n\t"
+                   __ASM_CFI(".cfi_rel_offset %rdi,-16\n\t")
+                   "movq %rcx,%rax\n\t"
+                   "movslq %edx,%rdx\n\t"
+                   "movq $4,%rcx\n\t"
+                   "cmp %rcx,%rdx\n\t"
+                   "cmovgq %rdx,%rcx\n\t"
+                   "leaq 0(,%rcx,8),%rdx\n\t"
+                   "subq %rdx,%rsp\n\t"
+                   "andq $~15,%rsp\n\t"
+                   "movq %rsp,%rdi\n\t"
+                   "movq %r8,%rsi\n\t"
+                   "rep; movsq\n\t"
+                   "movq 0(%rsp),%rcx\n\t"
+                   "movq 8(%rsp),%rdx\n\t"
+                   "movq 16(%rsp),%r8\n\t"
+                   "movq 24(%rsp),%r9\n\t"
+                   "callq *%rax\n\t"
+                   "leaq -16(%rbp),%rsp\n\t"
+                   "popq %rdi\n\t"
+                   __ASM_CFI(".cfi_same_value %rdi\n\t")
+                   "popq %rsi\n\t"
+                   __ASM_CFI(".cfi_same_value %rsi\n\t")
+                   __ASM_CFI(".cfi_def_cfa_register %rsp\n\t")
+                   "popq %rbp\n\t"
+                   __ASM_CFI(".cfi_adjust_cfa_offset -8\n\t")
+                   __ASM_CFI(".cfi_same_value %rbp\n\t")
+                   "ret")
+
+#else
+
+static void CDECL _vcomp_fork_call_wrapper(void *wrapper, int nargs, __ms_va_list args)
+{
+    ERR("Not implemented for this architecture\n");
 }
 
-int CDECL omp_get_max_threads(void)
+#endif
+
+static inline struct vcomp_thread_data *vcomp_get_thread_data(void)
 {
-    TRACE("stub\n");
-    return 1;
+    return (struct vcomp_thread_data *)TlsGetValue(vcomp_context_tls);
 }
 
-int CDECL omp_get_nested(void)
+static inline void vcomp_set_thread_data(struct vcomp_thread_data *thread_data)
 {
-    TRACE("stub\n");
-    return 0;
+    TlsSetValue(vcomp_context_tls, thread_data);
 }
 
-int CDECL omp_get_num_procs(void)
+/* returns the data of the current thread, creating the implicit task of
+ * threads which are not part of any team */
+static struct vcomp_thread_data *vcomp_init_thread_data(void)
 {
-    TRACE("stub\n");
-    return 1;
+    struct vcomp_thread_data *thread_data = vcomp_get_thread_data();
+    struct
+    {
+        struct vcomp_thread_data thread;
+        struct vcomp_task_data   task;
+    } *data;
+
+    if (thread_data) return thread_data;
+    if (!(data = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*data))))
+    {
+        ERR("could not create thread data\n");
+        ExitProcess(1);
+    }
+
+    thread_data = &data->thread;
+    thread_data->task = &data->task;
+    vcomp_set_thread_data(thread_data);
+    return thread_data;
 }
 
-int CDECL omp_get_num_threads(void)
+/* closes the events created by vcomp_init_team_events */
+static void vcomp_free_team_events(struct vcomp_thread_data *thread_data)
 {
-    TRACE("stub\n");
-    return 1;
+    if (thread_data->finished_event) CloseHandle(thread_data->finished_event);
+    if (thread_data->barrier_events[0]) CloseHandle(thread_data->barrier_events[0]);
+    if (thread_data->barrier_events[1]) CloseHandle(thread_data->barrier_events[1]);
 }
 
-int CDECL omp_get_thread_num(void)
+static void vcomp_free_thread_data(void)
 {
-    TRACE("stub\n");
-    return 0;
+    struct vcomp_thread_data *thread_data = vcomp_get_thread_data();
+
+    if (!thread_data || thread_data->worker) return;
+
+    vcomp_free_team_events(thread_data);
+    HeapFree(GetProcessHeap(), 0, thread_data);
+    vcomp_set_thread_data(NULL);
 }
 
-/* Time in seconds since "some time in the past" */
-double CDECL omp_get_wtime(void)
+static void vcomp_join_thread(struct vcomp_thread_data *thread_data, struct vcomp_team_data *team_data,
+                              struct vcomp_task_data *task_data, int thread_num)
 {
-    return GetTickCount() / 1000.0;
+    thread_data->team           = team_data;
+    thread_data->task           = task_data;
+    thread_data->thread_num     = thread_num;
+    thread_data->parallel       = TRUE;
+    thread_data->fork_threads   = 0;
+    thread_data->single         = 0;
+    thread_data->section        = 0;
+    thread_data->dynamic        = 0;
+    thread_data->dynamic_type   = 0;
 }
 
-void CDECL omp_set_dynamic(int val)
+static DWORD WINAPI _vcomp_fork_worker(void *param)
 {
-    TRACE("(%d): stub\n", val);
+    struct vcomp_thread_data *thread_data = param;
+    struct vcomp_team_data *team_data;
+
+    TRACE("starting worker thread %p\n", thread_data);
+
+    vcomp_set_thread_data(thread_data);
+
+    for (;;)
+    {
+        if (WaitForSingleObject(thread_data->wake_event, VCOMP_IDLE_TIMEOUT) == WAIT_TIMEOUT)
+        {
+            BOOL exit_thread;
+
+            EnterCriticalSection(&vcomp_section);
+            if ((exit_thread = !thread_data->team))
+                list_remove(&thread_data->entry);
+            LeaveCriticalSection(&vcomp_section);
+
+            /* if a team picked us up in the meantime the event is signaled */
+            if (exit_thread) break;
+            continue;
+        }
+
+        team_data = thread_data->team;
+        _vcomp_fork_call_wrapper(team_data->wrapper, team_data->nargs, team_data->valist);
+
+        /* the thread may be reused by another team as soon as it is back in
+         * the list, so the team data must only be accessed through the local
+         * pointer from here on */
+        EnterCriticalSection(&vcomp_section);
+        thread_data->team = NULL;
+        thread_data->task = NULL;
+        thread_data->parallel = FALSE;
+        list_add_head(&vcomp_idle_threads, &thread_data->entry);
+        LeaveCriticalSection(&vcomp_section);
+
+        if (!InterlockedDecrement(&team_data->running_threads))
+            SetEvent(team_data->finished_event);
+    }
+
+    TRACE("terminating worker thread %p\n", thread_data);
+
+    vcomp_set_thread_data(NULL);
+    vcomp_free_team_events(thread_data);
+    CloseHandle(thread_data->wake_event);
+    HeapFree(GetProcessHeap(), 0, thread_data);
+    FreeLibraryAndExitThread(vcomp_module, 0);
+    return 0;
 }
 
-void CDECL omp_set_nested(int nested)
+static struct vcomp_thread_data *vcomp_create_worker(void)
+{
+    struct vcomp_thread_data *thread_data;
+    HMODULE module;
+    HANDLE thread;
+
+    if (!(thread_data = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*thread_data))))
+        return NULL;
+
+    thread_data->worker = TRUE;
+    if (!(thread_data->wake_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        goto error;
+
+    /* the thread keeps a reference to the module until it exits */
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (const WCHAR *)vcomp_module, &module))
+        goto error;
+
+    if (!(thread = CreateThread(NULL, 0, _vcomp_fork_worker, thread_data, 0, NULL)))
+    {
+        FreeLibrary(module);
+        goto error;
+    }
+
+    CloseHandle(thread);
+    return thread_data;
+
+error:
+    ERR("could not create worker thread\n");
+    if (thread_data->wake_event) CloseHandle(thread_data->wake_event);
+    HeapFree(GetProcessHeap(), 0, thread_data);
+    return NULL;
+}
+
+/* creates the events used by the teams forked from the given thread */
+static BOOL vcomp_init_team_events(struct vcomp_thread_data *thread_data)
 {
-    TRACE("(%d): stub\n", nested);
+    if (!thread_data->finished_event &&
+        !(thread_data->finished_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        return FALSE;
+    if (!thread_data->barrier_events[0] &&
+        !(thread_data->barrier_events[0] = CreateEventW(NULL, TRUE, FALSE, NULL)))
+        return FALSE;
+    if (!thread_data->barrier_events[1] &&
+        !(thread_data->barrier_events[1] = CreateEventW(NULL, TRUE, FALSE, NULL)))
+        return FALSE;
+    return TRUE;
 }
 
-void CDECL omp_set_num_threads(int num_threads)
+void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
 {
-    TRACE("(%d): stub\n", num_threads);
+    struct vcomp_thread_data *prev_thread_data = vcomp_init_thread_data();
+    struct vcomp_thread_data thread_data, *data, *next;
+    struct vcomp_team_data team_data;
+    struct vcomp_task_data task_data;
+    struct list team_threads = LIST_INIT(team_threads);
+    int num_threads, i;
+
+    TRACE("(%d, %d, %p, ...)\n", ifval, nargs, wrapper);
+
+    if (prev_thread_data->parallel && !vcomp_nested_fork)
+        ifval = FALSE;
+
+    if (!ifval)
+        num_threads = 1;
+    else if (prev_thread_data->fork_threads)
+        num_threads = prev_thread_data->fork_threads;
+    else
+        num_threads = vcomp_max_threads;
+    prev_thread_data->fork_threads = 0;
+
+    team_data.num_threads           = 1;
+    team_data.running_threads       = 1;
+    team_data.finished_event        = prev_thread_data->finished_event;
+    team_data.nargs                 = nargs;
+    team_data.wrapper               = wrapper;
+    team_data.barrier               = 0;
+    team_data.barrier_count         = 0;
+    for (i = 0; i < 2; i++)
+    {
+        team_data.barrier_sleepers[i] = 0;
+        team_data.barrier_signaled[i] = FALSE;
+        team_data.barrier_events[i]   = prev_thread_data->barrier_events[i];
+    }
+    __ms_va_start(team_data.valist, wrapper);
+
+    task_data.single                = 0;
+    task_data.section               = 0;
+    task_data.num_sections          = 0;
+    task_data.section_index         = 0;
+    task_data.dynamic               = 0;
+    task_data.dynamic_iterations    = 0;
+
+    memset(&thread_data, 0, sizeof(thread_data));
+    vcomp_join_thread(&thread_data, &team_data, &task_data, 0);
+    thread_data.parallel = ifval || prev_thread_data->parallel;
+
+    if (num_threads > 1 && vcomp_init_team_events(prev_thread_data))
+    {
+        team_data.finished_event    = prev_thread_data->finished_event;
+        team_data.barrier_events[0] = prev_thread_data->barrier_events[0];
+        team_data.barrier_events[1] = prev_thread_data->barrier_events[1];
+
+        EnterCriticalSection(&vcomp_section);
+        while (team_data.num_threads < num_threads && !list_empty(&vcomp_idle_threads))
+        {
+            data = LIST_ENTRY(list_head(&vcomp_idle_threads), struct vcomp_thread_data, entry);
+            list_remove(&data->entry);
+            vcomp_join_thread(data, &team_data, &task_data, team_data.num_threads++);
+            list_add_tail(&team_threads, &data->entry);
+        }
+        LeaveCriticalSection(&vcomp_section);
+
+        while (team_data.num_threads < num_threads)
+        {
+            if (!(data = vcomp_create_worker())) break;
+            vcomp_join_thread(data, &team_data, &task_data, team_data.num_threads++);
+            list_add_tail(&team_threads, &data->entry);
+        }
+
+        /* the team is complete, start the workers */
+        team_data.running_threads = team_data.num_threads;
+        LIST_FOR_EACH_ENTRY_SAFE(data, next, &team_threads, struct vcomp_thread_data, entry)
+        {
+            list_remove(&data->entry);
+            SetEvent(data->wake_event);
+        }
+    }
+
+    vcomp_set_thread_data(&thread_data);
+    _vcomp_fork_call_wrapper(wrapper, nargs, team_data.valist);
+    vcomp_set_thread_data(prev_thread_data);
+
+    /* events of teams nested in this one */
+    vcomp_free_team_events(&thread_data);
+
+    if (team_data.num_threads > 1)
+    {
+        if (InterlockedDecrement(&team_data.running_threads))
+            WaitForSingleObject(team_data.finished_event, INFINITE);
+
+        for (i = 0; i < 2; i++)
+            if (team_data.barrier_signaled[i]) ResetEvent(team_data.barrier_events[i]);
+    }
+
+    __ms_va_end(team_data.valist);
 }
 
+/* The threads of a team first spin on the barrier generation, so that short
+ * work items don't have to go through the server. Threads which have to wait
+ * longer register as sleepers and block on the event of the generation, which
+ * the last thread only signals if somebody is sleeping. */
 void CDECL _vcomp_barrier(void)
 {
-    TRACE("stub\n");
+    struct vcomp_team_data *team_data = vcomp_init_thread_data()->team;
+    LONG generation;
+    int i, parity;
+
+    TRACE("()\n");
+
+    if (!team_data || team_data->num_threads == 1)
+        return;
+
+    generation = team_data->barrier;
+    parity = generation & 1;
+
+    if (InterlockedIncrement(&team_data->barrier_count) == team_data->num_threads)
+    {
+        /* last thread to arrive, prepare the next generation and release the others */
+        team_data->barrier_count = 0;
+        team_data->barrier_sleepers[!parity] = 0;
+        if (team_data->barrier_signaled[!parity])
+        {
+            ResetEvent(team_data->barrier_events[!parity]);
+            team_data->barrier_signaled[!parity] = FALSE;
+        }
+        InterlockedIncrement(&team_data->barrier);
+        if (InterlockedCompareExchange(&team_data->barrier_sleepers[parity], 0, 0))
+        {
+            team_data->barrier_signaled[parity] = TRUE;
+            SetEvent(team_data->barrier_events[parity]);
+        }
+        return;
+    }
+
+    for (i = 0; i < vcomp_spin_count; i++)
+        if (team_data->barrier != generation) return;
+
+    InterlockedIncrement(&team_data->barrier_sleepers[parity]);
+    if (team_data->barrier == generation)
+        WaitForSingleObject(team_data->barrier_events[parity], INFINITE);
 }
 
 void CDECL _vcomp_set_num_threads(int num_threads)
 {
-    TRACE("(%d): stub\n", num_threads);
+    TRACE("(%d)\n", num_threads);
+
+    if (num_threads >= 1)
+        vcomp_init_thread_data()->fork_threads = num_threads;
+}
+
+int CDECL _vcomp_get_thread_num(void)
+{
+    TRACE("()\n");
+    return vcomp_init_thread_data()->thread_num;
+}
+
+int CDECL _vcomp_master_begin(void)
+{
+    TRACE("()\n");
+    return !vcomp_init_thread_data()->thread_num;
+}
+
+void CDECL _vcomp_master_end(void)
+{
+    TRACE("()\n");
+    /* nothing to do here */
 }
 
 int CDECL _vcomp_single_begin(int flags)
 {
-    TRACE("(%x): stub\n", flags);
-    return TRUE;
+    struct vcomp_thread_data *thread_data = vcomp_init_thread_data();
+    struct vcomp_task_data *task_data = thread_data->task;
+    int ret = FALSE;
+
+    TRACE("(%x)\n", flags);
+
+    EnterCriticalSection(&vcomp_section);
+    thread_data->single++;
+    if ((int)(thread_data->single - task_data->single) > 0)
+    {
+        task_data->single = thread_data->single;
+        ret = TRUE;
+    }
+    LeaveCriticalSection(&vcomp_section);
+
+    return ret;
 }
 
 void CDECL _vcomp_single_end(void)
+{
+    TRACE("()\n");
+    /* nothing to do here */
+}
+
+void CDECL _vcomp_sections_init(int n)
+{
+    struct vcomp_thread_data *thread_data = vcomp_init_thread_data();
+    struct vcomp_task_data *task_data = thread_data->task;
+
+    TRACE("(%d)\n", n);
+
+    EnterCriticalSection(&vcomp_section);
+    thread_data->section++;
+    if ((int)(thread_data->section - task_data->section) > 0)
+    {
+        task_data->section       = thread_data->section;
+        task_data->num_sections  = n;
+        task_data->section_index = 0;
+    }
+    LeaveCriticalSection(&vcomp_section);
+}
+
+int CDECL _vcomp_sections_next(void)
+{
+    struct vcomp_thread_data *thread_data = vcomp_init_thread_data();
+    struct vcomp_task_data *task_data = thread_data->task;
+    int i = -1;
+
+    TRACE("()\n");
+
+    EnterCriticalSection(&vcomp_section);
+    if (thread_data->section == task_data->section &&
+        task_data->section_index != task_data->num_sections)
+    {
+        i = task_data->section_index++;
+    }
+    LeaveCriticalSection(&vcomp_section);
+    return i;
+}
+
+void CDECL _vcomp_for_static_simple_init(unsigned int first, unsigned int last, int step,
+                                         BOOL increment, unsigned int *begin, unsigned int *end)
+{
+    struct vcomp_thread_data *thread_data = vcomp_init_thread_data();
+    struct vcomp_team_data *team_data = thread_data->team;
+    int num_threads = team_data ? team_data->num_threads : 1;
+    int thread_num = thread_data->thread_num;
+    unsigned int iterations, per_thread, remaining;
+
+    TRACE("(%u, %u, %d, %u, %p, %p)\n", first, last, step, increment, begin, end);
+
+    if (num_threads == 1)
+    {
+        *begin = first;
+        *end   = last;
+        return;
+    }
+
+    if (step <= 0)
+    {
+        *begin = 0;
+        *end   = increment ? -1 : 1;
+        return;
+    }
+
+    if (increment)
+        iterations = 1 + (last - first) / step;
+    else
+    {
+        iterations = 1 + (first - last) / step;
+        step *= -1;
+    }
+
+    per_thread = iterations / num_threads;
+    remaining  = iterations - per_thread * num_threads;
+
+    if (thread_num < remaining)
+        per_thread++;
+    else if (per_thread)
+        first += remaining * step;
+    else
+    {
+        /* no iterations left for this thread */
+        *begin = first;
+        *end   = first - step;
+        return;
+    }
+
+    *begin = first + per_thread * thread_num * step;
+    *end   = *begin + (per_thread - 1) * step;
+}
+
+void CDECL _vcomp_for_static_init(int first, int last, int step, int chunksize, unsigned int *loops,
+                                  int *begin, int *end, int *next, int *lastchunk)
+{
+    struct vcomp_thread_data *thread_data = vcomp_init_thread_data();
+    struct vcomp_team_data *team_data = thread_data->team;
+    int num_threads = team_data ? team_data->num_threads : 1;
+    int thread_num = thread_data->thread_num;
+    unsigned int iterations, num_chunks, per_thread, remaining;
+
+    TRACE("(%d, %d, %d, %d, %p, %p, %p, %p, %p)\n",
+          first, last, step, chunksize, loops, begin, end, next, lastchunk);
+
+    if (num_threads == 1 && chunksize != 1)
+    {
+        *loops      = 1;
+        *begin      = first;
+        *end        = last;
+        *next       = 0;
+        *lastchunk  = first;
+        return;
+    }
+
+    if (first == last)
+    {
+        *loops = !thread_num;
+        if (!thread_num)
+        {
+            *begin      = first;
+            *end        = last;
+            *next       = 0;
+            *lastchunk  = first;
+        }
+        return;
+    }
+
+    if (step <= 0)
+    {
+        *loops = 0;
+        return;
+    }
+
+    if (first < last)
+        iterations = 1 + (last - first) / step;
+    else
+    {
+        iterations = 1 + (first - last) / step;
+        step *= -1;
+    }
+
+    if (chunksize < 1)
+        chunksize = 1;
+
+    num_chunks  = ((ULONGLONG)iterations + chunksize - 1) / chunksize;
+    per_thread  = num_chunks / num_threads;
+    remaining   = num_chunks - per_thread * num_threads;
+
+    *loops      = per_thread + (thread_num < remaining);
+    *begin      = first + thread_num * chunksize * step;
+    *end        = *begin + (chunksize - 1) * step;
+    *next       = chunksize * num_threads * step;
+    *lastchunk  = first + (num_chunks - 1) * chunksize * step;
+}
+
+void CDECL _vcomp_for_static_end(void)
+{
+    TRACE("()\n");
+    /* nothing to do here */
+}
+
+void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsigned int last,
+                                   int step, unsigned int chunksize)
+{
+    struct vcomp_thread_data *thread_data = vcomp_init_thread_data();
+    struct vcomp_team_data *team_data = thread_data->team;
+    struct vcomp_task_data *task_data = thread_data->task;
+    int num_threads = team_data ? team_data->num_threads : 1;
+    int thread_num = thread_data->thread_num;
+    unsigned int type = flags & ~VCOMP_DYNAMIC_FLAGS_INCREMENT;
+    unsigned int iterations;
+
+    TRACE("(%u, %u, %u, %d, %u)\n", flags, first, last, step, chunksize);
+
+    if (step <= 0)
+        iterations = 0;
+    else if (flags & VCOMP_DYNAMIC_FLAGS_INCREMENT)
+        iterations = 1 + (last - first) / step;
+    else
+    {
+        iterations = 1 + (first - last) / step;
+        step *= -1;
+    }
+
+    if ((int)chunksize <= 0)
+        chunksize = 1;
+
+    if (type == VCOMP_DYNAMIC_FLAGS_STATIC)
+    {
+        unsigned int per_thread = iterations / num_threads;
+        unsigned int remaining  = iterations - per_thread * num_threads;
+
+        if (thread_num < remaining)
+            per_thread++;
+        else if (per_thread)
+            first += remaining * step;
+        else
+        {
+            thread_data->dynamic_type = 0;
+            return;
+        }
+
+        thread_data->dynamic_type   = VCOMP_DYNAMIC_FLAGS_STATIC;
+        thread_data->dynamic_begin  = first + per_thread * thread_num * step;
+        thread_data->dynamic_end    = thread_data->dynamic_begin + (per_thread - 1) * step;
+    }
+    else
+    {
+        if (type != VCOMP_DYNAMIC_FLAGS_CHUNKED && type != VCOMP_DYNAMIC_FLAGS_GUIDED)
+        {
+            FIXME("unsupported flags %u\n", flags);
+            type = VCOMP_DYNAMIC_FLAGS_GUIDED;
+        }
+
+        EnterCriticalSection(&vcomp_section);
+        thread_data->dynamic++;
+        thread_data->dynamic_type = type;
+        if ((int)(thread_data->dynamic - task_data->dynamic) > 0)
+        {
+            task_data->dynamic              = thread_data->dynamic;
+            task_data->dynamic_first        = first;
+            task_data->dynamic_last         = last;
+            task_data->dynamic_iterations   = iterations;
+            task_data->dynamic_step         = step;
+            task_data->dynamic_chunksize    = chunksize;
+        }
+        LeaveCriticalSection(&vcomp_section);
+    }
+}
+
+int CDECL _vcomp_for_dynamic_next(unsigned int *begin, unsigned int *end)
+{
+    struct vcomp_thread_data *thread_data = vcomp_init_thread_data();
+    struct vcomp_team_data *team_data = thread_data->team;
+    struct vcomp_task_data *task_data = thread_data->task;
+    int num_threads = team_data ? team_data->num_threads : 1;
+    unsigned int iterations = 0;
+
+    TRACE("(%p, %p)\n", begin, end);
+
+    if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_STATIC)
+    {
+        *begin = thread_data->dynamic_begin;
+        *end   = thread_data->dynamic_end;
+        thread_data->dynamic_type = 0;
+        return 1;
+    }
+
+    if (thread_data->dynamic_type != VCOMP_DYNAMIC_FLAGS_CHUNKED &&
+        thread_data->dynamic_type != VCOMP_DYNAMIC_FLAGS_GUIDED)
+        return 0;
+
+    EnterCriticalSection(&vcomp_section);
+    if (thread_data->dynamic == task_data->dynamic &&
+        task_data->dynamic_iterations != 0)
+    {
+        iterations = min(task_data->dynamic_iterations, task_data->dynamic_chunksize);
+        if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED &&
+            task_data->dynamic_iterations > num_threads * task_data->dynamic_chunksize)
+        {
+            iterations = (task_data->dynamic_iterations + num_threads - 1) / num_threads;
+        }
+        *begin = task_data->dynamic_first;
+        *end   = task_data->dynamic_first + (iterations - 1) * task_data->dynamic_step;
+        task_data->dynamic_iterations -= iterations;
+        task_data->dynamic_first      += iterations * task_data->dynamic_step;
+        if (!task_data->dynamic_iterations)
+            *end = task_data->dynamic_last;
+    }
+    LeaveCriticalSection(&vcomp_section);
+
+    if (!iterations) thread_data->dynamic_type = 0;
+    return iterations != 0;
+}
+
+void CDECL _vcomp_flush(void)
+{
+    static LONG dummy;
+
+    TRACE("()\n");
+    InterlockedExchange(&dummy, 0);
+}
+
+static CRITICAL_SECTION *alloc_critsect(void)
+{
+    CRITICAL_SECTION *critsect;
+
+    if (!(critsect = HeapAlloc(GetProcessHeap(), 0, sizeof(*critsect))))
+    {
+        ERR("could not allocate critical section\n");
+        ExitProcess(1);
+    }
+
+    InitializeCriticalSection(critsect);
+    critsect->DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": critsect");
+    return critsect;
+}
+
+static void destroy_critsect(CRITICAL_SECTION *critsect)
+{
+    if (!critsect) return;
+    critsect->DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(critsect);
+    HeapFree(GetProcessHeap(), 0, critsect);
+}
+
+static inline BOOL critsect_is_locked_by_current_thread(CRITICAL_SECTION *critsect)
+{
+    return critsect->OwningThread == ULongToHandle(GetCurrentThreadId());
+}
+
+void CDECL _vcomp_enter_critsect(CRITICAL_SECTION **critsect)
+{
+    TRACE("(%p)\n", critsect);
+
+    if (!*critsect)
+    {
+        CRITICAL_SECTION *new_critsect = alloc_critsect();
+        if (InterlockedCompareExchangePointer((void **)critsect, new_critsect, NULL) != NULL)
+            destroy_critsect(new_critsect);  /* someone beat us to it */
+    }
+
+    EnterCriticalSection(*critsect);
+}
+
+void CDECL _vcomp_leave_critsect(CRITICAL_SECTION *critsect)
+{
+    TRACE("(%p)\n", critsect);
+    LeaveCriticalSection(critsect);
+}
+
+void CDECL omp_init_lock(omp_lock_t *lock)
+{
+    TRACE("(%p)\n", lock);
+    *lock = alloc_critsect();
+}
+
+void CDECL omp_destroy_lock(omp_lock_t *lock)
+{
+    TRACE("(%p)\n", lock);
+    destroy_critsect(*lock);
+}
+
+void CDECL omp_set_lock(omp_lock_t *lock)
+{
+    TRACE("(%p)\n", lock);
+
+    if (critsect_is_locked_by_current_thread(*lock))
+    {
+        ERR("omp_set_lock called while holding lock %p\n", *lock);
+        ExitProcess(1);
+    }
+
+    EnterCriticalSection(*lock);
+}
+
+void CDECL omp_unset_lock(omp_lock_t *lock)
+{
+    TRACE("(%p)\n", lock);
+    LeaveCriticalSection(*lock);
+}
+
+int CDECL omp_test_lock(omp_lock_t *lock)
+{
+    TRACE("(%p)\n", lock);
+
+    if (critsect_is_locked_by_current_thread(*lock))
+        return 0;
+
+    return TryEnterCriticalSection(*lock);
+}
+
+void CDECL omp_init_nest_lock(omp_nest_lock_t *lock)
+{
+    TRACE("(%p)\n", lock);
+    *lock = alloc_critsect();
+}
+
+void CDECL omp_destroy_nest_lock(omp_nest_lock_t *lock)
+{
+    TRACE("(%p)\n", lock);
+    destroy_critsect(*lock);
+}
+
+void CDECL omp_set_nest_lock(omp_nest_lock_t *lock)
+{
+    TRACE("(%p)\n", lock);
+    EnterCriticalSection(*lock);
+}
+
+void CDECL omp_unset_nest_lock(omp_nest_lock_t *lock)
+{
+    TRACE("(%p)\n", lock);
+    LeaveCriticalSection(*lock);
+}
+
+int CDECL omp_test_nest_lock(omp_nest_lock_t *lock)
+{
+    TRACE("(%p)\n", lock);
+    return TryEnterCriticalSection(*lock) ? (*lock)->RecursionCount : 0;
+}
+
+/* compare and exchange of bytes and words, built on top of the compare and
+ * exchange of the containing aligned dword */
+static char interlocked_cmpxchg8(char *dest, char xchg, char compare)
+{
+    LONG *base = (LONG *)((ULONG_PTR)dest & ~(ULONG_PTR)3);
+    int shift = ((ULONG_PTR)dest & 3) * 8;
+    LONG mask = (LONG)(0xffu << shift), old;
+
+    for (;;)
+    {
+        old = *(LONG volatile *)base;
+        if ((char)(old >> shift) != compare) return (char)(old >> shift);
+        if (InterlockedCompareExchange(base, (old & ~mask) | (LONG)((unsigned char)xchg << shift), old) == old)
+            return compare;
+    }
+}
+
+static short interlocked_cmpxchg16(short *dest, short xchg, short compare)
+{
+    LONG *base = (LONG *)((ULONG_PTR)dest & ~(ULONG_PTR)3);
+    int shift = ((ULONG_PTR)dest & 2) * 8;
+    LONG mask = (LONG)(0xffffu << shift), old;
+
+    for (;;)
+    {
+        old = *(LONG volatile *)base;
+        if ((short)(old >> shift) != compare) return (short)(old >> shift);
+        if (InterlockedCompareExchange(base, (old & ~mask) | (LONG)((unsigned short)xchg << shift), old) == old)
+            return compare;
+    }
+}
+
+#define VCOMP_ATOMIC_FUNC(name, type, stype, cmpxchg, expr) \
+    void CDECL _vcomp_atomic_##name(type *dest, type val) \
+    { \
+        type old; \
+        do old = *(type volatile *)dest; \
+        while ((type)cmpxchg((stype *)dest, (stype)(expr), (stype)old) != old); \
+    }
+
+#define VCOMP_ATOMIC_FLOAT_FUNC(name, type, itype, cmpxchg, expr) \
+    void CDECL _vcomp_atomic_##name(type *dest, type val) \
+    { \
+        union { type f; itype i; } old, new; \
+        do { old.i = *(itype volatile *)dest; new.f = (expr); } \
+        while (cmpxchg((itype *)dest, new.i, old.i) != old.i); \
+    }
+
+#define VCOMP_ATOMIC_INT_FUNCS(suffix, type, utype, cmpxchg) \
+    VCOMP_ATOMIC_FUNC(add_##suffix,   type,  type, cmpxchg, old + val) \
+    VCOMP_ATOMIC_FUNC(sub_##suffix,   type,  type, cmpxchg, old - val) \
+    VCOMP_ATOMIC_FUNC(mul_##suffix,   type,  type, cmpxchg, old * val) \
+    VCOMP_ATOMIC_FUNC(div_##suffix,   type,  type, cmpxchg, old / val) \
+    VCOMP_ATOMIC_FUNC(and_##suffix,   type,  type, cmpxchg, old & val) \
+    VCOMP_ATOMIC_FUNC(or_##suffix,    type,  type, cmpxchg, old | val) \
+    VCOMP_ATOMIC_FUNC(xor_##suffix,   type,  type, cmpxchg, old ^ val) \
+    VCOMP_ATOMIC_FUNC(shl_##suffix,   type,  type, cmpxchg, old << val) \
+    VCOMP_ATOMIC_FUNC(shr_##suffix,   type,  type, cmpxchg, old >> val) \
+    VCOMP_ATOMIC_FUNC(div_u##suffix,  utype, type, cmpxchg, old / val) \
+    VCOMP_ATOMIC_FUNC(shr_u##suffix,  utype, type, cmpxchg, old >> val)
+
+VCOMP_ATOMIC_INT_FUNCS(i1, char,   unsigned char,  interlocked_cmpxchg8)
+VCOMP_ATOMIC_INT_FUNCS(i2, short,  unsigned short, interlocked_cmpxchg16)
+VCOMP_ATOMIC_INT_FUNCS(i4, int,    unsigned int,   interlocked_cmpxchg)
+VCOMP_ATOMIC_INT_FUNCS(i8, LONG64, ULONG64,        interlocked_cmpxchg64)
+
+VCOMP_ATOMIC_FLOAT_FUNC(add_r4, float,  int,    interlocked_cmpxchg, old.f + val)
+VCOMP_ATOMIC_FLOAT_FUNC(sub_r4, float,  int,    interlocked_cmpxchg, old.f - val)
+VCOMP_ATOMIC_FLOAT_FUNC(mul_r4, float,  int,    interlocked_cmpxchg, old.f * val)
+VCOMP_ATOMIC_FLOAT_FUNC(div_r4, float,  int,    interlocked_cmpxchg, old.f / val)
+VCOMP_ATOMIC_FLOAT_FUNC(add_r8, double, LONG64, interlocked_cmpxchg64, old.f + val)
+VCOMP_ATOMIC_FLOAT_FUNC(sub_r8, double, LONG64, interlocked_cmpxchg64, old.f - val)
+VCOMP_ATOMIC_FLOAT_FUNC(mul_r8, double, LONG64, interlocked_cmpxchg64, old.f * val)
+VCOMP_ATOMIC_FLOAT_FUNC(div_r8, double, LONG64, interlocked_cmpxchg64, old.f / val)
+
+/* the logical operations are only used by reductions */
+static VCOMP_ATOMIC_FUNC(bool_and_i1, char,   char,   interlocked_cmpxchg8,  old && val)
+static VCOMP_ATOMIC_FUNC(bool_or_i1,  char,   char,   interlocked_cmpxchg8,  old || val)
+static VCOMP_ATOMIC_FUNC(bool_and_i2, short,  short,  interlocked_cmpxchg16, old && val)
+static VCOMP_ATOMIC_FUNC(bool_or_i2,  short,  short,  interlocked_cmpxchg16, old || val)
+static VCOMP_ATOMIC_FUNC(bool_and_i4, int,    int,    interlocked_cmpxchg, old && val)
+static VCOMP_ATOMIC_FUNC(bool_or_i4,  int,    int,    interlocked_cmpxchg, old || val)
+static VCOMP_ATOMIC_FUNC(bool_and_i8, LONG64, LONG64, interlocked_cmpxchg64, old && val)
+static VCOMP_ATOMIC_FUNC(bool_or_i8,  LONG64, LONG64, interlocked_cmpxchg64, old || val)
+static VCOMP_ATOMIC_FLOAT_FUNC(bool_and_r4, float,  int,    interlocked_cmpxchg, old.f && val)
+static VCOMP_ATOMIC_FLOAT_FUNC(bool_or_r4,  float,  int,    interlocked_cmpxchg, old.f || val)
+static VCOMP_ATOMIC_FLOAT_FUNC(bool_and_r8, double, LONG64, interlocked_cmpxchg64, old.f && val)
+static VCOMP_ATOMIC_FLOAT_FUNC(bool_or_r8,  double, LONG64, interlocked_cmpxchg64, old.f || val)
+
+#define VCOMP_REDUCTION_INT_FUNCS(suffix, usuffix, type, utype) \
+    void CDECL _vcomp_reduction_##suffix(unsigned int flags, type *dest, type val) \
+    { \
+        TRACE("(%x, %p, ...)\n", flags, dest); \
+        switch (flags & VCOMP_REDUCTION_FLAGS_MASK) \
+        { \
+        case VCOMP_REDUCTION_FLAGS_MUL:      _vcomp_atomic_mul_##suffix(dest, val); break; \
+        case VCOMP_REDUCTION_FLAGS_AND:      _vcomp_atomic_and_##suffix(dest, val); break; \
+        case VCOMP_REDUCTION_FLAGS_OR:       _vcomp_atomic_or_##suffix(dest, val); break; \
+        case VCOMP_REDUCTION_FLAGS_XOR:      _vcomp_atomic_xor_##suffix(dest, val); break; \
+        case VCOMP_REDUCTION_FLAGS_BOOL_AND: _vcomp_atomic_bool_and_##suffix(dest, val); break; \
+        case VCOMP_REDUCTION_FLAGS_BOOL_OR:  _vcomp_atomic_bool_or_##suffix(dest, val); break; \
+        default: \
+            if ((flags & VCOMP_REDUCTION_FLAGS_MASK) != VCOMP_REDUCTION_FLAGS_ADD) \
+                FIXME("unsupported reduction flags %x\n", flags); \
+            _vcomp_atomic_add_##suffix(dest, val); \
+            break; \
+        } \
+    } \
+    void CDECL _vcomp_reduction_##usuffix(unsigned int flags, utype *dest, utype val) \
+    { \
+        _vcomp_reduction_##suffix(flags, (type *)dest, val); \
+    }
+
+#define VCOMP_REDUCTION_FLOAT_FUNC(suffix, type) \
+    void CDECL _vcomp_reduction_##suffix(unsigned int flags, type *dest, type val) \
+    { \
+        TRACE("(%x, %p, ...)\n", flags, dest); \
+        switch (flags & VCOMP_REDUCTION_FLAGS_MASK) \
+        { \
+        case VCOMP_REDUCTION_FLAGS_MUL:      _vcomp_atomic_mul_##suffix(dest, val); break; \
+        case VCOMP_REDUCTION_FLAGS_BOOL_AND: _vcomp_atomic_bool_and_##suffix(dest, val); break; \
+        case VCOMP_REDUCTION_FLAGS_BOOL_OR:  _vcomp_atomic_bool_or_##suffix(dest, val); break; \
+        default: \
+            if ((flags & VCOMP_REDUCTION_FLAGS_MASK) != VCOMP_REDUCTION_FLAGS_ADD) \
+                FIXME("unsupported reduction flags %x\n", flags); \
+            _vcomp_atomic_add_##suffix(dest, val); \
+            break; \
+        } \
+    }
+
+VCOMP_REDUCTION_INT_FUNCS(i1, u1, char,   unsigned char)
+VCOMP_REDUCTION_INT_FUNCS(i2, u2, short,  unsigned short)
+VCOMP_REDUCTION_INT_FUNCS(i4, u4, int,    unsigned int)
+VCOMP_REDUCTION_INT_FUNCS(i8, u8, LONG64, ULONG64)
+VCOMP_REDUCTION_FLOAT_FUNC(r4, float)
+VCOMP_REDUCTION_FLOAT_FUNC(r8, double)
+
+int CDECL omp_get_dynamic(void)
 {
     TRACE("stub\n");
+    return 0;
+}
+
+int CDECL omp_get_max_threads(void)
+{
+    struct vcomp_thread_data *thread_data = vcomp_init_thread_data();
+
+    TRACE("()\n");
+    return thread_data->fork_threads ? thread_data->fork_threads : vcomp_max_threads;
+}
+
+int CDECL omp_get_nested(void)
+{
+    TRACE("()\n");
+    return vcomp_nested_fork;
+}
+
+int CDECL omp_get_num_procs(void)
+{
+    TRACE("()\n");
+    return vcomp_num_procs;
+}
+
+int CDECL omp_get_num_threads(void)
+{
+    struct vcomp_team_data *team_data = vcomp_init_thread_data()->team;
+
+    TRACE("()\n");
+    return team_data ? team_data->num_threads : 1;
+}
+
+int CDECL omp_get_thread_num(void)
+{
+    TRACE("()\n");
+    return vcomp_init_thread_data()->thread_num;
+}
+
+int CDECL omp_in_parallel(void)
+{
+    TRACE("()\n");
+    return vcomp_init_thread_data()->parallel;
+}
+
+/* Time in seconds since "some time in the past" */
+double CDECL omp_get_wtime(void)
+{
+    return GetTickCount() / 1000.0;
+}
+
+double CDECL omp_get_wtick(void)
+{
+    return 0.001;
+}
+
+void CDECL omp_set_dynamic(int val)
+{
+    TRACE("(%d): stub\n", val);
+}
+
+void CDECL omp_set_nested(int nested)
+{
+    TRACE("(%d)\n", nested);
+    vcomp_nested_fork = (nested != 0);
+}
+
+void CDECL omp_set_num_threads(int num_threads)
+{
+    TRACE("(%d)\n", num_threads);
+    if (num_threads >= 1)
+        vcomp_max_threads = num_threads;
 }
 
 BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
@@ -116,7 +1207,29 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
         case DLL_WINE_PREATTACH:
             return FALSE;    /* prefer native version */
         case DLL_PROCESS_ATTACH:
-            DisableThreadLibraryCalls(hinstDLL);
+        {
+            SYSTEM_INFO sysinfo;
+
+            if ((vcomp_context_tls = TlsAlloc()) == TLS_OUT_OF_INDEXES)
+            {
+                ERR("Failed to allocate TLS index\n");
+                return FALSE;
+            }
+
+            GetSystemInfo(&sysinfo);
+            vcomp_module      = hinstDLL;
+            vcomp_num_procs   = sysinfo.dwNumberOfProcessors;
+            vcomp_max_threads = sysinfo.dwNumberOfProcessors;
+            vcomp_spin_count  = vcomp_num_procs > 1 ? VCOMP_SPIN_COUNT : 0;
+            break;
+        }
+        case DLL_PROCESS_DETACH:
+            if (lpvReserved) break;
+            vcomp_free_thread_data();
+            if (vcomp_context_tls != TLS_OUT_OF_INDEXES) TlsFree(vcomp_context_tls);
+            break;
+        case DLL_THREAD_DETACH:
+            vcomp_free_thread_data();
             break;
     }
 
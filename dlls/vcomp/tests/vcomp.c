@@ -0,0 +1,650 @@
+/*
+ * Unit tests for the vcomp OpenMP runtime
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "windef.h"
+#include "winbase.h"
+#include "wine/test.h"
+
+#define VCOMP_DYNAMIC_FLAGS_STATIC      0x01
+#define VCOMP_DYNAMIC_FLAGS_CHUNKED     0x02
+#define VCOMP_DYNAMIC_FLAGS_GUIDED      0x03
+#define VCOMP_DYNAMIC_FLAGS_INCREMENT   0x40
+
+#define VCOMP_REDUCTION_FLAGS_ADD       0x100
+#define VCOMP_REDUCTION_FLAGS_MUL       0x200
+#define VCOMP_REDUCTION_FLAGS_AND       0x300
+#define VCOMP_REDUCTION_FLAGS_OR        0x400
+#define VCOMP_REDUCTION_FLAGS_XOR       0x500
+#define VCOMP_REDUCTION_FLAGS_BOOL_AND  0x600
+#define VCOMP_REDUCTION_FLAGS_BOOL_OR   0x700
+
+#define NUM_THREADS 4
+#define LOOP_SIZE   100
+
+static HMODULE hvcomp;
+
+static void  (CDECL *p_vcomp_atomic_add_i1)(char *dest, char val);
+static void  (CDECL *p_vcomp_atomic_add_i2)(short *dest, short val);
+static void  (CDECL *p_vcomp_atomic_add_i4)(int *dest, int val);
+static void  (CDECL *p_vcomp_atomic_add_i8)(LONG64 *dest, LONG64 val);
+static void  (CDECL *p_vcomp_atomic_add_r4)(float *dest, float val);
+static void  (CDECL *p_vcomp_atomic_add_r8)(double *dest, double val);
+static void  (CDECL *p_vcomp_atomic_and_i1)(char *dest, char val);
+static void  (CDECL *p_vcomp_atomic_div_i2)(short *dest, short val);
+static void  (CDECL *p_vcomp_atomic_div_r8)(double *dest, double val);
+static void  (CDECL *p_vcomp_atomic_div_ui4)(unsigned int *dest, unsigned int val);
+static void  (CDECL *p_vcomp_atomic_mul_i8)(LONG64 *dest, LONG64 val);
+static void  (CDECL *p_vcomp_atomic_mul_r4)(float *dest, float val);
+static void  (CDECL *p_vcomp_atomic_or_i4)(int *dest, int val);
+static void  (CDECL *p_vcomp_atomic_shl_i2)(short *dest, unsigned int val);
+static void  (CDECL *p_vcomp_atomic_shr_i1)(char *dest, unsigned int val);
+static void  (CDECL *p_vcomp_atomic_shr_ui1)(unsigned char *dest, unsigned int val);
+static void  (CDECL *p_vcomp_atomic_sub_i4)(int *dest, int val);
+static void  (CDECL *p_vcomp_atomic_sub_r8)(double *dest, double val);
+static void  (CDECL *p_vcomp_atomic_xor_i8)(LONG64 *dest, LONG64 val);
+static void  (CDECL *p_vcomp_barrier)(void);
+static void  (CDECL *p_vcomp_for_dynamic_init)(unsigned int flags, unsigned int first, unsigned int last,
+                                               int step, unsigned int chunksize);
+static int   (CDECL *p_vcomp_for_dynamic_next)(unsigned int *begin, unsigned int *end);
+static void  (CDECL *p_vcomp_for_static_end)(void);
+static void  (CDECL *p_vcomp_for_static_init)(int first, int last, int step, int chunksize, unsigned int *loops,
+                                              int *begin, int *end, int *next, int *lastchunk);
+static void  (CDECL *p_vcomp_for_static_simple_init)(unsigned int first, unsigned int last, int step,
+                                                     BOOL increment, unsigned int *begin, unsigned int *end);
+static void  (WINAPIV *p_vcomp_fork)(BOOL ifval, int nargs, void *wrapper, ...);
+static int   (CDECL *p_vcomp_get_thread_num)(void);
+static void  (CDECL *p_vcomp_reduction_i4)(unsigned int flags, int *dest, int val);
+static void  (CDECL *p_vcomp_reduction_i8)(unsigned int flags, LONG64 *dest, LONG64 val);
+static void  (CDECL *p_vcomp_reduction_r8)(unsigned int flags, double *dest, double val);
+static void  (CDECL *p_vcomp_reduction_u2)(unsigned int flags, unsigned short *dest, unsigned short val);
+static void  (CDECL *p_vcomp_set_num_threads)(int num_threads);
+static int   (CDECL *pomp_get_max_threads)(void);
+static int   (CDECL *pomp_get_nested)(void);
+static int   (CDECL *pomp_get_num_threads)(void);
+static int   (CDECL *pomp_get_thread_num)(void);
+static int   (CDECL *pomp_in_parallel)(void);
+static void  (CDECL *pomp_set_nested)(int nested);
+static void  (CDECL *pomp_set_num_threads)(int num_threads);
+
+#define VCOMP_GET_PROC(func) \
+    do \
+    { \
+        p ## func = (void *)GetProcAddress(hvcomp, #func); \
+        ok(p ## func != NULL, "Export '%s' not found\n", #func); \
+    } while (0)
+
+static BOOL init_vcomp(void)
+{
+    hvcomp = LoadLibraryA("vcomp.dll");
+    if (!hvcomp)
+    {
+        win_skip("vcomp.dll not installed (got %d)\n", GetLastError());
+        return FALSE;
+    }
+
+    VCOMP_GET_PROC(_vcomp_atomic_add_i1);
+    VCOMP_GET_PROC(_vcomp_atomic_add_i2);
+    VCOMP_GET_PROC(_vcomp_atomic_add_i4);
+    VCOMP_GET_PROC(_vcomp_atomic_add_i8);
+    VCOMP_GET_PROC(_vcomp_atomic_add_r4);
+    VCOMP_GET_PROC(_vcomp_atomic_add_r8);
+    VCOMP_GET_PROC(_vcomp_atomic_and_i1);
+    VCOMP_GET_PROC(_vcomp_atomic_div_i2);
+    VCOMP_GET_PROC(_vcomp_atomic_div_r8);
+    VCOMP_GET_PROC(_vcomp_atomic_div_ui4);
+    VCOMP_GET_PROC(_vcomp_atomic_mul_i8);
+    VCOMP_GET_PROC(_vcomp_atomic_mul_r4);
+    VCOMP_GET_PROC(_vcomp_atomic_or_i4);
+    VCOMP_GET_PROC(_vcomp_atomic_shl_i2);
+    VCOMP_GET_PROC(_vcomp_atomic_shr_i1);
+    VCOMP_GET_PROC(_vcomp_atomic_shr_ui1);
+    VCOMP_GET_PROC(_vcomp_atomic_sub_i4);
+    VCOMP_GET_PROC(_vcomp_atomic_sub_r8);
+    VCOMP_GET_PROC(_vcomp_atomic_xor_i8);
+    VCOMP_GET_PROC(_vcomp_barrier);
+    VCOMP_GET_PROC(_vcomp_for_dynamic_init);
+    VCOMP_GET_PROC(_vcomp_for_dynamic_next);
+    VCOMP_GET_PROC(_vcomp_for_static_end);
+    VCOMP_GET_PROC(_vcomp_for_static_init);
+    VCOMP_GET_PROC(_vcomp_for_static_simple_init);
+    VCOMP_GET_PROC(_vcomp_fork);
+    VCOMP_GET_PROC(_vcomp_get_thread_num);
+    VCOMP_GET_PROC(_vcomp_reduction_i4);
+    VCOMP_GET_PROC(_vcomp_reduction_i8);
+    VCOMP_GET_PROC(_vcomp_reduction_r8);
+    VCOMP_GET_PROC(_vcomp_reduction_u2);
+    VCOMP_GET_PROC(_vcomp_set_num_threads);
+    VCOMP_GET_PROC(omp_get_max_threads);
+    VCOMP_GET_PROC(omp_get_nested);
+    VCOMP_GET_PROC(omp_get_num_threads);
+    VCOMP_GET_PROC(omp_get_thread_num);
+    VCOMP_GET_PROC(omp_in_parallel);
+    VCOMP_GET_PROC(omp_set_nested);
+    VCOMP_GET_PROC(omp_set_num_threads);
+
+    return TRUE;
+}
+
+#undef VCOMP_GET_PROC
+
+static void CDECL fork_cb(int num_threads, BOOL parallel, LONG *count, LONG *seen)
+{
+    int thread_num = pomp_get_thread_num();
+
+    ok(pomp_get_num_threads() == num_threads, "expected %d threads, got %d\n",
+       num_threads, pomp_get_num_threads());
+    ok(pomp_in_parallel() == parallel, "expected omp_in_parallel() %d, got %d\n",
+       parallel, pomp_in_parallel());
+    ok(p_vcomp_get_thread_num() == thread_num, "expected thread %d, got %d\n",
+       thread_num, p_vcomp_get_thread_num());
+    ok(thread_num >= 0 && thread_num < num_threads, "got thread %d\n", thread_num);
+    if (thread_num >= 0 && thread_num < NUM_THREADS)
+        InterlockedIncrement(&seen[thread_num]);
+    InterlockedIncrement(count);
+}
+
+static void check_fork_threads(int num_threads, LONG count, const LONG *seen)
+{
+    int i;
+
+    ok(count == num_threads, "expected %d calls, got %d\n", num_threads, count);
+    for (i = 0; i < NUM_THREADS; i++)
+        ok(seen[i] == (i < num_threads), "thread %d ran %d times\n", i, seen[i]);
+}
+
+static void test_vcomp_fork(void)
+{
+    LONG count, seen[NUM_THREADS];
+
+    pomp_set_num_threads(NUM_THREADS);
+    ok(pomp_get_max_threads() == NUM_THREADS, "got %d\n", pomp_get_max_threads());
+    ok(pomp_get_num_threads() == 1, "got %d\n", pomp_get_num_threads());
+    ok(!pomp_in_parallel(), "in parallel outside of a team\n");
+
+    count = 0;
+    memset(seen, 0, sizeof(seen));
+    p_vcomp_fork(TRUE, 4, fork_cb, NUM_THREADS, TRUE, &count, seen);
+    check_fork_threads(NUM_THREADS, count, seen);
+
+    /* the thread count of a num_threads clause only applies to the next fork */
+    count = 0;
+    memset(seen, 0, sizeof(seen));
+    p_vcomp_set_num_threads(2);
+    ok(pomp_get_max_threads() == 2, "got %d\n", pomp_get_max_threads());
+    p_vcomp_fork(TRUE, 4, fork_cb, 2, TRUE, &count, seen);
+    check_fork_threads(2, count, seen);
+    ok(pomp_get_max_threads() == NUM_THREADS, "got %d\n", pomp_get_max_threads());
+
+    count = 0;
+    memset(seen, 0, sizeof(seen));
+    p_vcomp_fork(TRUE, 4, fork_cb, NUM_THREADS, TRUE, &count, seen);
+    check_fork_threads(NUM_THREADS, count, seen);
+
+    /* if clause evaluating to false */
+    count = 0;
+    memset(seen, 0, sizeof(seen));
+    p_vcomp_fork(FALSE, 4, fork_cb, 1, FALSE, &count, seen);
+    check_fork_threads(1, count, seen);
+
+    ok(pomp_get_num_threads() == 1, "got %d\n", pomp_get_num_threads());
+    ok(!pomp_in_parallel(), "in parallel after the team is done\n");
+}
+
+static void CDECL nested_inner_cb(int num_threads, LONG *count)
+{
+    ok(pomp_get_num_threads() == num_threads, "expected %d threads, got %d\n",
+       num_threads, pomp_get_num_threads());
+    ok(pomp_in_parallel(), "not in parallel in a nested team\n");
+    InterlockedIncrement(count);
+}
+
+static void CDECL nested_outer_cb(int inner_threads, LONG *count, LONG *inner_count)
+{
+    int thread_num = pomp_get_thread_num();
+    LONG local_count = 0;
+
+    p_vcomp_set_num_threads(2);
+    p_vcomp_fork(TRUE, 2, nested_inner_cb, inner_threads, &local_count);
+    ok(local_count == inner_threads, "expected %d calls, got %d\n", inner_threads, local_count);
+    InterlockedExchangeAdd(inner_count, local_count);
+
+    /* the outer team is back */
+    ok(pomp_get_thread_num() == thread_num, "expected thread %d, got %d\n",
+       thread_num, pomp_get_thread_num());
+    ok(pomp_get_num_threads() == NUM_THREADS, "got %d\n", pomp_get_num_threads());
+    InterlockedIncrement(count);
+}
+
+static void test_vcomp_fork_nested(void)
+{
+    LONG count, inner_count;
+    int i;
+
+    pomp_set_num_threads(NUM_THREADS);
+    ok(!pomp_get_nested(), "nested parallelism enabled by default\n");
+
+    /* nested teams only get the thread that forked them */
+    count = inner_count = 0;
+    p_vcomp_fork(TRUE, 3, nested_outer_cb, 1, &count, &inner_count);
+    ok(count == NUM_THREADS, "expected %d calls, got %d\n", NUM_THREADS, count);
+    ok(inner_count == NUM_THREADS, "expected %d calls, got %d\n", NUM_THREADS, inner_count);
+
+    pomp_set_nested(1);
+    ok(pomp_get_nested(), "nested parallelism not enabled\n");
+
+    /* repeated so that the inner teams reuse the threads of the pool */
+    for (i = 0; i < 3; i++)
+    {
+        count = inner_count = 0;
+        p_vcomp_fork(TRUE, 3, nested_outer_cb, 2, &count, &inner_count);
+        ok(count == NUM_THREADS, "%d: expected %d calls, got %d\n", i, NUM_THREADS, count);
+        ok(inner_count == 2 * NUM_THREADS, "%d: expected %d calls, got %d\n", i, 2 * NUM_THREADS, inner_count);
+    }
+
+    pomp_set_nested(0);
+    ok(!pomp_get_nested(), "nested parallelism not disabled\n");
+}
+
+/* checks that each iteration of the loop was run exactly once */
+static void check_loop(const char *desc, const LONG *marks, int first, int last, int step)
+{
+    int i, expected, low = min(first, last), high = max(first, last);
+
+    for (i = 0; i < LOOP_SIZE; i++)
+    {
+        expected = i >= low && i <= high && !((i - first) % step);
+        if (marks[i] != expected) break;
+    }
+    ok(i == LOOP_SIZE, "%s: iteration %d ran %d times\n", desc, i, i < LOOP_SIZE ? marks[i] : 0);
+}
+
+static void CDECL for_static_simple_cb(unsigned int first, unsigned int last, int step, BOOL increment, LONG *marks)
+{
+    unsigned int begin, end;
+    int i;
+
+    p_vcomp_for_static_simple_init(first, last, step, increment, &begin, &end);
+    if (increment)
+        for (i = begin; i <= (int)end; i += step) InterlockedIncrement(&marks[i]);
+    else
+        for (i = begin; i >= (int)end; i -= step) InterlockedIncrement(&marks[i]);
+    p_vcomp_for_static_end();
+}
+
+static void CDECL for_static_cb(int first, int last, int step, int chunksize, LONG *marks)
+{
+    int begin, end, next, lastchunk, i;
+    unsigned int loops;
+
+    p_vcomp_for_static_init(first, last, step, chunksize, &loops, &begin, &end, &next, &lastchunk);
+    for (; loops; loops--)
+    {
+        /* the last chunk may extend past the end of the loop */
+        if (begin == lastchunk) end = last;
+        if (first <= last)
+            for (i = begin; i <= end; i += step) InterlockedIncrement(&marks[i]);
+        else
+            for (i = begin; i >= end; i -= step) InterlockedIncrement(&marks[i]);
+        begin += next;
+        end += next;
+    }
+    p_vcomp_for_static_end();
+}
+
+static void test_vcomp_for_static(void)
+{
+    static const struct
+    {
+        int first, last, step, chunksize;
+    }
+    tests[] =
+    {
+        {  0, 99, 1, 1 },
+        {  0, 99, 1, 3 },
+        {  0, 99, 2, 3 },
+        {  0, 98, 1, 7 },
+        {  5,  6, 1, 8 },
+        { 99,  0, 1, 3 },
+        { 98,  1, 3, 2 },
+        { 42, 42, 1, 1 },
+    };
+    char desc[64];
+    LONG marks[LOOP_SIZE];
+    unsigned int i;
+
+    pomp_set_num_threads(NUM_THREADS);
+
+    for (i = 0; i < sizeof(tests)/sizeof(tests[0]); i++)
+    {
+        sprintf(desc, "static %d..%d step %d chunk %d", tests[i].first, tests[i].last,
+                tests[i].step, tests[i].chunksize);
+        memset(marks, 0, sizeof(marks));
+        p_vcomp_fork(TRUE, 5, for_static_cb, tests[i].first, tests[i].last, tests[i].step,
+                     tests[i].chunksize, marks);
+        check_loop(desc, marks, tests[i].first, tests[i].last, tests[i].step);
+
+        if (tests[i].first == tests[i].last) continue;
+
+        sprintf(desc, "static simple %d..%d step %d", tests[i].first, tests[i].last, tests[i].step);
+        memset(marks, 0, sizeof(marks));
+        p_vcomp_fork(TRUE, 5, for_static_simple_cb, tests[i].first, tests[i].last, tests[i].step,
+                     tests[i].first < tests[i].last, marks);
+        check_loop(desc, marks, tests[i].first, tests[i].last, tests[i].step);
+    }
+
+    /* outside of a parallel region, the whole loop goes to the calling thread */
+    memset(marks, 0, sizeof(marks));
+    for_static_cb(0, 99, 1, 3, marks);
+    check_loop("static without team", marks, 0, 99, 1);
+
+    memset(marks, 0, sizeof(marks));
+    for_static_simple_cb(0, 99, 1, TRUE, marks);
+    check_loop("static simple without team", marks, 0, 99, 1);
+}
+
+static void CDECL for_dynamic_cb(unsigned int flags, unsigned int first, unsigned int last, int step,
+                                 unsigned int chunksize, LONG *marks, LONG *chunks)
+{
+    unsigned int begin, end;
+    int i;
+
+    p_vcomp_for_dynamic_init(flags, first, last, step, chunksize);
+    while (p_vcomp_for_dynamic_next(&begin, &end))
+    {
+        if (flags & VCOMP_DYNAMIC_FLAGS_INCREMENT)
+            for (i = begin; i <= (int)end; i += step) InterlockedIncrement(&marks[i]);
+        else
+            for (i = begin; i >= (int)end; i -= step) InterlockedIncrement(&marks[i]);
+        InterlockedIncrement(chunks);
+    }
+    /* the compiler puts a barrier at the end of the loop */
+    p_vcomp_barrier();
+}
+
+static void test_vcomp_for_dynamic(void)
+{
+    static const struct
+    {
+        unsigned int flags;
+        int first, last, step;
+        unsigned int chunksize;
+        LONG min_chunks, max_chunks;
+    }
+    tests[] =
+    {
+        { VCOMP_DYNAMIC_FLAGS_CHUNKED | VCOMP_DYNAMIC_FLAGS_INCREMENT,  0, 99, 1, 7, 15, 15 },
+        { VCOMP_DYNAMIC_FLAGS_CHUNKED | VCOMP_DYNAMIC_FLAGS_INCREMENT,  0, 99, 2, 1, 50, 50 },
+        { VCOMP_DYNAMIC_FLAGS_CHUNKED,                                 99,  0, 1, 5, 20, 20 },
+        { VCOMP_DYNAMIC_FLAGS_GUIDED | VCOMP_DYNAMIC_FLAGS_INCREMENT,   0, 99, 1, 2,  5, 50 },
+        { VCOMP_DYNAMIC_FLAGS_GUIDED,                                  98,  1, 3, 1,  1, 33 },
+        { VCOMP_DYNAMIC_FLAGS_STATIC | VCOMP_DYNAMIC_FLAGS_INCREMENT,   0, 98, 1, 1,  4,  4 },
+        { VCOMP_DYNAMIC_FLAGS_STATIC,                                  99, 97, 1, 1,  3,  3 },
+    };
+    char desc[64];
+    LONG marks[LOOP_SIZE], chunks;
+    unsigned int i;
+
+    pomp_set_num_threads(NUM_THREADS);
+
+    for (i = 0; i < sizeof(tests)/sizeof(tests[0]); i++)
+    {
+        sprintf(desc, "dynamic %#x %d..%d step %d chunk %u", tests[i].flags, tests[i].first,
+                tests[i].last, tests[i].step, tests[i].chunksize);
+        memset(marks, 0, sizeof(marks));
+        chunks = 0;
+        p_vcomp_fork(TRUE, 7, for_dynamic_cb, tests[i].flags, tests[i].first, tests[i].last,
+                     tests[i].step, tests[i].chunksize, marks, &chunks);
+        check_loop(desc, marks, tests[i].first, tests[i].last, tests[i].step);
+        ok(chunks >= tests[i].min_chunks && chunks <= tests[i].max_chunks, "%s: got %d chunks\n", desc, chunks);
+    }
+
+    /* two loops in a row in the same team */
+    memset(marks, 0, sizeof(marks));
+    chunks = 0;
+    p_vcomp_fork(TRUE, 7, for_dynamic_cb, VCOMP_DYNAMIC_FLAGS_CHUNKED | VCOMP_DYNAMIC_FLAGS_INCREMENT,
+                 0, 99, 1, 3, marks, &chunks);
+    check_loop("dynamic first loop", marks, 0, 99, 1);
+    memset(marks, 0, sizeof(marks));
+    chunks = 0;
+    p_vcomp_fork(TRUE, 7, for_dynamic_cb, VCOMP_DYNAMIC_FLAGS_GUIDED | VCOMP_DYNAMIC_FLAGS_INCREMENT,
+                 0, 99, 1, 3, marks, &chunks);
+    check_loop("dynamic second loop", marks, 0, 99, 1);
+}
+
+static void CDECL barrier_cb(int rounds, LONG *count, LONG *failures)
+{
+    int i;
+
+    for (i = 0; i < rounds; i++)
+    {
+        InterlockedIncrement(count);
+        p_vcomp_barrier();
+        /* everybody has incremented the counter for this round */
+        if (*(volatile LONG *)count != (i + 1) * NUM_THREADS) InterlockedIncrement(failures);
+        p_vcomp_barrier();
+        /* sleep once in a while so that the others have to block */
+        if (!(i % 16) && pomp_get_thread_num() == i / 16 % NUM_THREADS) Sleep(20);
+    }
+}
+
+static void test_vcomp_barrier(void)
+{
+    LONG count = 0, failures = 0;
+
+    pomp_set_num_threads(NUM_THREADS);
+    p_vcomp_fork(TRUE, 3, barrier_cb, 100, &count, &failures);
+    ok(count == 100 * NUM_THREADS, "got %d\n", count);
+    ok(!failures, "%d threads left the barrier early\n", failures);
+
+    /* a barrier outside of a parallel region returns at once */
+    p_vcomp_barrier();
+}
+
+static void test_vcomp_atomic(void)
+{
+    unsigned char uc;
+    unsigned int ui;
+    double d;
+    LONG64 l;
+    float f;
+    short s;
+    char c;
+    int i;
+
+    c = 0x7f;
+    p_vcomp_atomic_add_i1(&c, 1);
+    ok(c == (char)0x80, "got %d\n", c);
+    c = 0x3c;
+    p_vcomp_atomic_and_i1(&c, 0x0f);
+    ok(c == 0x0c, "got %d\n", c);
+    c = (char)0x80;
+    p_vcomp_atomic_shr_i1(&c, 2);
+    ok(c == (char)0xe0, "got %d\n", c);
+    uc = 0x80;
+    p_vcomp_atomic_shr_ui1(&uc, 2);
+    ok(uc == 0x20, "got %u\n", uc);
+
+    s = -1000;
+    p_vcomp_atomic_div_i2(&s, 3);
+    ok(s == -333, "got %d\n", s);
+    s = 0x1234;
+    p_vcomp_atomic_shl_i2(&s, 4);
+    ok(s == 0x2340, "got %#x\n", s);
+    s = 0x7fff;
+    p_vcomp_atomic_add_i2(&s, 1);
+    ok(s == (short)0x8000, "got %d\n", s);
+
+    i = 100;
+    p_vcomp_atomic_sub_i4(&i, 142);
+    ok(i == -42, "got %d\n", i);
+    i = 0x0f0;
+    p_vcomp_atomic_or_i4(&i, 0xf00);
+    ok(i == 0xff0, "got %#x\n", i);
+    ui = 0xfffffff0;
+    p_vcomp_atomic_div_ui4(&ui, 16);
+    ok(ui == 0x0fffffff, "got %#x\n", ui);
+
+    l = (LONG64)1 << 32;
+    p_vcomp_atomic_mul_i8(&l, 3);
+    ok(l == (LONG64)3 << 32, "got 0x%x%08x\n", (ULONG)(l >> 32), (ULONG)l);
+    l = ((LONG64)0x12 << 32) | 0x3456789a;
+    p_vcomp_atomic_xor_i8(&l, (LONG64)0x12 << 32);
+    ok(l == 0x3456789a, "got 0x%x%08x\n", (ULONG)(l >> 32), (ULONG)l);
+    l = -1;
+    p_vcomp_atomic_add_i8(&l, ((LONG64)1 << 32) + 1);
+    ok(l == (LONG64)1 << 32, "got 0x%x%08x\n", (ULONG)(l >> 32), (ULONG)l);
+
+    f = 1.5f;
+    p_vcomp_atomic_add_r4(&f, 2.0f);
+    ok(f == 3.5f, "got %f\n", f);
+    p_vcomp_atomic_mul_r4(&f, 2.0f);
+    ok(f == 7.0f, "got %f\n", f);
+    d = 1.0;
+    p_vcomp_atomic_div_r8(&d, 4.0);
+    ok(d == 0.25, "got %f\n", d);
+    p_vcomp_atomic_sub_r8(&d, 1.0);
+    ok(d == -0.75, "got %f\n", d);
+}
+
+/* the threads update neighbouring bytes and words, which share a dword */
+static void CDECL atomic_cb(char *bytes, short *words, int *sum, LONG64 *sum64, double *sumd)
+{
+    int thread_num = pomp_get_thread_num(), i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        p_vcomp_atomic_add_i1(&bytes[thread_num], 1);
+        p_vcomp_atomic_add_i2(&words[thread_num % 2], 1);
+        p_vcomp_atomic_add_i4(sum, 1);
+        p_vcomp_atomic_add_i8(sum64, ((LONG64)1 << 32) + 1);
+        p_vcomp_atomic_add_r8(sumd, 0.5);
+    }
+}
+
+static void test_vcomp_atomic_threads(void)
+{
+    int sum = 0, i;
+    LONG64 sum64 = 0;
+    double sumd = 0.0;
+    union
+    {
+        char bytes[NUM_THREADS];
+        short words[2];
+        LONG align;
+    } bytes, words;
+
+    pomp_set_num_threads(NUM_THREADS);
+    memset(&bytes, 0, sizeof(bytes));
+    memset(&words, 0, sizeof(words));
+    p_vcomp_fork(TRUE, 5, atomic_cb, bytes.bytes, words.words, &sum, &sum64, &sumd);
+
+    for (i = 0; i < NUM_THREADS; i++)
+        ok((unsigned char)bytes.bytes[i] == 1000 % 256, "byte %d: got %d\n", i, bytes.bytes[i]);
+    ok(words.words[0] == 1000 * NUM_THREADS / 2, "got %d\n", words.words[0]);
+    ok(words.words[1] == 1000 * NUM_THREADS / 2, "got %d\n", words.words[1]);
+    ok(sum == 1000 * NUM_THREADS, "got %d\n", sum);
+    ok(sum64 == 1000 * NUM_THREADS * (((LONG64)1 << 32) + 1), "got 0x%x%08x\n", (ULONG)(sum64 >> 32), (ULONG)sum64);
+    ok(sumd == 500.0 * NUM_THREADS, "got %f\n", sumd);
+}
+
+struct reduction_results
+{
+    int            add, and, or, xor, bool_and, bool_or;
+    LONG64         mul;
+    double         addd;
+    unsigned short addu;
+};
+
+static void CDECL reduction_cb(struct reduction_results *res)
+{
+    int thread_num = pomp_get_thread_num();
+
+    p_vcomp_reduction_i4(VCOMP_REDUCTION_FLAGS_ADD, &res->add, thread_num + 1);
+    p_vcomp_reduction_i4(VCOMP_REDUCTION_FLAGS_AND, &res->and, ~(1 << thread_num));
+    p_vcomp_reduction_i4(VCOMP_REDUCTION_FLAGS_OR, &res->or, 1 << thread_num);
+    p_vcomp_reduction_i4(VCOMP_REDUCTION_FLAGS_XOR, &res->xor, 3 << thread_num);
+    p_vcomp_reduction_i4(VCOMP_REDUCTION_FLAGS_BOOL_AND, &res->bool_and, thread_num != 2);
+    p_vcomp_reduction_i4(VCOMP_REDUCTION_FLAGS_BOOL_OR, &res->bool_or, thread_num == 2);
+    p_vcomp_reduction_i8(VCOMP_REDUCTION_FLAGS_MUL, &res->mul, thread_num + 2);
+    p_vcomp_reduction_r8(VCOMP_REDUCTION_FLAGS_ADD, &res->addd, 0.25 * (thread_num + 1));
+    p_vcomp_reduction_u2(VCOMP_REDUCTION_FLAGS_ADD, &res->addu, 0x4000);
+}
+
+static void test_vcomp_reduction(void)
+{
+    struct reduction_results res;
+
+    pomp_set_num_threads(NUM_THREADS);
+
+    res.add      = 0;
+    res.and      = 0xff;
+    res.or       = 0;
+    res.xor      = 0;
+    res.bool_and = 1;
+    res.bool_or  = 0;
+    res.mul      = 1;
+    res.addd     = 0.0;
+    res.addu     = 0;
+    p_vcomp_fork(TRUE, 1, reduction_cb, &res);
+
+    ok(res.add == 1 + 2 + 3 + 4, "got %d\n", res.add);
+    ok(res.and == 0xf0, "got %#x\n", res.and);
+    ok(res.or == 0xf, "got %#x\n", res.or);
+    ok(res.xor == 0x11, "got %#x\n", res.xor);
+    ok(res.bool_and == 0, "got %d\n", res.bool_and);
+    ok(res.bool_or == 1, "got %d\n", res.bool_or);
+    ok(res.mul == 2 * 3 * 4 * 5, "got 0x%x%08x\n", (ULONG)(res.mul >> 32), (ULONG)res.mul);
+    ok(res.addd == 2.5, "got %f\n", res.addd);
+    ok(res.addu == 0, "got %#x\n", res.addu);
+
+    /* a team of one thread */
+    res.add      = 10;
+    res.bool_and = 2;
+    res.bool_or  = 0;
+    p_vcomp_reduction_i4(VCOMP_REDUCTION_FLAGS_ADD, &res.add, 5);
+    ok(res.add == 15, "got %d\n", res.add);
+    p_vcomp_reduction_i4(VCOMP_REDUCTION_FLAGS_BOOL_AND, &res.bool_and, 7);
+    ok(res.bool_and == 1, "got %d\n", res.bool_and);
+    p_vcomp_reduction_i4(VCOMP_REDUCTION_FLAGS_BOOL_OR, &res.bool_or, 0);
+    ok(res.bool_or == 0, "got %d\n", res.bool_or);
+}
+
+START_TEST(vcomp)
+{
+    int max_threads;
+
+    if (!init_vcomp())
+        return;
+
+    max_threads = pomp_get_max_threads();
+
+    test_vcomp_fork();
+    test_vcomp_fork_nested();
+    test_vcomp_for_static();
+    test_vcomp_for_dynamic();
+    test_vcomp_barrier();
+    test_vcomp_atomic();
+    test_vcomp_atomic_threads();
+    test_vcomp_reduction();
+
+    pomp_set_num_threads(max_threads);
+    FreeLibrary(hvcomp);
+}
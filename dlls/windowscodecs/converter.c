@@ -75,7 +75,9 @@ typedef struct FormatConverter {
     WICBitmapDitherType dither;
     double alpha_threshold;
     WICBitmapPaletteType palette_type;
-    CRITICAL_SECTION lock; /* must be held when initialized */
+    BYTE *srcbuffer, *bgrabuffer; /* reused by CopyPixels calls */
+    UINT srcbuffer_size, bgrabuffer_size;
+    CRITICAL_SECTION lock; /* must be held when initialized or copying */
 } FormatConverter;
 
 static inline FormatConverter *impl_from_IWICFormatConverter(IWICFormatConverter *iface)
@@ -83,6 +85,37 @@ static inline FormatConverter *impl_from_IWICFormatConverter(IWICFormatConverter
     return CONTAINING_RECORD(iface, FormatConverter, IWICFormatConverter_iface);
 }
 
+/* returns a buffer of at least size bytes, which is kept for later calls */
+static BYTE *get_buffer(BYTE **buffer, UINT *buffer_size, UINT size)
+{
+    if (size > *buffer_size)
+    {
+        HeapFree(GetProcessHeap(), 0, *buffer);
+        *buffer = HeapAlloc(GetProcessHeap(), 0, size);
+        *buffer_size = *buffer ? size : 0;
+    }
+
+    return *buffer;
+}
+
+static BOOL format_has_alpha(enum pixelformat format)
+{
+    switch (format)
+    {
+    case format_1bppIndexed:
+    case format_2bppIndexed:
+    case format_4bppIndexed:
+    case format_8bppIndexed:
+    case format_16bppBGRA5551:
+    case format_32bppBGRA:
+    case format_32bppPBGRA:
+    case format_64bppRGBA:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
 static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRect *prc,
     UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer, enum pixelformat source_format)
 {
@@ -121,7 +154,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = (prc->Width+7)/8;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -150,8 +183,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -188,7 +219,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = (prc->Width+3)/4;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -213,8 +244,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -251,7 +280,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = (prc->Width+1)/2;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -274,8 +303,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -294,7 +321,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = prc->Width;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -316,8 +343,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -350,7 +375,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = prc->Width;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -369,8 +394,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -389,7 +412,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = prc->Width * 2;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -411,8 +434,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -431,7 +452,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = 2 * prc->Width;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -459,8 +480,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -479,7 +498,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = 2 * prc->Width;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -507,8 +526,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -527,7 +544,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = 2 * prc->Width;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -555,8 +572,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -575,7 +590,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -598,8 +613,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -619,7 +632,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -646,8 +659,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -707,7 +718,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = 6 * prc->Width;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -731,8 +742,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -751,7 +760,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             srcstride = 8 * prc->Width;
             srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
             if (!srcdata) return E_OUTOFMEMORY;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
@@ -776,8 +785,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -836,7 +843,7 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
         return S_OK;
     default:
         hr = copypixels_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
-        if (SUCCEEDED(hr) && prc)
+        if (SUCCEEDED(hr) && prc && format_has_alpha(source_format))
         {
             INT x, y;
 
@@ -856,6 +863,145 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
     }
 }
 
+static HRESULT copypixels_8bpp_to_24bpp(struct FormatConverter *This, const WICRect *prc,
+    UINT cbStride, BYTE *pbBuffer, enum pixelformat source_format, BOOL rgb)
+{
+    HRESULT res;
+    INT x, y;
+    UINT i;
+    BYTE *srcdata;
+    UINT srcstride, srcdatasize;
+    const BYTE *srcrow;
+    const BYTE *srcbyte;
+    BYTE *dstrow;
+    BYTE *dstpixel;
+    WICColor colors[256];
+
+    if (source_format == format_8bppIndexed)
+    {
+        IWICPalette *palette;
+        UINT actualcolors;
+
+        res = PaletteImpl_Create(&palette);
+        if (FAILED(res)) return res;
+
+        res = IWICBitmapSource_CopyPalette(This->source, palette);
+        if (SUCCEEDED(res))
+            res = IWICPalette_GetColors(palette, 256, colors, &actualcolors);
+
+        IWICPalette_Release(palette);
+
+        if (FAILED(res)) return res;
+    }
+    else
+    {
+        for (i=0; i<256; i++)
+            colors[i] = 0xff000000|(i<<16)|(i<<8)|i;
+    }
+
+    /* swap the palette instead of every pixel */
+    if (rgb)
+    {
+        for (i=0; i<256; i++)
+            colors[i] = (colors[i]&0xff00ff00)|((colors[i]&0xff)<<16)|((colors[i]>>16)&0xff);
+    }
+
+    srcstride = prc->Width;
+    srcdatasize = srcstride * prc->Height;
+
+    srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
+    if (!srcdata) return E_OUTOFMEMORY;
+
+    res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+
+    if (SUCCEEDED(res))
+    {
+        srcrow = srcdata;
+        dstrow = pbBuffer;
+        for (y=0; y<prc->Height; y++) {
+            srcbyte=srcrow;
+            dstpixel=dstrow;
+            for (x=0; x<prc->Width; x++) {
+                WICColor color = colors[*srcbyte++];
+                *dstpixel++=color; /* blue */
+                *dstpixel++=color>>8; /* green */
+                *dstpixel++=color>>16; /* red */
+            }
+            srcrow += srcstride;
+            dstrow += cbStride;
+        }
+    }
+
+    return res;
+}
+
+static HRESULT copypixels_32bpp_to_24bpp(struct FormatConverter *This, const WICRect *prc,
+    UINT cbStride, BYTE *pbBuffer, enum pixelformat source_format, BOOL rgb)
+{
+    HRESULT res;
+    INT x, y;
+    BYTE *srcdata;
+    UINT srcstride, srcdatasize;
+    const BYTE *srcrow;
+    const BYTE *srcpixel;
+    BYTE *dstrow;
+    BYTE *dstpixel;
+
+    srcstride = 4 * prc->Width;
+    srcdatasize = srcstride * prc->Height;
+
+    switch (source_format)
+    {
+    case format_32bppBGR:
+    case format_32bppBGRA:
+    case format_32bppPBGRA:
+        srcdata = get_buffer(&This->srcbuffer, &This->srcbuffer_size, srcdatasize);
+        if (!srcdata) return E_OUTOFMEMORY;
+
+        res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+        break;
+    default:
+        /* anything else goes through 32bppBGRA */
+        srcdata = get_buffer(&This->bgrabuffer, &This->bgrabuffer_size, srcdatasize);
+        if (!srcdata) return E_OUTOFMEMORY;
+
+        res = copypixels_to_32bppBGRA(This, prc, srcstride, srcdatasize, srcdata, source_format);
+        break;
+    }
+
+    if (SUCCEEDED(res))
+    {
+        srcrow = srcdata;
+        dstrow = pbBuffer;
+        for (y=0; y<prc->Height; y++) {
+            srcpixel=srcrow;
+            dstpixel=dstrow;
+            if (rgb)
+            {
+                for (x=0; x<prc->Width; x++) {
+                    *dstpixel++=srcpixel[2]; /* red */
+                    *dstpixel++=srcpixel[1]; /* green */
+                    *dstpixel++=srcpixel[0]; /* blue */
+                    srcpixel+=4;
+                }
+            }
+            else
+            {
+                for (x=0; x<prc->Width; x++) {
+                    *dstpixel++=*srcpixel++; /* blue */
+                    *dstpixel++=*srcpixel++; /* green */
+                    *dstpixel++=*srcpixel++; /* red */
+                    srcpixel++; /* alpha */
+                }
+            }
+            srcrow += srcstride;
+            dstrow += cbStride;
+        }
+    }
+
+    return res;
+}
+
 static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRect *prc,
     UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer, enum pixelformat source_format)
 {
@@ -873,54 +1019,15 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
             return hr;
         }
         return S_OK;
-    case format_32bppBGR:
-    case format_32bppBGRA:
-    case format_32bppPBGRA:
+    case format_8bppIndexed:
+    case format_8bppGray:
         if (prc)
-        {
-            HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-
-            srcstride = 4 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
-
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        srcpixel++; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
-
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
-            return res;
-        }
+            return copypixels_8bpp_to_24bpp(This, prc, cbStride, pbBuffer, source_format, FALSE);
         return S_OK;
     default:
-        FIXME("Unimplemented conversion path!\n");
-        return WINCODEC_ERR_UNSUPPORTEDOPERATION;
+        if (prc)
+            return copypixels_32bpp_to_24bpp(This, prc, cbStride, pbBuffer, source_format, FALSE);
+        return S_OK;
     }
 }
 
@@ -941,56 +1048,15 @@ static HRESULT copypixels_to_24bppRGB(struct FormatConverter *This, const WICRec
             return hr;
         }
         return S_OK;
-    case format_32bppBGR:
-    case format_32bppBGRA:
-    case format_32bppPBGRA:
+    case format_8bppIndexed:
+    case format_8bppGray:
         if (prc)
-        {
-            HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-
-            srcstride = 4 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
-
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        srcpixel++; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-
-                reverse_bgr8(3, pbBuffer, prc->Width, prc->Height, cbStride);
-            }
-
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
-            return res;
-        }
+            return copypixels_8bpp_to_24bpp(This, prc, cbStride, pbBuffer, source_format, TRUE);
         return S_OK;
     default:
-        FIXME("Unimplemented conversion path!\n");
-        return WINCODEC_ERR_UNSUPPORTEDOPERATION;
+        if (prc)
+            return copypixels_32bpp_to_24bpp(This, prc, cbStride, pbBuffer, source_format, TRUE);
+        return S_OK;
     }
 }
 
@@ -1074,6 +1140,8 @@ static ULONG WINAPI FormatConverter_Release(IWICFormatConverter *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        HeapFree(GetProcessHeap(), 0, This->srcbuffer);
+        HeapFree(GetProcessHeap(), 0, This->bgrabuffer);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -1150,8 +1218,11 @@ static HRESULT WINAPI FormatConverter_CopyPixels(IWICFormatConverter *iface,
             prc = &rc;
         }
 
-        return This->dst_format->copy_function(This, prc, cbStride, cbBufferSize,
+        EnterCriticalSection(&This->lock);
+        hr = This->dst_format->copy_function(This, prc, cbStride, cbBufferSize,
             pbBuffer, This->src_format->format);
+        LeaveCriticalSection(&This->lock);
+        return hr;
     }
     else
         return WINCODEC_ERR_NOTINITIALIZED;
@@ -1288,6 +1359,8 @@ HRESULT FormatConverter_CreateInstance(IUnknown *pUnkOuter, REFIID iid, void** p
     This->IWICFormatConverter_iface.lpVtbl = &FormatConverter_Vtbl;
     This->ref = 1;
     This->source = NULL;
+    This->srcbuffer = This->bgrabuffer = NULL;
+    This->srcbuffer_size = This->bgrabuffer_size = 0;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": FormatConverter.lock");
 
@@ -19,6 +19,7 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -33,6 +34,23 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+/* fixed point precision of the filter weights, and the extra bits of
+ * precision kept between the vertical and horizontal passes */
+#define FILTER_BITS 14
+#define FILTER_EXTRA_BITS 6
+
+/* maximum amount of source data to request at once */
+#define SCALER_BAND_SIZE 0x100000
+
+/* Weights of a separable filter along one dimension. Destination pixel i is
+ * computed from source pixels first[i] to first[i]+taps-1 weighted by
+ * weights[i*taps] to weights[i*taps+taps-1], which sum to 1 << FILTER_BITS. */
+struct scaler_filter {
+    UINT taps;
+    UINT *first;
+    INT *weights;
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -43,6 +61,8 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    struct scaler_filter filter_x, filter_y;
+    INT *filter_row;
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -51,6 +71,106 @@ static inline BitmapScaler *impl_from_IWICBitmapScaler(IWICBitmapScaler *iface)
     return CONTAINING_RECORD(iface, BitmapScaler, IWICBitmapScaler_iface);
 }
 
+static void free_filter(struct scaler_filter *filter)
+{
+    HeapFree(GetProcessHeap(), 0, filter->first);
+    HeapFree(GetProcessHeap(), 0, filter->weights);
+    filter->first = NULL;
+    filter->weights = NULL;
+    filter->taps = 0;
+}
+
+static double filter_weight(WICBitmapInterpolationMode mode, double x, double scale)
+{
+    x = fabs(x);
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear:
+        return x < 1.0 ? 1.0 - x : 0.0;
+    case WICBitmapInterpolationModeCubic:
+        /* Catmull-Rom spline, a = -0.5 */
+        if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+        if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+        return 0.0;
+    default:
+        /* Fant: the area of the source pixel covered by the destination pixel */
+        return max(0.0, min(x + 0.5, scale / 2.0) - max(x - 0.5, -scale / 2.0));
+    }
+}
+
+static HRESULT create_filter(struct scaler_filter *filter, WICBitmapInterpolationMode mode,
+    UINT src_size, UINT dst_size)
+{
+    double scale = (double)src_size / dst_size;
+    double support, center, *tmp;
+    INT start, s, clamped;
+    UINT i, k, largest;
+    INT total;
+
+    if (!src_size || !dst_size)
+        return E_INVALIDARG;
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear: support = 1.0; break;
+    case WICBitmapInterpolationModeCubic: support = 2.0; break;
+    default: support = max(scale, 1.0) / 2.0 + 0.5; break;
+    }
+
+    filter->taps = min((UINT)ceil(support * 2.0) + 1, src_size);
+    filter->first = HeapAlloc(GetProcessHeap(), 0, dst_size * sizeof(UINT));
+    filter->weights = HeapAlloc(GetProcessHeap(), 0, dst_size * filter->taps * sizeof(INT));
+    tmp = HeapAlloc(GetProcessHeap(), 0, filter->taps * sizeof(double));
+
+    if (!filter->first || !filter->weights || !tmp)
+    {
+        HeapFree(GetProcessHeap(), 0, tmp);
+        free_filter(filter);
+        return E_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < dst_size; i++)
+    {
+        INT *weights = filter->weights + i * filter->taps;
+        double sum = 0.0;
+
+        /* source pixel s covers [s, s+1), destination pixel i is centered here */
+        center = (i + 0.5) * scale;
+        start = (INT)floor(center - 0.5 - support) + 1;
+        filter->first[i] = max(0, min(start, (INT)(src_size - filter->taps)));
+
+        /* pixels past the edges are replaced by the edge pixels */
+        memset(tmp, 0, filter->taps * sizeof(double));
+        for (s = start; s + 0.5 - center < support; s++)
+        {
+            clamped = max(0, min(s, (INT)src_size - 1));
+            tmp[clamped - filter->first[i]] += filter_weight(mode, s + 0.5 - center, scale);
+        }
+
+        for (k = 0; k < filter->taps; k++)
+            sum += tmp[k];
+
+        total = 0;
+        largest = 0;
+        for (k = 0; k < filter->taps; k++)
+        {
+            weights[k] = sum != 0.0 ? floor(tmp[k] / sum * (1 << FILTER_BITS) + 0.5) : 0;
+            total += weights[k];
+            if (weights[k] > weights[largest]) largest = k;
+        }
+
+        /* make the weights add up exactly, so flat areas stay flat */
+        if (sum != 0.0)
+            weights[largest] += (1 << FILTER_BITS) - total;
+        else
+            weights[min((UINT)center, src_size - 1) - filter->first[i]] = 1 << FILTER_BITS;
+    }
+
+    HeapFree(GetProcessHeap(), 0, tmp);
+    return S_OK;
+}
+
 static HRESULT WINAPI BitmapScaler_QueryInterface(IWICBitmapScaler *iface, REFIID iid,
     void **ppv)
 {
@@ -97,6 +217,9 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        free_filter(&This->filter_x);
+        free_filter(&This->filter_y);
+        HeapFree(GetProcessHeap(), 0, This->filter_row);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -191,6 +314,65 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+static void Filter_GetRequiredSourceRect(BitmapScaler *This,
+    UINT x, UINT y, WICRect *src_rect)
+{
+    src_rect->X = This->filter_x.first[x];
+    src_rect->Y = This->filter_y.first[y];
+    src_rect->Width = This->filter_x.taps;
+    src_rect->Height = This->filter_y.taps;
+}
+
+static void Filter_CopyScanline(BitmapScaler *This,
+    UINT dst_x, UINT dst_y, UINT dst_width,
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer)
+{
+    UINT channels = This->bpp/8;
+    UINT taps_x = This->filter_x.taps, taps_y = This->filter_y.taps;
+    UINT first_x = This->filter_x.first[dst_x];
+    UINT count = (This->filter_x.first[dst_x + dst_width - 1] + taps_x - first_x) * channels;
+    UINT offset = (first_x - src_data_x) * channels;
+    UINT src_y = This->filter_y.first[dst_y] - src_data_y;
+    const INT *weights = This->filter_y.weights + dst_y * taps_y;
+    INT *row = This->filter_row;
+    const BYTE *src;
+    UINT i, j, k;
+
+    /* vertical pass over all the source columns needed */
+    src = src_data[src_y] + offset;
+    for (j=0; j<count; j++)
+        row[j] = src[j] * weights[0];
+
+    for (k=1; k<taps_y; k++)
+    {
+        src = src_data[src_y + k] + offset;
+        for (j=0; j<count; j++)
+            row[j] += src[j] * weights[k];
+    }
+
+    for (j=0; j<count; j++)
+        row[j] = (row[j] + (1 << (FILTER_BITS - FILTER_EXTRA_BITS - 1))) >> (FILTER_BITS - FILTER_EXTRA_BITS);
+
+    /* horizontal pass, each channel separately */
+    for (i=0; i<dst_width; i++)
+    {
+        const INT *col = row + (This->filter_x.first[dst_x + i] - first_x) * channels;
+
+        weights = This->filter_x.weights + (dst_x + i) * taps_x;
+
+        for (j=0; j<channels; j++)
+        {
+            INT sum = 0;
+
+            for (k=0; k<taps_x; k++)
+                sum += col[k * channels + j] * weights[k];
+
+            sum = (sum + (1 << (FILTER_BITS + FILTER_EXTRA_BITS - 1))) >> (FILTER_BITS + FILTER_EXTRA_BITS);
+            pbBuffer[i * channels + j] = sum < 0 ? 0 : (sum > 255 ? 255 : sum);
+        }
+    }
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -203,7 +385,8 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     ULONG bytesperrow;
     ULONG src_bytesperrow;
     ULONG buffer_size;
-    UINT y;
+    UINT max_rows;
+    INT y, row, band_end;
 
     TRACE("(%p,%p,%u,%u,%p)\n", iface, prc, cbStride, cbBufferSize, pbBuffer);
 
@@ -245,27 +428,37 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         goto end;
     }
 
+    if (!dest_rect.Width || !dest_rect.Height)
+    {
+        hr = S_OK;
+        goto end;
+    }
+
     /* MSDN recommends calling CopyPixels once for each scanline from top to
      * bottom, and claims codecs optimize for this. Ideally, when called in this
      * way, we should avoid requesting a scanline from the source more than
      * once, by saving the data that will be useful for the next scanline after
      * the call returns. The GetRequiredSourceRect/CopyScanline functions are
      * designed to make it possible to do this in a generic way, but for now we
-     * just grab all the data we need in each call. */
+     * just grab the data we need in each call, in bands of at most
+     * SCALER_BAND_SIZE bytes so large images don't need a copy of the whole
+     * source. */
 
     This->fn_get_required_source_rect(This, dest_rect.X, dest_rect.Y, &src_rect_ul);
     This->fn_get_required_source_rect(This, dest_rect.X+dest_rect.Width-1,
         dest_rect.Y+dest_rect.Height-1, &src_rect_br);
 
     src_rect.X = src_rect_ul.X;
-    src_rect.Y = src_rect_ul.Y;
     src_rect.Width = src_rect_br.Width + src_rect_br.X - src_rect_ul.X;
-    src_rect.Height = src_rect_br.Height + src_rect_br.Y - src_rect_ul.Y;
 
     src_bytesperrow = (src_rect.Width * This->bpp + 7)/8;
-    buffer_size = src_bytesperrow * src_rect.Height;
 
-    src_rows = HeapAlloc(GetProcessHeap(), 0, sizeof(BYTE*) * src_rect.Height);
+    /* a band always holds at least the rows needed for one scanline */
+    max_rows = max(SCALER_BAND_SIZE / src_bytesperrow, src_rect_ul.Height);
+    max_rows = min(max_rows, src_rect_br.Height + src_rect_br.Y - src_rect_ul.Y);
+    buffer_size = src_bytesperrow * max_rows;
+
+    src_rows = HeapAlloc(GetProcessHeap(), 0, sizeof(BYTE*) * max_rows);
     src_bits = HeapAlloc(GetProcessHeap(), 0, buffer_size);
 
     if (!src_rows || !src_bits)
@@ -276,18 +469,35 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         goto end;
     }
 
-    for (y=0; y<src_rect.Height; y++)
+    for (y=0; y<max_rows; y++)
         src_rows[y] = src_bits + y * src_bytesperrow;
 
-    hr = IWICBitmapSource_CopyPixels(This->source, &src_rect, src_bytesperrow,
-        buffer_size, src_bits);
+    hr = S_OK;
 
-    if (SUCCEEDED(hr))
+    for (y=0; y < dest_rect.Height && SUCCEEDED(hr); y = band_end)
     {
-        for (y=0; y < dest_rect.Height; y++)
+        This->fn_get_required_source_rect(This, dest_rect.X, dest_rect.Y+y, &src_rect_ul);
+        src_rect.Y = src_rect_ul.Y;
+        src_rect.Height = src_rect_ul.Height;
+
+        for (band_end = y+1; band_end < dest_rect.Height; band_end++)
         {
-            This->fn_copy_scanline(This, dest_rect.X, dest_rect.Y+y, dest_rect.Width,
-                src_rows, src_rect.X, src_rect.Y, pbBuffer + cbStride * y);
+            This->fn_get_required_source_rect(This, dest_rect.X, dest_rect.Y+band_end, &src_rect_br);
+            if (src_rect_br.Y + src_rect_br.Height - src_rect.Y > max_rows)
+                break;
+            src_rect.Height = src_rect_br.Y + src_rect_br.Height - src_rect.Y;
+        }
+
+        hr = IWICBitmapSource_CopyPixels(This->source, &src_rect, src_bytesperrow,
+            src_bytesperrow * src_rect.Height, src_bits);
+
+        if (SUCCEEDED(hr))
+        {
+            for (row=y; row < band_end; row++)
+            {
+                This->fn_copy_scanline(This, dest_rect.X, dest_rect.Y+row, dest_rect.Width,
+                    src_rows, src_rect.X, src_rect.Y, pbBuffer + cbStride * row);
+            }
         }
     }
 
@@ -300,6 +510,24 @@ end:
     return hr;
 }
 
+static BOOL filter_pixelformat(const WICPixelFormatGUID *format)
+{
+    static const WICPixelFormatGUID * const formats[] = {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat24bppRGB,
+        &GUID_WICPixelFormat32bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+        &GUID_WICPixelFormat32bppPBGRA
+    };
+    UINT i;
+
+    for (i=0; i<sizeof(formats)/sizeof(formats[0]); i++)
+        if (IsEqualGUID(format, formats[i])) return TRUE;
+
+    return FALSE;
+}
+
 static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     IWICBitmapSource *pISource, UINT uiWidth, UINT uiHeight,
     WICBitmapInterpolationMode mode)
@@ -336,6 +564,47 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+            /* the filters work on 8 bits per channel */
+            if (filter_pixelformat(&src_pixelformat))
+            {
+                IWICBitmapSource_AddRef(pISource);
+                This->source = pISource;
+            }
+            else
+            {
+                hr = WICConvertBitmapSource(&GUID_WICPixelFormat32bppBGRA,
+                    pISource, &This->source);
+                This->bpp = 32;
+            }
+
+            if (SUCCEEDED(hr))
+                hr = create_filter(&This->filter_x, mode, This->src_width, This->width);
+            if (SUCCEEDED(hr))
+                hr = create_filter(&This->filter_y, mode, This->src_height, This->height);
+            if (SUCCEEDED(hr))
+            {
+                This->filter_row = HeapAlloc(GetProcessHeap(), 0,
+                    This->src_width * (This->bpp/8) * sizeof(INT));
+                if (!This->filter_row) hr = E_OUTOFMEMORY;
+            }
+
+            if (FAILED(hr))
+            {
+                free_filter(&This->filter_x);
+                free_filter(&This->filter_y);
+                if (This->source)
+                {
+                    IWICBitmapSource_Release(This->source);
+                    This->source = NULL;
+                }
+            }
+
+            This->fn_get_required_source_rect = Filter_GetRequiredSourceRect;
+            This->fn_copy_scanline = Filter_CopyScanline;
+            break;
         default:
             FIXME("unsupported mode %i\n", mode);
             /* fall-through */
@@ -391,6 +660,9 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    memset(&This->filter_x, 0, sizeof(This->filter_x));
+    memset(&This->filter_y, 0, sizeof(This->filter_y));
+    This->filter_row = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
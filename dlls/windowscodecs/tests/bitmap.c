@@ -19,6 +19,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <math.h>
 
@@ -769,6 +770,224 @@ todo_wine
     DeleteObject(hpal);
 }
 
+static void test_bitmap_scaler(void)
+{
+    static const WICBitmapInterpolationMode modes[] = {
+        WICBitmapInterpolationModeNearestNeighbor,
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant
+    };
+    static const UINT sizes[][2] = { {3, 2}, {16, 12}, {8, 1} };
+    BYTE src[8 * 6 * 3], dst[16 * 12 * 3];
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    WICPixelFormatGUID format;
+    UINT width, height, i, j, k;
+    HRESULT hr;
+
+    /* a flat image stays flat whatever filter is used */
+    for (i = 0; i < sizeof(src); i += 3)
+    {
+        src[i] = 10;
+        src[i + 1] = 100;
+        src[i + 2] = 200;
+    }
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 8, 6, &GUID_WICPixelFormat24bppBGR,
+                                                   8 * 3, sizeof(src), src, &bitmap);
+    ok(hr == S_OK, "IWICImagingFactory_CreateBitmapFromMemory error %#x\n", hr);
+
+    for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++)
+    {
+        for (j = 0; j < sizeof(sizes)/sizeof(sizes[0]); j++)
+        {
+            hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+            ok(hr == S_OK, "CreateBitmapScaler error %#x\n", hr);
+
+            hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap,
+                                             sizes[j][0], sizes[j][1], modes[i]);
+            ok(hr == S_OK, "%u: Initialize error %#x\n", modes[i], hr);
+
+            hr = IWICBitmapScaler_GetSize(scaler, &width, &height);
+            ok(hr == S_OK, "%u: GetSize error %#x\n", modes[i], hr);
+            ok(width == sizes[j][0] && height == sizes[j][1], "%u: got %ux%u\n", modes[i], width, height);
+
+            hr = IWICBitmapScaler_GetPixelFormat(scaler, &format);
+            ok(hr == S_OK, "%u: GetPixelFormat error %#x\n", modes[i], hr);
+            ok(IsEqualGUID(&format, &GUID_WICPixelFormat24bppBGR), "%u: got format %s\n",
+               modes[i], debugstr_guid(&format));
+
+            memset(dst, 0, sizeof(dst));
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, width * 3, sizeof(dst), dst);
+            ok(hr == S_OK, "%u: CopyPixels error %#x\n", modes[i], hr);
+
+            for (k = 0; k < width * height * 3; k += 3)
+            {
+                if (dst[k] != 10 || dst[k + 1] != 100 || dst[k + 2] != 200) break;
+            }
+            ok(k == width * height * 3, "%u: %ux%u: pixel %u differs\n", modes[i], width, height, k / 3);
+
+            IWICBitmapScaler_Release(scaler);
+        }
+    }
+
+    IWICBitmap_Release(bitmap);
+}
+
+static HRESULT scale_8bpp_gray(const BYTE *src, UINT src_width, UINT src_height,
+                               UINT width, UINT height, WICBitmapInterpolationMode mode, BYTE *dst)
+{
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    HRESULT hr;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, src_width, src_height, &GUID_WICPixelFormat8bppGray,
+                                                   src_width, src_width * src_height, (BYTE *)src, &bitmap);
+    if (hr != S_OK) return hr;
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    if (hr == S_OK)
+    {
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, width, height, mode);
+        if (hr == S_OK)
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, width, width * height, dst);
+        IWICBitmapScaler_Release(scaler);
+    }
+
+    IWICBitmap_Release(bitmap);
+    return hr;
+}
+
+static void test_bitmap_scaler_filters(void)
+{
+    static const WICBitmapInterpolationMode modes[] = {
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant
+    };
+    static const BYTE gradient[8] = {0, 32, 64, 96, 128, 160, 192, 224};
+    static const BYTE checkerboard[16] =
+    {
+        0,   0,   255, 255,
+        0,   0,   255, 255,
+        255, 255, 0,   0,
+        255, 255, 0,   0
+    };
+    static const UINT gradient_widths[] = {4, 5, 16};
+    static const UINT checkerboard_sizes[] = {2, 3, 6};
+    BYTE dst[36];
+    UINT i, j, x, y, w;
+    double pos, ref;
+    HRESULT hr;
+
+    for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++)
+    {
+        /* a gradient stays monotonic and close to its linear interpolation
+         * at the pixel centers, whatever the filter */
+        for (j = 0; j < sizeof(gradient_widths)/sizeof(gradient_widths[0]); j++)
+        {
+            w = gradient_widths[j];
+            memset(dst, 0xcc, sizeof(dst));
+            hr = scale_8bpp_gray(gradient, 8, 1, w, 1, modes[i], dst);
+            ok(hr == S_OK, "%u: %ux1: scaling failed %#x\n", modes[i], w, hr);
+
+            for (x = 0; x < w; x++)
+            {
+                pos = (x + 0.5) * 8 / w - 0.5;
+                if (pos < 0.0) pos = 0.0;
+                if (pos > 7.0) pos = 7.0;
+                ref = pos * 32;
+                ok(fabs(dst[x] - ref) <= 16.0, "%u: %ux1: pixel %u is %u, expected about %.1f\n",
+                   modes[i], w, x, dst[x], ref);
+                if (x) ok(dst[x] >= dst[x - 1], "%u: %ux1: pixel %u is %u, less than %u\n",
+                          modes[i], w, x, dst[x], dst[x - 1]);
+            }
+        }
+
+        /* a checkerboard keeps its symmetries: it is unchanged by a transposition
+         * and inverted by a horizontal mirror */
+        for (j = 0; j < sizeof(checkerboard_sizes)/sizeof(checkerboard_sizes[0]); j++)
+        {
+            w = checkerboard_sizes[j];
+            memset(dst, 0xcc, sizeof(dst));
+            hr = scale_8bpp_gray(checkerboard, 4, 4, w, w, modes[i], dst);
+            ok(hr == S_OK, "%u: %ux%u: scaling failed %#x\n", modes[i], w, w, hr);
+
+            ok(dst[0] <= 16, "%u: %ux%u: top left pixel is %u\n", modes[i], w, w, dst[0]);
+            ok(dst[w - 1] >= 239, "%u: %ux%u: top right pixel is %u\n", modes[i], w, w, dst[w - 1]);
+
+            for (y = 0; y < w; y++)
+            {
+                for (x = 0; x < w; x++)
+                {
+                    if (abs(dst[y * w + x] - dst[x * w + y]) > 1) break;
+                    if (abs(dst[y * w + x] + dst[y * w + w - 1 - x] - 255) > 1) break;
+                }
+                if (x < w) break;
+            }
+            ok(y == w, "%u: %ux%u: pixel %u,%u breaks the symmetry\n", modes[i], w, w, x, y);
+        }
+    }
+}
+
+static void test_bitmap_scaler_bands(void)
+{
+    static const WICBitmapInterpolationMode modes[] = {
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant
+    };
+    /* the source is too big to be read in a single band */
+    const UINT src_width = 1024, src_height = 2048, width = 600, height = 1500;
+    WICRect rc = { 100, 700, 400, 600 };
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    BYTE *src, *dst, *part;
+    UINT i, x, y;
+    HRESULT hr;
+
+    src = HeapAlloc(GetProcessHeap(), 0, src_width * src_height);
+    dst = HeapAlloc(GetProcessHeap(), 0, width * height);
+    part = HeapAlloc(GetProcessHeap(), 0, rc.Width * rc.Height);
+
+    for (y = 0; y < src_height; y++)
+        for (x = 0; x < src_width; x++)
+            src[y * src_width + x] = (x ^ y) & 0xff;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, src_width, src_height, &GUID_WICPixelFormat8bppGray,
+                                                   src_width, src_width * src_height, src, &bitmap);
+    ok(hr == S_OK, "CreateBitmapFromMemory error %#x\n", hr);
+
+    for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++)
+    {
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "%u: CreateBitmapScaler error %#x\n", modes[i], hr);
+
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, width, height, modes[i]);
+        ok(hr == S_OK, "%u: Initialize error %#x\n", modes[i], hr);
+
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, width, width * height, dst);
+        ok(hr == S_OK, "%u: CopyPixels error %#x\n", modes[i], hr);
+
+        /* a part of the image must match the same part of the whole image */
+        memset(part, 0xcc, rc.Width * rc.Height);
+        hr = IWICBitmapScaler_CopyPixels(scaler, &rc, rc.Width, rc.Width * rc.Height, part);
+        ok(hr == S_OK, "%u: CopyPixels error %#x\n", modes[i], hr);
+
+        for (y = 0; y < rc.Height; y++)
+            if (memcmp(part + y * rc.Width, dst + (rc.Y + y) * width + rc.X, rc.Width)) break;
+        ok(y == rc.Height, "%u: row %u differs\n", modes[i], rc.Y + y);
+
+        IWICBitmapScaler_Release(scaler);
+    }
+
+    IWICBitmap_Release(bitmap);
+    HeapFree(GetProcessHeap(), 0, src);
+    HeapFree(GetProcessHeap(), 0, dst);
+    HeapFree(GetProcessHeap(), 0, part);
+}
+
 START_TEST(bitmap)
 {
     HRESULT hr;
@@ -784,6 +1003,9 @@ START_TEST(bitmap)
     test_CreateBitmapFromMemory();
     test_CreateBitmapFromHICON();
     test_CreateBitmapFromHBITMAP();
+    test_bitmap_scaler();
+    test_bitmap_scaler_filters();
+    test_bitmap_scaler_bands();
 
     IWICImagingFactory_Release(factory);
 
@@ -295,6 +295,24 @@ static const BYTE bits_32bppBGRA[] = {
 static const struct bitmap_data testdata_32bppBGRA = {
     &GUID_WICPixelFormat32bppBGRA, 32, bits_32bppBGRA, 4, 2, 96.0, 96.0};
 
+static const BYTE bits_32bppPBGRA[] = {
+    255,0,0,255, 0,255,0,255, 0,0,255,255, 0,0,0,255,
+    0,255,255,255, 255,0,255,255, 255,255,0,255, 255,255,255,255};
+static const struct bitmap_data testdata_32bppPBGRA = {
+    &GUID_WICPixelFormat32bppPBGRA, 32, bits_32bppPBGRA, 4, 2, 96.0, 96.0};
+
+static const BYTE bits_8bppGray[] = {
+    0,80,160,255,
+    255,160,80,0};
+static const struct bitmap_data testdata_8bppGray = {
+    &GUID_WICPixelFormat8bppGray, 8, bits_8bppGray, 4, 2, 96.0, 96.0};
+
+static const BYTE bits_24bppBGR_gray[] = {
+    0,0,0, 80,80,80, 160,160,160, 255,255,255,
+    255,255,255, 160,160,160, 80,80,80, 0,0,0};
+static const struct bitmap_data testdata_24bppBGR_gray = {
+    &GUID_WICPixelFormat24bppBGR, 24, bits_24bppBGR_gray, 4, 2, 96.0, 96.0};
+
 static void test_conversion(const struct bitmap_data *src, const struct bitmap_data *dst, const char *name, BOOL todo)
 {
     BitmapTestSrc *src_obj;
@@ -659,6 +677,9 @@ START_TEST(converter)
 
     test_conversion(&testdata_32bppBGR, &testdata_24bppRGB, "32bppBGR -> 24bppRGB", 0);
     test_conversion(&testdata_24bppRGB, &testdata_32bppBGR, "24bppRGB -> 32bppBGR", 0);
+    test_conversion(&testdata_24bppBGR, &testdata_32bppPBGRA, "24bppBGR -> 32bppPBGRA", 0);
+    test_conversion(&testdata_32bppBGRA, &testdata_24bppBGR, "32bppBGRA -> 24bppBGR", 0);
+    test_conversion(&testdata_8bppGray, &testdata_24bppBGR_gray, "8bppGray -> 24bppBGR", 0);
 
     test_invalid_conversion();
     test_default_converter();